@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT = core gui printsupport qml serialbus serialport widgets
+QT = core gui printsupport qml serialbus serialport widgets concurrent
 
 CONFIG(release, debug|release):DEFINES += QT_NO_DEBUG_OUTPUT
 
@@ -18,6 +18,12 @@ TEMPLATE = app
 SOURCES += main.cpp\
     mainwindow.cpp \
     canframemodel.cpp \
+    canframestore.cpp \
+    lazyframefile.cpp \
+    canbinaryfile.cpp \
+    cancompressedfile.cpp \
+    continuouslogger.cpp \
+    signalexport.cpp \
     utility.cpp \
     qcustomplot.cpp \
     frameplaybackwindow.cpp \
@@ -41,6 +47,7 @@ SOURCES += main.cpp\
     re/sniffer/snifferwindow.cpp \
     dbc/dbc_classes.cpp \
     dbc/dbchandler.cpp \
+    dbc/dbccache.cpp \
     dbc/dbcloadsavewindow.cpp \
     dbc/dbcmaineditor.cpp \
     dbc/dbcsignaleditor.cpp \
@@ -68,6 +75,13 @@ SOURCES += main.cpp\
 HEADERS  += mainwindow.h \
     can_structs.h \
     canframemodel.h \
+    canframestore.h \
+    lazyframefile.h \
+    framelineformat.h \
+    canbinaryfile.h \
+    cancompressedfile.h \
+    continuouslogger.h \
+    signalexport.h \
     utility.h \
     qcustomplot.h \
     frameplaybackwindow.h \
@@ -82,6 +96,8 @@ HEADERS  += mainwindow.h \
     scriptcontainer.h \
     canfilter.h \
     utils/lfqueue.h \
+    utils/textscanner.h \
+    utils/textwriter.h \
     motorcontrollerconfigwindow.h \
     connections/canconnection.h \
     connections/serialbusconnection.h \
@@ -94,6 +110,7 @@ HEADERS  += mainwindow.h \
     re/sniffer/snifferwindow.h \
     dbc/dbc_classes.h \
     dbc/dbchandler.h \
+    dbc/dbccache.h \
     dbc/dbcloadsavewindow.h \
     dbc/dbcmaineditor.h \
     dbc/dbcsignaleditor.h \
@@ -7,7 +7,7 @@
 #include <QDebug>
 #include <algorithm>
 
-BisectWindow::BisectWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+BisectWindow::BisectWindow(const CANFrameView *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::BisectWindow)
 {
@@ -19,6 +19,7 @@ BisectWindow::BisectWindow(const QVector<CANFrame> *frames, QWidget *parent) :
     connect(ui->btnCalculate, &QAbstractButton::clicked, this, &BisectWindow::handleCalculateButton);
     connect(ui->btnReplaceFrames, &QAbstractButton::clicked, this, &BisectWindow::handleReplaceButton);
     connect(ui->btnSaveFrames, &QAbstractButton::clicked, this, &BisectWindow::handleSaveButton);
+    connect(ui->btnSplitFile, &QAbstractButton::clicked, this, &BisectWindow::handleSplitFileButton);
     connect(ui->slideFrameNumber, &QSlider::sliderReleased, this, &BisectWindow::updateFrameNumText);
     connect(ui->slidePercentage, &QSlider::sliderReleased, this, &BisectWindow::updatePercentText);
     connect(ui->editFrameNumber, &QLineEdit::editingFinished, this, &BisectWindow::updateFrameNumSlider);
@@ -113,6 +114,15 @@ void BisectWindow::handleCalculateButton()
     refreshFrameNumbers();
 }
 
+//the split comes straight out of a file on disk, loading only the time window and IDs asked for
+void BisectWindow::handleSplitFileButton()
+{
+    QString filename;
+    splitFrames.clear();
+    if (!FrameFileIO::loadFrameFile(filename, &splitFrames, true)) splitFrames.clear();
+    refreshFrameNumbers();
+}
+
 void BisectWindow::handleReplaceButton()
 {
 
@@ -122,7 +132,8 @@ void BisectWindow::handleSaveButton()
 {
     QMessageBox msg;
     QString filename;
-    if (FrameFileIO::saveFrameFile(filename, &splitFrames))
+    CANFrameView splitView(&splitFrames);
+    if (FrameFileIO::saveFrameFile(filename, &splitView))
     {
         msg.setText(tr("Successfully saved file"));
     }
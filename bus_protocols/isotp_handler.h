@@ -39,7 +39,7 @@ private:
     QList<ISOTP_MESSAGE> messageBuffer;
     QList<CANFrame> sendingFrames;
     QList<CANFilter> filters;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameView *modelFrames;
     bool useExtendedAddressing;
     bool isReceiving;
     bool waitingForFlow;
@@ -0,0 +1,301 @@
+#include "canbinaryfile.h"
+
+#include <QDebug>
+#include <QMap>
+#include <QtEndian>
+#include <string.h>
+
+//how many records are encoded into memory before each write when saving
+#define WRITE_BATCH 4096
+
+CANBinaryFile::CANBinaryFile()
+{
+    map = NULL;
+    opened = false;
+    numFrames = 0;
+    recordSize = CANBIN_RECORD_SIZE;
+    headerFlags = 0;
+}
+
+CANBinaryFile::~CANBinaryFile()
+{
+    close();
+}
+
+/*
+ * Maps the whole file and checks the header. Frames are only decoded when asked for so opening
+ * even a huge capture is quick and costs no memory beyond the index.
+ */
+bool CANBinaryFile::open(QString filename)
+{
+    close();
+
+    file.setFileName(filename);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    qint64 fileSize = file.size();
+    if (fileSize < CANBIN_HEADER_SIZE)
+    {
+        close();
+        return false;
+    }
+
+    map = file.map(0, fileSize);
+    if (!map)
+    {
+        qDebug() << "Could not map " << filename;
+        close();
+        return false;
+    }
+
+    if (memcmp(map, CANBIN_MAGIC, 8) != 0 || qFromLittleEndian<quint32>(map + 8) > CANBIN_VERSION)
+    {
+        close();
+        return false;
+    }
+
+    recordSize = qFromLittleEndian<quint32>(map + 12);
+    quint64 frameCount = qFromLittleEndian<quint64>(map + 16);
+    qint64 indexOffset = qFromLittleEndian<quint64>(map + 24);
+    headerFlags = qFromLittleEndian<quint32>(map + 32);
+
+    //a file cut short (say the program died while writing it) still gives up every complete record
+    qint64 dataEnd = (indexOffset > 0 && indexOffset <= fileSize) ? indexOffset : fileSize;
+    if (recordSize < CANBIN_RECORD_SIZE || frameCount > 0x7FFFFFFF)
+    {
+        close();
+        return false;
+    }
+    qint64 available = (dataEnd - CANBIN_HEADER_SIZE) / recordSize;
+    numFrames = (int)qMin((qint64)frameCount, available);
+
+    if (indexOffset > 0 && !readIndex(indexOffset))
+    {
+        qDebug() << "Index footer of " << filename << " is damaged, ignoring it";
+        idIndex.clear();
+        checkpoints.clear();
+    }
+
+    opened = true;
+    return true;
+}
+
+bool CANBinaryFile::readIndex(qint64 indexOffset)
+{
+    qint64 fileSize = file.size();
+    qint64 pos = indexOffset;
+
+    if (pos + 4 > fileSize) return false;
+    quint32 numIDs = qFromLittleEndian<quint32>(map + pos);
+    pos += 4;
+    if (pos + (qint64)numIDs * 24 + 4 > fileSize) return false;
+
+    idIndex.resize(numIDs);
+    for (quint32 i = 0; i < numIDs; i++)
+    {
+        idIndex[i].ID = qFromLittleEndian<quint32>(map + pos);
+        idIndex[i].count = qFromLittleEndian<quint32>(map + pos + 4);
+        idIndex[i].firstTimestamp = qFromLittleEndian<quint64>(map + pos + 8);
+        idIndex[i].lastTimestamp = qFromLittleEndian<quint64>(map + pos + 16);
+        pos += 24;
+    }
+
+    quint32 numCheckpoints = qFromLittleEndian<quint32>(map + pos);
+    pos += 4;
+    if (pos + (qint64)numCheckpoints * 16 > fileSize) return false;
+
+    checkpoints.resize(numCheckpoints);
+    for (quint32 i = 0; i < numCheckpoints; i++)
+    {
+        checkpoints[i].record = qFromLittleEndian<quint64>(map + pos);
+        checkpoints[i].timestamp = qFromLittleEndian<quint64>(map + pos + 8);
+        pos += 16;
+    }
+    return true;
+}
+
+void CANBinaryFile::close()
+{
+    if (map) file.unmap(map);
+    map = NULL;
+    if (file.isOpen()) file.close();
+    opened = false;
+    numFrames = 0;
+    headerFlags = 0;
+    idIndex.clear();
+    checkpoints.clear();
+}
+
+CANFrame CANBinaryFile::frameAt(int idx) const
+{
+    CANFrame frame;
+    decodeRecord(recordPtr(idx), frame);
+    return frame;
+}
+
+//decodes up to num frames starting at first into out. Returns how many were decoded
+int CANBinaryFile::readFrames(int first, int num, CANFrame *out) const
+{
+    if (first < 0 || first >= numFrames) return 0;
+    if (num > numFrames - first) num = numFrames - first;
+
+    const uchar *rec = recordPtr(first);
+    for (int i = 0; i < num; i++)
+    {
+        decodeRecord(rec, out[i]);
+        rec += recordSize;
+    }
+    return num;
+}
+
+/*
+ * First record with a timestamp at or past the given one. The checkpoints narrow it down to one
+ * stretch of CANBIN_CHECKPOINT_INTERVAL records which is then binary searched in place.
+ * Only meaningful for files whose timestamps are monotonic. Returns count() if every frame is earlier.
+ */
+int CANBinaryFile::findRecordAtTime(uint64_t timestamp) const
+{
+    qint64 low = 0, high = numFrames;
+
+    for (int i = 0; i < checkpoints.count(); i++)
+    {
+        if (checkpoints[i].timestamp < timestamp) low = checkpoints[i].record;
+        else
+        {
+            high = qMin((qint64)checkpoints[i].record + 1, (qint64)numFrames);
+            break;
+        }
+    }
+
+    while (low < high)
+    {
+        qint64 mid = (low + high) / 2;
+        if (qFromLittleEndian<quint64>(recordPtr(mid)) < timestamp) low = mid + 1;
+        else high = mid;
+    }
+    return (int)low;
+}
+
+void CANBinaryFile::encodeHeader(uchar *out, quint64 frameCount, qint64 indexOffset, quint32 flags)
+{
+    memset(out, 0, CANBIN_HEADER_SIZE);
+    memcpy(out, CANBIN_MAGIC, 8);
+    qToLittleEndian<quint32>(CANBIN_VERSION, out + 8);
+    qToLittleEndian<quint32>(CANBIN_RECORD_SIZE, out + 12);
+    qToLittleEndian<quint64>(frameCount, out + 16);
+    qToLittleEndian<quint64>(indexOffset, out + 24);
+    qToLittleEndian<quint32>(flags, out + 32);
+}
+
+void CANBinaryFile::encodeRecord(const CANFrame &frame, uchar *out)
+{
+    qToLittleEndian<quint64>(frame.timestamp, out);
+    qToLittleEndian<quint32>(frame.ID, out + 8);
+    out[12] = frame.bus;
+    out[13] = frame.len;
+    out[14] = (frame.extended ? 1 : 0) | (frame.isReceived ? 2 : 0);
+    out[15] = 0;
+    memcpy(out + 16, frame.data, 8);
+}
+
+void CANBinaryFile::decodeRecord(const uchar *in, CANFrame &frame)
+{
+    frame.timestamp = qFromLittleEndian<quint64>(in);
+    frame.ID = qFromLittleEndian<quint32>(in + 8);
+    frame.bus = in[12];
+    frame.len = in[13];
+    if (frame.len > 8) frame.len = 8;
+    frame.extended = (in[14] & 1) != 0;
+    frame.isReceived = (in[14] & 2) != 0;
+    memcpy(frame.data, in + 16, 8);
+}
+
+bool CANBinaryFile::write(QString filename, const CANFrameView *frames)
+{
+    QFile outFile(filename);
+    if (!outFile.open(QIODevice::WriteOnly)) return false;
+
+    uchar header[CANBIN_HEADER_SIZE];
+    //frame count and index offset get filled in once everything is written
+    encodeHeader(header, 0, 0, 0);
+    if (outFile.write((const char *)header, sizeof(header)) != sizeof(header)) return false;
+
+    QMap<uint32_t, CANBinaryIDEntry> ids;
+    QVector<CANBinaryCheckpoint> checkpoints;
+    bool monotonic = true;
+    uint64_t lastTimestamp = 0;
+
+    QByteArray buffer(WRITE_BATCH * CANBIN_RECORD_SIZE, 0);
+    int num = frames->count();
+    int inBuffer = 0;
+    for (int i = 0; i < num; i++)
+    {
+        const CANFrame &frame = frames->at(i);
+        encodeRecord(frame, (uchar *)buffer.data() + inBuffer * CANBIN_RECORD_SIZE);
+        inBuffer++;
+        if (inBuffer == WRITE_BATCH)
+        {
+            if (outFile.write(buffer.constData(), inBuffer * CANBIN_RECORD_SIZE) < 0) return false;
+            inBuffer = 0;
+        }
+
+        if (i > 0 && frame.timestamp < lastTimestamp) monotonic = false;
+        lastTimestamp = frame.timestamp;
+        if ((i % CANBIN_CHECKPOINT_INTERVAL) == 0)
+        {
+            CANBinaryCheckpoint point = {(uint64_t)i, frame.timestamp};
+            checkpoints.append(point);
+        }
+
+        QMap<uint32_t, CANBinaryIDEntry>::iterator it = ids.find(frame.ID);
+        if (it == ids.end())
+        {
+            CANBinaryIDEntry entry = {frame.ID, 1, frame.timestamp, frame.timestamp};
+            ids.insert(frame.ID, entry);
+        }
+        else
+        {
+            it.value().count++;
+            it.value().lastTimestamp = frame.timestamp;
+        }
+    }
+    if (inBuffer > 0 && outFile.write(buffer.constData(), inBuffer * CANBIN_RECORD_SIZE) < 0) return false;
+
+    qint64 indexOffset = outFile.pos();
+    QByteArray footer;
+    footer.resize(4 + ids.count() * 24 + 4 + checkpoints.count() * 16);
+    uchar *out = (uchar *)footer.data();
+    qToLittleEndian<quint32>(ids.count(), out);
+    out += 4;
+    foreach (const CANBinaryIDEntry &entry, ids)
+    {
+        qToLittleEndian<quint32>(entry.ID, out);
+        qToLittleEndian<quint32>(entry.count, out + 4);
+        qToLittleEndian<quint64>(entry.firstTimestamp, out + 8);
+        qToLittleEndian<quint64>(entry.lastTimestamp, out + 16);
+        out += 24;
+    }
+    qToLittleEndian<quint32>(checkpoints.count(), out);
+    out += 4;
+    for (int i = 0; i < checkpoints.count(); i++)
+    {
+        qToLittleEndian<quint64>(checkpoints[i].record, out);
+        qToLittleEndian<quint64>(checkpoints[i].timestamp, out + 8);
+        out += 16;
+    }
+    if (outFile.write(footer) != footer.size()) return false;
+
+    encodeHeader(header, num, indexOffset, monotonic ? CANBIN_FLAG_MONOTONIC : 0);
+    if (!outFile.seek(0)) return false;
+    if (outFile.write((const char *)header, sizeof(header)) != sizeof(header)) return false;
+
+    outFile.close();
+    return true;
+}
+
+bool CANBinaryFile::isBinaryFile(QString filename)
+{
+    QFile inFile(filename);
+    if (!inFile.open(QIODevice::ReadOnly)) return false;
+    return inFile.read(8) == QByteArray(CANBIN_MAGIC);
+}
@@ -0,0 +1,102 @@
+#ifndef CANBINARYFILE_H
+#define CANBINARYFILE_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include "can_structs.h"
+#include "canframestore.h"
+
+/*
+ * SavvyCAN native binary capture file. Everything is little endian.
+ *
+ * Header (40 bytes):
+ *   char     magic[8]       "SVCANBIN"
+ *   uint32   version
+ *   uint32   recordSize     bytes per frame record, lets later versions grow the record
+ *   uint64   frameCount
+ *   uint64   indexOffset    where the index footer starts, 0 if the file has none
+ *   uint32   flags          CANBIN_FLAG_MONOTONIC if timestamps never go backwards
+ *   uint32   reserved
+ *
+ * Records (recordSize bytes each, 24 in version 1):
+ *   uint64   timestamp
+ *   uint32   ID
+ *   uint8    bus
+ *   uint8    len
+ *   uint8    flags          bit 0 extended, bit 1 received
+ *   uint8    reserved
+ *   uint8    data[8]
+ *
+ * Index footer:
+ *   uint32   number of IDs, then per ID (sorted by ID): uint32 ID, uint32 count, uint64 first timestamp, uint64 last timestamp
+ *   uint32   number of checkpoints, then per checkpoint: uint64 record, uint64 timestamp
+ *            one checkpoint every CANBIN_CHECKPOINT_INTERVAL records
+ *
+ * Since records are fixed width any frame can be read straight out of the mapped file without parsing
+ * anything before it.
+ */
+
+#define CANBIN_MAGIC                "SVCANBIN"
+#define CANBIN_VERSION              1
+#define CANBIN_HEADER_SIZE          40
+#define CANBIN_RECORD_SIZE          24
+#define CANBIN_CHECKPOINT_INTERVAL  65536
+#define CANBIN_FLAG_MONOTONIC       1
+
+struct CANBinaryIDEntry
+{
+    uint32_t ID;
+    uint32_t count;
+    uint64_t firstTimestamp;
+    uint64_t lastTimestamp;
+};
+
+struct CANBinaryCheckpoint
+{
+    uint64_t record;
+    uint64_t timestamp;
+};
+
+class CANBinaryFile
+{
+public:
+    CANBinaryFile();
+    ~CANBinaryFile();
+
+    bool open(QString filename);
+    void close();
+    bool isOpen() const { return opened; }
+
+    int count() const { return numFrames; }
+    bool isMonotonic() const { return (headerFlags & CANBIN_FLAG_MONOTONIC) != 0; }
+    CANFrame frameAt(int idx) const;
+    int readFrames(int first, int num, CANFrame *out) const;
+    int findRecordAtTime(uint64_t timestamp) const;
+
+    const QVector<CANBinaryIDEntry> &getIDIndex() const { return idIndex; }
+    const QVector<CANBinaryCheckpoint> &getCheckpoints() const { return checkpoints; }
+
+    static bool write(QString filename, const CANFrameView *frames);
+    static bool isBinaryFile(QString filename);
+    static void encodeHeader(uchar *out, quint64 frameCount, qint64 indexOffset, quint32 flags);
+    static void encodeRecord(const CANFrame &frame, uchar *out);
+    static void decodeRecord(const uchar *in, CANFrame &frame);
+
+private:
+    Q_DISABLE_COPY(CANBinaryFile)
+
+    bool readIndex(qint64 indexOffset);
+    const uchar *recordPtr(int idx) const { return map + CANBIN_HEADER_SIZE + (qint64)idx * recordSize; }
+
+    QFile file;
+    uchar *map;
+    bool opened;
+    int numFrames;
+    int recordSize;
+    quint32 headerFlags;
+    QVector<CANBinaryIDEntry> idIndex;
+    QVector<CANBinaryCheckpoint> checkpoints;
+};
+
+#endif // CANBINARYFILE_H
@@ -0,0 +1,412 @@
+#include "cancompressedfile.h"
+
+#include <QDebug>
+#include <QHash>
+#include <QtEndian>
+#include <QtConcurrent>
+#include <string.h>
+
+//zlib level blocks are packed with. Past 6 it gets much slower for very little
+#define COMPRESS_LEVEL  6
+
+//what the delta coding keeps per ID while going through a block
+struct SlotState
+{
+    uint64_t timestamp;
+    uint32_t ID;
+    int bus;
+    uchar data[8];
+};
+
+struct EncodeJob
+{
+    const CANFrameView *frames;
+    int first;
+    int num;
+    QByteArray block;
+};
+
+static uchar *writeVarint(uchar *p, quint64 val)
+{
+    while (val >= 0x80)
+    {
+        *p++ = (uchar)(val | 0x80);
+        val >>= 7;
+    }
+    *p++ = (uchar)val;
+    return p;
+}
+
+static bool readVarint(const uchar *&p, const uchar *end, quint64 &val)
+{
+    val = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (p >= end) return false;
+        uchar b = *p++;
+        val |= (quint64)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+static quint64 zigzag(qint64 val) { return ((quint64)val << 1) ^ (quint64)(val >> 63); }
+static qint64 unzigzag(quint64 val) { return (qint64)(val >> 1) ^ -(qint64)(val & 1); }
+
+//what makes two frames the same stream as far as the delta coding goes
+static quint64 slotKey(const CANFrame &frame)
+{
+    return frame.ID | ((quint64)frame.bus << 32) | (frame.extended ? (1ull << 48) : 0);
+}
+
+CANCompressedFile::CANCompressedFile()
+{
+    map = NULL;
+    opened = false;
+    numFrames = 0;
+    headerFlags = 0;
+}
+
+CANCompressedFile::~CANCompressedFile()
+{
+    close();
+}
+
+/*
+ * Maps the file and walks the chain of block headers. Nothing gets decompressed until a block is asked for.
+ */
+bool CANCompressedFile::open(QString filename)
+{
+    close();
+
+    file.setFileName(filename);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    qint64 fileSize = file.size();
+    if (fileSize < CANCMP_HEADER_SIZE)
+    {
+        close();
+        return false;
+    }
+
+    map = file.map(0, fileSize);
+    if (!map)
+    {
+        qDebug() << "Could not map " << filename;
+        close();
+        return false;
+    }
+
+    if (memcmp(map, CANCMP_MAGIC, 8) != 0 || qFromLittleEndian<quint32>(map + 8) > CANCMP_VERSION)
+    {
+        close();
+        return false;
+    }
+    headerFlags = qFromLittleEndian<quint32>(map + 24);
+
+    qint64 pos = CANCMP_HEADER_SIZE;
+    qint64 total = 0;
+    while (pos + CANCMP_BLOCK_HEADER_SIZE <= fileSize)
+    {
+        CANCompressedBlock block;
+        quint32 packedSize = qFromLittleEndian<quint32>(map + pos);
+        block.offset = pos;
+        block.firstFrame = (int)total;
+        block.numFrames = (int)qFromLittleEndian<quint32>(map + pos + 4);
+        block.firstTimestamp = qFromLittleEndian<quint64>(map + pos + 8);
+        block.lastTimestamp = qFromLittleEndian<quint64>(map + pos + 16);
+
+        //a block cut short by a writer that never finished is left off along with anything after it
+        qint64 next = pos + CANCMP_BLOCK_HEADER_SIZE + packedSize;
+        if (next > fileSize || block.numFrames < 0 || total + block.numFrames > 0x7FFFFFFF) break;
+
+        blocks.append(block);
+        total += block.numFrames;
+        pos = next;
+    }
+    numFrames = (int)total;
+
+    opened = true;
+    return true;
+}
+
+void CANCompressedFile::close()
+{
+    if (map) file.unmap(map);
+    map = NULL;
+    if (file.isOpen()) file.close();
+    opened = false;
+    numFrames = 0;
+    headerFlags = 0;
+    blocks.clear();
+}
+
+bool CANCompressedFile::decodeBlock(int block, CANFrame *out) const
+{
+    if (!opened || block < 0 || block >= blocks.count()) return false;
+    const CANCompressedBlock &info = blocks[block];
+    qint64 size = CANCMP_BLOCK_HEADER_SIZE + qFromLittleEndian<quint32>(map + info.offset);
+    return decodeBlock(map + info.offset, size, out, info.numFrames);
+}
+
+int CANCompressedFile::findBlockAtTime(uint64_t timestamp) const
+{
+    int low = 0, high = blocks.count();
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (blocks[mid].lastTimestamp < timestamp) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+void CANCompressedFile::encodeHeader(uchar *out, quint64 frameCount, quint32 flags)
+{
+    memset(out, 0, CANCMP_HEADER_SIZE);
+    memcpy(out, CANCMP_MAGIC, 8);
+    qToLittleEndian<quint32>(CANCMP_VERSION, out + 8);
+    qToLittleEndian<quint32>(CANCMP_BLOCK_FRAMES, out + 12);
+    qToLittleEndian<quint64>(frameCount, out + 16);
+    qToLittleEndian<quint32>(flags, out + 24);
+}
+
+QByteArray CANCompressedFile::encodeBlock(const CANFrame *frames, int num)
+{
+    //worst case a frame is flags, two 10 byte varints for slot and ID, bus, a 10 byte varint timestamp and 8 data bytes
+    QByteArray raw(num * 40, 0);
+    uchar *p = (uchar *)raw.data();
+
+    QHash<quint64, int> slotIndex;
+    QVector<SlotState> slotStates;
+    uint64_t prevTimestamp = num ? frames[0].timestamp : 0;
+
+    for (int i = 0; i < num; i++)
+    {
+        const CANFrame &frame = frames[i];
+        unsigned int len = qMin(frame.len, 8u);
+        *p++ = (frame.extended ? 1 : 0) | (frame.isReceived ? 2 : 0) | (len << 4);
+
+        quint64 key = slotKey(frame);
+        QHash<quint64, int>::iterator it = slotIndex.find(key);
+        int slot;
+        if (it == slotIndex.end())
+        {
+            slot = slotStates.count();
+            slotIndex.insert(key, slot);
+            SlotState state;
+            state.timestamp = prevTimestamp;
+            state.ID = frame.ID;
+            state.bus = frame.bus;
+            memset(state.data, 0, 8);
+            slotStates.append(state);
+            p = writeVarint(p, slot);
+            p = writeVarint(p, frame.ID);
+            *p++ = (uchar)frame.bus;
+        }
+        else
+        {
+            slot = it.value();
+            p = writeVarint(p, slot);
+        }
+
+        SlotState &state = slotStates[slot];
+        p = writeVarint(p, zigzag((qint64)(frame.timestamp - state.timestamp)));
+        state.timestamp = frame.timestamp;
+        prevTimestamp = frame.timestamp;
+
+        for (unsigned int b = 0; b < 8; b++)
+        {
+            uchar val = (b < len) ? frame.data[b] : 0;
+            if (b < len) *p++ = val ^ state.data[b];
+            state.data[b] = val;
+        }
+    }
+    raw.resize((int)(p - (uchar *)raw.data()));
+
+    QByteArray packed = qCompress(raw, COMPRESS_LEVEL);
+    QByteArray block(CANCMP_BLOCK_HEADER_SIZE, 0);
+    uchar *header = (uchar *)block.data();
+    qToLittleEndian<quint32>(packed.size(), header);
+    qToLittleEndian<quint32>(num, header + 4);
+    qToLittleEndian<quint64>(num ? frames[0].timestamp : 0, header + 8);
+    qToLittleEndian<quint64>(num ? frames[num - 1].timestamp : 0, header + 16);
+    block.append(packed);
+    return block;
+}
+
+bool CANCompressedFile::decodeBlock(const uchar *block, qint64 size, CANFrame *out, int maxFrames)
+{
+    if (size < CANCMP_BLOCK_HEADER_SIZE) return false;
+    quint32 packedSize = qFromLittleEndian<quint32>(block);
+    int num = (int)qFromLittleEndian<quint32>(block + 4);
+    uint64_t prevTimestamp = qFromLittleEndian<quint64>(block + 8);
+    if (CANCMP_BLOCK_HEADER_SIZE + (qint64)packedSize > size || num > maxFrames) return false;
+
+    QByteArray raw = qUncompress(block + CANCMP_BLOCK_HEADER_SIZE, (int)packedSize);
+    if (raw.isEmpty() && num > 0) return false;
+    const uchar *p = (const uchar *)raw.constData();
+    const uchar *end = p + raw.size();
+
+    QVector<SlotState> slotStates;
+    for (int i = 0; i < num; i++)
+    {
+        CANFrame &frame = out[i];
+        if (p >= end) return false;
+        uchar flags = *p++;
+        frame.extended = (flags & 1) != 0;
+        frame.isReceived = (flags & 2) != 0;
+        frame.len = flags >> 4;
+        if (frame.len > 8) return false;
+
+        quint64 slot;
+        if (!readVarint(p, end, slot) || slot > (quint64)slotStates.count()) return false;
+        if (slot == (quint64)slotStates.count())
+        {
+            quint64 id;
+            if (!readVarint(p, end, id) || p >= end) return false;
+            SlotState state;
+            state.timestamp = prevTimestamp;
+            state.ID = (uint32_t)id;
+            state.bus = *p++;
+            memset(state.data, 0, 8);
+            slotStates.append(state);
+        }
+
+        SlotState &state = slotStates[(int)slot];
+        frame.ID = state.ID;
+        frame.bus = state.bus;
+        quint64 delta;
+        if (!readVarint(p, end, delta)) return false;
+        frame.timestamp = state.timestamp + unzigzag(delta);
+        state.timestamp = frame.timestamp;
+        prevTimestamp = frame.timestamp;
+
+        if (end - p < (qint64)frame.len) return false;
+        for (unsigned int b = 0; b < 8; b++)
+        {
+            uchar val = (b < frame.len) ? (*p++ ^ state.data[b]) : 0;
+            state.data[b] = val;
+            frame.data[b] = val;
+        }
+    }
+    return true;
+}
+
+static void encodeJob(EncodeJob &job)
+{
+    QVector<CANFrame> frames(job.num);
+    for (int i = 0; i < job.num; i++) frames[i] = job.frames->at(job.first + i);
+    job.block = CANCompressedFile::encodeBlock(frames.constData(), job.num);
+}
+
+/*
+ * Blocks don't depend on each other so they are packed on every core at once and then written in order.
+ */
+bool CANCompressedFile::write(QString filename, const CANFrameView *frames)
+{
+    QFile outFile(filename);
+    if (!outFile.open(QIODevice::WriteOnly)) return false;
+
+    int num = frames->count();
+    bool monotonic = true;
+    for (int i = 1; i < num && monotonic; i++)
+    {
+        if (frames->at(i).timestamp < frames->at(i - 1).timestamp) monotonic = false;
+    }
+
+    uchar header[CANCMP_HEADER_SIZE];
+    encodeHeader(header, num, monotonic ? CANCMP_FLAG_MONOTONIC : 0);
+    if (outFile.write((const char *)header, sizeof(header)) != sizeof(header)) return false;
+
+    QVector<EncodeJob> jobs;
+    for (int first = 0; first < num; first += CANCMP_BLOCK_FRAMES)
+    {
+        EncodeJob job = {frames, first, qMin(CANCMP_BLOCK_FRAMES, num - first), QByteArray()};
+        jobs.append(job);
+    }
+    QtConcurrent::blockingMap(jobs, encodeJob);
+
+    for (int i = 0; i < jobs.count(); i++)
+    {
+        if (outFile.write(jobs[i].block) != jobs[i].block.size()) return false;
+    }
+
+    outFile.close();
+    return true;
+}
+
+bool CANCompressedFile::isCompressedFile(QString filename)
+{
+    QFile inFile(filename);
+    if (!inFile.open(QIODevice::ReadOnly)) return false;
+    return inFile.read(8) == QByteArray(CANCMP_MAGIC);
+}
+
+CANCompressedWriter::CANCompressedWriter()
+{
+    bytes = 0;
+    frameCount = 0;
+    lastTimestamp = 0;
+    monotonic = true;
+}
+
+CANCompressedWriter::~CANCompressedWriter()
+{
+    close();
+}
+
+bool CANCompressedWriter::open(QString filename)
+{
+    close();
+
+    file.setFileName(filename);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    pending.clear();
+    pending.reserve(CANCMP_BLOCK_FRAMES);
+    frameCount = 0;
+    lastTimestamp = 0;
+    monotonic = true;
+
+    uchar header[CANCMP_HEADER_SIZE];
+    CANCompressedFile::encodeHeader(header, 0, 0);
+    bytes = file.write((const char *)header, sizeof(header));
+    return bytes == sizeof(header);
+}
+
+bool CANCompressedWriter::append(const CANFrame &frame)
+{
+    if ((frameCount > 0 || !pending.isEmpty()) && frame.timestamp < lastTimestamp) monotonic = false;
+    lastTimestamp = frame.timestamp;
+    pending.append(frame);
+    if (pending.count() >= CANCMP_BLOCK_FRAMES) return flush();
+    return true;
+}
+
+bool CANCompressedWriter::flush()
+{
+    if (!file.isOpen()) return false;
+    if (pending.isEmpty()) return true;
+
+    QByteArray block = CANCompressedFile::encodeBlock(pending.constData(), pending.count());
+    frameCount += pending.count();
+    pending.clear();
+    if (file.write(block) != block.size()) return false;
+    bytes += block.size();
+
+    uchar header[CANCMP_HEADER_SIZE];
+    CANCompressedFile::encodeHeader(header, frameCount, monotonic ? CANCMP_FLAG_MONOTONIC : 0);
+    if (!file.seek(0) || file.write((const char *)header, sizeof(header)) != sizeof(header)) return false;
+    if (!file.seek(bytes)) return false;
+    file.flush();
+    return true;
+}
+
+bool CANCompressedWriter::close()
+{
+    if (!file.isOpen()) return true;
+    bool result = flush();
+    file.close();
+    return result;
+}
@@ -0,0 +1,130 @@
+#ifndef CANCOMPRESSEDFILE_H
+#define CANCOMPRESSEDFILE_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include "can_structs.h"
+#include "canframestore.h"
+
+/*
+ * SavvyCAN compressed capture file. Meant for long captures where the same IDs go by over and over at fixed
+ * periods with payloads that hardly change. Everything is little endian.
+ *
+ * Header (32 bytes):
+ *   char     magic[8]       "SVCANCMP"
+ *   uint32   version
+ *   uint32   blockFrames    most frames the writer puts in one block
+ *   uint64   frameCount     0 if the writer never got to close the file, the blocks are counted instead
+ *   uint32   flags          CANCMP_FLAG_MONOTONIC if timestamps never go backwards
+ *   uint32   reserved
+ *
+ * Then blocks, one after the other, each one decodable without looking at any other:
+ *   uint32   packedSize     bytes of packed data after this block header
+ *   uint32   numFrames
+ *   uint64   firstTimestamp
+ *   uint64   lastTimestamp
+ *   packed   qCompress()ed frame stream
+ *
+ * The frame stream before compression. Each distinct ID/bus/extended combination seen in the block gets a
+ * slot in the order it first shows up:
+ *   uint8    flags          bit 0 extended, bit 1 received, bits 4-7 len
+ *   varint   slot           a new slot is the next unused number and is followed by varint ID, uint8 bus
+ *   varint   timestamp      zigzagged difference to the last frame in the same slot. A new slot is against
+ *                           the frame before it (or firstTimestamp for the first frame of the block)
+ *   uint8    data[len]      XOR with the last data in the same slot (zeroes for a new slot)
+ *
+ * So a periodic message with an unchanged payload turns into the same few bytes followed by zeroes, which the
+ * block compression then squeezes down to next to nothing. There is no index footer: the block headers chain
+ * together, so opening a file just hops from header to header and a file cut short still gives up every
+ * complete block.
+ */
+
+#define CANCMP_MAGIC                "SVCANCMP"
+#define CANCMP_VERSION              1
+#define CANCMP_HEADER_SIZE          32
+#define CANCMP_BLOCK_HEADER_SIZE    24
+#define CANCMP_BLOCK_FRAMES         16384
+#define CANCMP_FLAG_MONOTONIC       1
+
+struct CANCompressedBlock
+{
+    qint64   offset;        //of the block header within the file
+    int      firstFrame;    //number of frames in all blocks before this one
+    int      numFrames;
+    uint64_t firstTimestamp;
+    uint64_t lastTimestamp;
+};
+
+class CANCompressedFile
+{
+public:
+    CANCompressedFile();
+    ~CANCompressedFile();
+
+    bool open(QString filename);
+    void close();
+    bool isOpen() const { return opened; }
+
+    int count() const { return numFrames; }
+    bool isMonotonic() const { return (headerFlags & CANCMP_FLAG_MONOTONIC) != 0; }
+    const QVector<CANCompressedBlock> &getBlocks() const { return blocks; }
+
+    //fills out with the frames of one block, block.numFrames of them. Safe to call from several threads at once
+    bool decodeBlock(int block, CANFrame *out) const;
+    //block that holds the first frame at or past the given timestamp. Only meaningful for monotonic files
+    int findBlockAtTime(uint64_t timestamp) const;
+
+    static bool write(QString filename, const CANFrameView *frames);
+    static bool isCompressedFile(QString filename);
+    static void encodeHeader(uchar *out, quint64 frameCount, quint32 flags);
+    //returns a whole block, header and all, ready to be written out
+    static QByteArray encodeBlock(const CANFrame *frames, int num);
+    static bool decodeBlock(const uchar *block, qint64 size, CANFrame *out, int maxFrames);
+
+private:
+    Q_DISABLE_COPY(CANCompressedFile)
+
+    QFile file;
+    uchar *map;
+    bool opened;
+    int numFrames;
+    quint32 headerFlags;
+    QVector<CANCompressedBlock> blocks;
+};
+
+/*
+ * Writes a compressed file a frame at a time, for when the frames aren't all known up front (continuous
+ * logging). Frames are held until there are enough for a block. The header is brought up to date after every
+ * block so the file is readable right up to the last full block even if close() never gets called.
+ */
+class CANCompressedWriter
+{
+public:
+    CANCompressedWriter();
+    ~CANCompressedWriter();
+
+    bool open(QString filename);
+    bool append(const CANFrame &frame);
+    //writes whatever is held as a (short) block
+    bool flush();
+    bool close();
+
+    bool isOpen() const { return file.isOpen(); }
+    qint64 bytesWritten() const { return bytes; }
+    quint64 framesWritten() const { return frameCount; }
+    int framesPending() const { return pending.count(); }
+
+private:
+    Q_DISABLE_COPY(CANCompressedWriter)
+
+    QFile file;
+    QVector<CANFrame> pending;
+    qint64 bytes;
+    quint64 frameCount;
+    uint64_t lastTimestamp;
+    bool monotonic;
+};
+
+#endif // CANCOMPRESSEDFILE_H
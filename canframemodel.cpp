@@ -4,36 +4,92 @@
 #include <QApplication>
 #include <QPalette>
 #include <QDateTime>
+#include <QThread>
+#include <QtConcurrent>
+#include <algorithm>
 #include "utility.h"
 
+//below this many frames a filter rescan is quicker done on one thread
+#define PARALLEL_SCAN_MIN   200000
+
+//looks for every frame whose ID is enabled in ids, in the store or in the file being viewed if there is one
+struct RowScan
+{
+    const CANFrameStore *store;
+    const LazyFrameFile *file;
+    const CANIDBitset *ids;
+};
+
+static QVector<quint32> scanRowRange(const RowScan &scan, int begin, int end)
+{
+    QVector<quint32> rows;
+    if (scan.file)
+    {
+        //a page at a time straight from the file so the slices don't fight over the page cache
+        QVector<CANFrame> page(LAZY_PAGE_FRAMES);
+        for (int first = begin; first < end; first += LAZY_PAGE_FRAMES)
+        {
+            int num = qMin(LAZY_PAGE_FRAMES, end - first);
+            scan.file->readFrames(first, num, page.data());
+            for (int i = 0; i < num; i++)
+            {
+                if (scan.ids->test(page[i].ID)) rows.append(first + i);
+            }
+        }
+        return rows;
+    }
+
+    for (int i = begin; i < end; i++)
+    {
+        if (scan.ids->test(scan.store->at(i).ID)) rows.append(i);
+    }
+    return rows;
+}
+
+//splits the frames into one slice per core and glues the matching rows back together in order
+static QVector<quint32> scanRows(const RowScan &scan)
+{
+    int count = scan.file ? scan.file->count() : scan.store->count();
+    int threads = QThread::idealThreadCount();
+    if (count < PARALLEL_SCAN_MIN || threads < 2) return scanRowRange(scan, 0, count);
+
+    int sliceSize = (count + threads - 1) / threads;
+    QList< QFuture< QVector<quint32> > > slices;
+    for (int begin = sliceSize; begin < count; begin += sliceSize)
+    {
+        slices.append(QtConcurrent::run(scanRowRange, scan, begin, qMin(begin + sliceSize, count)));
+    }
+
+    QVector<quint32> rows = scanRowRange(scan, 0, qMin(sliceSize, count));
+    for (int i = 0; i < slices.count(); i++)
+    {
+        rows += slices[i].result();
+    }
+    return rows;
+}
+
 
 CANFrameModel::~CANFrameModel()
 {
+    delete viewedFile;
     frames.clear();
     filteredFrames.clear();
     filters.clear();
+    knownIDs.clear();
+    enabledIDs.clear();
 }
 
 
 int CANFrameModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
-    if (filteredFrames.data())
-    {
-        int rows = filteredFrames.count();
-        return rows;
-    }
-
-     //just in case somehow data is invalid which I have seen before.
-    //But, this should not happen so issue a debugging message too
-    qDebug() << "Invalid data for filteredFrames. Returning 0.";
-    return 0;
+    return visibleRows;
 }
 
 int CANFrameModel::totalFrameCount()
 {
     int count;
-    count = frames.count();
+    count = framesView.count();
     return count;
 }
 
@@ -44,31 +100,25 @@ int CANFrameModel::columnCount(const QModelIndex &index) const
 }
 
 CANFrameModel::CANFrameModel(QObject *parent)
-    : QAbstractTableModel(parent)
+    : QAbstractTableModel(parent),
+      framesView(&frames),
+      filteredView(&frames, &filteredFrames)
 {
-
-    if (QSysInfo::WordSize > 32)
-    {
-        qDebug() << "64 bit OS detected. Requesting a large preallocation";
-        preallocSize = 10000000;
-    }
-    else //if compiling for 32 bit you can't ask for gigabytes of preallocation so tone it down.
-    {
-        qDebug() << "32 bit OS detected. Requesting a much restricted prealloc";
-        preallocSize = 2000000;
-    }
-
-    frames.reserve(preallocSize);
-    filteredFrames.reserve(preallocSize); //the goal is to prevent a reallocation from ever happening
+    //no preallocation needed. frames grows a chunk at a time and never moves what it already holds
 
     dbcHandler = DBCHandler::getReference();
     interpretFrames = false;
     overwriteDups = false;
+    holdFrames = false;
+    viewedFile = NULL;
     useHexMode = true;
     timeSeconds = false;
     timeOffset = 0;
     needFilterRefresh = false;
     lastUpdateNumFrames = 0;
+    visibleRows = 0;
+    allRowsChanged = false;
+    cellCache.setMaxCost(CELL_CACHE_SIZE);
     timeFormat =  "MMM-dd HH:mm:ss.zzz";
 }
 
@@ -78,8 +128,9 @@ void CANFrameModel::setHexMode(bool mode)
     {
         this->beginResetModel();
         useHexMode = mode;
+        cellCache.clear();
         Utility::decimalMode = !useHexMode;
-        this->endResetModel();
+        finishReset();
     }
 }
 
@@ -89,7 +140,8 @@ void CANFrameModel::setSecondsMode(bool mode)
     {
         this->beginResetModel();
         Utility::secondsMode = mode;
-        this->endResetModel();
+        cellCache.clear();
+        finishReset();
     }
 }
 
@@ -99,7 +151,8 @@ void CANFrameModel::setSysTimeMode(bool mode)
     {
         this->beginResetModel();
         Utility::sysTimeMode = mode;
-        this->endResetModel();
+        cellCache.clear();
+        finishReset();
     }
 }
 
@@ -111,7 +164,8 @@ void CANFrameModel::setInterpetMode(bool mode)
     {
         this->beginResetModel();
         interpretFrames = mode;
-        this->endResetModel();
+        cellCache.clear();
+        finishReset();
     }
 }
 
@@ -119,43 +173,76 @@ void CANFrameModel::setTimeFormat(QString format)
 {
     Utility::timeFormat = format;
     beginResetModel(); //reset model to show new time format
-    endResetModel();
+    cellCache.clear();
+    finishReset();
 }
 
 void CANFrameModel::normalizeTiming()
 {
     mutex.lock();
-    if (frames.count() == 0) return;
+    if (frames.count() == 0) //also the case while viewing a file, whose timestamps are left as they are
+    {
+        mutex.unlock();
+        return;
+    }
     timeOffset = frames[0].timestamp;
     for (int j = 0; j < frames.count(); j++)
     {
         if (frames[j].timestamp < timeOffset) timeOffset = frames[j].timestamp;
     }
+    this->beginResetModel();
     for (int i = 0; i < frames.count(); i++)
     {
         frames[i].timestamp -= timeOffset;
     }
-    this->beginResetModel();
-    for (int i = 0; i < filteredFrames.count(); i++)
-    {
-        filteredFrames[i].timestamp -= timeOffset;
-    }
-    this->endResetModel();
+    cellCache.clear();
+    finishReset();
     mutex.unlock();
 }
 
 void CANFrameModel::setOverwriteMode(bool mode)
 {
+    mutex.lock();
     beginResetModel();
     overwriteDups = mode;
-    endResetModel();
+    rebuildLatestRows();
+    finishReset();
+    mutex.unlock();
 }
 
+/*
+ * Toggling a single ID patches the filtered rows instead of scanning everything against every filter.
+ * Turning an ID off just drops its rows, turning one on merges in its rows from idRows so the
+ * filtered list stays in capture order.
+ */
 void CANFrameModel::setFilterState(unsigned int ID, bool state)
 {
     if (!filters.contains(ID)) return;
-    filters[ID] = state;
-    sendRefresh();
+    if (filters[ID] == state) return;
+
+    mutex.lock();
+    beginResetModel();
+    updateFilter(ID, state);
+    if (viewedFile) rebuildFilteredRows(); //no per ID rows to patch from, but a parallel scan of the file is quick enough
+    else if (state)
+    {
+        const QVector<quint32> addedRows = idRows.value(ID).rows;
+        QVector<quint32> merged(filteredFrames.count() + addedRows.count());
+        std::merge(filteredFrames.constBegin(), filteredFrames.constEnd(), addedRows.constBegin(), addedRows.constEnd(), merged.begin());
+        filteredFrames.swap(merged);
+    }
+    else
+    {
+        int kept = 0;
+        for (int i = 0; i < filteredFrames.count(); i++)
+        {
+            if (frames.at(filteredFrames[i]).ID != ID) filteredFrames[kept++] = filteredFrames[i];
+        }
+        filteredFrames.resize(kept);
+    }
+    lastUpdateNumFrames = 0;
+    finishReset();
+    mutex.unlock();
 }
 
 void CANFrameModel::setAllFilters(bool state)
@@ -165,53 +252,73 @@ void CANFrameModel::setAllFilters(bool state)
     {
         it.value() = state;
     }
+    rebuildFilterBits();
     sendRefresh();
 }
 
+//records the state of an ID in the filter map and the lookup bitsets together
+void CANFrameModel::updateFilter(int ID, bool state)
+{
+    filters.insert(ID, state);
+    knownIDs.set(ID, true);
+    enabledIDs.set(ID, state);
+}
+
+void CANFrameModel::rebuildFilterBits()
+{
+    knownIDs.clear();
+    enabledIDs.clear();
+    QMap<int, bool>::const_iterator it;
+    for (it = filters.constBegin(); it != filters.constEnd(); ++it)
+    {
+        knownIDs.set(it.key(), true);
+        if (it.value()) enabledIDs.set(it.key(), true);
+    }
+}
+
+//caller holds the mutex
+void CANFrameModel::rebuildFilteredRows()
+{
+    RowScan scan = {&frames, viewedFile, &enabledIDs};
+    filteredFrames = scanRows(scan);
+}
+
 void CANFrameModel::recalcOverwrite()
 {
     if (!overwriteDups) return; //no need to do a thing if mode is disabled
+    if (viewedFile) return; //a file being viewed is read only
 
     qDebug() << "recalcOverwrite called in model";
 
-    int lastUnique = 0;
-    bool found;
+    int lastUnique = -1;
 
+    //one pass: the first time an ID shows up it gets the next slot at the front, after that its slot
+    //is overwritten by every newer frame. Same result as before without searching the slots each time.
     mutex.lock();
     beginResetModel();
-    for (int i = 1; i < frames.count(); i++)
+    latestRows.clear();
+    for (int i = 0; i < frames.count(); i++)
     {
-        found = false;
-        for (int j = 0; j <= lastUnique; j++)
+        QHash<uint32_t, int>::const_iterator it = latestRows.constFind(frames[i].ID);
+        if (it != latestRows.constEnd())
         {
-            if (frames[i].ID == frames[j].ID)
-            {
-                frames.replace(j, frames[i]);
-                found = true;
-                break;
-            }
+            frames[it.value()] = frames[i];
         }
-        if (!found)
+        else
         {
             lastUnique++;
-            frames.replace(lastUnique, frames[i]);
+            latestRows.insert(frames[i].ID, lastUnique);
+            if (lastUnique != i) frames[lastUnique] = frames[i];
         }
     }
 
-    while (frames.count() > lastUnique) frames.removeLast();
-
-    filteredFrames.clear();
-    filteredFrames.reserve(preallocSize);
+    if (frames.count() > 0) frames.truncate(lastUnique + 1);
+    rebuildIDRows();
 
-    for (int i = 0; i < frames.count(); i++)
-    {
-        if (filters[frames[i].ID])
-        {
-            filteredFrames.append(frames[i]);
-        }
-    }
+    rebuildFilteredRows();
 
-    endResetModel();
+    cellCache.clear();
+    finishReset();
     mutex.unlock();
 }
 
@@ -225,11 +332,46 @@ enum class Column {
     Data      = 6 ///< The frames payload data
 };
 
+//hex bytes of the frame followed by the decoded signals if interpreting
+QString CANFrameModel::formatData(const CANFrame &thisFrame) const
+{
+    QString tempString;
+    int dLen = thisFrame.len;
+    if (dLen < 0) dLen = 0;
+    if (dLen > 8) dLen = 8;
+    for (int i = 0; i < dLen; i++)
+    {
+        tempString.append(Utility::formatNumber(thisFrame.data[i]));
+        tempString.append(" ");
+    }
+    //now, if we're supposed to interpret the data and the DBC handler is loaded then use it
+    if (dbcHandler != NULL && interpretFrames)
+    {
+        DBC_MESSAGE *msg = dbcHandler->findMessage(thisFrame);
+        if (msg != NULL)
+        {
+            tempString.append("\n");
+            tempString.append(msg->name + "\n" + msg->comment + "\n");
+            const DBCMessageDecoder &decoder = msg->getDecoder();
+            QVector<QString> sigStrings(decoder.getCount());
+            QVector<bool> sigValid(decoder.getCount());
+            decoder.decodeText(thisFrame, sigStrings.data(), sigValid.data());
+            for (int j = 0; j < decoder.getCount(); j++)
+            {
+                if (sigValid[j])
+                {
+                    tempString.append(sigStrings[j]);
+                    tempString.append("\n");
+                }
+            }
+        }
+    }
+    return tempString;
+}
+
 QVariant CANFrameModel::data(const QModelIndex &index, int role) const
 {
-    int dLen;
     QString tempString;
-    CANFrame thisFrame;
 
     if (!index.isValid())
         return QVariant();
@@ -237,7 +379,8 @@ QVariant CANFrameModel::data(const QModelIndex &index, int role) const
     if (index.row() >= (filteredFrames.count()))
         return QVariant();
 
-    thisFrame = filteredFrames.at(index.row());
+    //a copy, the frame might come out of the page cache of a file being viewed
+    const CANFrame thisFrame = framesView.at(filteredFrames.at(index.row()));
 
     if (role == Qt::BackgroundColorRole)
     {
@@ -269,10 +412,6 @@ QVariant CANFrameModel::data(const QModelIndex &index, int role) const
     if (role == Qt::DisplayRole) {
         switch (Column(index.column()))
         {
-        case Column::TimeStamp:
-            return Utility::formatTimestamp(thisFrame.timestamp);
-        case Column::FrameId:
-            return Utility::formatCANID(thisFrame.ID, thisFrame.extended);
         case Column::Extended:
             return QString::number(thisFrame.extended);
         case Column::Direction:
@@ -282,36 +421,32 @@ QVariant CANFrameModel::data(const QModelIndex &index, int role) const
             return QString::number(thisFrame.bus);
         case Column::Length:
             return QString::number(thisFrame.len);
+        default:
+            break;
+        }
+
+        //the rest take real work to format (and decode when interpreting) so they are cached until the row
+        //changes or a display setting does
+        quint64 key = ((quint64)filteredFrames.at(index.row()) << 3) | index.column();
+        QString *cached = cellCache.object(key);
+        if (cached) return *cached;
+
+        switch (Column(index.column()))
+        {
+        case Column::TimeStamp:
+            tempString = Utility::formatTimestamp(thisFrame.timestamp);
+            break;
+        case Column::FrameId:
+            tempString = Utility::formatCANID(thisFrame.ID, thisFrame.extended);
+            break;
         case Column::Data:
-            dLen = thisFrame.len;
-            if (dLen < 0) dLen = 0;
-            if (dLen > 8) dLen = 8;
-            for (int i = 0; i < dLen; i++)
-            {
-                tempString.append(Utility::formatNumber(thisFrame.data[i]));
-                tempString.append(" ");
-            }
-            //now, if we're supposed to interpret the data and the DBC handler is loaded then use it
-            if (dbcHandler != NULL && interpretFrames)
-            {
-                DBC_MESSAGE *msg = dbcHandler->findMessage(thisFrame);
-                if (msg != NULL)
-                {
-                    tempString.append("\n");
-                    tempString.append(msg->name + "\n" + msg->comment + "\n");
-                    for (int j = 0; j < msg->sigHandler->getCount(); j++)
-                    {
-                        QString sigString;
-                        if (msg->sigHandler->findSignalByIdx(j)->processAsText(thisFrame, sigString))
-                        {
-                            tempString.append(sigString);
-                            tempString.append("\n");
-                        }
-                    }
-                }
-            }
-            return tempString;
+            tempString = formatData(thisFrame);
+            break;
+        default:
+            return QVariant();
         }
+        cellCache.insert(key, new QString(tempString));
+        return tempString;
     }
 
     return QVariant();
@@ -355,6 +490,63 @@ void CANFrameModel::addFrame(const CANFrame& frame, bool autoRefresh = false)
 {
     /*TODO: remove mutex */
     mutex.lock();
+    if (viewedFile) //nothing is added to a file being viewed
+    {
+        mutex.unlock();
+        return;
+    }
+    if (holdFrames) heldFrames.append(frame);
+    else storeFrame(frame, autoRefresh);
+    mutex.unlock();
+}
+
+
+void CANFrameModel::addFrames(const CANConnection*, const QVector<CANFrame>& pFrames)
+{
+    //the view hears about these on the next sendBulkRefresh, both new rows and rows overwritten in place
+    mutex.lock();
+    if (viewedFile) //nothing is added to a file being viewed
+    {
+        mutex.unlock();
+        return;
+    }
+    if (holdFrames) heldFrames += pFrames;
+    else
+    {
+        foreach(const CANFrame& frame, pFrames)
+        {
+            storeFrame(frame, false);
+        }
+    }
+    mutex.unlock();
+}
+
+/*
+ * Lets something else read the frame list from another thread, a background save for one, without it changing
+ * underneath. Frames that come in meanwhile are kept aside and added in order when the hold is released.
+ */
+void CANFrameModel::holdNewFrames(bool hold)
+{
+    mutex.lock();
+    holdFrames = hold;
+    if (!hold)
+    {
+        foreach(const CANFrame& frame, heldFrames)
+        {
+            storeFrame(frame, false);
+        }
+        heldFrames.clear();
+    }
+    mutex.unlock();
+}
+
+/*
+ * Adds one frame. Caller holds the mutex. In overwrite mode the frame replaces the newest one with the
+ * same ID in place, found through latestRows. With autoRefresh the view is told about the new or changed
+ * row straight away, otherwise it is left for sendBulkRefresh to report along with everything else.
+ */
+void CANFrameModel::storeFrame(const CANFrame &frame, bool autoRefresh)
+{
     CANFrame tempFrame;
     tempFrame = frame;
     tempFrame.timestamp -= timeOffset;
@@ -362,95 +554,158 @@ void CANFrameModel::addFrame(const CANFrame& frame, bool autoRefresh = false)
     lastUpdateNumFrames++;
 
     //if this ID isn't found in the filters list then add it and show it by default
-    if (!filters.contains(tempFrame.ID))
+    if (!knownIDs.test(tempFrame.ID))
     {
-        filters.insert(tempFrame.ID, true);
+        updateFilter(tempFrame.ID, true);
         needFilterRefresh = true;
     }
 
-    if (!overwriteDups)
+    if (overwriteDups)
     {
-        frames.append(tempFrame);
-        if (filters[tempFrame.ID])
+        QHash<uint32_t, int>::const_iterator it = latestRows.constFind(tempFrame.ID);
+        if (it != latestRows.constEnd())
         {
-            if (autoRefresh) beginInsertRows(QModelIndex(), filteredFrames.count() + 1, filteredFrames.count() + 1);
-            filteredFrames.append(tempFrame);
-            if (autoRefresh) endInsertRows();
+            //the filtered list only holds row numbers so it sees the new frame straight away
+            frames[it.value()] = tempFrame;
+            dropCachedRow(it.value());
+            int row = filteredRowOf(it.value());
+            if (row < 0 || row >= visibleRows) return; //not shown or not shown yet
+            if (autoRefresh) emit dataChanged(index(row, 0), index(row, columnCount(QModelIndex()) - 1));
+            else markRowChanged(row);
+            return;
         }
+        latestRows.insert(tempFrame.ID, frames.count());
     }
-    else //yes, overwrite dups
+
+    frames.append(tempFrame);
+    indexRow(frames.count() - 1);
+    if (enabledIDs.test(tempFrame.ID))
     {
-        bool found = false;
-        for (int i = 0; i < frames.count(); i++)
-        {
-            if (frames[i].ID == tempFrame.ID)
-            {
-                frames.replace(i, tempFrame);
-                found = true;
-                break;
-            }
-        }
-        if (!found)
-        {
-            frames.append(tempFrame);
-            if (filters[tempFrame.ID])
-            {
-                if (autoRefresh) beginInsertRows(QModelIndex(), filteredFrames.count() + 1, filteredFrames.count() + 1);
-                filteredFrames.append(tempFrame);
-                if (autoRefresh) endInsertRows();
-            }
-        }
-        else
-        {
-            for (int j = 0; j < filteredFrames.count(); j++)
-            {
-                if (filteredFrames[j].ID == tempFrame.ID)
-                {
-                    if (autoRefresh) beginResetModel();
-                    filteredFrames.replace(j, tempFrame);
-                    if (autoRefresh) endResetModel();
-                }
-            }
-        }
+        filteredFrames.append(frames.count() - 1);
+        if (autoRefresh) showNewRows();
     }
-
-    mutex.unlock();
 }
 
+//announce the filtered rows added since the view last heard from us
+void CANFrameModel::showNewRows()
+{
+    if (filteredFrames.count() <= visibleRows) return;
+    beginInsertRows(QModelIndex(), visibleRows, filteredFrames.count() - 1);
+    visibleRows = filteredFrames.count();
+    endInsertRows();
+}
 
-void CANFrameModel::addFrames(const CANConnection*, const QVector<CANFrame>& pFrames)
+//remember a row whose contents changed for the next bulk refresh. Past a point it's cheaper to repaint them all
+void CANFrameModel::markRowChanged(int row)
 {
-    foreach(const CANFrame& frame, pFrames)
+    if (allRowsChanged) return;
+    if (changedRows.count() >= MAX_CHANGED_ROWS)
     {
-        addFrame(frame);
+        allRowsChanged = true;
+        changedRows.clear();
+        return;
     }
-    if (overwriteDups) //if in overwrite mode we'll update every time frames come in
+    changedRows.append(row);
+}
+
+//throws away every formatted cell. Needed when something the text depends on changes behind the model's back, like the DBC files
+void CANFrameModel::clearCellCache()
+{
+    cellCache.clear();
+    if (visibleRows > 0) emit dataChanged(index(0, 0), index(visibleRows - 1, columnCount(QModelIndex()) - 1));
+}
+
+void CANFrameModel::dropCachedRow(int storeRow)
+{
+    quint64 key = (quint64)storeRow << 3;
+    cellCache.remove(key | (int)Column::TimeStamp);
+    cellCache.remove(key | (int)Column::FrameId);
+    cellCache.remove(key | (int)Column::Data);
+}
+
+//end of a model reset. The view throws away what it knew so it now knows about every row
+void CANFrameModel::finishReset()
+{
+    visibleRows = filteredFrames.count();
+    changedRows.clear();
+    allRowsChanged = false;
+    endResetModel();
+}
+
+//adds a just appended store row to the rows of its ID. Caller holds the mutex
+void CANFrameModel::indexRow(int row)
+{
+    const CANFrame &frame = frames.at(row);
+    IDRows &entry = idRows[frame.ID];
+    if (!entry.rows.isEmpty() && frames.at(entry.rows.last()).timestamp > frame.timestamp) entry.monotonic = false;
+    entry.rows.append(row);
+}
+
+void CANFrameModel::rebuildIDRows()
+{
+    idRows.clear();
+    for (int i = 0; i < frames.count(); i++) indexRow(i);
+}
+
+//in overwrite mode each ID is updated in the row it first showed up in, even if the store still holds older duplicates
+void CANFrameModel::rebuildLatestRows()
+{
+    latestRows.clear();
+    if (!overwriteDups) return;
+
+    for (int i = 0; i < frames.count(); i++)
     {
-        beginResetModel();
-        endResetModel();
+        if (!latestRows.contains(frames[i].ID)) latestRows.insert(frames[i].ID, i);
     }
 }
 
-void CANFrameModel::sendRefresh()
+//filtered rows are in store order so a binary search finds where a store row ended up. -1 if it's filtered out
+int CANFrameModel::filteredRowOf(int storeRow) const
 {
-    qDebug() << "Sending mass refresh";
-    QVector<CANFrame> tempContainer;
-    int count = frames.count();
-    for (int i = 0; i < count; i++)
+    QVector<quint32>::const_iterator it = std::lower_bound(filteredFrames.constBegin(), filteredFrames.constEnd(), (quint32)storeRow);
+    if (it == filteredFrames.constEnd() || *it != (quint32)storeRow) return -1;
+    return it - filteredFrames.constBegin();
+}
+
+//sends one dataChanged per run of consecutive rows marked as changed
+void CANFrameModel::emitRowsChanged()
+{
+    int lastCol = columnCount(QModelIndex()) - 1;
+
+    if (allRowsChanged)
+    {
+        if (visibleRows > 0) emit dataChanged(index(0, 0), index(visibleRows - 1, lastCol));
+        allRowsChanged = false;
+        changedRows.clear();
+        return;
+    }
+    if (changedRows.isEmpty()) return;
+
+    std::sort(changedRows.begin(), changedRows.end());
+    int first = changedRows[0];
+    int prev = changedRows[0];
+    for (int i = 1; i <= changedRows.count(); i++)
     {
-        if (filters[frames[i].ID])
+        if (i < changedRows.count() && changedRows[i] <= prev + 1)
         {
-            tempContainer.append(frames[i]);
+            prev = changedRows[i];
+            continue;
         }
+        emit dataChanged(index(first, 0), index(prev, lastCol));
+        if (i < changedRows.count()) first = prev = changedRows[i];
     }
+    changedRows.clear();
+}
+
+void CANFrameModel::sendRefresh()
+{
+    qDebug() << "Sending mass refresh";
     mutex.lock();
     beginResetModel();
-    filteredFrames.clear();
-    filteredFrames.reserve(preallocSize);
-    filteredFrames.append(tempContainer);
+    rebuildFilteredRows();
 
     lastUpdateNumFrames = 0;
-    endResetModel();
+    finishReset();
     mutex.unlock();
 }
 
@@ -462,19 +717,19 @@ void CANFrameModel::sendRefresh(int pos)
 
 //issue a refresh for the last num entries in the model.
 //used by the serial worker to do batch updates so it doesn't
-//have to send thousands of messages per second
+//have to send thousands of messages per second.
+//Only the rows appended since the last call are inserted and only overwritten rows are repainted
+//so the view keeps its selection and scroll position while capturing.
 int CANFrameModel::sendBulkRefresh()
 {
-    //int num = filteredFrames.count() - lastUpdateNumFrames;
     if (lastUpdateNumFrames <= 0) return 0;
 
-    if (lastUpdateNumFrames == 0 && !overwriteDups) return 0;
-    if (filteredFrames.count() == 0) return 0;
-
     qDebug() << "Bulk refresh of " << lastUpdateNumFrames;
 
-    beginResetModel();
-    endResetModel();
+    mutex.lock();
+    showNewRows();
+    emitRowsChanged();
+    mutex.unlock();
 
     int num = lastUpdateNumFrames;
     lastUpdateNumFrames = 0;
@@ -486,12 +741,16 @@ void CANFrameModel::clearFrames()
 {
     mutex.lock();
     this->beginResetModel();
+    dropViewedFile();
     frames.clear();
     filteredFrames.clear();
     filters.clear();
-    frames.reserve(preallocSize);
-    filteredFrames.reserve(preallocSize);
-    this->endResetModel();
+    knownIDs.clear();
+    enabledIDs.clear();
+    latestRows.clear();
+    idRows.clear();
+    cellCache.clear();
+    finishReset();
     lastUpdateNumFrames = 0;
     mutex.unlock();
 
@@ -505,47 +764,97 @@ void CANFrameModel::clearFrames()
  */
 void CANFrameModel::insertFrames(const QVector<CANFrame> &newFrames)
 {
-    //not resetting the model here because the serial worker automatically does a bulk refresh every 1/4 second
-    //and that refresh will cause the view to update. If you do both it usually ends up thinking you have
-    //double the number of frames.
-    //beginResetModel();
+    //the new rows are announced with a single insert at the end. The bulk refresh only ever announces rows
+    //past visibleRows so it won't count these a second time.
     mutex.lock();
-    int insertedFiltered = 0;
+    if (viewedFile)
+    {
+        //loading a file while another is being viewed replaces it
+        beginResetModel();
+        dropViewedFile();
+        filteredFrames.clear();
+        filters.clear();
+        knownIDs.clear();
+        enabledIDs.clear();
+        cellCache.clear();
+        finishReset();
+    }
     for (int i = 0; i < newFrames.count(); i++)
     {
+        if (overwriteDups && !latestRows.contains(newFrames[i].ID)) latestRows.insert(newFrames[i].ID, frames.count());
         frames.append(newFrames[i]);
-        if (!filters.contains(newFrames[i].ID))
+        indexRow(frames.count() - 1);
+        if (!knownIDs.test(newFrames[i].ID))
         {
-            filters.insert(newFrames[i].ID, true);
+            updateFilter(newFrames[i].ID, true);
             needFilterRefresh = true;
         }
-        if (filters[newFrames[i].ID])
+        if (enabledIDs.test(newFrames[i].ID))
         {
-            insertedFiltered++;
-            filteredFrames.append(newFrames[i]);
+            filteredFrames.append(frames.count() - 1);
         }
     }
     lastUpdateNumFrames = newFrames.count();
+    showNewRows();
     mutex.unlock();
-    //endResetModel();
-    //beginInsertRows(QModelIndex(), filteredFrames.count() + 1, filteredFrames.count() + insertedFiltered);
-    //endInsertRows();
     if (needFilterRefresh) emit updatedFiltersList();
 }
 
+/*
+ * Returns the view row of the last frame with this ID at or before timestamp (in seconds), -1 if there isn't one
+ * or the ID is filtered out. Only the rows of that ID are looked at, with a binary search unless the
+ * capture has that ID going back in time somewhere.
+ */
 int CANFrameModel::getIndexFromTimeID(unsigned int ID, double timestamp)
 {
     int bestIndex = -1;
     uint64_t intTimeStamp = timestamp * 1000000l;
-    for (int i = 0; i < frames.count(); i++)
+
+    QMutexLocker locker(&mutex);
+    if (viewedFile)
     {
-        if ((frames[i].ID == ID))
+        //no per ID rows for a file. Find the time among the shown rows, taking the file to be in time order
+        //like nearly every log is, then look back a ways for the ID
+        int low = 0, high = filteredFrames.count();
+        while (low < high)
+        {
+            int mid = (low + high) / 2;
+            if (viewedFile->at(filteredFrames[mid]).timestamp <= intTimeStamp) low = mid + 1;
+            else high = mid;
+        }
+        for (int row = low - 1; row >= 0 && row >= low - FILE_ID_SEARCH_ROWS; row--)
         {
-            if (frames[i].timestamp <= intTimeStamp) bestIndex = i;
+            if (viewedFile->at(filteredFrames[row]).ID == ID) return row;
+        }
+        return -1;
+    }
+
+    QHash<uint32_t, IDRows>::const_iterator it = idRows.constFind(ID);
+    if (it == idRows.constEnd()) return -1;
+    const QVector<quint32> &rows = it.value().rows;
+
+    if (it.value().monotonic)
+    {
+        int low = 0, high = rows.count(); //find the first row past the timestamp
+        while (low < high)
+        {
+            int mid = (low + high) / 2;
+            if (frames.at(rows[mid]).timestamp <= intTimeStamp) low = mid + 1;
+            else high = mid;
+        }
+        if (low > 0) bestIndex = rows[low - 1];
+    }
+    else
+    {
+        for (int i = 0; i < rows.count(); i++)
+        {
+            if (frames.at(rows[i]).timestamp <= intTimeStamp) bestIndex = rows[i];
             else break; //drop out of loop as soon as we pass the proper timestamp
         }
     }
-    return bestIndex;
+
+    if (bestIndex < 0) return -1;
+    return filteredRowOf(bestIndex);
 }
 
 void CANFrameModel::loadFilterFile(QString filename)
@@ -571,6 +880,7 @@ void CANFrameModel::loadFilterFile(QString filename)
     }
     inFile->close();
 
+    rebuildFilterBits();
     sendRefresh();
 
     emit updatedFiltersList();
@@ -609,17 +919,76 @@ bool CANFrameModel::needsFilterRefresh()
  * external code that needs to access frames directly and doesn't care about
  * this model's normal output mechanism.
  */
-const QVector<CANFrame>* CANFrameModel::getListReference() const
+const CANFrameView* CANFrameModel::getListReference() const
 {
-    return &frames;
+    return &framesView;
 }
 
-const QVector<CANFrame>* CANFrameModel::getFilteredListReference() const
+const CANFrameView* CANFrameModel::getFilteredListReference() const
 {
-    return &filteredFrames;
+    return &filteredView;
 }
 
 const QMap<int, bool>* CANFrameModel::getFiltersReference() const
 {
     return &filters;
 }
+
+/*
+ * Swaps whatever is in the model for a file browsed in place. Every ID in it starts out shown. The frame lists
+ * handed out by getListReference() and getFilteredListReference() read from the file until clearFrames() or
+ * insertFrames() puts the model back to holding frames itself. Captured frames are ignored meanwhile.
+ */
+void CANFrameModel::viewFile(LazyFrameFile *file)
+{
+    mutex.lock();
+    beginResetModel();
+    dropViewedFile();
+    frames.clear();
+    heldFrames.clear();
+    latestRows.clear();
+    idRows.clear();
+    filters.clear();
+    cellCache.clear();
+    timeOffset = 0;
+
+    viewedFile = file;
+    resetViews();
+    const QVector<uint32_t> &ids = file->getIDs();
+    for (int i = 0; i < ids.count(); i++) filters.insert(ids[i], true);
+    rebuildFilterBits();
+    rebuildFilteredRows();
+    lastUpdateNumFrames = 0;
+    finishReset();
+    mutex.unlock();
+
+    emit updatedFiltersList();
+}
+
+bool CANFrameModel::isViewingFile() const
+{
+    return viewedFile != NULL;
+}
+
+//back to showing the store. Caller holds the mutex and has started a model reset
+void CANFrameModel::dropViewedFile()
+{
+    if (!viewedFile) return;
+    delete viewedFile;
+    viewedFile = NULL;
+    resetViews();
+}
+
+void CANFrameModel::resetViews()
+{
+    if (viewedFile)
+    {
+        framesView = CANFrameView(viewedFile);
+        filteredView = CANFrameView(viewedFile, &filteredFrames);
+    }
+    else
+    {
+        framesView = CANFrameView(&frames);
+        filteredView = CANFrameView(&frames, &filteredFrames);
+    }
+}
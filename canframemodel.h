@@ -6,10 +6,28 @@
 #include <QVector>
 #include <QDebug>
 #include <QMutex>
+#include <QHash>
+#include <QCache>
 #include "can_structs.h"
+#include "canframestore.h"
 #include "dbc/dbchandler.h"
 #include "connections/canconnection.h"
 
+//more overwritten rows than this between refreshes and the whole view is repainted instead
+#define MAX_CHANGED_ROWS    8192
+//formatted cells kept around for repainting. A few screens worth is plenty
+#define CELL_CACHE_SIZE     20000
+//rows looked back through for an ID at a given time while viewing a file, which has no per ID index
+#define FILE_ID_SEARCH_ROWS 200000
+
+//every store row holding one ID. monotonic stays true while their timestamps never go backwards so they can be binary searched
+struct IDRows
+{
+    IDRows() : monotonic(true) {}
+    QVector<quint32> rows;
+    bool monotonic;
+};
+
 class CANFrameModel: public QAbstractTableModel
 {
     Q_OBJECT
@@ -44,23 +62,57 @@ public:
     bool needsFilterRefresh();
     void insertFrames(const QVector<CANFrame> &newFrames);
     int getIndexFromTimeID(unsigned int ID, double timestamp);
-    const QVector<CANFrame> *getListReference() const; //thou shalt not modify these frames externally!
-    const QVector<CANFrame> *getFilteredListReference() const; //Thus saith the Lord, NO.
+    const CANFrameView *getListReference() const; //thou shalt not modify these frames externally!
+    const CANFrameView *getFilteredListReference() const; //Thus saith the Lord, NO.
     const QMap<int, bool> *getFiltersReference() const; //this neither
+    void holdNewFrames(bool hold); //while held new frames wait off to the side and the list stays as it is
+    void viewFile(LazyFrameFile *file); //shows a file without loading it. The model owns it from here on
+    bool isViewingFile() const;
 
 public slots:
     void addFrame(const CANFrame&, bool);
     void addFrames(const CANConnection*, const QVector<CANFrame>&);
+    void clearCellCache();
 
 signals:
     void updatedFiltersList();
 
 private:
-    QVector<CANFrame> frames;
-    QVector<CANFrame> filteredFrames;
-    QMap<int, bool> filters;
+    QString formatData(const CANFrame &frame) const;
+    void dropCachedRow(int storeRow);
+    void storeFrame(const CANFrame &frame, bool autoRefresh);
+    void indexRow(int row);
+    void rebuildIDRows();
+    void rebuildLatestRows();
+    int filteredRowOf(int storeRow) const;
+    void showNewRows();
+    void markRowChanged(int row);
+    void emitRowsChanged();
+    void finishReset();
+    void updateFilter(int ID, bool state);
+    void rebuildFilterBits();
+    void rebuildFilteredRows();
+    void dropViewedFile();
+    void resetViews();
+
+    CANFrameStore frames;
+    QVector<quint32> filteredFrames; //rows in frames that pass the filters
+    CANFrameView framesView;
+    CANFrameView filteredView;
+    QMap<int, bool> filters; //every ID seen and whether it is shown. The bitsets below mirror it for fast lookups
+    CANIDBitset knownIDs;
+    CANIDBitset enabledIDs;
+    QHash<uint32_t, IDRows> idRows; //rows of each ID in store order, for jumping to an ID at a given time
+    QHash<uint32_t, int> latestRows; //store row holding the newest frame of each ID, only kept up in overwrite mode
+    int visibleRows; //filtered rows the view has been told about. The rest get announced on the next bulk refresh
+    QVector<int> changedRows; //rows overwritten since the last bulk refresh
+    bool allRowsChanged;
+    mutable QCache<quint64, QString> cellCache; //formatted text of the slow columns keyed by store row and column
     DBCHandler *dbcHandler;
     QMutex mutex;
+    bool holdFrames;
+    QVector<CANFrame> heldFrames; //arrived while holdFrames was set, added once it is cleared
+    LazyFrameFile *viewedFile; //frames come from here instead of the store while a file is being viewed
     bool interpretFrames; //should we use the dbcHandler?
     bool overwriteDups; //should we display all frames or only the newest for each ID?
     QString timeFormat;
@@ -70,7 +122,6 @@ private:
     bool needFilterRefresh;
     uint64_t timeOffset;
     int lastUpdateNumFrames;
-    uint32_t preallocSize;
 };
 
 
@@ -0,0 +1,125 @@
+#include "canframestore.h"
+
+CANFrameStore::CANFrameStore()
+{
+    numFrames = 0;
+}
+
+CANFrameStore::~CANFrameStore()
+{
+    clear();
+}
+
+void CANFrameStore::append(const CANFrame &frame)
+{
+    if ((numFrames & CHUNK_MASK) == 0 && (numFrames >> CHUNK_BITS) == chunks.count())
+    {
+        chunks.append(new CANFrame[CHUNK_SIZE]);
+    }
+    chunks[numFrames >> CHUNK_BITS][numFrames & CHUNK_MASK] = frame;
+    numFrames++;
+}
+
+void CANFrameStore::append(const QVector<CANFrame> &newFrames)
+{
+    for (int i = 0; i < newFrames.count(); i++) append(newFrames[i]);
+}
+
+void CANFrameStore::clear()
+{
+    for (int i = 0; i < chunks.count(); i++) delete[] chunks[i];
+    chunks.clear();
+    numFrames = 0;
+}
+
+//drops everything past the first count frames. Chunks that end up unused are freed.
+void CANFrameStore::truncate(int count)
+{
+    if (count < 0) count = 0;
+    if (count >= numFrames) return;
+
+    numFrames = count;
+    int neededChunks = (count + CHUNK_MASK) >> CHUNK_BITS;
+    while (chunks.count() > neededChunks)
+    {
+        delete[] chunks.last();
+        chunks.removeLast();
+    }
+}
+
+CANFrameView::CANFrameView()
+{
+    store = NULL;
+    rows = NULL;
+    vec = NULL;
+    file = NULL;
+}
+
+CANFrameView::CANFrameView(const CANFrameStore *store, const QVector<quint32> *rows)
+{
+    this->store = store;
+    this->rows = rows;
+    vec = NULL;
+    file = NULL;
+}
+
+CANFrameView::CANFrameView(const QVector<CANFrame> *frames)
+{
+    store = NULL;
+    rows = NULL;
+    vec = frames;
+    file = NULL;
+}
+
+CANFrameView::CANFrameView(const LazyFrameFile *file, const QVector<quint32> *rows)
+{
+    store = NULL;
+    this->rows = rows;
+    vec = NULL;
+    this->file = file;
+}
+
+QVector<CANFrame> CANFrameView::toVector() const
+{
+    if (vec && !rows) return *vec;
+
+    QVector<CANFrame> out;
+    int num = count();
+    out.reserve(num);
+    for (int i = 0; i < num; i++) out.append(at(i));
+    return out;
+}
+
+CANIDBitset::CANIDBitset()
+{
+}
+
+CANIDBitset::~CANIDBitset()
+{
+    clear();
+}
+
+void CANIDBitset::set(uint32_t ID, bool state)
+{
+    int page = ID >> PAGE_BITS;
+    if (page >= pages.count())
+    {
+        if (!state) return; //nothing to clear in a page that was never made
+        pages.resize(page + 1); //new entries come up NULL
+    }
+    if (!pages[page])
+    {
+        if (!state) return;
+        pages[page] = new quint64[PAGE_WORDS]();
+    }
+
+    quint64 bit = 1ull << (ID & 63);
+    if (state) pages[page][(ID & PAGE_MASK) >> 6] |= bit;
+    else pages[page][(ID & PAGE_MASK) >> 6] &= ~bit;
+}
+
+void CANIDBitset::clear()
+{
+    for (int i = 0; i < pages.count(); i++) delete[] pages[i];
+    pages.clear();
+}
@@ -0,0 +1,125 @@
+#ifndef CANFRAMESTORE_H
+#define CANFRAMESTORE_H
+
+#include <QVector>
+#include "can_structs.h"
+#include "lazyframefile.h"
+
+/*
+ * Append only storage for captured frames. Frames live in fixed size chunks that are never moved
+ * once allocated so appending is always O(1), a frame's address never changes and nothing has to be
+ * preallocated up front. Growing only ever reallocates the small table of chunk pointers.
+ */
+class CANFrameStore
+{
+public:
+    static const int CHUNK_BITS = 16; //65536 frames per chunk, a bit over 2.5MB
+    static const int CHUNK_SIZE = 1 << CHUNK_BITS;
+    static const int CHUNK_MASK = CHUNK_SIZE - 1;
+
+    CANFrameStore();
+    ~CANFrameStore();
+
+    void append(const CANFrame &frame);
+    void append(const QVector<CANFrame> &newFrames);
+    void clear();
+    void truncate(int count);
+
+    int count() const { return numFrames; }
+    bool isEmpty() const { return numFrames == 0; }
+
+    const CANFrame &at(int idx) const { return chunks[idx >> CHUNK_BITS][idx & CHUNK_MASK]; }
+    const CANFrame &operator[](int idx) const { return at(idx); }
+    CANFrame &operator[](int idx) { return chunks[idx >> CHUNK_BITS][idx & CHUNK_MASK]; }
+
+private:
+    Q_DISABLE_COPY(CANFrameStore)
+
+    QVector<CANFrame *> chunks;
+    int numFrames;
+};
+
+/*
+ * Read only window onto a list of frames. It can sit over a CANFrameStore as is, over a CANFrameStore through a
+ * list of row numbers (which is how the filtered view avoids keeping a second copy of every frame), over a
+ * plain QVector of frames such as a freshly loaded file or over a LazyFrameFile being browsed without loading it
+ * (again with or without rows). This is what the model hands out to everyone else
+ * so the rest of the program reads frames the same way no matter where they are kept.
+ */
+class CANFrameView
+{
+public:
+    CANFrameView();
+    CANFrameView(const CANFrameStore *store, const QVector<quint32> *rows = NULL);
+    CANFrameView(const QVector<CANFrame> *frames);
+    CANFrameView(const LazyFrameFile *file, const QVector<quint32> *rows = NULL);
+
+    int count() const
+    {
+        if (rows) return rows->count();
+        if (store) return store->count();
+        if (vec) return vec->count();
+        if (file) return file->count();
+        return 0;
+    }
+    int size() const { return count(); }
+    int length() const { return count(); }
+    bool isEmpty() const { return count() == 0; }
+
+    const CANFrame &at(int idx) const
+    {
+        if (rows) idx = (int)rows->at(idx);
+        if (store) return store->at(idx);
+        if (file) return file->at(idx);
+        return vec->at(idx);
+    }
+    const CANFrame &operator[](int idx) const { return at(idx); }
+    const CANFrame &first() const { return at(0); }
+    const CANFrame &last() const { return at(count() - 1); }
+
+    //index into the underlying store of the given row. Same as the row unless this is a filtered view
+    int storeIndex(int idx) const { return rows ? (int)rows->at(idx) : idx; }
+    //the file underneath if this is a view of one, for scans that would rather read it in big pieces
+    const LazyFrameFile *lazyFile() const { return file; }
+
+    QVector<CANFrame> toVector() const;
+
+private:
+    const CANFrameStore *store;
+    const QVector<quint32> *rows;
+    const QVector<CANFrame> *vec;
+    const LazyFrameFile *file;
+};
+
+/*
+ * Set of CAN IDs stored as a bitmap so testing an ID is a couple of loads, which matters when it is done
+ * for every frame in a capture. The bits are kept in 64K ID pages that are only allocated once an ID in
+ * that range is set, so the 11 bit IDs cost 8KB and a log full of scattered 29 bit IDs stays small too.
+ */
+class CANIDBitset
+{
+public:
+    static const int PAGE_BITS = 16;
+    static const int PAGE_MASK = (1 << PAGE_BITS) - 1;
+    static const int PAGE_WORDS = (1 << PAGE_BITS) / 64;
+
+    CANIDBitset();
+    ~CANIDBitset();
+
+    void set(uint32_t ID, bool state);
+    void clear();
+
+    bool test(uint32_t ID) const
+    {
+        uint32_t page = ID >> PAGE_BITS;
+        if (page >= (uint32_t)pages.count() || !pages[page]) return false;
+        return (pages[page][(ID & PAGE_MASK) >> 6] >> (ID & 63)) & 1;
+    }
+
+private:
+    Q_DISABLE_COPY(CANIDBitset)
+
+    QVector<quint64 *> pages;
+};
+
+#endif // CANFRAMESTORE_H
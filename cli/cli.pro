@@ -0,0 +1,53 @@
+# Headless batch converter, see main.cpp. Built on its own: qmake cli.pro && make
+# It only ever runs a QCoreApplication, widgets are linked because FrameFileIO and the DBC classes use them in
+# their dialogs, which the command line never shows.
+
+QT += core gui widgets concurrent
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+CONFIG(release, debug|release):DEFINES += QT_NO_DEBUG_OUTPUT
+
+TARGET = savvycan-cli
+TEMPLATE = app
+
+INCLUDEPATH += ../
+
+SOURCES += \
+    main.cpp \
+    framesource.cpp \
+    framesink.cpp \
+    ../framefileio.cpp \
+    ../canframestore.cpp \
+    ../lazyframefile.cpp \
+    ../canbinaryfile.cpp \
+    ../cancompressedfile.cpp \
+    ../continuouslogger.cpp \
+    ../canfilter.cpp \
+    ../can_structs.cpp \
+    ../utility.cpp \
+    ../dbc/dbc_classes.cpp \
+    ../dbc/dbchandler.cpp \
+    ../dbc/dbccache.cpp
+
+HEADERS += \
+    framesource.h \
+    framesink.h \
+    ../framefileio.h \
+    ../framelineformat.h \
+    ../canframestore.h \
+    ../lazyframefile.h \
+    ../canbinaryfile.h \
+    ../cancompressedfile.h \
+    ../continuouslogger.h \
+    ../canfilter.h \
+    ../can_structs.h \
+    ../utility.h \
+    ../config.h \
+    ../utils/textscanner.h \
+    ../utils/textwriter.h \
+    ../utils/lfqueue.h \
+    ../dbc/dbc_classes.h \
+    ../dbc/dbchandler.h \
+    ../dbc/dbccache.h
@@ -0,0 +1,325 @@
+#include "framesink.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QVector>
+#include <QScopedPointer>
+#include "framefileio.h"
+#include "canbinaryfile.h"
+#include "cancompressedfile.h"
+#include "continuouslogger.h"
+#include "dbc/dbchandler.h"
+#include "utils/textwriter.h"
+
+//GVRET csv, formatted the way ContinuousLogger does it
+class CSVSink : public FrameSink
+{
+public:
+    bool open(QString filename)
+    {
+        file.setFileName(filename);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+        out.reset(new TextWriter(&file));
+        out->put("Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8\n");
+        return true;
+    }
+
+    bool write(const CANFrame *frames, int count)
+    {
+        char line[LOGGER_MAX_LINE];
+        for (int i = 0; i < count; i++) out->put(line, ContinuousLogger::formatCSVLine(frames[i], line));
+        return !out->hasFailed();
+    }
+
+    bool close()
+    {
+        bool result = out->flush();
+        file.close();
+        return result;
+    }
+
+private:
+    QFile file;
+    QScopedPointer<TextWriter> out;
+};
+
+//SavvyCAN native binary. The header is written again at the end with the count and whether it came out in order
+class BinarySink : public FrameSink
+{
+public:
+    BinarySink() : frameCount(0), lastTimestamp(0), monotonic(true), failed(false) {}
+
+    bool open(QString filename)
+    {
+        file.setFileName(filename);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+        uchar header[CANBIN_HEADER_SIZE];
+        CANBinaryFile::encodeHeader(header, 0, 0, 0);
+        return file.write((const char *)header, sizeof(header)) == sizeof(header);
+    }
+
+    bool write(const CANFrame *frames, int count)
+    {
+        buffer.resize(count * CANBIN_RECORD_SIZE);
+        uchar *out = (uchar *)buffer.data();
+        for (int i = 0; i < count; i++)
+        {
+            CANBinaryFile::encodeRecord(frames[i], out + i * CANBIN_RECORD_SIZE);
+            if (frameCount > 0 && frames[i].timestamp < lastTimestamp) monotonic = false;
+            lastTimestamp = frames[i].timestamp;
+            frameCount++;
+        }
+        if (file.write(buffer) != buffer.size()) failed = true;
+        return !failed;
+    }
+
+    bool close()
+    {
+        uchar header[CANBIN_HEADER_SIZE];
+        CANBinaryFile::encodeHeader(header, frameCount, 0, monotonic ? CANBIN_FLAG_MONOTONIC : 0);
+        if (!file.seek(0) || file.write((const char *)header, sizeof(header)) != sizeof(header)) failed = true;
+        file.close();
+        return !failed;
+    }
+
+private:
+    QFile file;
+    QByteArray buffer;
+    quint64 frameCount;
+    uint64_t lastTimestamp;
+    bool monotonic;
+    bool failed;
+};
+
+//SavvyCAN compressed, the writer puts it out a block at a time by itself
+class CompressedSink : public FrameSink
+{
+public:
+    bool open(QString filename) { return writer.open(filename); }
+
+    bool write(const CANFrame *frames, int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (!writer.append(frames[i])) return false;
+        }
+        return true;
+    }
+
+    bool close() { return writer.close(); }
+
+private:
+    CANCompressedWriter writer;
+};
+
+/*
+ * One row per signal of every frame the DBC files know: time in seconds, bus, ID, message, signal and value.
+ * The value is what processAsText() shows, so value tables come out as their descriptions.
+ */
+class DecodedSink : public FrameSink
+{
+public:
+    DecodedSink(DBCHandler *pDBC) : dbc(pDBC) {}
+
+    bool open(QString filename)
+    {
+        file.setFileName(filename);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+        out.reset(new TextWriter(&file));
+        out->put("Time,Bus,ID,Message,Signal,Value\n");
+        return true;
+    }
+
+    bool write(const CANFrame *frames, int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            const CANFrame &frame = frames[i];
+            DBC_MESSAGE *msg = dbc->findMessage(frame);
+            if (!msg) continue;
+
+            const DBCMessageDecoder &decoder = msg->getDecoder();
+            texts.resize(decoder.getCount());
+            valid.resize(decoder.getCount());
+            decoder.decodeText(frame, texts.data(), valid.data());
+            for (int s = 0; s < decoder.getCount(); s++)
+            {
+                if (!valid[s]) continue;
+                DBC_SIGNAL *sig = decoder.getSignal(s);
+                const QString &text = texts[s];
+
+                out->putFixed(frame.timestamp, 6);
+                out->put(',');
+                out->putDecimal(frame.bus);
+                out->put(',');
+                out->putHex(frame.ID);
+                out->put(',');
+                putField(msg->name);
+                out->put(',');
+                putField(sig->name);
+                out->put(',');
+                //the text has the signal name and ": " in front of the value
+                putField(text.mid(sig->name.length() + 2));
+                out->put('\n');
+            }
+        }
+        return !out->hasFailed();
+    }
+
+    bool close()
+    {
+        bool result = out->flush();
+        file.close();
+        return result;
+    }
+
+private:
+    //quoted if it would otherwise break up the line
+    void putField(const QString &field)
+    {
+        QByteArray bytes = field.toUtf8();
+        if (bytes.indexOf(',') < 0 && bytes.indexOf('"') < 0)
+        {
+            out->put(bytes);
+            return;
+        }
+        out->put('"');
+        out->put(bytes.replace("\"", "\"\""));
+        out->put('"');
+    }
+
+    DBCHandler *dbc;
+    QFile file;
+    QScopedPointer<TextWriter> out;
+    QVector<QString> texts;
+    QVector<bool> valid;
+};
+
+//any of FrameFileIO's savers, fed everything at once when the sink is closed
+class SaverSink : public FrameSink
+{
+public:
+    SaverSink(QString pFilename, FrameFileIO::SaveFunc pSaver) : filename(pFilename), saver(pSaver) {}
+
+    bool write(const CANFrame *frames, int count)
+    {
+        for (int i = 0; i < count; i++) held.append(frames[i]);
+        return true;
+    }
+
+    bool close()
+    {
+        CANFrameView view(&held);
+        return saver(filename, &view, NULL);
+    }
+
+private:
+    QString filename;
+    FrameFileIO::SaveFunc saver;
+    QVector<CANFrame> held;
+};
+
+struct SinkFormat
+{
+    const char *name;
+    const char *extension;
+    bool fromExtension;             //picked when the output file name ends in extension and no format is given
+    FrameFileIO::SaveFunc saver;    //NULL for the formats written as they go
+};
+
+static const SinkFormat sinkFormats[] =
+{
+    {"csv",         "csv",      true,   NULL},
+    {"scb",         "scb",      true,   NULL},
+    {"scz",         "scz",      true,   NULL},
+    {"decoded",     "csv",      false,  NULL},
+    {"crtd",        "txt",      true,   FrameFileIO::saveCRTDFile},
+    {"generic",     "csv",      false,  FrameFileIO::saveGenericCSVFile},
+    {"busmaster",   "log",      false,  FrameFileIO::saveLogFile},
+    {"candump",     "log",      true,   FrameFileIO::saveCanDumpFile},
+    {"microchip",   "can",      true,   FrameFileIO::saveMicrochipFile},
+    {"trace",       "trace",    true,   FrameFileIO::saveTraceFile},
+    {"ixxat",       "csv",      false,  FrameFileIO::saveIXXATFile},
+    {"cando",       "avc",      true,   FrameFileIO::saveCANDOFile},
+    {"vehiclespy",  "csv",      false,  FrameFileIO::saveVehicleSpyFile}
+};
+
+static const SinkFormat *findSinkFormat(QString name)
+{
+    for (unsigned int i = 0; i < sizeof(sinkFormats) / sizeof(sinkFormats[0]); i++)
+    {
+        if (name == sinkFormats[i].name) return &sinkFormats[i];
+    }
+    return NULL;
+}
+
+QStringList FrameSink::formatNames()
+{
+    QStringList names;
+    for (unsigned int i = 0; i < sizeof(sinkFormats) / sizeof(sinkFormats[0]); i++) names.append(sinkFormats[i].name);
+    return names;
+}
+
+QString FrameSink::formatForFile(QString filename)
+{
+    QString suffix = QFileInfo(filename).suffix().toLower();
+    for (unsigned int i = 0; i < sizeof(sinkFormats) / sizeof(sinkFormats[0]); i++)
+    {
+        if (sinkFormats[i].fromExtension && suffix == sinkFormats[i].extension) return sinkFormats[i].name;
+    }
+    return QString();
+}
+
+QString FrameSink::extensionFor(QString format)
+{
+    const SinkFormat *found = findSinkFormat(format);
+    return found ? QString(found->extension) : QString();
+}
+
+FrameSink *FrameSink::create(QString filename, QString format, DBCHandler *dbc, QString &error)
+{
+    const SinkFormat *found = findSinkFormat(format);
+    if (!found)
+    {
+        error = "unknown output format " + format;
+        return NULL;
+    }
+    if (found->saver) return new SaverSink(filename, found->saver);
+
+    bool opened = false;
+    FrameSink *sink = NULL;
+    if (format == "csv")
+    {
+        CSVSink *csv = new CSVSink();
+        opened = csv->open(filename);
+        sink = csv;
+    }
+    else if (format == "scb")
+    {
+        BinarySink *binary = new BinarySink();
+        opened = binary->open(filename);
+        sink = binary;
+    }
+    else if (format == "scz")
+    {
+        CompressedSink *compressed = new CompressedSink();
+        opened = compressed->open(filename);
+        sink = compressed;
+    }
+    else
+    {
+        if (!dbc || dbc->getFileCount() == 0)
+        {
+            error = "decoded output needs a DBC file";
+            return NULL;
+        }
+        DecodedSink *decoded = new DecodedSink(dbc);
+        opened = decoded->open(filename);
+        sink = decoded;
+    }
+
+    if (opened) return sink;
+    delete sink;
+    error = "couldn't create " + filename;
+    return NULL;
+}
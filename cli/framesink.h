@@ -0,0 +1,34 @@
+#ifndef FRAMESINK_H
+#define FRAMESINK_H
+
+#include <QString>
+#include <QStringList>
+#include "can_structs.h"
+
+class DBCHandler;
+
+/*
+ * Where converted frames go, a batch at a time. GVRET csv, SavvyCAN binary and compressed and decoded signal
+ * csv are written as the frames arrive so memory use stays the same however much goes through. The other
+ * formats only have whole file savers in FrameFileIO, so for those the frames are held until close().
+ */
+class FrameSink
+{
+public:
+    virtual ~FrameSink() {}
+
+    virtual bool write(const CANFrame *frames, int count) = 0;
+    //finishes off the file. False if anything couldn't be written
+    virtual bool close() = 0;
+
+    //names the format option takes, in the order the help lists them
+    static QStringList formatNames();
+    //format name going with a file name's extension, empty if it doesn't say
+    static QString formatForFile(QString filename);
+    //extension files written in a format get when the tool names them itself
+    static QString extensionFor(QString format);
+    //the decoded format needs dbc, everything else ignores it. NULL with error set on failure
+    static FrameSink *create(QString filename, QString format, DBCHandler *dbc, QString &error);
+};
+
+#endif // FRAMESINK_H
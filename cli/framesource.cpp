@@ -0,0 +1,248 @@
+#include "framesource.h"
+
+#include <QFile>
+#include <QScopedPointer>
+#include <algorithm>
+#include "canbinaryfile.h"
+#include "cancompressedfile.h"
+#include "framelineformat.h"
+#include "utils/textscanner.h"
+
+//one of the formats loadLineFile() handles, parsed a line at a time
+class LineSource : public FrameSource
+{
+public:
+    LineSource(const LoadFilter &pFilter) : filter(pFilter), untimed(0), foundErrors(false) {}
+
+    bool open(QString filename, LineFormat lineFormat)
+    {
+        file.setFileName(filename);
+        if (!file.open(QIODevice::ReadOnly)) return false;
+        format = lineFormat;
+        reader.reset(new LineReader(&file));
+
+        TextSpan line;
+        for (int i = 0; i < format.headerLines && reader->nextLine(line); i++)
+        {
+            if (i == 0 && format.readHeader) format.variant = format.readHeader(line);
+        }
+        return true;
+    }
+
+    int read(CANFrame *out, int max)
+    {
+        int num = 0;
+        TextSpan line;
+        while (num < max && reader->nextLine(line))
+        {
+            CANFrame frame;
+            LineResult result = format.parse(line, frame, format.variant);
+            if (result == LINE_UNTIMED)
+            {
+                //counted whether the frame is kept or not, so timestamps match what a full load makes up
+                untimed++;
+                frame.timestamp = format.untimedStart + untimed * format.untimedStep;
+            }
+            else if (result == LINE_ERROR) foundErrors = true;
+            if (result != LINE_FRAME && result != LINE_UNTIMED) continue;
+
+            filter.anchor(frame.timestamp);
+            if (filter.matches(frame)) out[num++] = frame;
+        }
+        return num;
+    }
+
+    bool ok() const { return !foundErrors; }
+
+private:
+    QFile file;
+    QScopedPointer<LineReader> reader;
+    LineFormat format;
+    LoadFilter filter;
+    uint64_t untimed;
+    bool foundErrors;
+};
+
+//SavvyCAN native binary, read a batch of records at a time out of the mapped file
+class BinarySource : public FrameSource
+{
+public:
+    BinarySource(const LoadFilter &pFilter) : filter(pFilter), next(0), last(0), failed(false) {}
+
+    bool open(QString filename)
+    {
+        if (!file.open(filename)) return false;
+        last = file.count();
+        if (last > 0) filter.anchor(file.frameAt(0).timestamp);
+        if (file.isMonotonic())
+        {
+            next = file.findRecordAtTime(filter.startTime);
+            if (filter.endTime < UINT64_MAX) last = file.findRecordAtTime(filter.endTime + 1);
+        }
+        return true;
+    }
+
+    int read(CANFrame *out, int max)
+    {
+        int num = 0;
+        while (num < max && next < last)
+        {
+            CANFrame *batch = out + num;
+            int got = file.readFrames(next, qMin(max - num, last - next), batch);
+            if (got <= 0)
+            {
+                failed = true;
+                break;
+            }
+            next += got;
+
+            int kept = 0;
+            for (int i = 0; i < got; i++)
+            {
+                if (filter.matches(batch[i])) batch[kept++] = batch[i];
+            }
+            num += kept;
+        }
+        return num;
+    }
+
+    bool ok() const { return !failed; }
+
+private:
+    CANBinaryFile file;
+    LoadFilter filter;
+    int next;
+    int last;
+    bool failed;
+};
+
+//SavvyCAN compressed, decoded a block at a time
+class CompressedSource : public FrameSource
+{
+public:
+    CompressedSource(const LoadFilter &pFilter) : filter(pFilter), block(0), lastBlock(0), pos(0), failed(false) {}
+
+    bool open(QString filename)
+    {
+        if (!file.open(filename)) return false;
+        const QVector<CANCompressedBlock> &blocks = file.getBlocks();
+        lastBlock = blocks.count();
+        if (!blocks.isEmpty()) filter.anchor(blocks[0].firstTimestamp);
+        if (file.isMonotonic())
+        {
+            block = file.findBlockAtTime(filter.startTime);
+            //the block holding the first frame past the window can still start inside it
+            if (filter.endTime < UINT64_MAX) lastBlock = qMin(file.findBlockAtTime(filter.endTime + 1) + 1, lastBlock);
+        }
+        return true;
+    }
+
+    int read(CANFrame *out, int max)
+    {
+        int num = 0;
+        while (num < max)
+        {
+            if (pos >= decoded.count())
+            {
+                if (block >= lastBlock) break;
+                decoded.resize(file.getBlocks()[block].numFrames);
+                if (!file.decodeBlock(block, decoded.data()))
+                {
+                    failed = true;
+                    break;
+                }
+                block++;
+                pos = 0;
+                continue;
+            }
+            const CANFrame &frame = decoded[pos++];
+            if (filter.matches(frame)) out[num++] = frame;
+        }
+        return num;
+    }
+
+    bool ok() const { return !failed; }
+
+private:
+    CANCompressedFile file;
+    LoadFilter filter;
+    QVector<CANFrame> decoded;
+    int block;
+    int lastBlock;
+    int pos;
+    bool failed;
+};
+
+//formats only FrameFileIO's whole file loaders understand. Loaded filtered, then handed out from memory
+class LoadedSource : public FrameSource
+{
+public:
+    LoadedSource() : pos(0), loadedOK(false) {}
+
+    void load(QString filename, FrameFileIO::FileFormat format, const LoadFilter &filter)
+    {
+        loadedOK = FrameFileIO::loadFileOfFormat(filename, format, &frames, filter);
+    }
+
+    int read(CANFrame *out, int max)
+    {
+        int num = qMin(max, frames.count() - pos);
+        std::copy(frames.constData() + pos, frames.constData() + pos + num, out);
+        pos += num;
+        if (pos == frames.count()) frames = QVector<CANFrame>();
+        return num;
+    }
+
+    bool ok() const { return loadedOK; }
+
+private:
+    QVector<CANFrame> frames;
+    int pos;
+    bool loadedOK;
+};
+
+FrameSource *FrameSource::open(QString filename, const LoadFilter &filter, QString &error)
+{
+    FrameFileIO::FileFormat format = FrameFileIO::detectFileFormat(filename);
+    FrameFileIO::LineFileType lineType;
+
+    switch (format)
+    {
+    case FrameFileIO::FORMAT_UNKNOWN:
+        error = "couldn't work out what format it is in";
+        return NULL;
+    case FrameFileIO::FORMAT_NATIVE_BINARY:
+    {
+        BinarySource *source = new BinarySource(filter);
+        if (source->open(filename)) return source;
+        delete source;
+        error = "couldn't be opened";
+        return NULL;
+    }
+    case FrameFileIO::FORMAT_COMPRESSED:
+    {
+        CompressedSource *source = new CompressedSource(filter);
+        if (source->open(filename)) return source;
+        delete source;
+        error = "couldn't be opened";
+        return NULL;
+    }
+    case FrameFileIO::FORMAT_NATIVE_CSV:    lineType = FrameFileIO::LINEFILE_NATIVE_CSV; break;
+    case FrameFileIO::FORMAT_CRTD:          lineType = FrameFileIO::LINEFILE_CRTD; break;
+    case FrameFileIO::FORMAT_GENERIC_CSV:   lineType = FrameFileIO::LINEFILE_GENERIC_CSV; break;
+    case FrameFileIO::FORMAT_BUSMASTER:     lineType = FrameFileIO::LINEFILE_LOG; break;
+    case FrameFileIO::FORMAT_CANDUMP:       lineType = FrameFileIO::LINEFILE_CANDUMP; break;
+    default:
+    {
+        LoadedSource *source = new LoadedSource();
+        source->load(filename, format, filter);
+        return source;
+    }
+    }
+
+    LineSource *source = new LineSource(filter);
+    if (source->open(filename, FrameFileIO::lineFormat(lineType))) return source;
+    delete source;
+    error = "couldn't be opened";
+    return NULL;
+}
@@ -0,0 +1,32 @@
+#ifndef FRAMESOURCE_H
+#define FRAMESOURCE_H
+
+#include <QString>
+#include <QVector>
+#include "can_structs.h"
+#include "framefileio.h"
+
+//frames a source hands over at a time, and what a merge keeps buffered for each of its inputs
+#define SOURCE_BATCH_FRAMES     16384
+
+/*
+ * A log read front to back a batch at a time, so a file of any size goes through in a fixed amount of memory.
+ * Line based text logs are parsed a line at a time and SavvyCAN binary and compressed files are read a record
+ * or block at a time, starting from the time window when their timestamps are in order. The other formats only
+ * have whole file loaders, so those are loaded (filtered) and handed out from memory.
+ */
+class FrameSource
+{
+public:
+    virtual ~FrameSource() {}
+
+    //up to max frames the filter keeps, in file order. 0 once the file is used up
+    virtual int read(CANFrame *out, int max) = 0;
+    //false if the file had lines that couldn't be parsed or couldn't be read all the way
+    virtual bool ok() const { return true; }
+
+    //detects the format and opens the file. NULL with error set if it can't be read
+    static FrameSource *open(QString filename, const LoadFilter &filter, QString &error);
+};
+
+#endif // FRAMESOURCE_H
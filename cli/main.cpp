@@ -0,0 +1,388 @@
+/*
+ * savvycan-cli, converts, trims, decodes and merges logs without a GUI (or a display) for use on build servers
+ * and in scripts. Everything goes through the same loaders and savers the GUI uses.
+ *
+ *   savvycan-cli -o all.scz a.log b.log          a.log then b.log, compressed
+ *   savvycan-cli --merge -o all.csv a.log b.log  both logs interleaved by timestamp
+ *   savvycan-cli -d out -f scb a.csv b.csv       every log to its own binary file, several at once
+ *   savvycan-cli --dbc car.dbc -f decoded --ids 1F0,7E8 --start 10 --end 20 --relative -o sig.csv a.log
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <QDir>
+#include <QSet>
+#include <QList>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QScopedPointer>
+#include <QTextStream>
+#include <queue>
+#include <vector>
+
+#include "can_structs.h"
+#include "canfilter.h"
+#include "framefileio.h"
+#include "dbc/dbchandler.h"
+#include "framesource.h"
+#include "framesink.h"
+
+//frames picked by bus or ID mask, on top of what the LoadFilter given to the sources keeps
+struct Selection
+{
+    QSet<int> buses;            //empty for every bus
+    QList<CANFilter> masks;     //empty for every ID. A frame has to pass one of them
+
+    bool keep(const CANFrame &frame) const
+    {
+        if (!buses.isEmpty() && !buses.contains(frame.bus)) return false;
+        if (masks.isEmpty()) return true;
+        for (int i = 0; i < masks.count(); i++)
+        {
+            CANFilter filter = masks[i];
+            if (filter.checkFilter(frame.ID, filter.bus == -1 ? -1 : (int)frame.bus)) return true;
+        }
+        return false;
+    }
+
+    //drops the frames not selected, keeping the rest in order. Returns how many are left
+    int apply(CANFrame *frames, int count) const
+    {
+        if (buses.isEmpty() && masks.isEmpty()) return count;
+        int kept = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if (keep(frames[i])) frames[kept++] = frames[i];
+        }
+        return kept;
+    }
+};
+
+//one output file and everything that goes into it
+struct Job
+{
+    QStringList inputs;
+    QString output;
+    bool merge;
+    QString error;
+    quint64 frames;
+};
+
+struct Settings
+{
+    LoadFilter filter;
+    Selection selection;
+    QString format;
+    DBCHandler *dbc;
+};
+
+static Settings settings;
+
+//next batch of selected frames from source, 0 once it is used up
+static int readSelected(FrameSource *source, CANFrame *out)
+{
+    int count;
+    do
+    {
+        int got = source->read(out, SOURCE_BATCH_FRAMES);
+        if (got == 0) return 0;
+        count = settings.selection.apply(out, got);
+    } while (count == 0);
+    return count;
+}
+
+//one input after another
+static bool concatenate(QList<FrameSource *> &sources, FrameSink *sink, Job &job)
+{
+    QVector<CANFrame> batch(SOURCE_BATCH_FRAMES);
+    for (int i = 0; i < sources.count(); i++)
+    {
+        int count;
+        while ((count = readSelected(sources[i], batch.data())) > 0)
+        {
+            if (!sink->write(batch.constData(), count)) return false;
+            job.frames += count;
+        }
+    }
+    return true;
+}
+
+/*
+ * Interleaves the inputs by timestamp, each of which is expected to be in order already, so only a batch of
+ * each is held at once. Frames with the same timestamp come out in the order their inputs were given.
+ */
+static bool mergeByTime(QList<FrameSource *> &sources, FrameSink *sink, Job &job)
+{
+    struct Input
+    {
+        QVector<CANFrame> frames;
+        int pos;
+        int count;
+    };
+    typedef std::pair<uint64_t, int> Head;  //timestamp of the next frame of an input, and which input
+
+    QVector<Input> inputs(sources.count());
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head> > heads;
+    for (int i = 0; i < sources.count(); i++)
+    {
+        inputs[i].frames.resize(SOURCE_BATCH_FRAMES);
+        inputs[i].pos = 0;
+        inputs[i].count = readSelected(sources[i], inputs[i].frames.data());
+        if (inputs[i].count > 0) heads.push(Head(inputs[i].frames[0].timestamp, i));
+    }
+
+    QVector<CANFrame> out(SOURCE_BATCH_FRAMES);
+    int outCount = 0;
+    while (!heads.empty())
+    {
+        int i = heads.top().second;
+        heads.pop();
+        Input &input = inputs[i];
+        out[outCount++] = input.frames[input.pos++];
+        if (input.pos == input.count)
+        {
+            input.pos = 0;
+            input.count = readSelected(sources[i], input.frames.data());
+        }
+        if (input.count > 0) heads.push(Head(input.frames[input.pos].timestamp, i));
+
+        if (outCount == out.count())
+        {
+            if (!sink->write(out.constData(), outCount)) return false;
+            job.frames += outCount;
+            outCount = 0;
+        }
+    }
+    if (outCount > 0 && !sink->write(out.constData(), outCount)) return false;
+    job.frames += outCount;
+    return true;
+}
+
+static void runJob(Job *pJob)
+{
+    Job &job = *pJob;
+    QList<FrameSource *> sources;
+    for (int i = 0; i < job.inputs.count() && job.error.isEmpty(); i++)
+    {
+        QString error;
+        FrameSource *source = FrameSource::open(job.inputs[i], settings.filter, error);
+        if (source) sources.append(source);
+        else job.error = job.inputs[i] + ": " + error;
+    }
+
+    if (job.error.isEmpty())
+    {
+        QString error;
+        QScopedPointer<FrameSink> sink(FrameSink::create(job.output, settings.format, settings.dbc, error));
+        if (!sink) job.error = error;
+        else
+        {
+            bool written = job.merge ? mergeByTime(sources, sink.data(), job) : concatenate(sources, sink.data(), job);
+            if (!sink->close()) written = false;
+            if (!written) job.error = job.output + ": couldn't be written";
+        }
+    }
+
+    for (int i = 0; i < sources.count(); i++)
+    {
+        if (job.error.isEmpty() && !sources[i]->ok()) job.error = job.inputs[i] + ": had lines that couldn't be read, they were left out";
+        delete sources[i];
+    }
+}
+
+//signals compile their extractors and value tables and messages their decoders the first time they are used,
+//which has to happen before any threads share them
+static void prepareDBC(DBCHandler *dbc)
+{
+    for (int f = 0; f < dbc->getFileCount(); f++)
+    {
+        DBCMessageHandler *messages = dbc->getFileByIdx(f)->messageHandler;
+        for (int m = 0; m < messages->getCount(); m++)
+        {
+            DBC_MESSAGE *msg = messages->findMsgByIdx(m);
+            DBCSignalHandler *sigs = msg->sigHandler;
+            for (int s = 0; s < sigs->getCount(); s++)
+            {
+                sigs->findSignalByIdx(s)->getExtractor();
+                sigs->findSignalByIdx(s)->getValueTable();
+            }
+            msg->getDecoder();
+        }
+    }
+}
+
+static bool parseSeconds(QString text, uint64_t &out)
+{
+    bool ok;
+    double seconds = text.toDouble(&ok);
+    if (!ok || seconds < 0) return false;
+    out = (uint64_t)(seconds * 1000000.0 + 0.5);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("savvycan-cli");
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Converts, trims, decodes and merges CAN logs. The format of every input is worked out from its contents.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("inputs", "Logs to read.", "inputs...");
+    QCommandLineOption outputOpt(QStringList() << "o" << "output", "Write everything to <file>.", "file");
+    QCommandLineOption dirOpt(QStringList() << "d" << "output-dir", "Convert each input to a file of its own in <dir>.", "dir");
+    QCommandLineOption formatOpt(QStringList() << "f" << "format",
+                                 "Output format: " + FrameSink::formatNames().join(", ") + ". Defaults from the output file name.", "format");
+    QCommandLineOption mergeOpt("merge", "Interleave the inputs by timestamp instead of putting them one after another.");
+    QCommandLineOption idsOpt("ids", "Only these IDs, hex, separated by commas.", "list");
+    QCommandLineOption busOpt("bus", "Only these buses, separated by commas.", "list");
+    QCommandLineOption maskOpt("filter", "Only IDs where ID & MASK == ID, on BUS if given. Can be given more than once.", "id/mask[@bus]");
+    QCommandLineOption startOpt("start", "Only frames from <seconds> on.", "seconds");
+    QCommandLineOption endOpt("end", "Only frames up to <seconds>.", "seconds");
+    QCommandLineOption relativeOpt("relative", "Count --start and --end from the first frame of each input.");
+    QCommandLineOption dbcOpt("dbc", "DBC file for the decoded format. Can be given more than once.", "file");
+    QCommandLineOption jobsOpt(QStringList() << "j" << "jobs", "Inputs converted at once with --output-dir. Defaults to the number of cores.", "count");
+    parser.addOptions(QList<QCommandLineOption>() << outputOpt << dirOpt << formatOpt << mergeOpt << idsOpt << busOpt << maskOpt
+                      << startOpt << endOpt << relativeOpt << dbcOpt << jobsOpt);
+    parser.process(app);
+
+    QStringList inputs = parser.positionalArguments();
+    if (inputs.isEmpty() || parser.isSet(outputOpt) == parser.isSet(dirOpt))
+    {
+        err << "Give some inputs and one of --output or --output-dir. See --help.\n";
+        return 2;
+    }
+    if (parser.isSet(dirOpt) && parser.isSet(mergeOpt))
+    {
+        err << "--merge needs a single --output file.\n";
+        return 2;
+    }
+
+    settings.format = parser.value(formatOpt);
+    if (settings.format.isEmpty() && parser.isSet(outputOpt)) settings.format = FrameSink::formatForFile(parser.value(outputOpt));
+    if (settings.format.isEmpty())
+    {
+        err << "Couldn't tell the output format from the file name, give one with --format.\n";
+        return 2;
+    }
+    if (!FrameSink::formatNames().contains(settings.format))
+    {
+        err << "Unknown format " << settings.format << ".\n";
+        return 2;
+    }
+
+    QStringList ids = parser.value(idsOpt).split(',', QString::SkipEmptyParts);
+    for (int i = 0; i < ids.count(); i++)
+    {
+        bool ok;
+        settings.filter.ids.insert(ids[i].trimmed().toUInt(&ok, 16));
+        if (!ok)
+        {
+            err << ids[i] << " isn't a hex ID.\n";
+            return 2;
+        }
+    }
+    QStringList buses = parser.value(busOpt).split(',', QString::SkipEmptyParts);
+    for (int i = 0; i < buses.count(); i++)
+    {
+        bool ok;
+        settings.selection.buses.insert(buses[i].trimmed().toInt(&ok));
+        if (!ok)
+        {
+            err << buses[i] << " isn't a bus number.\n";
+            return 2;
+        }
+    }
+    QStringList masks = parser.values(maskOpt);
+    for (int i = 0; i < masks.count(); i++)
+    {
+        QStringList busSplit = masks[i].split('@');
+        QStringList idSplit = busSplit[0].split('/');
+        bool idOK, maskOK = true, busOK = true;
+        uint32_t ID = idSplit[0].toUInt(&idOK, 16);
+        uint32_t mask = (idSplit.count() > 1) ? idSplit[1].toUInt(&maskOK, 16) : 0x1FFFFFFF;
+        int bus = (busSplit.count() > 1) ? busSplit[1].toInt(&busOK) : -1;
+        if (!idOK || !maskOK || !busOK || busSplit.count() > 2 || idSplit.count() > 2)
+        {
+            err << masks[i] << " isn't id/mask@bus.\n";
+            return 2;
+        }
+        CANFilter filter;
+        filter.setFilter(ID & mask, mask, bus);
+        settings.selection.masks.append(filter);
+    }
+    if ((parser.isSet(startOpt) && !parseSeconds(parser.value(startOpt), settings.filter.startTime))
+            || (parser.isSet(endOpt) && !parseSeconds(parser.value(endOpt), settings.filter.endTime)))
+    {
+        err << "--start and --end take seconds.\n";
+        return 2;
+    }
+    settings.filter.fromFirstFrame = parser.isSet(relativeOpt);
+
+    settings.dbc = DBCHandler::getReference();
+    QStringList dbcFiles = parser.values(dbcOpt);
+    for (int i = 0; i < dbcFiles.count(); i++)
+    {
+        if (!settings.dbc->loadDBCFile(dbcFiles[i]))
+        {
+            err << dbcFiles[i] << " couldn't be read.\n";
+            return 1;
+        }
+    }
+    prepareDBC(settings.dbc);
+
+    QVector<Job> jobs;
+    if (parser.isSet(outputOpt))
+    {
+        Job job = {inputs, parser.value(outputOpt), parser.isSet(mergeOpt), QString(), 0};
+        jobs.append(job);
+    }
+    else
+    {
+        QDir dir(parser.value(dirOpt));
+        if (!dir.exists() && !dir.mkpath("."))
+        {
+            err << "Couldn't create " << dir.path() << ".\n";
+            return 1;
+        }
+        QString extension = FrameSink::extensionFor(settings.format);
+        for (int i = 0; i < inputs.count(); i++)
+        {
+            QString output = dir.filePath(QFileInfo(inputs[i]).completeBaseName() + "." + extension);
+            if (QFileInfo(output).absoluteFilePath() == QFileInfo(inputs[i]).absoluteFilePath())
+            {
+                err << inputs[i] << " would be written over by its own conversion.\n";
+                return 2;
+            }
+            Job job = {QStringList() << inputs[i], output, false, QString(), 0};
+            jobs.append(job);
+        }
+    }
+
+    /*
+     * Files are converted on a pool of their own. The loaders put work on the global pool and wait for it, which
+     * is never held up by a pool full of conversions waiting on those loaders.
+     */
+    QThreadPool pool;
+    int threads = parser.isSet(jobsOpt) ? parser.value(jobsOpt).toInt() : QThread::idealThreadCount();
+    pool.setMaxThreadCount(qMax(1, threads));
+    QList<QFuture<void> > running;
+    for (int i = 0; i < jobs.count(); i++) running.append(QtConcurrent::run(&pool, runJob, jobs.data() + i));
+    for (int i = 0; i < running.count(); i++) running[i].waitForFinished();
+
+    int result = 0;
+    for (int i = 0; i < jobs.count(); i++)
+    {
+        out << jobs[i].output << ": " << jobs[i].frames << " frames\n";
+        if (!jobs[i].error.isEmpty())
+        {
+            err << jobs[i].error << "\n";
+            result = 1;
+        }
+    }
+    return result;
+}
@@ -56,12 +56,14 @@ void CANConManager::stopAllConnections()
 void CANConManager::add(CANConnection* pConn_p)
 {
     mConns.append(pConn_p);
+    connect(pConn_p, SIGNAL(framesSent(int)), this, SIGNAL(framesSent(int)));
 }
 
 
 void CANConManager::remove(CANConnection* pConn_p)
 {
     //disconnect(pConn_p, 0, this, 0);
+    disconnect(pConn_p, SIGNAL(framesSent(int)), this, SIGNAL(framesSent(int)));
     mConns.removeOne(pConn_p);
 }
 
@@ -130,10 +132,11 @@ void CANConManager::refreshConnection(CANConnection* pConn_p)
         emit connectionStatusUpdated(buses);
     }
 
-    if (pConn_p->getQueue().peek() == NULL) return;
+    if (pConn_p->getQueue().peek() == NULL && pConn_p->getTxEchoQueue().peek() == NULL) return;
 
     CANFrame* frame_p = NULL;
     QVector<CANFrame> frames;
+    int count;
 
     //Each connection only knows about its own bus numbers
     //so this variable is used to fix that up to turn local bus numbers
@@ -148,11 +151,24 @@ void CANConManager::refreshConnection(CANConnection* pConn_p)
 
     //qDebug() << "Bus fixup number: " << busBase;
 
-    while( (frame_p = pConn_p->getQueue().peek() ) ) {
-        frame_p->bus += busBase;
-        //qDebug() << "Rx of frame from bus: " << frame_p->bus;
+    frames.reserve(pConn_p->getQueue().count());
+
+    //take received frames a contiguous span at a time
+    while( (frame_p = pConn_p->getQueue().peekBatch(count) ) ) {
+        for (int i = 0; i < count; i++)
+        {
+            frames.append(frame_p[i]);
+            frames.last().bus += busBase;
+            //qDebug() << "Rx of frame from bus: " << frames.last().bus;
+        }
+        pConn_p->getQueue().dequeueBatch(count);
+    }
+
+    //then the frames we sent out through this connection
+    while( (frame_p = pConn_p->getTxEchoQueue().peek() ) ) {
         frames.append(*frame_p);
-        pConn_p->getQueue().dequeue();
+        frames.last().bus += busBase;
+        pConn_p->getTxEchoQueue().dequeue();
     }
 
     if(frames.size())
@@ -165,16 +181,53 @@ void CANConManager::refreshConnection(CANConnection* pConn_p)
  * and there is a GVRET object first then a socketcan object it'll send on the socketcan object as
  * gvret will have claimed buses 0 and 1 and socketcan bus 2. But, each actual CANConnection expects
  * its own bus numbers to start at zero so the frame bus number has to be offset accordingly.
- * Also keep in mind that the CANConnection "sendFrame" function uses a blocking queued connection
- * and so will force the frame to be delivered before it keeps going. This allows on the stack variables
- * to be used but is slow. This function uses an on the stack copy of the frame so the way it works
- * is a good thing but performance will suffer. TODO: Investigate a way to use non-blocking calls.
+ * The CANConnection "sendFrame" function copies the frame into the connection's transmit queue and returns
+ * right away. The connection's own thread sends it later. So on the stack variables are fine and callers never
+ * wait on the hardware. A false return means the frame was invalid, the device not connected or the transmit queue full.
 */
 bool CANConManager::sendFrame(const CANFrame& pFrame)
+{
+    bool queueFull;
+    return routeFrame(pFrame, queueFull);
+}
+
+bool CANConManager::sendFrames(const QList<CANFrame>& pFrames)
+{
+    foreach(const CANFrame& frame, pFrames)
+    {
+        if(!sendFrame(frame))
+            return false;
+    }
+
+    return true;
+}
+
+bool CANConManager::sendPendingFrames(QList<CANFrame>& pFrames)
+{
+    bool queueFull = false;
+    int handled = 0;
+
+    while (handled < pFrames.count())
+    {
+        //refused frames are dropped unless they only have to wait for room
+        if (!routeFrame(pFrames[handled], queueFull) && queueFull) break;
+        handled++;
+    }
+
+    if (handled == pFrames.count()) pFrames.clear();
+    else if (handled > 0) pFrames.erase(pFrames.begin(), pFrames.begin() + handled);
+
+    return pFrames.isEmpty();
+}
+
+//does the work of sendFrame. pQueueFull is set when the frame was fine and its device connected, so the only thing
+//in the way was a full transmit queue and the frame can be offered again once framesSent comes along
+bool CANConManager::routeFrame(const CANFrame& pFrame, bool& pQueueFull)
 {
     int busBase = 0;
     CANFrame workingFrame = pFrame;
-    CANFrame *txFrame;
+
+    pQueueFull = false;
 
     foreach (CANConnection* conn, mConns)
     {
@@ -192,27 +245,21 @@ bool CANConManager::sendFrame(const CANFrame& pFrame)
                 workingFrame.timestamp = mElapsedTimer.nsecsElapsed() / 1000;
                 //workingFrame.timestamp -= mTimestampBasis;
             }
-            txFrame = conn->getQueue().get();
-            *txFrame = workingFrame;
-            conn->getQueue().queue();
-            return conn->sendFrame(workingFrame);
+            if (!conn->sendFrame(workingFrame))
+            {
+                pQueueFull = (conn->getStatus() == CANCon::CONNECTED) && (workingFrame.len <= 8);
+                return false;
+            }
+            //echo it back so it shows up with received traffic. The receive queue belongs to the connection's
+            //thread so it goes in the echo queue which any sending thread may write to.
+            conn->getTxEchoQueue().enqueue(workingFrame);
+            return true;
         }
         busBase += conn->getNumBuses();
     }
     return false;
 }
 
-bool CANConManager::sendFrames(const QList<CANFrame>& pFrames)
-{
-    foreach(const CANFrame& frame, pFrames)
-    {
-        if(!sendFrame(frame))
-            return false;
-    }
-
-    return true;
-}
-
 //For each device associated with buses go through and see if that device has a bus
 //that the filter should apply to. If so forward the data on but fudge
 //the bus numbers if bus wasn't -1 so that they're local to the device
@@ -38,6 +38,15 @@ public:
     //just the multi-frame version of above function.
     bool sendFrames(const QList<CANFrame>& pFrames);
 
+    /**
+     * @brief sendPendingFrames queues frames from the front of a list until a transmit queue has no more room
+     * @param pFrames - the frames to send. Those handled are taken off the list, the rest have to be offered again later
+     * @return true once the list is empty
+     * @note Frames no connection can send (unknown bus, device not connected, bad length) are dropped just as sendFrame
+     * refuses them. Only a full transmit queue leaves frames in the list. framesSent tells when there is room again.
+     */
+    bool sendPendingFrames(QList<CANFrame>& pFrames);
+
     /**
      * @brief Add a new filter for the targetted frames. If a frame matches it will immediately be sent via the targettedFrameReceived signal
      * @param pBusId - Which bus to bond to. -1 for any, otherwise a bitfield of buses (but 0 = first bus, etc)
@@ -63,6 +72,8 @@ public:
 signals:
     void framesReceived(CANConnection* pConn_p, QVector<CANFrame>& pFrames);
     void connectionStatusUpdated(int conns);
+    //a connection handed a batch of frames to its device so its transmit queue has room again
+    void framesSent(int pCount);
 
 private slots:
     void refreshCanList();
@@ -70,6 +81,7 @@ private slots:
 private:
     explicit CANConManager(QObject *parent = 0);
     void refreshConnection(CANConnection* pConn_p);
+    bool routeFrame(const CANFrame& pFrame, bool& pQueueFull);
 
     static CANConManager*  mInstance;
     QList<CANConnection*>  mConns;
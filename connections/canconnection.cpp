@@ -8,6 +8,9 @@ CANConnection::CANConnection(QString pPort,
                              int pQueueLen,
                              bool pUseThread) :
     mQueue(),
+    mTxEchoQueue(),
+    mTxQueue(),
+    mTxDrainPending(0),
     mNumBuses(pNumBuses),
     mPort(pPort),
     mType(pType),
@@ -24,6 +27,8 @@ CANConnection::CANConnection(QString pPort,
 
     /* set queue size */
     mQueue.setSize(pQueueLen); /*TODO add check on returned value */
+    mTxEchoQueue.setSize(pQueueLen);
+    mTxQueue.setSize(pQueueLen);
 
     /* allocate buses */
     /* TODO: change those tables for a vector */
@@ -155,35 +160,89 @@ void CANConnection::setBusSettings(int pBusIdx, CANBus pBus)
 
 bool CANConnection::sendFrame(const CANFrame& pFrame)
 {
-    /* make sure we execute in mThread context */
-    if( mThread_p && (mThread_p != QThread::currentThread()) )
+    /* no working thread, send right away */
+    if(!mThread_p)
+        return piSendFrame(pFrame);
+
+    if(!queueTxFrame(pFrame))
+        return false;
+
+    scheduleTxDrain();
+    return true;
+}
+
+
+bool CANConnection::sendFrames(const QList<CANFrame>& pFrames)
+{
+    /* no working thread, send right away */
+    if(!mThread_p)
+        return piSendFrames(pFrames);
+
+    bool ret = true;
+    foreach(const CANFrame& frame, pFrames)
     {
-        bool ret;
-        QMetaObject::invokeMethod(this, "sendFrame",
-                                  Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(bool, ret),
-                                  Q_ARG(const CANFrame&, pFrame));
-        return ret;
+        if(!queueTxFrame(frame)) {
+            ret = false;
+            break;
+        }
     }
 
-    return piSendFrame(pFrame);
+    /* wake the working thread once for the whole list */
+    scheduleTxDrain();
+    return ret;
 }
 
 
-bool CANConnection::sendFrames(const QList<CANFrame>& pFrames)
+bool CANConnection::queueTxFrame(const CANFrame& pFrame)
 {
-    /* make sure we execute in mThread context */
-    if( mThread_p && (mThread_p != QThread::currentThread()) )
+    /* sanity checks, the device is not there to tell us anymore */
+    if(pFrame.bus >= (uint32_t) mNumBuses || pFrame.len > 8)
+        return false;
+
+    /* nothing would ever drain the queue towards a device that is not there */
+    if(getStatus() != CANCon::CONNECTED)
+        return false;
+
+    /* false if the queue is full, caller has to try again later */
+    return mTxQueue.enqueue(pFrame);
+}
+
+
+void CANConnection::scheduleTxDrain()
+{
+    /* only one pending call at a time, drainTxQueue will pick up everything queued meanwhile */
+    if(mTxDrainPending.testAndSetOrdered(0, 1))
+        QMetaObject::invokeMethod(this, "drainTxQueue", Qt::QueuedConnection);
+}
+
+
+void CANConnection::drainTxQueue()
+{
+    /* clear flag before draining so that a frame queued during the drain schedules a new one */
+    mTxDrainPending.storeRelease(0);
+
+    const int batchSize = 256;
+    QList<CANFrame> batch;
+    CANFrame* frame_p;
+
+    batch.reserve(batchSize);
+
+    while( (frame_p = mTxQueue.peek()) )
     {
-        bool ret;
-        QMetaObject::invokeMethod(this, "sendFrames",
-                                  Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(bool, ret),
-                                  Q_ARG(const QList<CANFrame>&, pFrames));
-        return ret;
+        batch.append(*frame_p);
+        mTxQueue.dequeue();
+
+        if(batch.count() == batchSize) {
+            piSendFrames(batch);
+            emit framesSent(batch.count());
+            batch.clear();
+        }
     }
 
-    return piSendFrames(pFrames);
+    if(batch.count()) {
+        piSendFrames(batch);
+        emit framesSent(batch.count());
+    }
 }
 
 
@@ -233,6 +292,11 @@ LFQueue<CANFrame>& CANConnection::getQueue() {
 }
 
 
+LFMPSCQueue<CANFrame>& CANConnection::getTxEchoQueue() {
+    return mTxEchoQueue;
+}
+
+
 CANCon::type CANConnection::getType() {
     return mType;
 }
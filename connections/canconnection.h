@@ -56,6 +56,13 @@ public:
      */
     LFQueue<CANFrame>& getQueue();
 
+    /**
+     * @brief getTxEchoQueue
+     * @return the queue holding copies of transmitted frames to display along with received ones
+     * @note any thread can write in it, the reader is the same as for @ref getQueue
+     */
+    LFMPSCQueue<CANFrame>& getTxEchoQueue();
+
     /**
      * @brief getType
      * @return the @ref CANCon::type of the device
@@ -97,6 +104,13 @@ signals:
       */
     void debugOutput(QString debugString);
 
+    /**
+     * @brief event emitted from the working thread each time a batch of queued frames has been handed to the device
+     * @param pCount: the number of frames in the batch
+     * @note senders throttling on a full transmit queue can use this to know there is room again
+     */
+    void framesSent(int pCount);
+
 public slots:
 
     /**
@@ -140,16 +154,17 @@ public slots:
     /**
      * @brief provides device with the frame to send
      * @param pFrame: the frame to send
-     * @return false if parameter is invalid (bus id for instance)
-     * @note this calls piSendFrame (in the working thread context if one has been started)
+     * @return false if parameter is invalid (bus id for instance), if the device is not connected or if the transmit queue is full
+     * @note if a working thread is used, the frame is put in the transmit queue and the call returns immediately,
+     * @note the working thread then hands queued frames to piSendFrames. Otherwise this calls piSendFrame directly
      */
     bool sendFrame(const CANFrame& pFrame);
 
     /**
      * @brief provides device with a list of frames to send
      * @param pFrame: the list of frames to send
-     * @return false if parameter is invalid (bus id for instance)
-     * @note this calls piSendFrameBatch (in the working thread context if one has been started)
+     * @return false if parameter is invalid (bus id for instance), if the device is not connected or if the transmit queue is full
+     * @note frames are queued the same way as for @ref sendFrame. Frames queued before a failure are still sent
      */
     bool sendFrames(const QList<CANFrame>& pFrames);
 
@@ -182,6 +197,13 @@ public slots:
 
     void debugInput(QByteArray bytes);
 
+private slots:
+    /**
+     * @brief empties the transmit queue, handing frames to piSendFrames in batches
+     * @note always executed in the working thread context
+     */
+    void drainTxQueue();
+
 protected:
     int mNumBuses; //protected to allow connected device to figure out how many buses are available
     QVector<BusData> mBusData;
@@ -292,7 +314,21 @@ protected:
     virtual bool piSendFrames(const QList<CANFrame>&);
 
 private:
-    LFQueue<CANFrame>   mQueue;
+    /**
+     * @brief puts a frame in the transmit queue without waking the working thread
+     * @return false if the frame is invalid, the device is not connected or the queue is full
+     */
+    bool queueTxFrame(const CANFrame& pFrame);
+
+    /**
+     * @brief schedules drainTxQueue in the working thread unless it is already pending
+     */
+    void scheduleTxDrain();
+
+    LFQueue<CANFrame>       mQueue;         /* written by the working thread only */
+    LFMPSCQueue<CANFrame>   mTxEchoQueue;
+    LFMPSCQueue<CANFrame>   mTxQueue;       /* any sender thread in, working thread out */
+    QAtomicInt              mTxDrainPending;
     const QString       mPort;
     const CANCon::type  mType;
     bool                mIsCapSuspended;
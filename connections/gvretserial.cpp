@@ -196,8 +196,6 @@ void GVRetSerial::piSetBusSettings(int pBusIdx, CANBus bus)
 bool GVRetSerial::piSendFrame(const CANFrame& frame)
 {
     QByteArray buffer;
-    unsigned int c;
-    int ID;
 
     //qDebug() << "Sending out GVRET frame with id " << frame.ID << " on bus " << frame.bus;
 
@@ -207,30 +205,57 @@ bool GVRetSerial::piSendFrame(const CANFrame& frame)
     if (!serial->isOpen()) return false;
     //if (!isConnected) return false;
 
-    ID = frame.ID;
-    if (frame.extended) ID |= 1 << 31;
+    buildFrameCommand(frame, buffer);
+
+    //qDebug() << "writing " << buffer.length() << " bytes to serial port";
+    debugOutput("writing " + QString::number(buffer.length()) + " bytes to serial port");
+    serial->write(buffer);
+
+    return true;
+}
+
+//All the frames get packed into one buffer and written in one go. Writing (and logging) frame by frame
+//is what kept playback from getting anywhere near a full bus.
+bool GVRetSerial::piSendFrames(const QList<CANFrame>& frames)
+{
+    QByteArray buffer;
 
-    buffer[0] = (char)0xF1; //start of a command over serial
-    buffer[1] = 0; //command ID for sending a CANBUS frame
-    buffer[2] = (unsigned char)(ID & 0xFF); //four bytes of ID LSB first
-    buffer[3] = (unsigned char)(ID >> 8);
-    buffer[4] = (unsigned char)(ID >> 16);
-    buffer[5] = (unsigned char)(ID >> 24);
-    buffer[6] = (unsigned char)((frame.bus) & 3);
-    buffer[7] = (unsigned char)frame.len;
-    for (c = 0; c < frame.len; c++)
+    if (serial == NULL) return false;
+    if (!serial->isOpen()) return false;
+
+    buffer.reserve(frames.count() * 17);
+    foreach (const CANFrame& frame, frames)
     {
-        buffer[8 + c] = frame.data[c];
+        buildFrameCommand(frame, buffer);
     }
-    buffer[8 + frame.len] = 0;
+    framesRapid += frames.count();
 
-    //qDebug() << "writing " << buffer.length() << " bytes to serial port";
-    debugOutput("writing " + QString::number(buffer.length()) + " bytes to serial port");
+    debugOutput("writing " + QString::number(buffer.length()) + " bytes to serial port for " + QString::number(frames.count()) + " frames");
     serial->write(buffer);
 
     return true;
 }
 
+//appends the GVRET binary command to send frame to the end of buffer
+void GVRetSerial::buildFrameCommand(const CANFrame& frame, QByteArray& buffer)
+{
+    int ID;
+
+    ID = frame.ID;
+    if (frame.extended) ID |= 1 << 31;
+
+    buffer.append((char)0xF1); //start of a command over serial
+    buffer.append((char)0); //command ID for sending a CANBUS frame
+    buffer.append((char)(ID & 0xFF)); //four bytes of ID LSB first
+    buffer.append((char)(ID >> 8));
+    buffer.append((char)(ID >> 16));
+    buffer.append((char)(ID >> 24));
+    buffer.append((char)((frame.bus) & 3));
+    buffer.append((char)frame.len);
+    buffer.append((const char *)frame.data, frame.len);
+    buffer.append((char)0);
+}
+
 
 
 /****************************************************************/
@@ -52,6 +52,7 @@ protected:
     virtual bool piGetBusSettings(int pBusIdx, CANBus& pBus);
     virtual void piSuspend(bool pSuspend);
     virtual bool piSendFrame(const CANFrame&) ;
+    virtual bool piSendFrames(const QList<CANFrame>&) ;
 
     void disconnectDevice();
 
@@ -66,6 +67,7 @@ private slots:
 
 private:
     void readSettings();
+    void buildFrameCommand(const CANFrame& frame, QByteArray& buffer);
     void procRXChar(unsigned char);
     void sendCommValidation();
     void rebuildLocalTimeBasis();
@@ -0,0 +1,331 @@
+#include "continuouslogger.h"
+
+#include <QFileInfo>
+#include <QDebug>
+#include <string.h>
+
+#include "canbinaryfile.h"
+#include "utils/textwriter.h"
+
+//formatted output is collected up to this size before being written
+#define WRITE_BUFFER_SIZE   (256 * 1024)
+//anything sitting in the buffer longer than this gets written anyway
+#define WRITE_INTERVAL_MS   250
+//how long the writer naps when there is nothing queued
+#define IDLE_SLEEP_MS       5
+
+ContinuousLogger::ContinuousLogger(QObject *parent) : QThread(parent)
+{
+    logFormat = FORMAT_CSV;
+    maxBytes = 0;
+    maxSeconds = 0;
+    fileNumber = 0;
+    bytesInFile = 0;
+    framesInFile = 0;
+    framesBuffered = 0;
+    lastTimestamp = 0;
+    monotonic = true;
+    queue.setSize(LOGGER_QUEUE_SIZE);
+}
+
+ContinuousLogger::~ContinuousLogger()
+{
+    stopLogging();
+}
+
+bool ContinuousLogger::startLogging(QString filename, LogFormat format, qint64 rotateBytes, int rotateSeconds)
+{
+    stopLogging();
+
+    baseName = filename;
+    logFormat = format;
+    maxBytes = rotateBytes;
+    maxSeconds = rotateSeconds;
+    fileNumber = 0;
+    queue.flush();
+    framesWritten.store(0);
+    framesDropped.store(0);
+    stopRequested.store(0);
+    writeFailed.store(0);
+    failure.clear();
+
+    if (!openFile()) return false;
+
+    logging.store(1);
+    start(QThread::LowPriority);
+    return true;
+}
+
+//the writer may have stopped by itself after a failure, it is waited for all the same
+void ContinuousLogger::stopLogging()
+{
+    stopRequested.store(1);
+    wait();
+    logging.store(0);
+}
+
+/*
+ * Runs in whatever thread emits framesReceived, which is the GUI thread. This is the only producer for the
+ * ring. If the writer can't keep up the frames that don't fit are counted and dropped rather than blocking.
+ */
+void ContinuousLogger::framesReceived(CANConnection *pConn_p, QVector<CANFrame> &pFrames)
+{
+    Q_UNUSED(pConn_p);
+    if (!logging.load()) return;
+
+    int done = 0;
+    while (done < pFrames.count())
+    {
+        int free;
+        CANFrame *space = queue.getBatch(free);
+        if (!space) break;
+
+        int num = qMin(free, pFrames.count() - done);
+        for (int i = 0; i < num; i++) space[i] = pFrames[done + i];
+        queue.queueBatch(num);
+        done += num;
+    }
+
+    if (done < pFrames.count()) framesDropped.fetchAndAddRelaxed(pFrames.count() - done);
+}
+
+void ContinuousLogger::run()
+{
+    buffer.reserve(WRITE_BUFFER_SIZE + LOGGER_MAX_LINE);
+    framesBuffered = 0;
+    writeTimer.start();
+
+    for (;;)
+    {
+        int count;
+        CANFrame *frames = queue.peekBatch(count);
+
+        if (!frames)
+        {
+            if (stopRequested.load()) break;
+            if (!buffer.isEmpty() && writeTimer.elapsed() > WRITE_INTERVAL_MS) writeBuffer();
+            if (maxSeconds > 0 && fileTimer.elapsed() >= maxSeconds * 1000ll)
+            {
+                if (!writeBuffer())
+                {
+                    logFailed(tr("Writing to %1 failed.").arg(currentName));
+                    break;
+                }
+                closeFile();
+                if (!openFile())
+                {
+                    logFailed(tr("Could not open %1.").arg(currentName));
+                    break;
+                }
+            }
+            msleep(IDLE_SLEEP_MS);
+            continue;
+        }
+
+        bool failed = false;
+        for (int i = 0; i < count; i++)
+        {
+            const CANFrame &frame = frames[i];
+            int oldSize = buffer.size();
+            if (logFormat == FORMAT_COMPRESSED)
+            {
+                if (!packedFile.append(frame)) failed = true;
+                bytesInFile = packedFile.bytesWritten();
+            }
+            else if (logFormat == FORMAT_BINARY)
+            {
+                buffer.resize(oldSize + CANBIN_RECORD_SIZE);
+                CANBinaryFile::encodeRecord(frame, (uchar *)buffer.data() + oldSize);
+            }
+            else
+            {
+                buffer.resize(oldSize + LOGGER_MAX_LINE);
+                buffer.resize(oldSize + formatCSVLine(frame, buffer.data() + oldSize));
+            }
+
+            if (framesInFile > 0 && frame.timestamp < lastTimestamp) monotonic = false;
+            lastTimestamp = frame.timestamp;
+            framesInFile++;
+        }
+        framesBuffered += count;
+        queue.dequeueBatch(count);
+        if (failed)
+        {
+            logFailed(tr("Writing to %1 failed.").arg(currentName));
+            break;
+        }
+
+        bool rotate = (maxBytes > 0 && bytesInFile + buffer.size() >= maxBytes)
+                   || (maxSeconds > 0 && fileTimer.elapsed() >= maxSeconds * 1000ll);
+        if (rotate || buffer.size() >= WRITE_BUFFER_SIZE || writeTimer.elapsed() > WRITE_INTERVAL_MS)
+        {
+            if (!writeBuffer())
+            {
+                logFailed(tr("Writing to %1 failed.").arg(currentName));
+                break;
+            }
+        }
+        if (rotate)
+        {
+            closeFile();
+            if (!openFile())
+            {
+                logFailed(tr("Could not open %1.").arg(currentName));
+                break;
+            }
+        }
+    }
+
+    if (!writeBuffer() && !hasFailed()) logFailed(tr("Writing to %1 failed.").arg(currentName));
+    closeFile();
+}
+
+/*
+ * Gives up on the log from the writer thread. Frames stop going into the ring right away, so they aren't
+ * counted as dropped, and the GUI finds out through loggingFailed.
+ */
+void ContinuousLogger::logFailed(const QString &message)
+{
+    qDebug() << "Continuous logging stopped: " << message;
+    failure = message;
+    writeFailed.storeRelease(1);
+    logging.store(0);
+    emit loggingFailed();
+}
+
+QString ContinuousLogger::nextFileName()
+{
+    if (fileNumber == 0) return baseName;
+
+    QFileInfo info(baseName);
+    QString name = info.path() + "/" + info.completeBaseName() + "_" + QString::number(fileNumber);
+    if (!info.suffix().isEmpty()) name += "." + info.suffix();
+    return name;
+}
+
+bool ContinuousLogger::openFile()
+{
+    QString name = nextFileName();
+    currentName = name;
+    fileNumber++;
+
+    bytesInFile = 0;
+    framesInFile = 0;
+    lastTimestamp = 0;
+    monotonic = true;
+    fileTimer.start();
+
+    if (logFormat == FORMAT_COMPRESSED)
+    {
+        //the writer keeps its own header up to date
+        if (!packedFile.open(name))
+        {
+            qDebug() << "Could not open " << name << " for continuous logging";
+            return false;
+        }
+        bytesInFile = packedFile.bytesWritten();
+        return true;
+    }
+
+    file.setFileName(name);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "Could not open " << name << " for continuous logging";
+        return false;
+    }
+
+    if (logFormat == FORMAT_BINARY)
+    {
+        uchar header[CANBIN_HEADER_SIZE];
+        CANBinaryFile::encodeHeader(header, 0, 0, 0);
+        bytesInFile = file.write((const char *)header, sizeof(header));
+    }
+    else bytesInFile = file.write("Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8\n");
+
+    return bytesInFile > 0;
+}
+
+/*
+ * Binary files get their header rewritten with the frame count after every write so a file is readable
+ * up to the last write even if the program never gets to close it.
+ */
+bool ContinuousLogger::writeBuffer()
+{
+    writeTimer.restart();
+
+    //compressed frames are already with the writer, which puts them out a block at a time by itself
+    if (logFormat == FORMAT_COMPRESSED)
+    {
+        int pending = packedFile.framesPending();
+        framesWritten.fetchAndAddRelaxed(framesBuffered - pending);
+        framesBuffered = pending;
+        bytesInFile = packedFile.bytesWritten();
+        return packedFile.isOpen();
+    }
+
+    if (buffer.isEmpty() || !file.isOpen()) return file.isOpen();
+
+    qint64 written = file.write(buffer);
+    buffer.resize(0);
+    if (written < 0)
+    {
+        qDebug() << "Continuous log write to " << file.fileName() << " failed";
+        return false;
+    }
+    bytesInFile += written;
+    framesWritten.fetchAndAddRelaxed(framesBuffered);
+    framesBuffered = 0;
+
+    if (logFormat == FORMAT_BINARY)
+    {
+        uchar header[CANBIN_HEADER_SIZE];
+        CANBinaryFile::encodeHeader(header, framesInFile, 0, monotonic ? CANBIN_FLAG_MONOTONIC : 0);
+        qint64 end = file.pos();
+        file.seek(0);
+        file.write((const char *)header, sizeof(header));
+        file.seek(end);
+    }
+    file.flush();
+    return true;
+}
+
+void ContinuousLogger::closeFile()
+{
+    if (file.isOpen()) file.close();
+    if (packedFile.isOpen())
+    {
+        packedFile.close();
+        framesWritten.fetchAndAddRelaxed(framesBuffered);
+        framesBuffered = 0;
+    }
+}
+
+//timestamp,ID,extended,dir,bus,len,8 data bytes each followed by a comma
+int ContinuousLogger::formatCSVLine(const CANFrame &frame, char *out)
+{
+    char *p = out;
+
+    p = TextWriter::writeDecimal(p, frame.timestamp);
+    *p++ = ',';
+    p = TextWriter::writeHex(p, frame.ID, 8);
+    *p++ = ',';
+
+    if (frame.extended) { memcpy(p, "true,", 5); p += 5; }
+    else { memcpy(p, "false,", 6); p += 6; }
+
+    memcpy(p, frame.isReceived ? "Rx," : "Tx,", 3);
+    p += 3;
+
+    p = TextWriter::writeDecimal(p, frame.bus);
+    *p++ = ',';
+    p = TextWriter::writeDecimal(p, frame.len);
+    *p++ = ',';
+
+    for (unsigned int i = 0; i < 8; i++)
+    {
+        p = TextWriter::writeHexByte(p, (i < frame.len) ? frame.data[i] : 0);
+        *p++ = ',';
+    }
+    *p++ = '\n';
+    return (int)(p - out);
+}
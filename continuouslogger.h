@@ -0,0 +1,110 @@
+#ifndef CONTINUOUSLOGGER_H
+#define CONTINUOUSLOGGER_H
+
+#include <QThread>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QAtomicInteger>
+#include "can_structs.h"
+#include "cancompressedfile.h"
+#include "utils/lfqueue.h"
+
+class CANConnection;
+
+//frames that can be waiting for the writer thread before new ones get dropped
+#define LOGGER_QUEUE_SIZE       262144
+//longest line formatCSVLine can produce
+#define LOGGER_MAX_LINE         128
+
+/*
+ * Continuous logging to disk on a thread of its own. Frames come straight from CANConManager::framesReceived
+ * (not from the main frame list, which overwrite mode rewrites in place) and go through a lock free ring to the
+ * writer, which formats them into a buffer and writes big blocks. The GUI thread only ever copies frames into
+ * the ring. Files can be rolled over to a new one after so many bytes or so many seconds; rolled over files get
+ * _1, _2 and so on added to the name.
+ */
+class ContinuousLogger : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum LogFormat
+    {
+        FORMAT_CSV,         //GVRET csv, same as saveNativeCSVFile
+        FORMAT_BINARY,      //SavvyCAN native binary
+        FORMAT_COMPRESSED   //SavvyCAN compressed, goes to disk a whole block at a time
+    };
+
+    ContinuousLogger(QObject *parent = 0);
+    ~ContinuousLogger();
+
+    /**
+     * @brief opens the first file and starts the writer thread
+     * @param rotateBytes - start a new file once this many bytes are written, 0 for never
+     * @param rotateSeconds - start a new file after this many seconds, 0 for never
+     * @return false if the file could not be created
+     */
+    bool startLogging(QString filename, LogFormat format, qint64 rotateBytes = 0, int rotateSeconds = 0);
+
+    /* writes out whatever is still queued, closes the file and waits for the thread to finish */
+    void stopLogging();
+
+    //false once the writer has given up on a failed write or open, see loggingFailed
+    bool isLogging() const { return logging.load() != 0; }
+    quint64 getFramesWritten() const { return framesWritten.load(); }
+    quint64 getFramesDropped() const { return framesDropped.load(); }
+    //whether this log stopped because a file couldn't be written or opened, and which
+    bool hasFailed() const { return writeFailed.loadAcquire() != 0; }
+    QString getFailure() const { return hasFailed() ? failure : QString(); }
+
+    /* formats one frame the way saveNativeCSVFile does, returns the number of characters written */
+    static int formatCSVLine(const CANFrame &frame, char *out);
+
+public slots:
+    void framesReceived(CANConnection *pConn_p, QVector<CANFrame> &pFrames);
+
+signals:
+    //emitted from the writer thread when it gives up, nothing more is logged. stopLogging() still has to be called
+    void loggingFailed();
+
+protected:
+    void run();
+
+private:
+    bool openFile();
+    void closeFile();
+    bool writeBuffer();
+    QString nextFileName();
+    void logFailed(const QString &message);
+
+    LFQueue<CANFrame> queue;
+    QAtomicInt stopRequested;
+    QAtomicInteger<quint64> framesWritten;
+    QAtomicInteger<quint64> framesDropped;
+    QAtomicInt logging;
+    QAtomicInt writeFailed;
+    QString failure; //set before writeFailed
+
+    //only touched by the writer thread once it is running
+    QFile file;
+    CANCompressedWriter packedFile; //used instead of file for FORMAT_COMPRESSED
+    QString baseName;
+    QString currentName;
+    LogFormat logFormat;
+    qint64 maxBytes;
+    int maxSeconds;
+    int fileNumber;
+    qint64 bytesInFile;
+    quint64 framesInFile;
+    int framesBuffered; //formatted into buffer but not written yet
+    uint64_t lastTimestamp;
+    bool monotonic;
+    QByteArray buffer;
+    QElapsedTimer fileTimer;
+    QElapsedTimer writeTimer;
+};
+
+#endif // CONTINUOUSLOGGER_H
@@ -1,4 +1,5 @@
 #include "dbc_classes.h"
+#include <algorithm>
 #include "dbchandler.h"
 #include "utility.h"
 
@@ -38,8 +39,6 @@ s 5   47 46 45 44 43 42 41 40
 */
 bool DBC_SIGNAL::processAsText(const CANFrame &frame, QString &outString)
 {
-    int64_t result = 0;
-    bool isSigned = false;
     double endResult;
 
     if (valType == STRING)
@@ -64,70 +63,8 @@ bool DBC_SIGNAL::processAsText(const CANFrame &frame, QString &outString)
         else return false;
     }
 
-    if (valType == SIGNED_INT) isSigned = true;
-    if (valType == SIGNED_INT || valType == UNSIGNED_INT)
-    {
-        if ( frame.len*8 < (startBit+signalSize) )
-        {
-            result = 0;
-            return false;
-        }
-        result = Utility::processIntegerSignal(frame.data, startBit, signalSize, intelByteOrder, isSigned);
-        endResult = ((double)result * factor) + bias;
-        result = (int64_t)endResult;
-    }
-    else if (valType == SP_FLOAT)
-    {
-        if ( frame.len*8 < (startBit+32) )
-        {
-            result = 0;
-            return false;
-        }
-        //The theory here is that we force the integer signal code to treat this as
-        //a 32 bit unsigned integer. This integer is then cast into a float in such a way
-        //that the bytes that make up the integer are instead treated as having made up
-        //a 32 bit single precision float. That's evil incarnate but it is very fast and small
-        //in terms of new code.
-        result = Utility::processIntegerSignal(frame.data, startBit, 32, false, false);
-        endResult = (*((float *)(&result)) * factor) + bias;
-    }
-    else //double precision float
-    {
-        if ( frame.len < 8 )
-        {
-            result = 0;
-            return false;
-        }
-        //like the above, this is rotten and evil and wrong in so many ways. Force
-        //calculation of a 64 bit integer and then cast it into a double.
-        result = Utility::processIntegerSignal(frame.data, 0, 64, false, false);
-        endResult = (*((double *)(&result)) * factor) + bias;
-    }
-
-    QString outputString;
-
-    outputString = name + ": ";
-
-    if (valList.count() > 0) //if this is a value list type then look it up and display the proper string
-    {
-        bool foundVal = false;
-        for (int x = 0; x < valList.count(); x++)
-        {
-            if (valList.at(x).value == result)
-            {
-                outputString += valList.at(x).descript;
-                foundVal = true;
-                break;
-            }
-        }
-        if (!foundVal) outputString += QString::number(endResult) + unitName;
-    }
-    else //otherwise display the actual number and unit (if it exists)
-    {
-       outputString += QString::number(endResult) + unitName;
-    }
-
-    outString = outputString;
+    if (!decodeValue(frame, endResult)) return false;
+    formatValue(endResult, outString);
     return true;
 }
 
@@ -140,7 +77,6 @@ bool DBC_SIGNAL::processAsText(const CANFrame &frame, QString &outString)
 bool DBC_SIGNAL::processAsInt(const CANFrame &frame, int32_t &outValue)
 {
     int32_t result = 0;
-    bool isSigned = false;
     if (valType == STRING || valType == SP_FLOAT  || valType == DP_FLOAT)
     {
         return false;
@@ -158,13 +94,12 @@ bool DBC_SIGNAL::processAsInt(const CANFrame &frame, int32_t &outValue)
         else return false;
     }
 
-    if (valType == SIGNED_INT) isSigned = true;
     if ( frame.len*8 < (startBit+signalSize) )
     {
         result = 0;
         return false;
     }
-    result = Utility::processIntegerSignal(frame.data, startBit, signalSize, intelByteOrder, isSigned);
+    result = getExtractor().extract(frame.data);
 
     double endResult = ((double)result * factor) + bias;
     result = (int32_t)endResult;
@@ -179,10 +114,6 @@ bool DBC_SIGNAL::processAsInt(const CANFrame &frame, int32_t &outValue)
 //Similar syntax to processSignalInt but with double instead.
 bool DBC_SIGNAL::processAsDouble(const CANFrame &frame, double &outValue)
 {
-    int64_t result = 0;
-    bool isSigned = false;
-    double endResult;
-
     if (valType == STRING)
     {
         return false;
@@ -200,24 +131,35 @@ bool DBC_SIGNAL::processAsDouble(const CANFrame &frame, double &outValue)
         else return false;
     }
 
-    if (valType == SIGNED_INT) isSigned = true;
+    return decodeValue(frame, outValue);
+}
+
+//The part of processAsDouble that comes after the multiplexor check. DBCMessageDecoder has already sorted out
+//which signals are in the frame so it comes straight here.
+bool DBC_SIGNAL::decodeValue(const CANFrame &frame, double &outValue)
+{
+    int64_t result = 0;
+    double endResult;
+
+    if (valType == STRING)
+    {
+        return false;
+    }
+
     if (valType == SIGNED_INT || valType == UNSIGNED_INT)
     {
         if ( frame.len*8 < (startBit+signalSize) )
         {
-            result = 0;
             return false;
         }
-        result = Utility::processIntegerSignal(frame.data, startBit, signalSize, intelByteOrder, isSigned);
+        result = getExtractor().extract(frame.data);
         endResult = ((double)result * factor) + bias;
-        result = (int64_t)endResult;
     }
     /*TODO: It should be noted that the below floating point has not even been tested. For shame! Test it!*/
     else if (valType == SP_FLOAT)
     {
         if ( frame.len*8 < (startBit+32) )
         {
-            result = 0;
             return false;
         }
         //The theory here is that we force the integer signal code to treat this as
@@ -225,19 +167,18 @@ bool DBC_SIGNAL::processAsDouble(const CANFrame &frame, double &outValue)
         //that the bytes that make up the integer are instead treated as having made up
         //a 32 bit single precision float. That's evil incarnate but it is very fast and small
         //in terms of new code.
-        result = Utility::processIntegerSignal(frame.data, startBit, 32, false, false);
+        result = getExtractor().extract(frame.data);
         endResult = (*((float *)(&result)) * factor) + bias;
     }
     else //double precision float
     {
         if ( frame.len < 8 )
         {
-            result = 0;
             return false;
         }
         //like the above, this is rotten and evil and wrong in so many ways. Force
         //calculation of a 64 bit integer and then cast it into a double.
-        result = Utility::processIntegerSignal(frame.data, 0, 64, false, false);
+        result = getExtractor().extract(frame.data);
         endResult = (*((double *)(&result)) * factor) + bias;
     }
 
@@ -245,6 +186,190 @@ bool DBC_SIGNAL::processAsDouble(const CANFrame &frame, double &outValue)
     return true;
 }
 
+//Turns a decoded value into the "name: value" text processAsText gives. If the signal has a value list and the
+//value is in it then the description is shown, otherwise the number and unit (if it exists).
+void DBC_SIGNAL::formatValue(double value, QString &outString)
+{
+    getValueTable().format(value, outString);
+}
+
+/*
+ * Batch version of the above for decoding one signal out of a whole run of frames at once.
+ * outValues and outValid must both have room for count entries. outValid[i] says whether
+ * outValues[i] could be decoded (frame long enough and, for multiplexed signals, the right mux value).
+ * Returns the number of frames that decoded.
+*/
+int DBC_SIGNAL::processAsDouble(const CANFrame *frames, int count, double *outValues, bool *outValid)
+{
+    int numValid = 0;
+
+    if (valType == STRING || count <= 0)
+    {
+        for (int i = 0; i < count; i++) outValid[i] = false;
+        return 0;
+    }
+
+    const SignalExtractor &ext = getExtractor();
+    int minLen; //in bits for int and single precision, same test the single frame version does
+    if (valType == DP_FLOAT) minLen = 64;
+    else if (valType == SP_FLOAT) minLen = startBit + 32;
+    else minLen = startBit + signalSize;
+
+    QVector<int64_t> raw(count);
+    ext.extractBatch(frames, count, raw.data());
+
+    for (int i = 0; i < count; i++)
+    {
+        outValid[i] = false;
+        if ((int)frames[i].len * 8 < minLen) continue;
+
+        if (isMultiplexed)
+        {
+            int val;
+            if (parentMessage->multiplexorSignal == NULL) continue;
+            if (!parentMessage->multiplexorSignal->processAsInt(frames[i], val)) continue;
+            if (val != multiplexValue) continue;
+        }
+
+        if (valType == SP_FLOAT)
+        {
+            int64_t result = raw[i];
+            outValues[i] = (*((float *)(&result)) * factor) + bias;
+        }
+        else if (valType == DP_FLOAT)
+        {
+            int64_t result = raw[i];
+            outValues[i] = (*((double *)(&result)) * factor) + bias;
+        }
+        else outValues[i] = ((double)raw[i] * factor) + bias;
+
+        outValid[i] = true;
+        numValid++;
+    }
+
+    return numValid;
+}
+
+/*
+ * Returns the compiled extractor for this signal. The signal editor changes the fields of a signal in place
+ * so the extractor is checked against them and rebuilt if they no longer match. Floating point signals always
+ * get pulled out as big endian unsigned integers of the appropriate size, same as they always have been.
+*/
+const SignalExtractor &DBC_SIGNAL::getExtractor()
+{
+    int sBit = startBit;
+    int size = signalSize;
+    bool littleEndian = intelByteOrder;
+    bool isSigned = (valType == SIGNED_INT);
+
+    if (valType == SP_FLOAT)
+    {
+        size = 32;
+        littleEndian = false;
+        isSigned = false;
+    }
+    else if (valType == DP_FLOAT)
+    {
+        sBit = 0;
+        size = 64;
+        littleEndian = false;
+        isSigned = false;
+    }
+
+    if (!extractor.isFor(sBit, size, littleEndian, isSigned)) extractor = SignalExtractor(sBit, size, littleEndian, isSigned);
+    return extractor;
+}
+
+/*
+ * Returns the value table for this signal. Like the extractor it is checked against the signal first, which is
+ * quick as the copies it keeps share their data with the signal's until those get edited, and rebuilt if stale.
+*/
+const DBCValueTable &DBC_SIGNAL::getValueTable()
+{
+    if (!valueTable.isFor(name, unitName, valList)) valueTable = DBCValueTable(name, unitName, valList);
+    return valueTable;
+}
+
+DBCValueTable::DBCValueTable()
+{
+    denseBase = 0;
+}
+
+DBCValueTable::DBCValueTable(const QString &name, const QString &unitName, const QList<DBC_VAL_ENUM_ENTRY> &valList)
+{
+    sigName = name;
+    sigUnit = unitName;
+    sigValues = valList;
+    prefix = name + ": ";
+    denseBase = 0;
+    if (valList.isEmpty()) return;
+
+    //sorted by value, keeping the first description of any value listed twice as that's the one a search found
+    QVector<QPair<int64_t, int> > order;
+    order.reserve(valList.count());
+    for (int i = 0; i < valList.count(); i++) order.append(qMakePair((int64_t)valList[i].value, i));
+    std::stable_sort(order.begin(), order.end(),
+                     [](const QPair<int64_t, int> &a, const QPair<int64_t, int> &b) { return a.first < b.first; });
+
+    for (int i = 0; i < order.count(); i++)
+    {
+        if (!values.isEmpty() && values.last() == order[i].first) continue;
+        values.append(order[i].first);
+        texts.append(prefix + valList[order[i].second].descript);
+    }
+
+    //a straight table is used unless it would be mostly holes
+    int64_t span = values.last() - values.first() + 1;
+    if (span <= 4 * values.count() + 64)
+    {
+        denseBase = values.first();
+        dense.fill(-1, (int)span);
+        for (int i = 0; i < values.count(); i++) dense[(int)(values[i] - denseBase)] = i;
+    }
+}
+
+bool DBCValueTable::isFor(const QString &name, const QString &unitName, const QList<DBC_VAL_ENUM_ENTRY> &valList) const
+{
+    return sigValues == valList && sigName == name && sigUnit == unitName && !prefix.isEmpty();
+}
+
+//the formatted description of value, NULL if the value list doesn't have it
+const QString *DBCValueTable::findText(int64_t value) const
+{
+    if (!dense.isEmpty())
+    {
+        if (value < denseBase || value >= denseBase + dense.count()) return NULL;
+        int idx = dense[(int)(value - denseBase)];
+        return (idx >= 0) ? &texts[idx] : NULL;
+    }
+
+    const int64_t *found = std::lower_bound(values.constBegin(), values.constEnd(), value);
+    if (found == values.constEnd() || *found != value) return NULL;
+    return &texts[(int)(found - values.constBegin())];
+}
+
+//what DBC_SIGNAL::formatValue gives. Listed values just share the formatted text, everything else is built in one go
+void DBCValueTable::format(double value, QString &outString) const
+{
+    if (!texts.isEmpty())
+    {
+        const QString *found = findText((int64_t)value);
+        if (found != NULL)
+        {
+            outString = *found;
+            return;
+        }
+    }
+
+    QString number = QString::number(value);
+    QString outputString;
+    outputString.reserve(prefix.length() + number.length() + sigUnit.length());
+    outputString.append(prefix);
+    outputString.append(number);
+    outputString.append(sigUnit);
+    outString = outputString;
+}
+
 DBC_ATTRIBUTE_VALUE *DBC_SIGNAL::findAttrValByName(QString name)
 {
     if (attributes.length() == 0) return NULL;
@@ -265,6 +390,139 @@ DBC_ATTRIBUTE_VALUE *DBC_SIGNAL::findAttrValByIdx(int idx)
     return &attributes[idx];
 }
 
+DBCMessageDecoder::DBCMessageDecoder()
+{
+    message = NULL;
+    multiplexor = NULL;
+}
+
+DBCMessageDecoder::DBCMessageDecoder(DBC_MESSAGE *msg)
+{
+    message = msg;
+    multiplexor = msg->multiplexorSignal;
+
+    int count = msg->sigHandler->getCount();
+    layout.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
+        layout[i].sig = sig;
+        layout[i].isMultiplexed = sig->isMultiplexed;
+        layout[i].multiplexValue = sig->multiplexValue;
+
+        //multiplexed signals can't be found in any frame if the message has no multiplexor
+        if (!sig->isMultiplexed) plainSignals.append(i);
+        else if (multiplexor != NULL) groups[sig->multiplexValue].append(i);
+    }
+}
+
+//true if the decoder was built for this message and its signals haven't been added, removed or remultiplexed since
+bool DBCMessageDecoder::isFor(DBC_MESSAGE *msg) const
+{
+    if (msg != message || msg->multiplexorSignal != multiplexor) return false;
+    if (msg->sigHandler->getCount() != layout.count()) return false;
+    for (int i = 0; i < layout.count(); i++)
+    {
+        DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
+        if (sig != layout[i].sig || sig->isMultiplexed != layout[i].isMultiplexed) return false;
+        if (sig->isMultiplexed && sig->multiplexValue != layout[i].multiplexValue) return false;
+    }
+    return true;
+}
+
+int DBCMessageDecoder::getCount() const
+{
+    return layout.count();
+}
+
+DBC_SIGNAL *DBCMessageDecoder::getSignal(int idx) const
+{
+    if (idx < 0 || idx >= layout.count()) return NULL;
+    return layout[idx].sig;
+}
+
+//the multiplexed signals in this frame, NULL if there aren't any
+const QVector<int> *DBCMessageDecoder::activeGroup(const CANFrame &frame) const
+{
+    if (multiplexor == NULL || groups.isEmpty()) return NULL;
+
+    int val;
+    if (!multiplexor->processAsInt(frame, val)) return NULL;
+    QHash<int, QVector<int> >::const_iterator found = groups.constFind(val);
+    if (found == groups.constEnd()) return NULL;
+    return &found.value();
+}
+
+/*
+ * Decodes every signal of the message that is in the frame. outValues and outValid need room for getCount() entries.
+ * outValid[i] says whether outValues[i] was decoded. String signals never are, they only come out of decodeText.
+ * Returns the number of signals decoded.
+*/
+int DBCMessageDecoder::decode(const CANFrame &frame, double *outValues, bool *outValid) const
+{
+    int numValid = 0;
+    for (int i = 0; i < layout.count(); i++) outValid[i] = false;
+
+    for (int i = 0; i < plainSignals.count(); i++)
+    {
+        int idx = plainSignals[i];
+        if (layout[idx].sig->decodeValue(frame, outValues[idx]))
+        {
+            outValid[idx] = true;
+            numValid++;
+        }
+    }
+
+    const QVector<int> *group = activeGroup(frame);
+    if (group == NULL) return numValid;
+    for (int i = 0; i < group->count(); i++)
+    {
+        int idx = group->at(i);
+        if (layout[idx].sig->decodeValue(frame, outValues[idx]))
+        {
+            outValid[idx] = true;
+            numValid++;
+        }
+    }
+    return numValid;
+}
+
+//Same again but with the text processAsText would give for each signal
+int DBCMessageDecoder::decodeText(const CANFrame &frame, QString *outStrings, bool *outValid) const
+{
+    int numValid = 0;
+    for (int i = 0; i < layout.count(); i++) outValid[i] = false;
+
+    const QVector<int> *group = activeGroup(frame);
+    int numPlain = plainSignals.count();
+    int numGroup = (group != NULL) ? group->count() : 0;
+    for (int i = 0; i < numPlain + numGroup; i++)
+    {
+        int idx = (i < numPlain) ? plainSignals[i] : group->at(i - numPlain);
+        DBC_SIGNAL *sig = layout[idx].sig;
+        double value;
+
+        if (sig->valType == STRING) outValid[idx] = sig->processAsText(frame, outStrings[idx]);
+        else if (sig->decodeValue(frame, value))
+        {
+            sig->formatValue(value, outStrings[idx]);
+            outValid[idx] = true;
+        }
+        if (outValid[idx]) numValid++;
+    }
+    return numValid;
+}
+
+/*
+ * Returns the decoder for this message, rebuilt first if it is stale. Like DBC_SIGNAL::getExtractor() this is
+ * not safe to call from several threads while it rebuilds, so call it once beforehand when handing messages to threads.
+*/
+const DBCMessageDecoder &DBC_MESSAGE::getDecoder()
+{
+    if (!decoder.isFor(this)) decoder = DBCMessageDecoder(this);
+    return decoder;
+}
+
 DBC_ATTRIBUTE_VALUE *DBC_MESSAGE::findAttrValByName(QString name)
 {
     if (attributes.length() == 0) return NULL;
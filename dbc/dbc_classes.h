@@ -2,10 +2,13 @@
 #define DBC_CLASSES_H
 
 #include <QColor>
+#include <QHash>
 #include <QString>
 #include <QStringList>
 #include <QVariant>
+#include <QVector>
 #include "can_structs.h"
+#include "utility.h"
 
 /*classes to encapsulate data from a DBC file. Really, the stuff of interest
   are the nodes, messages, signals, attributes, and comments.
@@ -63,6 +66,40 @@ class DBC_VAL_ENUM_ENTRY
 public:
     int value;
     QString descript;
+
+    bool operator==(const DBC_VAL_ENUM_ENTRY &other) const
+    {
+        return value == other.value && descript == other.descript;
+    }
+};
+
+/*
+ * A signal's value list set up for showing decoded values as text. The descriptions are kept already formatted
+ * as "name: description" and are found through a table indexed by value when the values are close together,
+ * or by binary search of the sorted values when they are spread out (DTC codes and the like).
+ * Get one through DBC_SIGNAL::getValueTable() which rebuilds it when the signal's name, unit or value list change.
+*/
+class DBCValueTable
+{
+public:
+    DBCValueTable();
+    DBCValueTable(const QString &name, const QString &unitName, const QList<DBC_VAL_ENUM_ENTRY> &valList);
+
+    bool isFor(const QString &name, const QString &unitName, const QList<DBC_VAL_ENUM_ENTRY> &valList) const;
+    const QString *findText(int64_t value) const;
+    void format(double value, QString &outString) const;
+
+private:
+    //copies of what the table was built from. They share their data with the signal's until it changes them
+    QString sigName;
+    QString sigUnit;
+    QList<DBC_VAL_ENUM_ENTRY> sigValues;
+
+    QString prefix;             //"name: " for values that aren't in the list
+    QVector<QString> texts;     //formatted descriptions, one for each value in the list
+    QVector<int64_t> values;    //sorted, same order as texts
+    QVector<int> dense;         //texts index of each value from denseBase up, -1 where there is none. Empty if too sparse
+    int64_t denseBase;
 };
 
 class DBC_NODE
@@ -99,16 +136,59 @@ public: //TODO: this is sloppy. It shouldn't all be public!
     QString comment;
     QList<DBC_ATTRIBUTE_VALUE> attributes;
     QList<DBC_VAL_ENUM_ENTRY> valList;
+    SignalExtractor extractor; //compiled form of startBit/signalSize/byte order. Use getExtractor() to access it
+    DBCValueTable valueTable; //lookup form of valList. Use getValueTable() to access it
 
     bool processAsText(const CANFrame &frame, QString &outString);
     bool processAsInt(const CANFrame &frame, int32_t &outValue);
     bool processAsDouble(const CANFrame &frame, double &outValue);
+    int processAsDouble(const CANFrame *frames, int count, double *outValues, bool *outValid);
+    bool decodeValue(const CANFrame &frame, double &outValue);
+    void formatValue(double value, QString &outString);
+    const SignalExtractor &getExtractor();
+    const DBCValueTable &getValueTable();
     DBC_ATTRIBUTE_VALUE *findAttrValByName(QString name);
     DBC_ATTRIBUTE_VALUE *findAttrValByIdx(int idx);
 };
 
 class DBCSignalHandler; //forward declaration to keep from having to include dbchandler.h in this file and thus create a loop
 
+/*
+ * Decodes all of the signals of a message out of a frame in one go. The multiplexor is decoded once and then only the
+ * signals it selects, plus the ones that aren't multiplexed, are looked at. Going signal by signal instead has every
+ * multiplexed signal decode the multiplexor again just to find out whether it is in the frame at all.
+ * Results go into arrays with getCount() entries, in the same order as the message's sigHandler.
+ * Get one through DBC_MESSAGE::getDecoder() which rebuilds it when the message's signals have been changed.
+*/
+class DBCMessageDecoder
+{
+public:
+    DBCMessageDecoder();
+    DBCMessageDecoder(DBC_MESSAGE *msg);
+
+    bool isFor(DBC_MESSAGE *msg) const;
+    int getCount() const;
+    DBC_SIGNAL *getSignal(int idx) const;
+    int decode(const CANFrame &frame, double *outValues, bool *outValid) const;
+    int decodeText(const CANFrame &frame, QString *outStrings, bool *outValid) const;
+
+private:
+    struct Layout //what the signal looked like when the decoder was built, to tell when it no longer fits
+    {
+        DBC_SIGNAL *sig;
+        bool isMultiplexed;
+        int multiplexValue;
+    };
+
+    const QVector<int> *activeGroup(const CANFrame &frame) const;
+
+    DBC_MESSAGE *message;
+    DBC_SIGNAL *multiplexor;
+    QVector<Layout> layout;
+    QVector<int> plainSignals; //indexes of the signals found in every frame
+    QHash<int, QVector<int> > groups; //multiplexor value to indexes of the signals it selects
+};
+
 class DBC_MESSAGE
 {
 public:
@@ -124,7 +204,9 @@ public:
     QList<DBC_ATTRIBUTE_VALUE> attributes;
     DBCSignalHandler *sigHandler;
     DBC_SIGNAL* multiplexorSignal;
+    DBCMessageDecoder decoder; //use getDecoder() to access it
 
+    const DBCMessageDecoder &getDecoder();
     DBC_ATTRIBUTE_VALUE *findAttrValByName(QString name);
     DBC_ATTRIBUTE_VALUE *findAttrValByIdx(int idx);
 };
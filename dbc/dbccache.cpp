@@ -0,0 +1,257 @@
+#include "dbccache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include "dbchandler.h"
+
+#define DBCCACHE_MAGIC      0x53434443  //"SCDC"
+#define DBCCACHE_VERSION    1           //bump whenever what is written below changes
+
+//what an entry has to match to stand in for its source file
+struct SourceKey
+{
+    QString path;
+    qint64 size;
+    qint64 modified;
+
+    SourceKey(QString filename)
+    {
+        QFileInfo info(filename);
+        path = info.absoluteFilePath();
+        size = info.size();
+        modified = info.lastModified().toMSecsSinceEpoch();
+    }
+};
+
+QDataStream &operator<<(QDataStream &stream, const DBC_ATTRIBUTE_VALUE &val)
+{
+    stream << val.attrName;
+    stream << val.value;
+    return stream;
+}
+
+QDataStream &operator>>(QDataStream &stream, DBC_ATTRIBUTE_VALUE &val)
+{
+    stream >> val.attrName;
+    stream >> val.value;
+    return stream;
+}
+
+QDataStream &operator<<(QDataStream &stream, const DBC_VAL_ENUM_ENTRY &val)
+{
+    stream << (qint32)val.value;
+    stream << val.descript;
+    return stream;
+}
+
+QDataStream &operator>>(QDataStream &stream, DBC_VAL_ENUM_ENTRY &val)
+{
+    qint32 value;
+    stream >> value;
+    stream >> val.descript;
+    val.value = value;
+    return stream;
+}
+
+QDataStream &operator<<(QDataStream &stream, const DBC_ATTRIBUTE &attr)
+{
+    stream << attr.name;
+    stream << (qint32)attr.valType;
+    stream << (qint32)attr.attrType;
+    stream << attr.upper;
+    stream << attr.lower;
+    stream << attr.enumVals;
+    stream << attr.defaultValue;
+    return stream;
+}
+
+QDataStream &operator>>(QDataStream &stream, DBC_ATTRIBUTE &attr)
+{
+    qint32 valType, attrType;
+    stream >> attr.name;
+    stream >> valType;
+    stream >> attrType;
+    stream >> attr.upper;
+    stream >> attr.lower;
+    stream >> attr.enumVals;
+    stream >> attr.defaultValue;
+    attr.valType = (DBC_ATTRIBUTE_VAL_TYPE)valType;
+    attr.attrType = (DBC_ATTRIBUTE_TYPE)attrType;
+    return stream;
+}
+
+//messages and signals point at their nodes, the entry stores the node's position in the list instead
+static qint32 nodeIndex(DBCFile &file, DBC_NODE *node)
+{
+    if (!node) return -1;
+    for (int i = 0; i < file.dbc_nodes.count(); i++)
+    {
+        if (&file.dbc_nodes[i] == node) return i;
+    }
+    //copies of a DBCFile can still point at the nodes of the one they were copied from
+    for (int i = 0; i < file.dbc_nodes.count(); i++)
+    {
+        if (file.dbc_nodes[i].name == node->name) return i;
+    }
+    return -1;
+}
+
+static DBC_NODE *nodeAt(DBCFile &file, qint32 idx)
+{
+    if (idx < 0 || idx >= file.dbc_nodes.count()) return file.findNodeByIdx(0);
+    return &file.dbc_nodes[idx];
+}
+
+QString DBCCache::entryPath(QString filename)
+{
+    QByteArray hash = QCryptographicHash::hash(SourceKey(filename).path.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/dbc/" + QString::fromLatin1(hash) + ".dbcache";
+}
+
+bool DBCCache::save(QString filename, DBCFile &file)
+{
+    if (!file.loadErrors.isEmpty()) return false;
+
+    QString path = entryPath(filename);
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) return false;
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) return false;
+
+    SourceKey key(filename);
+    QDataStream stream(&out);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << (quint32)DBCCACHE_MAGIC << (quint32)DBCCACHE_VERSION;
+    stream << key.path << key.size << key.modified;
+
+    stream << (qint32)file.dbc_nodes.count();
+    for (int i = 0; i < file.dbc_nodes.count(); i++)
+    {
+        const DBC_NODE &node = file.dbc_nodes[i];
+        stream << node.name << node.comment << node.attributes;
+    }
+
+    stream << file.dbc_attributes;
+    stream << file.messageHandler->isJ1939();
+
+    stream << (qint32)file.messageHandler->getCount();
+    for (int i = 0; i < file.messageHandler->getCount(); i++)
+    {
+        DBC_MESSAGE *msg = file.messageHandler->findMsgByIdx(i);
+        stream << (quint32)msg->ID << msg->name << msg->comment << (quint32)msg->len << nodeIndex(file, msg->sender);
+        stream << msg->bgColor << msg->fgColor << msg->attributes;
+
+        qint32 multiplexor = -1;
+        stream << (qint32)msg->sigHandler->getCount();
+        for (int s = 0; s < msg->sigHandler->getCount(); s++)
+        {
+            DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(s);
+            if (sig == msg->multiplexorSignal) multiplexor = s;
+            stream << sig->name << (qint32)sig->startBit << (qint32)sig->signalSize << sig->intelByteOrder;
+            stream << sig->isMultiplexor << sig->isMultiplexed << (qint32)sig->multiplexValue << (qint32)sig->valType;
+            stream << sig->factor << sig->bias << sig->min << sig->max << nodeIndex(file, sig->receiver);
+            stream << sig->unitName << sig->comment << sig->attributes << sig->valList;
+        }
+        stream << multiplexor;
+    }
+
+    if (stream.status() != QDataStream::Ok) return false;
+    return out.commit();
+}
+
+bool DBCCache::load(QString filename, DBCFile &file)
+{
+    QFile in(entryPath(filename));
+    if (!in.open(QIODevice::ReadOnly)) return false;
+    uchar *mapped = in.map(0, in.size());
+    if (!mapped) return false;
+
+    //read in place, nothing is copied out of the mapping but the strings themselves
+    QByteArray bytes = QByteArray::fromRawData((const char *)mapped, in.size());
+    QDataStream stream(bytes);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0, version = 0;
+    SourceKey key(filename);
+    QString path;
+    qint64 size = -1, modified = -1;
+    stream >> magic >> version;
+    if (magic != DBCCACHE_MAGIC || version != DBCCACHE_VERSION) return false;
+    stream >> path >> size >> modified;
+    if (path != key.path || size != key.size || modified != key.modified) return false;
+
+    file.dbc_nodes.clear();
+    file.dbc_attributes.clear();
+    file.messageHandler->removeAllMessages();
+    file.loadErrors.clear();
+
+    qint32 count = 0;
+    stream >> count;
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        DBC_NODE node;
+        stream >> node.name >> node.comment >> node.attributes;
+        file.dbc_nodes.append(node);
+    }
+
+    bool isJ1939 = false;
+    stream >> file.dbc_attributes;
+    stream >> isJ1939;
+
+    //everything goes through addMessage() and addSignal() so the lookups and extractors are built as usual
+    stream >> count;
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        DBC_MESSAGE msg;
+        quint32 id, len;
+        qint32 sender, numSignals, multiplexor;
+        stream >> id >> msg.name >> msg.comment >> len >> sender;
+        stream >> msg.bgColor >> msg.fgColor >> msg.attributes;
+        msg.ID = id;
+        msg.len = len;
+        msg.sender = nodeAt(file, sender);
+        file.messageHandler->addMessage(msg);
+        DBC_MESSAGE *added = file.messageHandler->findMsgByIdx(file.messageHandler->getCount() - 1);
+
+        stream >> numSignals;
+        for (int s = 0; s < numSignals && stream.status() == QDataStream::Ok; s++)
+        {
+            DBC_SIGNAL sig;
+            qint32 startBit, signalSize, multiplexValue, valType, receiver;
+            stream >> sig.name >> startBit >> signalSize >> sig.intelByteOrder;
+            stream >> sig.isMultiplexor >> sig.isMultiplexed >> multiplexValue >> valType;
+            stream >> sig.factor >> sig.bias >> sig.min >> sig.max >> receiver;
+            stream >> sig.unitName >> sig.comment >> sig.attributes >> sig.valList;
+            sig.startBit = startBit;
+            sig.signalSize = signalSize;
+            sig.multiplexValue = multiplexValue;
+            sig.valType = (DBC_SIG_VAL_TYPE)valType;
+            sig.receiver = nodeAt(file, receiver);
+            sig.parentMessage = added;
+            added->sigHandler->addSignal(sig);
+        }
+        stream >> multiplexor;
+        added->multiplexorSignal = added->sigHandler->findSignalByIdx(multiplexor);
+    }
+
+    if (stream.status() != QDataStream::Ok || !stream.atEnd())
+    {
+        //a damaged entry, so it is parsed from the source again
+        file.dbc_nodes.clear();
+        file.dbc_attributes.clear();
+        file.messageHandler->removeAllMessages();
+        return false;
+    }
+
+    file.messageHandler->setJ1939(isJ1939);
+    QStringList fileList = filename.split('/');
+    file.fileName = fileList[fileList.length() - 1];
+    file.filePath = filename.left(filename.length() - file.fileName.length());
+    file.assocBuses = -1;
+    return true;
+}
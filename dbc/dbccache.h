@@ -0,0 +1,25 @@
+#ifndef DBCCACHE_H
+#define DBCCACHE_H
+
+#include <QString>
+
+class DBCFile;
+
+/*
+ * Parsed DBC files kept in binary form in the cache directory, one entry per source file. An entry records the
+ * source's path, size and modification time and is only used while all three still match, so a DBC file that has
+ * been edited or replaced is simply parsed (and cached) again. Entries are memory mapped and read straight into
+ * the DBCFile, which takes a few milliseconds where parsing a big DBC file takes a good part of a second.
+ */
+class DBCCache
+{
+public:
+    //fills file from the entry for filename. False if there isn't a usable one, and then file is left to loadFile()
+    static bool load(QString filename, DBCFile &file);
+    //writes the entry for filename. Files that loaded with errors aren't cached so the errors keep being shown
+    static bool save(QString filename, DBCFile &file);
+    //where the entry for filename is kept
+    static QString entryPath(QString filename);
+};
+
+#endif // DBCCACHE_H
@@ -1,16 +1,31 @@
 #include "dbchandler.h"
 
 #include <QFile>
-#include <QRegularExpression>
 #include <QDebug>
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QApplication>
 #include <QPalette>
+#include <ctype.h>
 #include "utility.h"
+#include "utils/textscanner.h"
+#include "dbccache.h"
 
 DBCHandler* DBCHandler::instance = NULL;
 
+//true when there is a GUI to show things in. Command line tools load DBC files with just a QCoreApplication
+static bool haveGUI()
+{
+    return qobject_cast<QApplication *>(QCoreApplication::instance()) != NULL;
+}
+
+//text color messages get unless the file says otherwise. The palette only exists when there is a GUI
+static QString defaultTextColor()
+{
+    if (haveGUI()) return QApplication::palette().color(QPalette::WindowText).name();
+    return QColor(Qt::black).name();
+}
+
 DBC_SIGNAL* DBCSignalHandler::findSignalByIdx(int idx)
 {
     if (sigs.count() == 0) return NULL;
@@ -36,6 +51,8 @@ DBC_SIGNAL* DBCSignalHandler::findSignalByName(QString name)
 bool DBCSignalHandler::addSignal(DBC_SIGNAL &sig)
 {
     sigs.append(sig);
+    sigs.last().getExtractor(); //compile it now rather than on the first decoded frame
+    sigs.last().getValueTable();
     return true;
 }
 
@@ -83,39 +100,31 @@ int DBCSignalHandler::getCount()
 DBC_MESSAGE* DBCMessageHandler::findMsgByID(uint32_t id)
 {
     if (messages.count() == 0) return NULL;
-    for (int i = 0; i < messages.count(); i++)
+
+    QHash<uint32_t, int>::const_iterator it;
+    if (isJ1939Handler)
     {
-        if (isJ1939Handler)
+        // include data page and extended data page in the pgn
+        uint32_t pgn = (id & 0x3FFFF00) >> 8;
+        if ( (pgn & 0xFF00) <= 0xEF00 )
         {
-            // include data page and extended data page in the pgn
-            uint32_t pgn = (id & 0x3FFFF00) >> 8;
-            if ( (pgn & 0xFF00) <= 0xEF00 )
-            {
-                // PDU1 format
-                pgn &= 0x3FF00;
-                if ((messages[i].ID & 0x3FF0000) == (pgn << 8))
-                {
-                    return &messages[i];
-                }
-            }
-            else
-            {
-                // PDU2 format
-                if ((messages[i].ID & 0x3FFFF00) == (pgn << 8))
-                {
-                    return &messages[i];
-                }
-            }
+            // PDU1 format - the PS byte is the destination address so it doesn't take part in the match
+            it = pdu1Index.constFind(pgn >> 8);
+            if (it == pdu1Index.constEnd()) return NULL;
         }
         else
         {
-            if ( messages[i].ID == id )
-            {
-                return &messages[i];
-            }
+            // PDU2 format
+            it = pdu2Index.constFind(pgn);
+            if (it == pdu2Index.constEnd()) return NULL;
         }
     }
-    return NULL;
+    else
+    {
+        it = idIndex.constFind(id);
+        if (it == idIndex.constEnd()) return NULL;
+    }
+    return &messages[it.value()];
 }
 
 DBC_MESSAGE* DBCMessageHandler::findMsgByIdx(int idx)
@@ -142,6 +151,7 @@ DBC_MESSAGE* DBCMessageHandler::findMsgByName(QString name)
 bool DBCMessageHandler::addMessage(DBC_MESSAGE &msg)
 {
     messages.append(msg);
+    indexMessage(messages.count() - 1);
     return true;
 }
 
@@ -158,6 +168,7 @@ bool DBCMessageHandler::removeMessageByIndex(int idx)
     if (idx < 0) return false;
     if (idx >= messages.count()) return false;
     messages.removeAt(idx);
+    rebuildIndex();
     return true;
 }
 
@@ -173,6 +184,7 @@ bool DBCMessageHandler::removeMessage(uint32_t ID)
             foundSome = true;
         }
     }
+    if (foundSome) rebuildIndex();
     return foundSome;
 }
 
@@ -188,12 +200,16 @@ bool DBCMessageHandler::removeMessage(QString name)
             foundSome = true;
         }
     }
+    if (foundSome) rebuildIndex();
     return foundSome;
 }
 
 void DBCMessageHandler::removeAllMessages()
 {
     messages.clear();
+    idIndex.clear();
+    pdu1Index.clear();
+    pdu2Index.clear();
 }
 
 int DBCMessageHandler::getCount()
@@ -211,6 +227,33 @@ void DBCMessageHandler::setJ1939(bool j1939)
     isJ1939Handler = j1939;
 }
 
+/*
+ * Adds the message at idx to the lookup tables. Only the first message with a given key
+ * is recorded so lookups return the same message a front to back search of the list would.
+ * Both J1939 tables are always kept up to date so that toggling J1939 mode costs nothing.
+*/
+void DBCMessageHandler::indexMessage(int idx)
+{
+    uint32_t id = messages[idx].ID;
+    if (!idIndex.contains(id)) idIndex.insert(id, idx);
+
+    uint32_t pdu1Key = (id >> 16) & 0x3FF;
+    if (!pdu1Index.contains(pdu1Key)) pdu1Index.insert(pdu1Key, idx);
+
+    uint32_t pdu2Key = (id >> 8) & 0x3FFFF;
+    if (!pdu2Index.contains(pdu2Key)) pdu2Index.insert(pdu2Key, idx);
+}
+
+//removing from the list shifts the index of everything after it so just start over
+void DBCMessageHandler::rebuildIndex()
+{
+    idIndex.clear();
+    pdu1Index.clear();
+    pdu2Index.clear();
+    idIndex.reserve(messages.count());
+    for (int i = 0; i < messages.count(); i++) indexMessage(i);
+}
+
 DBCFile::DBCFile()
 {
     messageHandler = new DBCMessageHandler;
@@ -231,6 +274,7 @@ DBCFile::DBCFile(const DBCFile& cpy)
     dbc_nodes.append(cpy.dbc_nodes);
     dbc_attributes.clear();
     dbc_attributes.append(cpy.dbc_attributes);
+    loadErrors = cpy.loadErrors;
 }
 
 DBCFile& DBCFile::operator=(const DBCFile& cpy)
@@ -245,6 +289,7 @@ DBCFile& DBCFile::operator=(const DBCFile& cpy)
         dbc_nodes.append(cpy.dbc_nodes);
         dbc_attributes.clear();
         dbc_attributes.append(cpy.dbc_attributes);
+        loadErrors = cpy.loadErrors;
     }
     return *this;
 }
@@ -326,452 +371,831 @@ void DBCFile::findAttributesByType(DBC_ATTRIBUTE_TYPE typ, QList<DBC_ATTRIBUTE>
     }
 }
 
-void DBCFile::loadFile(QString fileName)
+/*
+ * Tokens of a DBC file, read straight out of the file contents. Statements like BO_ and SG_ end at the end of
+ * their line while CM_, VAL_ and the attribute statements run up to a ; and can cover several lines (comments
+ * quite often do), so whether newlines are skipped over like spaces is switched per statement.
+ */
+class DBCScanner
 {
-    QFile *inFile = new QFile(fileName);
-    QString line;
-    QRegularExpression regex;
-    QRegularExpressionMatch match;
-    DBC_MESSAGE *currentMessage = NULL;
-    DBC_ATTRIBUTE attr;
-    int numSigFaults = 0, numMsgFaults = 0;
+public:
+    DBCScanner(const QByteArray &text) :
+        begin(text.constData()), pos(text.constData()), end(text.constData() + text.size()), line(1), multiline(true) {}
 
-    qDebug() << "DBC File: " << fileName;
+    int lineNumber() const { return line; }
+    void setMultiline(bool skipNewlines) { multiline = skipNewlines; }
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
+    void skipSpace()
     {
-        delete inFile;
-        return;
+        while (pos < end)
+        {
+            if (*pos == '\n')
+            {
+                if (!multiline) return;
+                line++;
+            }
+            else if (!TextSpan::isSpace(*pos)) return;
+            pos++;
+        }
     }
 
-    qDebug() << "Starting DBC load";
-    dbc_nodes.clear();
-    messageHandler->removeAllMessages();
-    messageHandler->setJ1939(false);
+    bool atEnd()
+    {
+        skipSpace();
+        return pos >= end;
+    }
 
-    DBC_NODE falseNode;
-    falseNode.name = "Vector__XXX";
-    falseNode.comment = "Default node if none specified";
-    dbc_nodes.append(falseNode);
+    bool atLineEnd()
+    {
+        skipSpace();
+        return pos >= end || *pos == '\n';
+    }
 
-    while (!inFile->atEnd()) {
-        line = QString(inFile->readLine().simplified());
-        if (line.startsWith("BO_ ")) //defines a message
+    bool peek(char c)
+    {
+        skipSpace();
+        return pos < end && *pos == c;
+    }
+
+    bool accept(char c)
+    {
+        if (!peek(c)) return false;
+        pos++;
+        return true;
+    }
+
+    //letters, digits and underscores. Empty if there isn't one here
+    TextSpan identifier()
+    {
+        skipSpace();
+        const char *start = pos;
+        while (pos < end && (isalnum((uchar)*pos) || *pos == '_')) pos++;
+        return TextSpan(start, pos - start);
+    }
+
+    //a number as written, with its sign, fraction and exponent
+    TextSpan number()
+    {
+        skipSpace();
+        const char *start = pos;
+        if (pos < end && (*pos == '-' || *pos == '+')) pos++;
+        while (pos < end)
         {
-            qDebug() << "Found a BO line";
-            regex.setPattern("^BO\\_ (\\w+) (\\w+) *: (\\w+) (\\w+)");
-            match = regex.match(line);
-            //captured 1 = the ID in decimal
-            //captured 2 = The message name
-            //captured 3 = the message length
-            //captured 4 = the NODE responsible for this message
-            if (match.hasMatch())
+            if (TextSpan::isDigit(*pos) || *pos == '.') pos++;
+            else if (*pos == 'e' || *pos == 'E')
             {
-                DBC_MESSAGE msg;
-                msg.ID = match.captured(1).toULong() & 0x7FFFFFFFul; //the ID is always stored in decimal format
-                msg.name = match.captured(2);
-                msg.len = match.captured(3).toInt();
-                msg.sender = findNodeByName(match.captured(4));
-                messageHandler->addMessage(msg);
-                currentMessage = messageHandler->findMsgByID(msg.ID);
+                pos++;
+                if (pos < end && (*pos == '-' || *pos == '+')) pos++;
             }
-            else numMsgFaults++;
+            else break;
         }
-        if (line.startsWith("SG_ ")) //defines a signal
-        {
-            int offset = 0;
-            bool isMultiplexor = false;
-            //bool isMultiplexed = false;
-            DBC_SIGNAL sig;
+        return TextSpan(start, pos - start);
+    }
 
-            sig.multiplexValue = 0;
-            sig.isMultiplexed = false;
-            sig.isMultiplexor = false;
+    bool integer(qint64 &value)
+    {
+        bool ok;
+        value = number().toInt(&ok);
+        return ok;
+    }
 
-            qDebug() << "Found a SG line";
-            regex.setPattern("^SG\\_ *(\\w+) +M *: *(\\d+)\\|(\\d+)@(\\d+)([\\+|\\-]) \\(([0-9.+\\-eE]+),([0-9.+\\-eE]+)\\) \\[([0-9.+\\-eE]+)\\|([0-9.+\\-eE]+)\\] \\\"(.*)\\\" (.*)");
+    bool real(double &value)
+    {
+        bool ok;
+        value = number().toDouble(&ok);
+        return ok;
+    }
 
-            match = regex.match(line);
-            if (match.hasMatch())
-            {
-                qDebug() << "Multiplexor signal";
-                isMultiplexor = true;
-                sig.isMultiplexor = true;
-            }
-            else
+    //a quoted string, which may run over several lines. \" and \\ stand for the character after the backslash
+    bool string(QString &value)
+    {
+        if (!accept('"')) return false;
+        const char *start = pos;
+        bool plain = true; //nothing to take out
+        while (pos < end && *pos != '"')
+        {
+            if (*pos == '\\' && pos + 1 < end)
             {
-                regex.setPattern("^SG\\_ *(\\w+) +m(\\d+) *: *(\\d+)\\|(\\d+)@(\\d+)([\\+|\\-]) \\(([0-9.+\\-eE]+),([0-9.+\\-eE]+)\\) \\[([0-9.+\\-eE]+)\\|([0-9.+\\-eE]+)\\] \\\"(.*)\\\" (.*)");
-                match = regex.match(line);
-                if (match.hasMatch())
-                {
-                    qDebug() << "Multiplexed signal";
-                    //isMultiplexed = true;
-                    sig.isMultiplexed = true;
-                    sig.multiplexValue = match.captured(2).toInt();
-                    offset = 1;
-                }
-                else
-                {
-                    qDebug() << "standard signal";
-                    regex.setPattern("^SG\\_ *(\\w+) *: *(\\d+)\\|(\\d+)@(\\d+)([\\+|\\-]) \\(([0-9.+\\-eE]+),([0-9.+\\-eE]+)\\) \\[([0-9.+\\-eE]+)\\|([0-9.+\\-eE]+)\\] \\\"(.*)\\\" (.*)");
-                    match = regex.match(line);
-                    sig.isMultiplexed = false;
-                    sig.isMultiplexor = false;
-                }
+                plain = false;
+                pos++;
             }
+            if (*pos == '\n') line++;
+            else if (*pos == '\r') plain = false;
+            pos++;
+        }
+        if (pos >= end) return false;
 
-            //captured 1 is the signal name
-            //captured 2 would be multiplex value if this is a multiplex signal. Then offset the rest of these by 1
-            //captured 2 is the starting bit
-            //captured 3 is the length in bits
-            //captured 4 is the byte order / value type
-            //captured 5 specifies signed/unsigned for ints
-            //captured 6 is the scaling factor
-            //captured 7 is the offset
-            //captured 8 is the minimum value
-            //captured 9 is the maximum value
-            //captured 10 is the unit
-            //captured 11 is the receiving node
-
-            if (match.hasMatch())
+        if (plain) value = QString::fromUtf8(start, pos - start);
+        else
+        {
+            //line breaks come out as plain newlines whatever the file uses
+            QByteArray bytes;
+            for (const char *c = start; c < pos; c++)
             {
-                sig.name = match.captured(1);
-                sig.startBit = match.captured(2 + offset).toInt();
-                sig.signalSize = match.captured(3 + offset).toInt();
-                int val = match.captured(4 + offset).toInt();
-                if (val < 2)
-                {
-                    if (match.captured(5 + offset) == "+") sig.valType = UNSIGNED_INT;
-                    else sig.valType = SIGNED_INT;
-                }
-                switch (val)
-                {
-                case 0: //big endian mode
-                    sig.intelByteOrder = false;
-                    break;
-                case 1: //little endian mode
-                    sig.intelByteOrder = true;
-                    break;
-                case 2:
-                    sig.valType = SP_FLOAT;
-                    break;
-                case 3:
-                    sig.valType = DP_FLOAT;
-                    break;
-                case 4:
-                    sig.valType = STRING;
-                    break;
-                }
-                sig.factor = match.captured(6 + offset).toDouble();
-                sig.bias = match.captured(7 + offset).toDouble();
-                sig.min = match.captured(8 + offset).toDouble();
-                sig.max = match.captured(9 + offset).toDouble();
-                sig.unitName = match.captured(10 + offset);
-                if (match.captured(11 + offset).contains(','))
-                {
-                    QString tmp = match.captured(11 + offset).split(',')[0];
-                    sig.receiver = findNodeByName(tmp);
-                }
-                else sig.receiver = findNodeByName(match.captured(11 + offset));
-                sig.parentMessage = currentMessage;
-                currentMessage->sigHandler->addSignal(sig);
-                if (isMultiplexor) currentMessage->multiplexorSignal = currentMessage->sigHandler->findSignalByName(sig.name);
+                if (*c == '\\') c++;
+                else if (*c == '\r') continue;
+                bytes.append(*c);
             }
-            else numSigFaults++;
+            value = QString::fromUtf8(bytes);
         }
-        if (line.startsWith("BU_:")) //line specifies the nodes on this canbus
+        pos++;
+        return true;
+    }
+
+    //a quoted string or whatever runs up to the next space or ;, which is how attribute values come
+    bool value(QString &text)
+    {
+        if (peek('"')) return string(text);
+        const char *start = pos;
+        while (pos < end && !TextSpan::isSpace(*pos) && *pos != ';') pos++;
+        text = QString::fromUtf8(start, pos - start);
+        return pos > start;
+    }
+
+    //on to the start of the next line, stepping over quoted strings that carry on past this one
+    void skipLine()
+    {
+        skipRest(false);
+    }
+
+    //on past the next ; that isn't in quotes
+    void skipStatement()
+    {
+        skipRest(true);
+    }
+
+    //true at the start of a line that is indented and not blank. The NS_ list is made of these
+    bool atIndentedLine()
+    {
+        const char *c = pos;
+        if (c >= end || (*c != ' ' && *c != '\t')) return false;
+        while (c < end && TextSpan::isSpace(*c) && *c != '\n') c++;
+        return c < end && *c != '\n';
+    }
+
+private:
+    //true at a line that starts one of the statements loadFile() reads
+    bool atKeyword()
+    {
+        static const char *keywords[] = {"BO_", "SG_", "BU_", "CM_", "VAL_", "BA_DEF_", "BA_DEF_DEF_", "BA_"};
+        const char *c = pos;
+        while (c < end && (*c == ' ' || *c == '\t')) c++;
+        const char *start = c;
+        while (c < end && (isalnum((uchar)*c) || *c == '_')) c++;
+        TextSpan word(start, c - start);
+        for (unsigned int i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++)
         {
-            qDebug() << "Found a BU line";
-            regex.setPattern("^BU\\_\\:(.*)");
-            match = regex.match(line);
-            //captured 1 = a list of node names separated by spaces. No idea how many yet
-            if (match.hasMatch())
-            {
-                QStringList nodeStrings = match.captured(1).split(' ');
-                qDebug() << "Found " << nodeStrings.count() << " node names";
-                for (int i = 0; i < nodeStrings.count(); i++)
-                {
-                    //qDebug() << nodeStrings[i];
-                    if (nodeStrings[i].length() > 1)
-                    {
-                        DBC_NODE node;
-                        node.name = nodeStrings[i];
-                        dbc_nodes.append(node);
-                    }
-                }
-            }
+            if (word.equals(keywords[i])) return true;
         }
-        if (line.startsWith("CM_ SG_ "))
+        return false;
+    }
+
+    void skipRest(bool toSemicolon)
+    {
+        //the failed statement may already have skipped over the newline to the next one
+        const char *back = pos;
+        while (back > begin && (back[-1] == ' ' || back[-1] == '\t')) back--;
+        if (toSemicolon && back > begin && back[-1] == '\n' && atKeyword()) return;
+
+        bool quoted = false;
+        while (pos < end)
         {
-            qDebug() << "Found an SG comment line";
-            regex.setPattern("^CM\\_ SG\\_ *(\\w+) *(\\w+) *\\\"(.*)\\\";");
-            match = regex.match(line);
-            //captured 1 is the ID to match against to get to the message
-            //captured 2 is the signal name from that message
-            //captured 3 is the comment itself
-            if (match.hasMatch())
+            char c = *pos++;
+            if (c == '\n')
             {
-                //qDebug() << "Comment was: " << match.captured(3);
-                DBC_MESSAGE *msg = messageHandler->findMsgByID(match.captured(1).toInt());
-                if (msg != NULL)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByName(match.captured(2));
-                    if (sig != NULL)
-                    {
-                        sig->comment = match.captured(3);
-                    }
-                }
+                line++;
+                //a statement missing its ; shouldn't take the next one with it
+                if (!quoted && (!toSemicolon || atKeyword())) return;
             }
+            else if (c == '"') quoted = !quoted;
+            else if (c == '\\' && quoted && pos < end && *pos != '\n') pos++;
+            else if (c == ';' && !quoted && toSemicolon) return;
         }
-        if (line.startsWith("CM_ BO_ "))
+    }
+
+    const char *begin;
+    const char *pos;
+    const char *end;
+    int line;
+    bool multiline;
+};
+
+/*
+ * Something a comment, value table or attribute statement refers to by message ID, signal or node name. These
+ * are collected while the file is read and then matched up in one go once everything is defined.
+ */
+struct DBCFixup
+{
+    enum Kind
+    {
+        MESSAGE_COMMENT,
+        SIGNAL_COMMENT,
+        NODE_COMMENT,
+        SIGNAL_VALUES,
+        //the ones that need an attribute definition come last
+        MESSAGE_ATTRIBUTE,
+        SIGNAL_ATTRIBUTE,
+        NODE_ATTRIBUTE,
+        ATTRIBUTE_DEFAULT
+    };
+
+    Kind kind;
+    int line;
+    uint32_t id;
+    QString name;       //signal or node name
+    QString attrName;
+    QString text;       //comment, or attribute value as written
+    QList<DBC_VAL_ENUM_ENTRY> values;
+};
+
+/*
+ * Reads a DBC file in one pass. Nodes, messages, signals and attribute definitions are added to the file as they
+ * come. Everything that refers back to them is kept as a DBCFixup and applied at the end through hashes of the
+ * message IDs, signal names and attribute names, rather than searching lists for each line the way the regular
+ * expression based loader did. Statements that can't be parsed are left out and noted with their line number.
+ */
+class DBCParser
+{
+public:
+    DBCParser(DBCFile *pFile, const QByteArray &text) : file(pFile), scan(text), currentMessage(NULL), statementLine(0) {}
+
+    void parse();
+
+    QStringList errors;
+
+private:
+    bool parseNodes();
+    bool parseMessage();
+    bool parseSignal();
+    bool parseComment();
+    bool parseValues();
+    bool parseAttributeDef();
+    bool parseAttributeDefault();
+    bool parseAttributeValue();
+    void skipNamespaces();
+    void applyFixups();
+    void applyFixup(const DBCFixup &fixup);
+
+    DBC_NODE *node(const TextSpan &name);
+    QVariant attributeValue(const DBC_ATTRIBUTE *attr, const QString &text);
+    void setAttributeValue(QList<DBC_ATTRIBUTE_VALUE> &attributes, const DBC_ATTRIBUTE *attr, const QString &text);
+    bool fail(QString what);
+    void noteError(int line, QString what);
+
+    DBCFile *file;
+    DBCScanner scan;
+    DBC_MESSAGE *currentMessage; //the one SG_ lines are added to
+    int statementLine;
+    QHash<uint32_t, DBC_MESSAGE *> messageIndex;
+    QHash<QPair<uint32_t, QString>, DBC_SIGNAL *> signalIndex;
+    QHash<QString, int> nodeIndex;
+    QHash<QString, DBC_ATTRIBUTE *> attributeIndex;
+    QList<DBCFixup> fixups;
+};
+
+void DBCParser::parse()
+{
+    for (int i = 0; i < file->dbc_nodes.count(); i++) nodeIndex.insert(file->dbc_nodes[i].name, i);
+
+    while (!scan.atEnd())
+    {
+        statementLine = scan.lineNumber();
+        TextSpan keyword = scan.identifier();
+        bool ok = true;
+
+        //these end with their line, everything else with a ;
+        bool lineStatement = keyword.equals("BO_") || keyword.equals("SG_") || keyword.equals("BU_") ||
+                             keyword.equals("NS_") || keyword.equals("BS_") || keyword.equals("VERSION");
+        scan.setMultiline(!lineStatement);
+
+        if (keyword.equals("BO_")) ok = parseMessage();
+        else if (keyword.equals("SG_")) ok = parseSignal();
+        else if (keyword.equals("BU_")) ok = parseNodes();
+        else if (keyword.equals("NS_")) skipNamespaces();
+        else if (keyword.equals("CM_")) ok = parseComment();
+        else if (keyword.equals("VAL_")) ok = parseValues();
+        else if (keyword.equals("BA_DEF_")) ok = parseAttributeDef();
+        else if (keyword.equals("BA_DEF_DEF_")) ok = parseAttributeDefault();
+        else if (keyword.equals("BA_")) ok = parseAttributeValue();
+        else if (!isalpha((uchar)keyword.at(0)))
         {
-            qDebug() << "Found a BO comment line";
-            regex.setPattern("^CM\\_ BO\\_ *(\\w+) *\\\"(.*)\\\";");
-            match = regex.match(line);
-            //captured 1 is the ID to match against to get to the message
-            //captured 2 is the comment itself
-            if (match.hasMatch())
-            {
-                //qDebug() << "Comment was: " << match.captured(2);
-                DBC_MESSAGE *msg = messageHandler->findMsgByID(match.captured(1).toInt());
-                if (msg != NULL)
-                {
-                    msg->comment = match.captured(2);
-                }
-            }
+            noteError(statementLine, "expected a keyword");
+            scan.setMultiline(false);
+            scan.skipLine();
         }
-        if (line.startsWith("CM_ BU_ "))
+        else if (lineStatement) scan.skipLine();
+        else scan.skipStatement(); //VAL_TABLE_, BO_TX_BU_, SIG_VALTYPE_ and the rest aren't kept
+
+        if (!ok)
         {
-            qDebug() << "Found a BU comment line";
-            regex.setPattern("^CM\\_ BU\\_ *(\\w+) *\\\"(.*)\\\";");
-            match = regex.match(line);
-            //captured 1 is the Node name
-            //captured 2 is the comment itself
-            if (match.hasMatch())
-            {
-                //qDebug() << "Comment was: " << match.captured(2);
-                DBC_NODE *node = findNodeByName(match.captured(1));
-                if (node != NULL)
-                {
-                    node->comment = match.captured(2);
-                }
-            }
+            //start again at the next statement
+            if (lineStatement) scan.skipLine();
+            else scan.skipStatement();
         }
-        //VAL_ (1090) (VCUPresentParkLightOC) (1 "Error present" 0 "Error not present") ;
-        if (line.startsWith("VAL_ "))
+        scan.setMultiline(true);
+    }
+
+    applyFixups();
+}
+
+//NS_ : is followed by an indented list of the keywords the file may use, which is of no interest
+void DBCParser::skipNamespaces()
+{
+    scan.skipLine();
+    while (scan.atIndentedLine()) scan.skipLine();
+}
+
+//BU_: node1 node2 ...
+bool DBCParser::parseNodes()
+{
+    if (!scan.accept(':')) return fail("expected : after BU_");
+    while (!scan.atLineEnd())
+    {
+        TextSpan name = scan.identifier();
+        if (name.isEmpty()) return fail("bad node name");
+
+        DBC_NODE node;
+        node.name = QString::fromUtf8(name.ptr, name.len);
+        if (!nodeIndex.contains(node.name)) nodeIndex.insert(node.name, file->dbc_nodes.count());
+        file->dbc_nodes.append(node);
+    }
+    return true;
+}
+
+//BO_ 1090 VCU_Status: 8 VCU
+bool DBCParser::parseMessage()
+{
+    //signals of a message that didn't parse mustn't end up in the one before it
+    currentMessage = NULL;
+
+    qint64 id, len;
+    if (!scan.integer(id)) return fail("bad message ID");
+    TextSpan name = scan.identifier();
+    if (name.isEmpty()) return fail("bad message name");
+    if (!scan.accept(':')) return fail("expected : after the message name");
+    if (!scan.integer(len)) return fail("bad message length");
+
+    DBC_MESSAGE msg;
+    msg.ID = (uint32_t)id & 0x7FFFFFFFul; //the ID is always stored in decimal format
+    msg.name = QString::fromUtf8(name.ptr, name.len);
+    msg.len = len;
+    msg.sender = node(scan.identifier());
+    file->messageHandler->addMessage(msg);
+
+    currentMessage = file->messageHandler->findMsgByIdx(file->messageHandler->getCount() - 1);
+    //references by ID go to the first message with it, same as findMsgByID
+    if (!messageIndex.contains(msg.ID)) messageIndex.insert(msg.ID, currentMessage);
+    scan.skipLine();
+    return true;
+}
+
+//SG_ name [M|mN] : start|size@order sign (factor,offset) [min|max] "unit" receiver,receiver...
+bool DBCParser::parseSignal()
+{
+    if (!currentMessage) return fail("signal outside of a message");
+
+    DBC_SIGNAL sig;
+    sig.multiplexValue = 0;
+    sig.isMultiplexed = false;
+    sig.isMultiplexor = false;
+    sig.intelByteOrder = false;
+
+    TextSpan name = scan.identifier();
+    if (name.isEmpty()) return fail("bad signal name");
+    sig.name = QString::fromUtf8(name.ptr, name.len);
+
+    if (!scan.peek(':'))
+    {
+        TextSpan mux = scan.identifier();
+        if (mux.equals("M")) sig.isMultiplexor = true;
+        else if (mux.at(0) == 'm')
         {
-            qDebug() << "Found a value definition line";
-            regex.setPattern("^VAL\\_ (\\w+) (\\w+) (.*);");
-            match = regex.match(line);
-            //captured 1 is the ID to match against
-            //captured 2 is the signal name to match against
-            //captured 3 is a series of values in the form (number "text") that is, all sep'd by spaces
-            if (match.hasMatch())
-            {
-                //qDebug() << "Data was: " << match.captured(3);
-                DBC_MESSAGE *msg = messageHandler->findMsgByID(match.captured(1).toInt());
-                if (msg != NULL)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByName(match.captured(2));
-                    if (sig != NULL)
-                    {
-                        QString tokenString = match.captured(3);
-                        DBC_VAL_ENUM_ENTRY val;
-                        while (tokenString.length() > 2)
-                        {
-                            regex.setPattern("(\\d+) \\\"(.*?)\\\"(.*)");
-                            match = regex.match(tokenString);
-                            if (match.hasMatch())
-                            {
-                                val.value = match.captured(1).toInt();
-                                val.descript = match.captured(2);
-                                //qDebug() << "sig val " << val.value << " desc " <<val.descript;
-                                sig->valList.append(val);
-                                int rightSize = tokenString.length() - match.captured(1).length() - match.captured(2).length() - 4;
-                                if (rightSize > 0) tokenString = tokenString.right(rightSize);
-                                else tokenString = "";
-                                //qDebug() << "New token string: " << tokenString;
-                            }
-                            else tokenString = "";
-                        }
-                    }
-                }
-            }
+            //mNM (a multiplexed signal that is itself a multiplexor) is only taken as multiplexed
+            TextSpan value = mux.mid(1);
+            if (value.at(value.len - 1) == 'M') value = value.mid(0, value.len - 1);
+            bool ok;
+            sig.multiplexValue = value.toInt(&ok);
+            if (!ok) return fail("bad multiplex value for signal " + sig.name);
+            sig.isMultiplexed = true;
         }
+        else return fail("bad multiplex indicator for signal " + sig.name);
+    }
+
+    qint64 startBit, size, order;
+    if (!scan.accept(':')) return fail("expected : after signal " + sig.name);
+    if (!scan.integer(startBit) || !scan.accept('|') || !scan.integer(size) || !scan.accept('@') || !scan.integer(order))
+    {
+        return fail("bad bit layout for signal " + sig.name);
+    }
+    sig.startBit = startBit;
+    sig.signalSize = size;
 
-        if (line.startsWith("BA_DEF_ SG_ "))
+    bool isSigned = scan.accept('-');
+    if (!isSigned && !scan.accept('+')) return fail("expected + or - for signal " + sig.name);
+    switch (order)
+    {
+    case 0: //big endian mode
+    case 1: //little endian mode
+        sig.intelByteOrder = (order == 1);
+        sig.valType = isSigned ? SIGNED_INT : UNSIGNED_INT;
+        break;
+    case 2:
+        sig.valType = SP_FLOAT;
+        break;
+    case 3:
+        sig.valType = DP_FLOAT;
+        break;
+    case 4:
+        sig.valType = STRING;
+        break;
+    default:
+        return fail("bad value type for signal " + sig.name);
+    }
+
+    if (!scan.accept('(') || !scan.real(sig.factor) || !scan.accept(',') || !scan.real(sig.bias) || !scan.accept(')'))
+    {
+        return fail("bad factor or offset for signal " + sig.name);
+    }
+    if (!scan.accept('[') || !scan.real(sig.min) || !scan.accept('|') || !scan.real(sig.max) || !scan.accept(']'))
+    {
+        return fail("bad range for signal " + sig.name);
+    }
+    if (!scan.string(sig.unitName)) return fail("bad unit for signal " + sig.name);
+
+    //only the first of the receivers is kept
+    sig.receiver = node(scan.identifier());
+    sig.parentMessage = currentMessage;
+
+    currentMessage->sigHandler->addSignal(sig);
+    DBC_SIGNAL *added = currentMessage->sigHandler->findSignalByIdx(currentMessage->sigHandler->getCount() - 1);
+    if (sig.isMultiplexor) currentMessage->multiplexorSignal = added;
+
+    QPair<uint32_t, QString> key(currentMessage->ID, sig.name);
+    if (!signalIndex.contains(key)) signalIndex.insert(key, added);
+    scan.skipLine();
+    return true;
+}
+
+//CM_ BO_ id "text"; CM_ SG_ id signal "text"; CM_ BU_ node "text";
+bool DBCParser::parseComment()
+{
+    DBCFixup fixup;
+    fixup.line = statementLine;
+    fixup.id = 0;
+
+    qint64 id = 0;
+    TextSpan name;
+    TextSpan target = scan.identifier();
+    if (target.equals("BO_"))
+    {
+        fixup.kind = DBCFixup::MESSAGE_COMMENT;
+        if (!scan.integer(id)) return fail("bad message ID in comment");
+    }
+    else if (target.equals("SG_"))
+    {
+        fixup.kind = DBCFixup::SIGNAL_COMMENT;
+        if (!scan.integer(id)) return fail("bad message ID in comment");
+        name = scan.identifier();
+        if (name.isEmpty()) return fail("bad signal name in comment");
+    }
+    else if (target.equals("BU_"))
+    {
+        fixup.kind = DBCFixup::NODE_COMMENT;
+        name = scan.identifier();
+        if (name.isEmpty()) return fail("bad node name in comment");
+    }
+    else
+    {
+        //comments on the whole network and on environment variables aren't kept
+        scan.skipStatement();
+        return true;
+    }
+
+    if (!scan.string(fixup.text)) return fail("bad comment text");
+    if (!scan.accept(';')) return fail("expected ; after comment");
+    fixup.id = (uint32_t)id & 0x7FFFFFFFul;
+    fixup.name = QString::fromUtf8(name.ptr, name.len);
+    fixups.append(fixup);
+    return true;
+}
+
+//VAL_ 1090 VCUPresentParkLightOC 1 "Error present" 0 "Error not present" ;
+bool DBCParser::parseValues()
+{
+    TextSpan idText = scan.number();
+    if (idText.isEmpty())
+    {
+        //value tables for environment variables aren't kept
+        scan.skipStatement();
+        return true;
+    }
+
+    bool ok;
+    DBCFixup fixup;
+    fixup.kind = DBCFixup::SIGNAL_VALUES;
+    fixup.line = statementLine;
+    fixup.id = (uint32_t)idText.toInt(&ok) & 0x7FFFFFFFul;
+    if (!ok) return fail("bad message ID in value table");
+    TextSpan name = scan.identifier();
+    if (name.isEmpty()) return fail("bad signal name in value table");
+    fixup.name = QString::fromUtf8(name.ptr, name.len);
+
+    while (!scan.accept(';'))
+    {
+        qint64 value;
+        DBC_VAL_ENUM_ENTRY val;
+        if (!scan.integer(value) || !scan.string(val.descript)) return fail("bad value table entry for signal " + fixup.name);
+        val.value = value;
+        fixup.values.append(val);
+    }
+    fixups.append(fixup);
+    return true;
+}
+
+//BA_DEF_ [BU_|BO_|SG_] "name" INT min max | HEX min max | FLOAT min max | STRING | ENUM "a","b",... ;
+bool DBCParser::parseAttributeDef()
+{
+    DBC_ATTRIBUTE attr;
+    attr.attrType = GENERAL;
+    attr.lower = 0;
+    attr.upper = 0;
+
+    if (!scan.peek('"'))
+    {
+        TextSpan target = scan.identifier();
+        if (target.equals("BU_")) attr.attrType = NODE;
+        else if (target.equals("BO_")) attr.attrType = MESSAGE;
+        else if (target.equals("SG_")) attr.attrType = SIG;
+        else
         {
-            qDebug() << "Found a SG attribute line";
+            //environment variable attributes aren't kept
+            scan.skipStatement();
+            return true;
+        }
+    }
+    if (!scan.string(attr.name)) return fail("bad attribute name");
 
-            if (parseAttribute(line.right(line.length() - 12), attr))
-            {
-                qDebug() << "Success";
-                attr.attrType = SIG;
-                dbc_attributes.append(attr);
-            }
+    TextSpan type = scan.identifier();
+    if (type.equals("INT") || type.equals("HEX") || type.equals("FLOAT"))
+    {
+        attr.valType = type.equals("FLOAT") ? QFLOAT : QINT;
+        //the bounds are optional
+        if (!scan.peek(';') && (!scan.real(attr.lower) || !scan.real(attr.upper)))
+        {
+            return fail("bad bounds for attribute " + attr.name);
         }
-        if (line.startsWith("BA_DEF_ BO_ ")) //definition of a message attribute
+    }
+    else if (type.equals("STRING")) attr.valType = QSTRING;
+    else if (type.equals("ENUM"))
+    {
+        attr.valType = ENUM;
+        while (!scan.peek(';'))
         {
-            qDebug() << "Found a BO attribute line";
-
-            if (parseAttribute(line.right(line.length() - 12), attr))
+            QString enumVal;
+            if (scan.peek('"'))
             {
-                qDebug() << "Success";
-                attr.attrType = MESSAGE;
-                dbc_attributes.append(attr);
+                if (!scan.string(enumVal)) return fail("bad value list for attribute " + attr.name);
+                attr.enumVals.append(enumVal);
             }
-        }
-        if (line.startsWith("BA_DEF_ BU_ ")) //definition of a node attribute
-        {
-            qDebug() << "Found a BU attribute line";
-
-            if (parseAttribute(line.right(line.length() - 12), attr))
+            else
             {
-                qDebug() << "Success";
-                attr.attrType = NODE;
-                dbc_attributes.append(attr);
+                //unquoted lists come through as one run of text
+                if (!scan.value(enumVal)) return fail("bad value list for attribute " + attr.name);
+                attr.enumVals.append(enumVal.split(',', QString::SkipEmptyParts));
             }
+            scan.accept(',');
         }
+    }
+    else return fail("unknown type for attribute " + attr.name);
+
+    if (!scan.accept(';')) return fail("expected ; after attribute " + attr.name);
+    file->dbc_attributes.append(attr);
+    return true;
+}
+
+//BA_DEF_DEF_ "name" value;
+bool DBCParser::parseAttributeDefault()
+{
+    DBCFixup fixup;
+    fixup.kind = DBCFixup::ATTRIBUTE_DEFAULT;
+    fixup.line = statementLine;
+    fixup.id = 0;
+    if (!scan.string(fixup.attrName)) return fail("bad attribute name");
+    if (!scan.value(fixup.text)) return fail("bad default for attribute " + fixup.attrName);
+    if (!scan.accept(';')) return fail("expected ; after the default for attribute " + fixup.attrName);
+    fixups.append(fixup);
+    return true;
+}
+
+//BA_ "name" BO_ id value; BA_ "name" SG_ id signal value; BA_ "name" BU_ node value;
+bool DBCParser::parseAttributeValue()
+{
+    DBCFixup fixup;
+    fixup.line = statementLine;
+    fixup.id = 0;
+    if (!scan.string(fixup.attrName)) return fail("bad attribute name");
+
+    qint64 id = 0;
+    TextSpan name;
+    TextSpan target = scan.identifier();
+    if (target.equals("BO_"))
+    {
+        fixup.kind = DBCFixup::MESSAGE_ATTRIBUTE;
+        if (!scan.integer(id)) return fail("bad message ID for attribute " + fixup.attrName);
+    }
+    else if (target.equals("SG_"))
+    {
+        fixup.kind = DBCFixup::SIGNAL_ATTRIBUTE;
+        if (!scan.integer(id)) return fail("bad message ID for attribute " + fixup.attrName);
+        name = scan.identifier();
+        if (name.isEmpty()) return fail("bad signal name for attribute " + fixup.attrName);
+    }
+    else if (target.equals("BU_"))
+    {
+        fixup.kind = DBCFixup::NODE_ATTRIBUTE;
+        name = scan.identifier();
+        if (name.isEmpty()) return fail("bad node name for attribute " + fixup.attrName);
+    }
+    else
+    {
+        //values for the whole network and for environment variables have nowhere to go
+        scan.skipStatement();
+        return true;
+    }
+
+    if (!scan.value(fixup.text)) return fail("bad value for attribute " + fixup.attrName);
+    if (!scan.accept(';')) return fail("expected ; after the value of attribute " + fixup.attrName);
+    fixup.id = (uint32_t)id & 0x7FFFFFFFul;
+    fixup.name = QString::fromUtf8(name.ptr, name.len);
+    fixups.append(fixup);
+    return true;
+}
+
+void DBCParser::applyFixups()
+{
+    for (int i = file->dbc_attributes.count() - 1; i >= 0; i--)
+    {
+        //inserted backwards so a name defined twice finds the first, same as findAttributeByName
+        attributeIndex.insert(file->dbc_attributes[i].name, &file->dbc_attributes[i]);
+    }
+
+    for (int i = 0; i < fixups.count(); i++) applyFixup(fixups[i]);
+}
 
-        if (line.startsWith("BA_DEF_DEF_ ")) //definition of default value for an attribute
+void DBCParser::applyFixup(const DBCFixup &fixup)
+{
+    DBC_MESSAGE *msg = NULL;
+    DBC_SIGNAL *sig = NULL;
+    DBC_NODE *node = NULL;
+    DBC_ATTRIBUTE *attr = NULL;
+
+    switch (fixup.kind)
+    {
+    case DBCFixup::MESSAGE_COMMENT:
+    case DBCFixup::MESSAGE_ATTRIBUTE:
+        msg = messageIndex.value(fixup.id);
+        if (!msg) return noteError(fixup.line, "no message with ID " + QString::number(fixup.id));
+        break;
+    case DBCFixup::SIGNAL_COMMENT:
+    case DBCFixup::SIGNAL_VALUES:
+    case DBCFixup::SIGNAL_ATTRIBUTE:
+        sig = signalIndex.value(qMakePair(fixup.id, fixup.name));
+        if (!sig)
         {
-            regex.setPattern("^BA\\_DEF\\_DEF\\_ \\\"*(\\w+)\\\"* \\\"*([#\\w]*)\\\"*");
-            match = regex.match(line);
-            //captured 1 is the name of the attribute
-            //captured 2 is the default value for that attribute
-            if (match.hasMatch())
-            {
-                qDebug() << "Found an attribute default value line, searching for an attribute named " << match.captured(1) << "with data " << match.captured(2);
-                DBC_ATTRIBUTE *found = findAttributeByName(match.captured(1));
-                if (found)
-                {
-                    switch (found->valType)
-                    {
-                    case QSTRING:
-                        found->defaultValue = match.captured(2);
-                        break;
-                    case QFLOAT:
-                        found->defaultValue = match.captured(2).toFloat();
-                        break;
-                    case QINT:
-                        found->defaultValue = match.captured(2).toInt();
-                        break;
-                    case ENUM:
-                        QString temp = match.captured(2);
-                        found->defaultValue = 0;
-                        for (int x = 0; x < found->enumVals.count(); x++)
-                        {
-                            if (!found->enumVals[x].compare(temp, Qt::CaseInsensitive))
-                            {
-                                found->defaultValue = x;
-                                break;
-                            }
-                        }
-                    }
-                    qDebug() << "Matched an attribute. Setting default value to " << found->defaultValue;
-                }
-            }
+            msg = messageIndex.value(fixup.id);
+            if (!msg) return noteError(fixup.line, "no message with ID " + QString::number(fixup.id));
+            //names were matched regardless of case before
+            sig = msg->sigHandler->findSignalByName(fixup.name);
+            if (!sig) return noteError(fixup.line, "no signal " + fixup.name + " in message " + msg->name);
         }
+        break;
+    case DBCFixup::NODE_COMMENT:
+    case DBCFixup::NODE_ATTRIBUTE:
+        node = file->findNodeByName(fixup.name);
+        if (!node) return noteError(fixup.line, "no node named " + fixup.name);
+        break;
+    case DBCFixup::ATTRIBUTE_DEFAULT:
+        break;
+    }
 
-        //BA_ "GenMsgCycleTime" BO_ 101 100;
-        if (line.startsWith("BA_ ")) //set value of attribute
-        {
-            regex.setPattern("^BA\\_ \\\"*(\\w+)\\\"* BO\\_ (\\d+) \\\"*([#\\w]+)\\\"*");
-            match = regex.match(line);
-            //captured 1 is the attribute name
-            //captured 2 is the message ID number (frame ID)
-            //captured 3 is the attribute value
-            if (match.hasMatch())
-            {
-                qDebug() << "Found an attribute setting line for a message";
-                DBC_ATTRIBUTE *foundAttr = findAttributeByName(match.captured(1));
-                if (foundAttr)
-                {
-                    qDebug() << "That attribute does exist";
-                    DBC_MESSAGE *foundMsg = messageHandler->findMsgByID(match.captured(2).toInt());
-                    if (foundMsg)
-                    {
-                        qDebug() << "It references a valid, registered message";
-                        DBC_ATTRIBUTE_VALUE *foundAttrVal = foundMsg->findAttrValByName(match.captured(1));
-                        if (foundAttrVal) {
-                            foundAttrVal->value = processAttributeVal(match.captured(3), foundAttr->valType);
-                        }
-                        else
-                        {
-                            DBC_ATTRIBUTE_VALUE val;
-                            val.attrName = match.captured(1);
-                            val.value = processAttributeVal(match.captured(3), foundAttr->valType);
-                            foundMsg->attributes.append(val);
-                        }
-                    }
-                }
-            }
+    if (fixup.kind >= DBCFixup::MESSAGE_ATTRIBUTE)
+    {
+        attr = attributeIndex.value(fixup.attrName);
+        if (!attr) attr = file->findAttributeByName(fixup.attrName);
+        if (!attr) return noteError(fixup.line, "attribute " + fixup.attrName + " isn't defined");
+    }
 
-            regex.setPattern("^BA\\_ \\\"*(\\w+)\\\"* SG\\_ (\\d+) \\\"*(\\w+)\\\"* \\\"*([#\\w]+)\\\"*");
-            match = regex.match(line);
-            //captured 1 is the attribute name
-            //captured 2 is the message ID number (frame ID)
-            //captured 3 is the signal name to bind to
-            //captured 4 is the attribute value
-            if (match.hasMatch())
-            {
-                qDebug() << "Found an attribute setting line for a signal";
-                DBC_ATTRIBUTE *foundAttr = findAttributeByName(match.captured(1));
-                if (foundAttr)
-                {
-                    qDebug() << "That attribute does exist";
-                    DBC_MESSAGE *foundMsg = messageHandler->findMsgByID(match.captured(2).toInt());
-                    if (foundMsg)
-                    {
-                        qDebug() << "It references a valid, registered message";
-                        DBC_SIGNAL *foundSig = foundMsg->sigHandler->findSignalByName(match.captured(3));
-                        if (foundSig)
-                        {
-                            DBC_ATTRIBUTE_VALUE *foundAttrVal = foundSig->findAttrValByName(match.captured(1));
-                            if (foundAttrVal) foundAttrVal->value = processAttributeVal(match.captured(3), foundAttr->valType);
-                            else
-                            {
-                                DBC_ATTRIBUTE_VALUE val;
-                                val.attrName = match.captured(1);
-                                val.value = processAttributeVal(match.captured(3), foundAttr->valType);
-                                foundSig->attributes.append(val);
-                            }
-                        }
-                    }
-                }
-            }
+    switch (fixup.kind)
+    {
+    case DBCFixup::MESSAGE_COMMENT:
+        msg->comment = fixup.text;
+        break;
+    case DBCFixup::SIGNAL_COMMENT:
+        sig->comment = fixup.text;
+        break;
+    case DBCFixup::NODE_COMMENT:
+        node->comment = fixup.text;
+        break;
+    case DBCFixup::SIGNAL_VALUES:
+        sig->valList.append(fixup.values);
+        sig->getValueTable(); //set up now rather than on the first decoded frame
+        break;
+    case DBCFixup::MESSAGE_ATTRIBUTE:
+        setAttributeValue(msg->attributes, attr, fixup.text);
+        break;
+    case DBCFixup::SIGNAL_ATTRIBUTE:
+        setAttributeValue(sig->attributes, attr, fixup.text);
+        break;
+    case DBCFixup::NODE_ATTRIBUTE:
+        setAttributeValue(node->attributes, attr, fixup.text);
+        break;
+    case DBCFixup::ATTRIBUTE_DEFAULT:
+        attr->defaultValue = attributeValue(attr, fixup.text);
+        break;
+    }
+}
 
-            regex.setPattern("^BA\\_ \\\"*(\\w+)\\\"* BU\\_ \\\"*(\\w+)\\\"* \\\"*([#\\w]+)\\\"*");
-            match = regex.match(line);
-            //captured 1 is the attribute name
-            //captured 2 is the name of the node
-            //captured 3 is the attribute value
-            if (match.hasMatch())
-            {
-                qDebug() << "Found an attribute setting line for a node";
-                DBC_ATTRIBUTE *foundAttr = findAttributeByName(match.captured(1));
-                if (foundAttr)
-                {
-                    qDebug() << "That attribute does exist";
-                    DBC_NODE *foundNode = findNodeByName(match.captured(2));
-                    if (foundNode)
-                    {
-                        qDebug() << "References a valid node name";
-                        DBC_ATTRIBUTE_VALUE *foundAttrVal = foundNode->findAttrValByName(match.captured(1));
-                        if (foundAttrVal) foundAttrVal->value = processAttributeVal(match.captured(3), foundAttr->valType);
-                        else
-                        {
-                            DBC_ATTRIBUTE_VALUE val;
-                            val.attrName = match.captured(1);
-                            val.value = processAttributeVal(match.captured(3), foundAttr->valType);
-                            foundNode->attributes.append(val);
-                        }
-                    }
-                }
+//unknown or missing node names go to the Vector__XXX node rather than leaving a NULL for the editors to trip on
+DBC_NODE *DBCParser::node(const TextSpan &name)
+{
+    int idx = nodeIndex.value(QString::fromUtf8(name.ptr, name.len), -1);
+    if (idx < 0)
+    {
+        DBC_NODE *found = file->findNodeByName(QString::fromUtf8(name.ptr, name.len));
+        if (found) return found;
+        idx = 0;
+    }
+    return &file->dbc_nodes[idx];
+}
 
-            }
+//enum values can be given by name or by index
+QVariant DBCParser::attributeValue(const DBC_ATTRIBUTE *attr, const QString &text)
+{
+    if (attr->valType == ENUM)
+    {
+        bool isIndex;
+        int idx = text.toInt(&isIndex);
+        if (isIndex) return idx;
+        for (int x = 0; x < attr->enumVals.count(); x++)
+        {
+            if (!attr->enumVals[x].compare(text, Qt::CaseInsensitive)) return x;
+        }
+        return 0;
+    }
+    return file->processAttributeVal(text, attr->valType);
+}
+
+void DBCParser::setAttributeValue(QList<DBC_ATTRIBUTE_VALUE> &attributes, const DBC_ATTRIBUTE *attr, const QString &text)
+{
+    for (int i = 0; i < attributes.count(); i++)
+    {
+        if (attributes[i].attrName.compare(attr->name, Qt::CaseInsensitive) == 0)
+        {
+            attributes[i].value = attributeValue(attr, text);
+            return;
         }
     }
+    DBC_ATTRIBUTE_VALUE val;
+    val.attrName = attr->name;
+    val.value = attributeValue(attr, text);
+    attributes.append(val);
+}
+
+bool DBCParser::fail(QString what)
+{
+    noteError(statementLine, what);
+    return false;
+}
+
+void DBCParser::noteError(int line, QString what)
+{
+    errors.append("line " + QString::number(line) + ": " + what);
+}
+
+void DBCFile::loadFile(QString fileName)
+{
+    QFile inFile(fileName);
+    DBC_ATTRIBUTE attr;
+
+    qDebug() << "DBC File: " << fileName;
+
+    if (!inFile.open(QIODevice::ReadOnly)) return;
+
+    qDebug() << "Starting DBC load";
+    dbc_nodes.clear();
+    messageHandler->removeAllMessages();
+    messageHandler->setJ1939(false);
+
+    DBC_NODE falseNode;
+    falseNode.name = "Vector__XXX";
+    falseNode.comment = "Default node if none specified";
+    dbc_nodes.append(falseNode);
+
+    QByteArray text = inFile.readAll(); //the parser works on spans of this
+    DBCParser parser(this, text);
+    parser.parse();
+    loadErrors = parser.errors;
+    inFile.close();
 
     //upon loading the file add our custom foreground and background color attributes if they don't exist already
     DBC_ATTRIBUTE *bgAttr = findAttributeByName("GenMsgBackgroundColor");
@@ -792,7 +1216,7 @@ void DBCFile::loadFile(QString fileName)
     if (!fgAttr)
     {
         attr.attrType = MESSAGE;
-        attr.defaultValue = QApplication::palette().color(QPalette::WindowText).name();
+        attr.defaultValue = defaultTextColor();
         attr.enumVals.clear();
         attr.lower = 0;
         attr.upper = 0;
@@ -831,25 +1255,34 @@ void DBCFile::loadFile(QString fileName)
         if (thisFG) msg->fgColor = QColor(thisFG->value.toString());
     }
 
-    if (numSigFaults > 0 || numMsgFaults > 0)
+    if (!loadErrors.isEmpty() && !haveGUI())
+    {
+        qWarning() << "DBC file" << fileName << "loaded with" << loadErrors.count() << "errors. The faulty entries have been left out.";
+        foreach (QString error, loadErrors) qWarning() << error;
+    }
+    else if (!loadErrors.isEmpty())
     {
         QMessageBox msgBox;
-        QString msg = "DBC file loaded with errors!\n";
-        msg += "Number of faulty message entries: " + QString::number(numMsgFaults) + "\n";
-        msg += "Number of faulty signal entries: " + QString::number(numSigFaults) + "\n\n";
-        msg += "Faulty entries have not been loaded.\n\n";
+        QString msg = "DBC file loaded with errors!\n\n";
+        for (int i = 0; i < loadErrors.count() && i < 10; i++) msg += loadErrors[i] + "\n";
+        if (loadErrors.count() > 10) msg += "... and " + QString::number(loadErrors.count() - 10) + " more\n";
+        msg += "\nFaulty entries have not been loaded.\n\n";
         msg += "All other entries are, however, loaded.";
         msgBox.setText(msg);
+        msgBox.setDetailedText(loadErrors.join("\n"));
         msgBox.exec();
     }
-    inFile->close();
-    delete inFile;
     QStringList fileList = fileName.split('/');
     this->fileName = fileList[fileList.length() - 1]; //whoops... same name as parameter in this function.
     filePath = fileName.left(fileName.length() - this->fileName.length());
     assocBuses = -1;
 }
 
+QStringList DBCFile::getLoadErrors()
+{
+    return loadErrors;
+}
+
 QVariant DBCFile::processAttributeVal(QString input, DBC_ATTRIBUTE_VAL_TYPE typ)
 {
     QVariant out;
@@ -869,102 +1302,6 @@ QVariant DBCFile::processAttributeVal(QString input, DBC_ATTRIBUTE_VAL_TYPE typ)
     return out;
 }
 
-bool DBCFile::parseAttribute(QString inpString, DBC_ATTRIBUTE &attr)
-{
-    bool goodAttr = false;
-    QRegularExpression regex;
-    QRegularExpressionMatch match;
-
-    regex.setPattern("\\\"*(\\w+)\\\"* \\\"*(\\w+)\\\"* (\\d+) (\\d+)");
-    match = regex.match(inpString);
-    //captured 1 is the name of the attribute to set up
-    //captured 2 is the type of signal attribute to create.
-    //captured 3 is the lower bound value for this attribute
-    //captured 4 is the upper bound value for this attribute
-    if (match.hasMatch())
-    {
-        qDebug() << "Parsing an attribute with low/high values";
-        attr.name = match.captured(1);
-        QString typ = match.captured(2);
-        attr.attrType = SIG;
-        attr.lower = 0;
-        attr.upper = 0;
-        attr.valType = QSTRING;
-        if (!typ.compare("INT", Qt::CaseInsensitive))
-        {
-            qDebug() << "INT attribute named " << attr.name;
-            attr.valType = QINT;
-            attr.lower = match.captured(3).toInt();
-            attr.upper = match.captured(4).toInt();
-            goodAttr = true;
-        }
-        if (!typ.compare("FLOAT", Qt::CaseInsensitive))
-        {
-            qDebug() << "FLOAT attribute named " << attr.name;
-            attr.valType = QFLOAT;
-            attr.lower = match.captured(3).toDouble();
-            attr.upper = match.captured(4).toDouble();
-            goodAttr = true;
-        }
-        if (!typ.compare("STRING", Qt::CaseInsensitive))
-        {
-            qDebug() << "STRING attribute named " << attr.name;
-            attr.valType = QSTRING;
-            goodAttr = true;
-        }
-    }
-    else
-    {
-        regex.setPattern("\\\"*(\\w+)\\\"* \\\"*(\\w+)\\\"* (.*)");
-        match = regex.match(inpString);
-        //Same as above but no upper/lower bound values.
-        if (match.hasMatch())
-        {
-            qDebug() << "Parsing an attribute without boundaries";
-            attr.name = match.captured(1);
-            QString typ = match.captured(2);
-            attr.lower = 0;
-            attr.upper = 0;
-            attr.attrType = SIG;
-
-            if (!typ.compare("INT", Qt::CaseInsensitive))
-            {
-                qDebug() << "INT attribute named " << attr.name;
-                attr.valType = QINT;
-                goodAttr = true;
-            }
-
-            if (!typ.compare("FLOAT", Qt::CaseInsensitive))
-            {
-                qDebug() << "FLOAT attribute named " << attr.name;
-                attr.valType = QFLOAT;
-                goodAttr = true;
-            }
-
-            if (!typ.compare("STRING", Qt::CaseInsensitive))
-            {
-                qDebug() << "STRING attribute named " << attr.name;
-                attr.valType = QSTRING;
-                goodAttr = true;
-            }
-
-            if (!typ.compare("ENUM", Qt::CaseInsensitive))
-            {
-                qDebug() << "ENUM attribute named " << attr.name;
-                QStringList enumLst = match.captured(3).split(',');
-                foreach (QString enumStr, enumLst)
-                {
-                    attr.enumVals.append(Utility::unQuote(enumStr));
-                    qDebug() << "Enum value: " << enumStr;
-                }
-                attr.valType = ENUM;
-                goodAttr = true;
-            }
-        }
-    }
-    return goodAttr;
-}
-
 void DBCFile::saveFile(QString fileName)
 {
     QFile *outFile = new QFile(fileName);
@@ -1279,7 +1616,7 @@ int DBCHandler::createBlankFile()
     newFile.dbc_attributes.append(attr);
 
     attr.attrType = MESSAGE;
-    attr.defaultValue = QApplication::palette().color(QPalette::WindowText).name();
+    attr.defaultValue = defaultTextColor();
     attr.enumVals.clear();
     attr.lower = 0;
     attr.upper = 0;
@@ -1300,11 +1637,20 @@ int DBCHandler::createBlankFile()
     return loadedFiles.count();
 }
 
+//the text is only parsed when the cache doesn't have an up to date copy of the file, which it then gets
+static void loadThroughCache(QString filename, DBCFile &file)
+{
+    if (DBCCache::load(filename, file)) return;
+    file.loadFile(filename);
+    DBCCache::save(filename, file);
+}
+
 //the only reason to even bother sending the index is to see if
 //the user wants to replace an already loaded DBC.
 //Otherwise add a new one. Well, always add a new one.
 //If a valid index is passed we'll remove that one and then commence
 //adding. Otherwise, just go straight to adding.
+
 DBCFile* DBCHandler::loadDBCFile(int idx)
 {
    if (idx > -1 && idx < loadedFiles.count()) removeDBCFile(idx);
@@ -1324,7 +1670,7 @@ DBCFile* DBCHandler::loadDBCFile(int idx)
         filename = dialog.selectedFiles()[0];
         //right now there is only one file type that can be loaded here so just do it.
         DBCFile newFile;
-        newFile.loadFile(filename);
+        loadThroughCache(filename, newFile);
         loadedFiles.append(newFile);
 
         return &loadedFiles.last();
@@ -1357,6 +1703,19 @@ void DBCHandler::swapFiles(int pos1, int pos2)
     loadedFiles.swap(pos1, pos2);
 }
 
+//loads the given file without asking for one. NULL if it can't be read
+DBCFile* DBCHandler::loadDBCFile(QString filename)
+{
+    QFile check(filename);
+    if (!check.open(QIODevice::ReadOnly)) return NULL;
+    check.close();
+
+    DBCFile newFile;
+    loadThroughCache(filename, newFile);
+    loadedFiles.append(newFile);
+    return &loadedFiles.last();
+}
+
 /*
  * Convenience function that encapsulates a whole lot of the details.
  * You give it a canbus frame and it'll tell you whether there is a loaded DBC file that can
@@ -2,6 +2,7 @@
 #define DBCHANDLER_H
 
 #include <QObject>
+#include <QHash>
 #include "dbc_classes.h"
 #include "can_structs.h"
 
@@ -45,6 +46,15 @@ public:
 private:
     QList<DBC_MESSAGE> messages;
     bool isJ1939Handler;
+
+    //lookup tables into messages so findMsgByID doesn't have to walk the whole list.
+    //Each maps a key to the index of the first message in the list with that key
+    QHash<uint32_t, int> idIndex; //straight 29/11 bit ID
+    QHash<uint32_t, int> pdu1Index; //J1939 DP, EDP and PF (PDU1 messages are matched without the PS byte)
+    QHash<uint32_t, int> pdu2Index; //J1939 DP, EDP, PF and PS
+
+    void indexMessage(int idx);
+    void rebuildIndex();
 };
 
 //technically there should be a node handler too but I'm sort of treating nodes as second class
@@ -63,6 +73,7 @@ public:
     void findAttributesByType(DBC_ATTRIBUTE_TYPE typ, QList<DBC_ATTRIBUTE> *list);
     void saveFile(QString);
     void loadFile(QString);
+    QStringList getLoadErrors(); //what loadFile() had to leave out, one "line N: ..." entry each
     QString getFullFilename();
     QString getFilename();
     QString getPath();
@@ -76,8 +87,10 @@ private:
     QString fileName;
     QString filePath;
     int assocBuses; //-1 = all buses, 0 = first bus, 1 = second bus, etc.
+    QStringList loadErrors;
 
-    bool parseAttribute(QString inpString, DBC_ATTRIBUTE &attr);
+    friend class DBCParser;
+    friend class DBCCache;
     QVariant processAttributeVal(QString input, DBC_ATTRIBUTE_VAL_TYPE typ);
 };
 
@@ -86,6 +99,7 @@ class DBCHandler: public QObject
     Q_OBJECT
 public:
     DBCFile* loadDBCFile(int);
+    DBCFile* loadDBCFile(QString filename);
     void saveDBCFile(int);
     void removeDBCFile(int);
     void removeAllFiles();
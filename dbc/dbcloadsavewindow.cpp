@@ -2,7 +2,7 @@
 #include "ui_dbcloadsavewindow.h"
 #include <QCheckBox>
 
-DBCLoadSaveWindow::DBCLoadSaveWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+DBCLoadSaveWindow::DBCLoadSaveWindow(const CANFrameView *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::DBCLoadSaveWindow)
 {
@@ -6,7 +6,7 @@
 #include <QSettings>
 #include <QColorDialog>
 
-DBCMainEditor::DBCMainEditor( const QVector<CANFrame> *frames, QWidget *parent) :
+DBCMainEditor::DBCMainEditor( const CANFrameView *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::DBCMainEditor)
 {
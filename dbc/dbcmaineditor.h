@@ -4,6 +4,7 @@
 #include <QDialog>
 #include <QDebug>
 #include "dbchandler.h"
+#include "canframestore.h"
 #include "dbcsignaleditor.h"
 #include "utility.h"
 
@@ -16,7 +17,7 @@ class DBCMainEditor : public QDialog
     Q_OBJECT
 
 public:
-    explicit DBCMainEditor(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit DBCMainEditor(const CANFrameView *frames, QWidget *parent = 0);
     ~DBCMainEditor();
     void setFileIdx(int idx);
 
@@ -33,7 +34,7 @@ private slots:
 private:
     Ui::DBCMainEditor *ui;
     DBCHandler *dbcHandler;
-    const QVector<CANFrame> *referenceFrames;
+    const CANFrameView *referenceFrames;
     DBCSignalEditor *sigEditor;
     int currRow;
     DBCFile *dbcFile;
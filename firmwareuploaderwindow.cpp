@@ -4,7 +4,7 @@
 
 #include <QFile>
 
-FirmwareUploaderWindow::FirmwareUploaderWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+FirmwareUploaderWindow::FirmwareUploaderWindow(const CANFrameView *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::FirmwareUploaderWindow)
 {
@@ -4,6 +4,7 @@
 #include <QDialog>
 #include <QTimer>
 #include "can_structs.h"
+#include "canframestore.h"
 #include "connections/canconmanager.h"
 #include "utility.h"
 
@@ -16,7 +17,7 @@ class FirmwareUploaderWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit FirmwareUploaderWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit FirmwareUploaderWindow(const CANFrameView *frames, QWidget *parent = 0);
     ~FirmwareUploaderWindow();
 
 signals:
@@ -46,7 +47,7 @@ private:
     int bus;
     uint32_t token;
     QByteArray firmwareData;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameView *modelFrames;
     QTimer *timer;
 };
 
@@ -2,18 +2,435 @@
 
 #include <QMessageBox>
 #include <QProgressDialog>
+#include <QFileInfo>
+#include <QSettings>
+#include <QFutureWatcher>
+#include <QEventLoop>
+#include <QScopedPointer>
+#include <QDateTime>
+#include <QTimer>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QCheckBox>
+#include <QLineEdit>
+#include <QDoubleValidator>
+#include <QThread>
+#include <QtConcurrent>
 
 #include <iostream>
+#include <algorithm>
 
 #include "utility.h"
+#include "canbinaryfile.h"
+#include "cancompressedfile.h"
+#include "utils/textscanner.h"
+#include "utils/textwriter.h"
+
+//lines parsed between trips through the event loop while loading a text log
+#define LOADER_EVENT_LINES  5000
+//lines looked through for a timestamp when searching a text log for the start of a time window
+#define SEEK_PROBE_LINES    64
+//once the search has narrowed a text log down to this many bytes the rest is just parsed and filtered
+#define SEEK_LINEAR_BYTES   (64 * 1024)
+//places in a text log checked to see whether its timestamps are in order before searching it
+#define SEEK_ORDER_PROBES   16
+//most tokens the text loaders pick out of a single line
+#define MAX_LINE_TOKENS     32
+//text logs at least this big are cut up and parsed on every core
+#define PARALLEL_LOAD_MIN   (8 * 1024 * 1024)
+//bytes of text in each piece of a parallel load
+#define LOAD_CHUNK_SIZE     (4 * 1024 * 1024)
+//frames saved between progress updates and checks for a cancel
+#define SAVE_STEP_FRAMES    16384
+//bytes from the start of a file detectFileFormat() looks at
+#define SNIFF_BYTES         16384
+//lines at the top of a file searched for a format's header
+#define SNIFF_HEADER_LINES  40
+//what finding a format's header is worth, on top of up to 100 for how many lines look like its frames
+#define SNIFF_HEADER_SCORE  100
+//anything scoring less isn't believed to be in that format at all
+#define SNIFF_MIN_SCORE     50
+
+struct DecodeJob
+{
+    const CANCompressedFile *file;
+    int block;
+    CANFrame *out;
+    bool ok;
+};
+
+struct LoadChunk
+{
+    const LineFormat *format;
+    const LoadFilter *filter;
+    const char *start;
+    const char *end;
+    QVector<CANFrame> frames;
+    QVector<int> untimed;   //frames still waiting for a made up timestamp, -1 for ones the filter dropped
+    bool foundErrors;
+};
+
+/*
+ * Savers call this for every frame. Now and then it records in context how far along they are and, when the save
+ * is running on the GUI thread, lets the GUI catch up. False means the save was canceled and the saver should stop.
+ */
+static bool saveStep(int done, int total, FileIOContext *context)
+{
+    if ((done % SAVE_STEP_FRAMES) != 0) return true;
+    QCoreApplication *app = QCoreApplication::instance();
+    if (app && QThread::currentThread() == app->thread()) QCoreApplication::processEvents();
+    if (!context) return true;
+    context->progress.store(total > 0 ? (int)((qint64)done * 1000 / total) : 1000);
+    return context->canceled.load() == 0;
+}
+
+//difference between local time and UTC around the given timestamp, in milliseconds
+static qint64 localOffsetMS(uint64_t timestamp)
+{
+    return QDateTime::fromMSecsSinceEpoch(timestamp / 1000).offsetFromUtc() * 1000ll;
+}
+
+/*
+ * Local time of day as h:m:s followed by the milliseconds, which is what the savers used to get from
+ * QDateTime::toString() one frame at a time. The UTC offset is worked out once per save so a capture
+ * running across a daylight saving change keeps the offset it started with.
+ */
+static void putTimeOfDay(TextWriter &out, uint64_t timestamp, qint64 utcOffset, char msSeparator, int msWidth)
+{
+    qint64 ms = ((qint64)(timestamp / 1000) + utcOffset) % 86400000ll;
+    if (ms < 0) ms += 86400000ll;
+    out.putDecimal(ms / 3600000);
+    out.put(':');
+    out.putDecimal((ms / 60000) % 60);
+    out.put(':');
+    out.putDecimal((ms / 1000) % 60);
+    out.put(msSeparator);
+    out.putDecimal(ms % 1000, msWidth);
+}
+
+/*
+ * The loaders that go through a file one frame at a time ask this before keeping each frame. A window counted
+ * from the first frame is pinned down by the first frame seen.
+ */
+static bool keepFrame(const CANFrame &frame, FileIOContext *context)
+{
+    if (!context || !context->filter) return true;
+    context->filter->anchor(frame.timestamp);
+    return context->filter->matches(frame);
+}
+
+static void parseLine(LoadChunk &chunk, const TextSpan &line)
+{
+    CANFrame frame;
+    switch (chunk.format->parse(line, frame, chunk.format->variant))
+    {
+    case LINE_FRAME:
+        if (!chunk.filter || chunk.filter->matches(frame)) chunk.frames.append(frame);
+        break;
+    case LINE_UNTIMED:
+        //a dropped frame still uses up a made up timestamp so the ones kept get what a full load gives them.
+        //They are checked against the time window once they have their timestamps
+        if (chunk.filter && !chunk.filter->matchesID(frame.ID))
+        {
+            chunk.untimed.append(-1);
+            break;
+        }
+        chunk.untimed.append(chunk.frames.count());
+        chunk.frames.append(frame);
+        break;
+    case LINE_ERROR:
+        chunk.foundErrors = true;
+        break;
+    case LINE_SKIP:
+        break;
+    }
+}
+
+static void parseChunk(LoadChunk &chunk)
+{
+    //a rough guess of 40 bytes a line saves growing the vector over and over
+    chunk.frames.reserve((int)((chunk.end - chunk.start) / 40));
+    const char *pos = chunk.start;
+    while (pos < chunk.end) parseLine(chunk, takeLine(pos, chunk.end));
+}
+
+/*
+ * Timestamp of the first frame at or after pos that has one of its own, looking at no more than SEEK_PROBE_LINES
+ * lines. lineStart, if given, is set to the start of its line.
+ */
+static bool findLineTime(const LineFormat &format, const char *pos, const char *end, uint64_t &timestamp, const char **lineStart = NULL)
+{
+    for (int i = 0; i < SEEK_PROBE_LINES && pos < end; i++)
+    {
+        const char *start = pos;
+        CANFrame frame;
+        if (format.parse(takeLine(pos, end), frame, format.variant) == LINE_FRAME)
+        {
+            timestamp = frame.timestamp;
+            if (lineStart) *lineStart = start;
+            return true;
+        }
+    }
+    return false;
+}
+
+//start of the line after the one pos is in
+static const char *nextLineStart(const char *pos, const char *end)
+{
+    const char *nl = (const char *)memchr(pos, '\n', end - pos);
+    return nl ? nl + 1 : end;
+}
+
+//true if timestamps picked from all over the text are in order, which is what searching it by time relies on
+static bool lineTimesInOrder(const LineFormat &format, const char *begin, const char *end)
+{
+    uint64_t last = 0;
+    int found = 0;
+    for (int i = 0; i < SEEK_ORDER_PROBES; i++)
+    {
+        const char *pos = begin + (end - begin) * i / SEEK_ORDER_PROBES;
+        if (i > 0) pos = nextLineStart(pos, end);
+        uint64_t timestamp;
+        if (!findLineTime(format, pos, end, timestamp)) continue;
+        if (found > 0 && timestamp < last) return false;
+        last = timestamp;
+        found++;
+    }
+    return found > 1;
+}
+
+/*
+ * Bisects text with timestamps in order for the frames at timestamp. Everything before low is earlier than it,
+ * and the line at high and everything after is at or past it. Once the two are SEEK_LINEAR_BYTES apart it stops,
+ * the filter sorts out the frames in between.
+ */
+static void seekLineTime(const LineFormat &format, const char *begin, const char *end, uint64_t timestamp,
+                         const char *&low, const char *&high)
+{
+    low = begin;
+    high = end;
+    while (high - low > SEEK_LINEAR_BYTES)
+    {
+        const char *mid = nextLineStart(low + (high - low) / 2, high);
+        const char *found;
+        uint64_t foundTime;
+        if (mid >= high || !findLineTime(format, mid, high, foundTime, &found)) break;
+        if (foundTime < timestamp) low = nextLineStart(found, high);
+        else high = mid;
+    }
+}
+
+/*
+ * Runs func over every piece of a load on the global thread pool. In the GUI this spins an event loop with a
+ * progress dialog that can cancel the load, in which case false comes back. That is the dialog the load already
+ * has up if it was given one, otherwise one of its own. Pieces already being worked on are allowed to finish.
+ */
+template <typename T>
+static bool runLoadJobs(QVector<T> &chunks, void (*func)(T &), QProgressDialog *dialog)
+{
+    QFuture<void> future = QtConcurrent::map(chunks, func);
+
+    if (!qobject_cast<QApplication *>(QCoreApplication::instance()))
+    {
+        future.waitForFinished();
+        return true;
+    }
+
+    QScopedPointer<QProgressDialog> ownProgress;
+    QProgressDialog *progress = dialog;
+    if (!progress)
+    {
+        ownProgress.reset(new QProgressDialog(qApp->activeWindow()));
+        progress = ownProgress.data();
+        progress->setWindowModality(Qt::WindowModal);
+        progress->setLabelText(QObject::tr("Loading file..."));
+        progress->setMinimumDuration(0);
+    }
+    progress->setCancelButtonText(QObject::tr("Cancel"));
+    progress->setRange(0, chunks.count());
+    progress->setValue(0);
+    progress->show();
+
+    QFutureWatcher<void> watcher;
+    QEventLoop loop;
+    QObject::connect(&watcher, &QFutureWatcher<void>::progressValueChanged, progress, &QProgressDialog::setValue);
+    QObject::connect(&watcher, &QFutureWatcher<void>::finished, &loop, &QEventLoop::quit);
+    QObject::connect(progress, &QProgressDialog::canceled, &watcher, &QFutureWatcher<void>::cancel);
+    watcher.setFuture(future);
+    if (!watcher.isFinished()) loop.exec();
+    future.waitForFinished();
+
+    return !future.isCanceled();
+}
+
+/*
+ * Loads a line based log. Small files are parsed right here, big ones are mapped, cut into chunks on line
+ * boundaries and handed to runLoadJobs(). The chunks are then joined in file order and any made up
+ * timestamps handed out in that same order. With a filter in context whose time window can be searched for only
+ * the stretch of the file holding the window is cut up.
+ */
+static bool loadLineFile(QString filename, LineFormat format, QVector<CANFrame> *frames, FileIOContext *context)
+{
+    LoadFilter *filter = context ? context->filter : NULL;
+    QFile inFile(filename);
+    if (!inFile.open(QIODevice::ReadOnly)) return false;
+
+    qint64 size = inFile.size();
+    const char *data = (size > 0) ? (const char *)inFile.map(0, size) : NULL;
+    QVector<LoadChunk> chunks;
 
-QFile FrameFileIO::continuousFile;
+    if (!data)
+    {
+        //empty, or can't be mapped (too big for a 32 bit address space). Read it front to back instead
+        LoadChunk chunk = {&format, filter, NULL, NULL, QVector<CANFrame>(), QVector<int>(), false};
+        LineReader reader(&inFile);
+        TextSpan line;
+        for (int i = 0; i < format.headerLines && reader.nextLine(line); i++)
+        {
+            if (i == 0 && format.readHeader) format.variant = format.readHeader(line);
+        }
+
+        int lineCounter = 0;
+        while (reader.nextLine(line))
+        {
+            lineCounter++;
+            if (lineCounter > LOADER_EVENT_LINES)
+            {
+                qApp->processEvents();
+                lineCounter = 0;
+            }
+            if (filter && filter->fromFirstFrame)
+            {
+                CANFrame frame;
+                LineResult result = format.parse(line, frame, format.variant);
+                if (result == LINE_FRAME) filter->anchor(frame.timestamp);
+                else if (result == LINE_UNTIMED) filter->anchor(format.untimedStart + format.untimedStep);
+            }
+            parseLine(chunk, line);
+        }
+        chunks.append(chunk);
+    }
+    else
+    {
+        const char *end = data + size;
+        const char *pos = data;
+        for (int i = 0; i < format.headerLines && pos < end; i++)
+        {
+            TextSpan line = takeLine(pos, end);
+            if (i == 0 && format.readHeader) format.variant = format.readHeader(line);
+        }
+
+        if (filter)
+        {
+            //pinned down here, before the pieces are parsed on other threads
+            uint64_t firstTime;
+            if (findLineTime(format, pos, end, firstTime)) filter->anchor(firstTime);
+            else filter->anchor(format.untimedStart + format.untimedStep);
+
+            //only the text that can hold the window gets parsed. Formats without timestamps are never searched
+            if (filter->hasTimeWindow() && lineTimesInOrder(format, pos, end))
+            {
+                const char *low;
+                const char *high;
+                seekLineTime(format, pos, end, filter->startTime, low, high);
+                pos = low;
+                if (filter->endTime < UINT64_MAX)
+                {
+                    seekLineTime(format, pos, end, filter->endTime + 1, low, high);
+                    end = high;
+                }
+            }
+        }
+
+        qint64 parseSize = end - pos;
+        while (pos < end)
+        {
+            const char *chunkEnd = end;
+            if (end - pos > LOAD_CHUNK_SIZE)
+            {
+                chunkEnd = (const char *)memchr(pos + LOAD_CHUNK_SIZE, '\n', end - pos - LOAD_CHUNK_SIZE);
+                chunkEnd = chunkEnd ? chunkEnd + 1 : end;
+            }
+            LoadChunk chunk = {&format, filter, pos, chunkEnd, QVector<CANFrame>(), QVector<int>(), false};
+            chunks.append(chunk);
+            pos = chunkEnd;
+        }
+
+        if (parseSize < PARALLEL_LOAD_MIN)
+        {
+            for (int i = 0; i < chunks.count(); i++) parseChunk(chunks[i]);
+        }
+        else if (!runLoadJobs(chunks, parseChunk, context ? context->progressDialog : NULL))
+        {
+            inFile.unmap((uchar *)data);
+            return false;
+        }
+        inFile.unmap((uchar *)data);
+    }
+
+    int total = frames->count();
+    for (int i = 0; i < chunks.count(); i++) total += chunks[i].frames.count();
+    frames->reserve(total);
+
+    bool foundErrors = false;
+    uint64_t timeStamp = format.untimedStart;
+    for (int i = 0; i < chunks.count(); i++)
+    {
+        LoadChunk &chunk = chunks[i];
+        for (int u = 0; u < chunk.untimed.count(); u++)
+        {
+            timeStamp += format.untimedStep;
+            if (chunk.untimed[u] >= 0) chunk.frames[chunk.untimed[u]].timestamp = timeStamp;
+        }
+        if (filter && !chunk.untimed.isEmpty())
+        {
+            chunk.frames.erase(std::remove_if(chunk.frames.begin(), chunk.frames.end(),
+                                              [filter](const CANFrame &frame) { return !filter->matchesTime(frame.timestamp); }),
+                               chunk.frames.end());
+        }
+        *frames += chunk.frames;
+        chunk.frames = QVector<CANFrame>(); //let go of each piece as soon as it is copied
+        if (chunk.foundErrors) foundErrors = true;
+    }
+    return !foundErrors;
+}
 
 FrameFileIO::FrameFileIO()
 {
 }
 
-bool FrameFileIO::saveFrameFile(QString &fileName, const QVector<CANFrame>* frameCache)
+/*
+ * Runs a saver on the thread pool while the GUI thread keeps going, showing how far along it is. The frames
+ * must not change until this returns, MainWindow holds new frames back in the model for that long. A canceled
+ * save leaves no half written file behind.
+ */
+bool FrameFileIO::saveInBackground(SaveFunc saver, QString filename, const CANFrameView *frames, QProgressDialog *progress)
+{
+    FileIOContext context;
+
+    QFutureWatcher<bool> watcher;
+    QEventLoop loop;
+    QTimer progressTimer;
+    QObject::connect(&watcher, &QFutureWatcher<bool>::finished, &loop, &QEventLoop::quit);
+    QObject::connect(&progressTimer, &QTimer::timeout, progress, [progress, &context]() { progress->setValue(context.progress.load()); });
+    QObject::connect(progress, &QProgressDialog::canceled, &watcher, [&context]() { context.canceled.store(1); });
+
+    watcher.setFuture(QtConcurrent::run(saver, filename, frames, &context));
+    progressTimer.start(100);
+    if (!watcher.isFinished()) loop.exec();
+    watcher.waitForFinished();
+    progressTimer.stop();
+
+    if (context.canceled.load())
+    {
+        QFile::remove(filename);
+        return false;
+    }
+    return watcher.result();
+}
+
+bool FrameFileIO::saveFrameFile(QString &fileName, const CANFrameView *frameCache)
 {
     QString filename;
     QFileDialog dialog(qApp->activeWindow());
@@ -30,6 +447,8 @@ bool FrameFileIO::saveFrameFile(QString &fileName, const QVector<CANFrame>* fram
     filters.append(QString(tr("CAN-DO Log (*.can *.avc *.evc *.qcc *.CAN *.AVC *.EVC *.QCC)")));
     filters.append(QString(tr("Vehicle Spy (*.csv *.CSV)")));
     filters.append(QString(tr("Candump/Kayak(*.log)")));
+    filters.append(QString(tr("SavvyCAN Binary (*.scb *.SCB)")));
+    filters.append(QString(tr("SavvyCAN Compressed (*.scz *.SCZ)")));
 
     dialog.setFileMode(QFileDialog::AnyFile);
     dialog.setNameFilters(filters);
@@ -39,71 +458,33 @@ bool FrameFileIO::saveFrameFile(QString &fileName, const QVector<CANFrame>* fram
     if (dialog.exec() == QDialog::Accepted)
     {
         filename = dialog.selectedFiles()[0];
+        SaveFunc saver = NULL;
+        QString extension;
+
+        if (dialog.selectedNameFilter() == filters[0]) { saver = saveNativeCSVFile; extension = ".csv"; }
+        if (dialog.selectedNameFilter() == filters[1]) { saver = saveCRTDFile; extension = ".txt"; }
+        if (dialog.selectedNameFilter() == filters[2]) { saver = saveGenericCSVFile; extension = ".csv"; }
+        if (dialog.selectedNameFilter() == filters[3]) { saver = saveLogFile; extension = ".log"; }
+        if (dialog.selectedNameFilter() == filters[4]) { saver = saveMicrochipFile; extension = ".log"; }
+        if (dialog.selectedNameFilter() == filters[5]) { saver = saveTraceFile; extension = ".trace"; }
+        if (dialog.selectedNameFilter() == filters[6]) { saver = saveIXXATFile; extension = ".csv"; }
+        if (dialog.selectedNameFilter() == filters[7]) { saver = saveCANDOFile; extension = ".can"; }
+        if (dialog.selectedNameFilter() == filters[8]) { saver = saveVehicleSpyFile; extension = ".csv"; }
+        if (dialog.selectedNameFilter() == filters[9]) { saver = saveCanDumpFile; extension = ".log"; }
+        if (dialog.selectedNameFilter() == filters[10]) { saver = saveNativeBinaryFile; extension = ".scb"; }
+        if (dialog.selectedNameFilter() == filters[11]) { saver = saveCompressedFile; extension = ".scz"; }
+        if (!saver) return false;
+        if (!filename.contains('.')) filename += extension;
 
         QProgressDialog progress(qApp->activeWindow());
         progress.setWindowModality(Qt::WindowModal);
         progress.setLabelText("Saving file...");
-        progress.setCancelButton(0);
-        progress.setRange(0,0);
+        progress.setCancelButtonText(tr("Cancel"));
+        progress.setRange(0, 1000);
         progress.setMinimumDuration(0);
         progress.show();
 
-        qApp->processEvents();
-
-        if (dialog.selectedNameFilter() == filters[0])
-        {
-            if (!filename.contains('.')) filename += ".csv";
-            result = saveNativeCSVFile(filename, frameCache);
-        }
-        if (dialog.selectedNameFilter() == filters[1])
-        {
-            if (!filename.contains('.')) filename += ".txt";
-            result = saveCRTDFile(filename, frameCache);
-        }
-        if (dialog.selectedNameFilter() == filters[2])
-        {
-            if (!filename.contains('.')) filename += ".csv";
-            result = saveGenericCSVFile(filename, frameCache);
-        }
-        if (dialog.selectedNameFilter() == filters[3])
-        {
-            if (!filename.contains('.')) filename += ".log";
-            result = saveLogFile(filename, frameCache);
-        }
-        if (dialog.selectedNameFilter() == filters[4])
-        {
-            if (!filename.contains('.')) filename += ".log";
-            result = saveMicrochipFile(filename, frameCache);
-        }
-
-        if (dialog.selectedNameFilter() == filters[5])
-        {
-            if (!filename.contains('.')) filename += ".trace";
-            result = saveTraceFile(filename, frameCache);
-        }
-
-        if (dialog.selectedNameFilter() == filters[6])
-        {
-            if (!filename.contains('.')) filename += ".csv";
-            result = saveIXXATFile(filename, frameCache);
-        }
-
-        if (dialog.selectedNameFilter() == filters[7])
-        {
-            if (!filename.contains('.')) filename += ".can";
-            result = saveCANDOFile(filename, frameCache);
-        }
-
-        if (dialog.selectedNameFilter() == filters[8])
-        {
-            if (!filename.contains('.')) filename += ".csv";
-            result = saveVehicleSpyFile(filename, frameCache);
-        }
-	if (dialog.selectedNameFilter() == filters[9])
-	{
-		if (!filename.contains('.')) filename += ".log";
-		saveCanDumpFile(filename,frameCache);
-	}
+        result = saveInBackground(saver, filename, frameCache, &progress);
         progress.cancel();
 
         if (result)
@@ -117,26 +498,107 @@ bool FrameFileIO::saveFrameFile(QString &fileName, const QVector<CANFrame>* fram
     return false;
 }
 
-bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache)
+/*
+ * Asks which part of a log to load: a window in seconds, from the first frame or by the file's own timestamps,
+ * and the IDs to keep as hex separated by spaces or commas. The last answers are offered again next time.
+ */
+static bool askLoadFilter(LoadFilter &filter)
+{
+    QSettings settings;
+    QDialog dialog(qApp->activeWindow());
+    dialog.setWindowTitle(QObject::tr("Load Part of File"));
+
+    QCheckBox *useWindow = new QCheckBox(QObject::tr("Only load frames in a time window"), &dialog);
+    QLineEdit *startEdit = new QLineEdit(settings.value("Load/PartStart", "0").toString(), &dialog);
+    QLineEdit *endEdit = new QLineEdit(settings.value("Load/PartEnd", "60").toString(), &dialog);
+    QCheckBox *fromFirst = new QCheckBox(QObject::tr("Seconds counted from the first frame of the file"), &dialog);
+    QLineEdit *idsEdit = new QLineEdit(settings.value("Load/PartIDs", "").toString(), &dialog);
+    QDoubleValidator *validator = new QDoubleValidator(0.0, 1e12, 6, &dialog);
+    validator->setLocale(QLocale::c());
+    startEdit->setValidator(validator);
+    endEdit->setValidator(validator);
+    useWindow->setChecked(settings.value("Load/PartUseWindow", true).toBool());
+    fromFirst->setChecked(settings.value("Load/PartFromFirst", true).toBool());
+    idsEdit->setPlaceholderText(QObject::tr("Hex, e.g. 1F0 7E8. Blank loads every ID"));
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    QObject::connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    QObject::connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    QFormLayout *layout = new QFormLayout(&dialog);
+    layout->addRow(useWindow);
+    layout->addRow(QObject::tr("From (s)"), startEdit);
+    layout->addRow(QObject::tr("To (s)"), endEdit);
+    layout->addRow(fromFirst);
+    layout->addRow(QObject::tr("IDs"), idsEdit);
+    layout->addRow(buttons);
+
+    if (dialog.exec() != QDialog::Accepted) return false;
+
+    QStringList idList = idsEdit->text().split(QRegExp("[,\\s]+"), QString::SkipEmptyParts);
+    for (int i = 0; i < idList.count(); i++)
+    {
+        bool ok;
+        uint32_t ID = idList[i].toUInt(&ok, 16);
+        if (!ok)
+        {
+            QMessageBox msgBox;
+            msgBox.setText(QObject::tr("%1 isn't a hex ID.").arg(idList[i]));
+            msgBox.exec();
+            return false;
+        }
+        filter.ids.insert(ID);
+    }
+
+    if (useWindow->isChecked())
+    {
+        double start = QLocale::c().toDouble(startEdit->text());
+        double end = QLocale::c().toDouble(endEdit->text());
+        if (end < start)
+        {
+            QMessageBox msgBox;
+            msgBox.setText(QObject::tr("The end of the time window is before its start."));
+            msgBox.exec();
+            return false;
+        }
+        filter.startTime = (uint64_t)(start * 1000000.0 + 0.5);
+        filter.endTime = (uint64_t)(end * 1000000.0 + 0.5);
+        filter.fromFirstFrame = fromFirst->isChecked();
+    }
+
+    settings.setValue("Load/PartStart", startEdit->text());
+    settings.setValue("Load/PartEnd", endEdit->text());
+    settings.setValue("Load/PartIDs", idsEdit->text());
+    settings.setValue("Load/PartUseWindow", useWindow->isChecked());
+    settings.setValue("Load/PartFromFirst", fromFirst->isChecked());
+    return true;
+}
+
+bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache, bool askWhichPart)
 {
     QString filename;
     QFileDialog dialog;
     bool result = false;
 
+    //each filter loads the format next to it. Auto detect looks at the file to pick one
     QStringList filters;
-    filters.append(QString(tr("GVRET Logs (*.csv *.CSV)")));
-    filters.append(QString(tr("CRTD Logs (*.txt *.TXT)")));
-    filters.append(QString(tr("Generic ID/Data CSV (*.csv *.CSV)")));
-    filters.append(QString(tr("BusMaster Log (*.log *.LOG)")));
-    filters.append(QString(tr("Microchip Log (*.can *.CAN)")));
-    filters.append(QString(tr("Vector trace files (*.trace *.TRACE)")));
-    filters.append(QString(tr("IXXAT MiniLog (*.csv *.CSV)")));
-    filters.append(QString(tr("CAN-DO Log (*.avc *.can *.evc *.qcc *.AVC *.CAN *.EVC *.QCC)")));
-    filters.append(QString(tr("Vehicle Spy (*.csv *.CSV)")));
-    filters.append(QString(tr("Candump/Kayak (*.log *.LOG)")));
-    filters.append(QString(tr("PCAN Viewer (*.trc *.TRC)")));
-    filters.append(QString(tr("Kvaser Log Decimal (*.txt *.TXT)")));
-    filters.append(QString(tr("Kvaser Log Hex (*.txt *.TXT)")));
+    QVector<FileFormat> formats;
+    filters.append(QString(tr("Any Supported Log, Auto Detected (*)"))); formats.append(FORMAT_UNKNOWN);
+    filters.append(QString(tr("GVRET Logs (*.csv *.CSV)"))); formats.append(FORMAT_NATIVE_CSV);
+    filters.append(QString(tr("CRTD Logs (*.txt *.TXT)"))); formats.append(FORMAT_CRTD);
+    filters.append(QString(tr("Generic ID/Data CSV (*.csv *.CSV)"))); formats.append(FORMAT_GENERIC_CSV);
+    filters.append(QString(tr("BusMaster Log (*.log *.LOG)"))); formats.append(FORMAT_BUSMASTER);
+    filters.append(QString(tr("Microchip Log (*.can *.CAN)"))); formats.append(FORMAT_MICROCHIP);
+    filters.append(QString(tr("Vector trace files (*.trace *.TRACE)"))); formats.append(FORMAT_TRACE);
+    filters.append(QString(tr("IXXAT MiniLog (*.csv *.CSV)"))); formats.append(FORMAT_IXXAT);
+    filters.append(QString(tr("CAN-DO Log (*.avc *.can *.evc *.qcc *.AVC *.CAN *.EVC *.QCC)"))); formats.append(FORMAT_CANDO);
+    filters.append(QString(tr("Vehicle Spy (*.csv *.CSV)"))); formats.append(FORMAT_VEHICLESPY);
+    filters.append(QString(tr("Candump/Kayak (*.log *.LOG)"))); formats.append(FORMAT_CANDUMP);
+    filters.append(QString(tr("PCAN Viewer (*.trc *.TRC)"))); formats.append(FORMAT_PCAN);
+    filters.append(QString(tr("Kvaser Log Decimal (*.txt *.TXT)"))); formats.append(FORMAT_KVASER_DEC);
+    filters.append(QString(tr("Kvaser Log Hex (*.txt *.TXT)"))); formats.append(FORMAT_KVASER_HEX);
+    filters.append(QString(tr("SavvyCAN Binary (*.scb *.SCB)"))); formats.append(FORMAT_NATIVE_BINARY);
+    filters.append(QString(tr("SavvyCAN Compressed (*.scz *.SCZ)"))); formats.append(FORMAT_COMPRESSED);
 
     dialog.setFileMode(QFileDialog::ExistingFile);
     dialog.setNameFilters(filters);
@@ -146,9 +608,23 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
     {
         filename = dialog.selectedFiles()[0];
 
+        int selected = filters.indexOf(dialog.selectedNameFilter());
+        FileFormat format = (selected >= 0) ? formats[selected] : FORMAT_UNKNOWN;
+        if (format == FORMAT_UNKNOWN) format = detectFileFormat(filename);
+        if (format == FORMAT_UNKNOWN)
+        {
+            QMessageBox msgBox;
+            msgBox.setText("Couldn't work out what format this file is in.\r\nTry picking the file type instead.");
+            msgBox.exec();
+            return false;
+        }
+
+        LoadFilter filter;
+        if (askWhichPart && !askLoadFilter(filter)) return false;
+
         QProgressDialog progress(qApp->activeWindow());
         progress.setWindowModality(Qt::WindowModal);
-        progress.setLabelText("Loading file...");
+        progress.setLabelText("Loading " + formatName(format) + " file...");
         progress.setCancelButton(0);
         progress.setRange(0,0);
         progress.setMinimumDuration(0);
@@ -156,20 +632,12 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
 
         qApp->processEvents();
 
-        if (dialog.selectedNameFilter() == filters[0]) result = loadNativeCSVFile(filename, frameCache);
-        if (dialog.selectedNameFilter() == filters[1]) result = loadCRTDFile(filename, frameCache);
-        if (dialog.selectedNameFilter() == filters[2]) result = loadGenericCSVFile(filename, frameCache);
-        if (dialog.selectedNameFilter() == filters[3]) result = loadLogFile(filename, frameCache);
-        if (dialog.selectedNameFilter() == filters[4]) result = loadMicrochipFile(filename, frameCache);
-        if (dialog.selectedNameFilter() == filters[5]) result = loadTraceFile(filename, frameCache);
-        if (dialog.selectedNameFilter() == filters[6]) result = loadIXXATFile(filename, frameCache);
-        if (dialog.selectedNameFilter() == filters[7]) result = loadCANDOFile(filename, frameCache);
-        if (dialog.selectedNameFilter() == filters[8]) result = loadVehicleSpyFile(filename, frameCache);
-        if (dialog.selectedNameFilter() == filters[9]) result = loadCanDumpFile(filename, frameCache);
-        if (dialog.selectedNameFilter() == filters[10]) result = loadPCANFile(filename, frameCache);
-        if (dialog.selectedNameFilter() == filters[11]) result = loadKvaserFile(filename, frameCache, false);
-        if (dialog.selectedNameFilter() == filters[12]) result = loadKvaserFile(filename, frameCache, true);
+        FileIOContext context;
+        context.filter = askWhichPart ? &filter : NULL;
+        context.progressDialog = &progress;
+        result = loadFileOfFormat(filename, format, frameCache, &context);
 
+        bool canceled = progress.wasCanceled();
         progress.cancel();
 
         if (result)
@@ -178,7 +646,7 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
             fileName = fileList[fileList.length() - 1];
             return true;
         }
-        else
+        else if (!canceled)
         {
             QMessageBox msgBox;
             msgBox.setText("File load completed with errors.\r\nPerhaps you selected the wrong file type?");
@@ -190,69 +658,182 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
 }
 
 
+bool FrameFileIO::convertToNativeBinary(QString &fileName)
+{
+    QVector<CANFrame> frames;
+    QString loadedName;
+
+    if (!loadFrameFile(loadedName, &frames)) return false;
+
+    QFileDialog dialog(qApp->activeWindow());
+    QStringList filters;
+    filters.append(QString(tr("SavvyCAN Binary (*.scb *.SCB)")));
+
+    dialog.setFileMode(QFileDialog::AnyFile);
+    dialog.setNameFilters(filters);
+    dialog.setViewMode(QFileDialog::Detail);
+    dialog.setAcceptMode(QFileDialog::AcceptSave);
+    dialog.selectFile(QFileInfo(loadedName).completeBaseName() + ".scb");
+
+    if (dialog.exec() != QDialog::Accepted) return false;
+
+    QString filename = dialog.selectedFiles()[0];
+    if (!filename.contains('.')) filename += ".scb";
+
+    CANFrameView view(&frames);
+    if (!saveNativeBinaryFile(filename, &view)) return false;
+
+    QStringList fileList = filename.split('/');
+    fileName = fileList[fileList.length() - 1];
+    return true;
+}
+
+/*
+ * Picks a line based log to browse where it sits. Building its page table runs on the thread pool behind a
+ * progress dialog that can cancel it, the same way saveInBackground() keeps the GUI going.
+ */
+LazyFrameFile *FrameFileIO::viewFrameFile(QString &fileName)
+{
+    QFileDialog dialog(qApp->activeWindow());
+    QStringList filters;
+    filters.append(QString(tr("GVRET Logs (*.csv *.CSV)")));
+    filters.append(QString(tr("CRTD Logs (*.txt *.TXT)")));
+    filters.append(QString(tr("Generic ID/Data CSV (*.csv *.CSV)")));
+    filters.append(QString(tr("BusMaster Log (*.log *.LOG)")));
+    filters.append(QString(tr("Candump/Kayak (*.log *.LOG)")));
+
+    dialog.setFileMode(QFileDialog::ExistingFile);
+    dialog.setNameFilters(filters);
+    dialog.setViewMode(QFileDialog::Detail);
+
+    if (dialog.exec() != QDialog::Accepted) return NULL;
+
+    QString filename = dialog.selectedFiles()[0];
+    LineFileType type = LINEFILE_NATIVE_CSV;
+    if (dialog.selectedNameFilter() == filters[1]) type = LINEFILE_CRTD;
+    if (dialog.selectedNameFilter() == filters[2]) type = LINEFILE_GENERIC_CSV;
+    if (dialog.selectedNameFilter() == filters[3]) type = LINEFILE_LOG;
+    if (dialog.selectedNameFilter() == filters[4]) type = LINEFILE_CANDUMP;
+
+    QProgressDialog progress(qApp->activeWindow());
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setLabelText(tr("Indexing file..."));
+    progress.setCancelButtonText(tr("Cancel"));
+    progress.setRange(0, 1000);
+    progress.setMinimumDuration(0);
+    progress.show();
+
+    LazyFrameFile *file = new LazyFrameFile;
+    QFutureWatcher<bool> watcher;
+    QEventLoop loop;
+    QTimer progressTimer;
+    QObject::connect(&watcher, &QFutureWatcher<bool>::finished, &loop, &QEventLoop::quit);
+    QObject::connect(&progressTimer, &QTimer::timeout, &progress, [&progress, file]() { progress.setValue(file->openProgress()); });
+    QObject::connect(&progress, &QProgressDialog::canceled, &watcher, [file]() { file->cancelOpen(); });
+
+    watcher.setFuture(QtConcurrent::run(file, &LazyFrameFile::open, filename, lineFormat(type)));
+    progressTimer.start(100);
+    if (!watcher.isFinished()) loop.exec();
+    watcher.waitForFinished();
+    progressTimer.stop();
+
+    if (!watcher.result())
+    {
+        bool canceled = progress.wasCanceled();
+        delete file;
+        if (!canceled)
+        {
+            QMessageBox msgBox;
+            msgBox.setText("Couldn't open the file to view it.");
+            msgBox.exec();
+        }
+        return NULL;
+    }
+
+    if (file->hadErrors())
+    {
+        QMessageBox msgBox;
+        msgBox.setText("Some lines of the file couldn't be read and are left out.\r\nPerhaps you selected the wrong file type?");
+        msgBox.exec();
+    }
+
+    QStringList fileList = filename.split('/');
+    fileName = fileList[fileList.length() - 1];
+    return file;
+}
+
+//loads inFilename with the given loader (loadCRTDFile, loadNativeCSVFile and so on) and writes it back out as native binary
+bool FrameFileIO::convertToNativeBinary(QString inFilename, QString outFilename, LoadFunc loader)
+{
+    QVector<CANFrame> frames;
+    if (!loader(inFilename, &frames, NULL)) return false;
+
+    CANFrameView view(&frames);
+    return saveNativeBinaryFile(outFilename, &view);
+}
+
 //2,2550.368293675,0.003818174999651092,67371008,F,F,HS CAN $119,HS CAN,,119,F,F,00,00,00,00,00,00,0D,8B,,,
 //Line,Abs Time(Sec),Rel Time (Sec),Status,Er,Tx,Description,Network,Node,Arb ID,Remote,Xtd,B1,B2,B3,B4,B5,B6,B7,B8,Value,Trigger,Signals
 // 0       1             2             3   4  5   6             7     8     9     10     11 12 13 14 15 16 17 18 19  20     21      22
-bool FrameFileIO::loadVehicleSpyFile(QString filename, QVector<CANFrame> *frames)
+bool FrameFileIO::loadVehicleSpyFile(QString filename, QVector<CANFrame> *frames, FileIOContext *context)
 {
     QFile *inFile = new QFile(filename);
     CANFrame thisFrame;
-    QByteArray line;
+    TextSpan line;
+    TextSpan tokens[MAX_LINE_TOKENS];
     int lineCounter = 0;
     bool pastHeader = false;
     bool foundErrors = false;
 
-    QDateTime now = QDateTime::currentDateTime();
-    QDateTime tempTime;
+    uint64_t now = QDateTime::currentDateTime().toMSecsSinceEpoch() * 1000ull;
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
+    if (!inFile->open(QIODevice::ReadOnly))
     {
         delete inFile;
         return false;
     }
 
-    while (!inFile->atEnd() && !pastHeader)
+    LineReader reader(inFile);
+    while (!pastHeader && reader.nextLine(line))
     {
-        line = inFile->readLine().simplified().toUpper();
-        if (line.startsWith("LINE")) lineCounter++;
+        if (line.trimmed().startsWithNoCase("LINE")) lineCounter++;
         if (lineCounter == 2) pastHeader = true;
     }
 
-    if (inFile->atEnd()) foundErrors = true;
+    if (reader.atEnd()) foundErrors = true;
 
-    while (!inFile->atEnd()) {
+    while (reader.nextLine(line)) {
         lineCounter++;
-        if (lineCounter > 100)
+        if (lineCounter > LOADER_EVENT_LINES)
         {
             qApp->processEvents();
             lineCounter = 0;
         }
-        line = inFile->readLine().simplified().toUpper();
 
-        QList<QByteArray> tokens = line.split(',');
-        if (tokens.length() > 20)
+        int numTokens = TextTokenizer(line, ',').split(tokens, MAX_LINE_TOKENS);
+        if (numTokens > 20)
         {
             thisFrame.bus = 0;
-            tempTime = now;
-            tempTime.addMSecs(tokens[1].toDouble() * 1000.0);
-            thisFrame.timestamp = tempTime.toMSecsSinceEpoch() * 1000ul;
-            if (tokens[5].startsWith("T")) thisFrame.isReceived = false;
+            //offset in seconds from the start of the capture
+            thisFrame.timestamp = now + tokens[1].toFixed(6);
+            if (tokens[5].trimmed().startsWithNoCase("T")) thisFrame.isReceived = false;
                 else thisFrame.isReceived = true;
-            thisFrame.ID = tokens[9].toInt(NULL, 16);
-            if (tokens[11].startsWith("T")) thisFrame.extended = true;
+            thisFrame.ID = tokens[9].toHex();
+            if (tokens[11].trimmed().startsWithNoCase("T")) thisFrame.extended = true;
                 else thisFrame.extended = false;
 
             thisFrame.len = 0;
             for (int i = 0; i < 8; i++)
             {
-                if (tokens[12 + i].length() > 0)
+                TextSpan byte = tokens[12 + i].trimmed();
+                if (byte.len > 0)
                 {
-                    thisFrame.data[i] = tokens[12 + i].toInt(NULL, 16);
+                    thisFrame.data[i] = byte.toHex();
                     thisFrame.len++;
                 }
                 else break;
             }
-            frames->append(thisFrame);
+            if (keepFrame(thisFrame, context)) frames->append(thisFrame);
         }
         else foundErrors = true;
     }
@@ -261,10 +842,11 @@ bool FrameFileIO::loadVehicleSpyFile(QString filename, QVector<CANFrame> *frames
     return !foundErrors;
 }
 
-bool FrameFileIO::saveVehicleSpyFile(QString filename, const QVector<CANFrame> *frames)
+bool FrameFileIO::saveVehicleSpyFile(QString filename, const CANFrameView *frames, FileIOContext *context)
 {
     Q_UNUSED(filename);
     Q_UNUSED(frames);
+    Q_UNUSED(context);
     return true;
 }
 
@@ -291,128 +873,71 @@ tokens:
 3-x = The data bytes
 */
 
-bool FrameFileIO::loadCRTDFile(QString filename, QVector<CANFrame>* frames)
+static LineResult parseCRTDLine(const TextSpan &rawLine, CANFrame &thisFrame, int)
 {
-    QFile *inFile = new QFile(filename);
-    CANFrame thisFrame;
-    QByteArray line;
-    int lineCounter = 0;
-    bool foundErrors = false;
-
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
-
-    line = inFile->readLine().toUpper(); //read out the header first and discard it.
+    TextSpan tokens[MAX_LINE_TOKENS];
+    TextSpan line = rawLine.trimmed();
+    if (line.len <= 2) return LINE_SKIP;
+
+    int numTokens = TextTokenizer(line, ' ', true).split(tokens, MAX_LINE_TOKENS);
+    if (numTokens <= 3) return LINE_ERROR;
+
+    //a timestamp with a decimal point is in seconds. Without one assume it is already microseconds
+    if (tokens[0].indexOf('.') > -1) thisFrame.timestamp = tokens[0].toFixed(6);
+        else thisFrame.timestamp = tokens[0].toInt();
+    char firstChar = tokens[1].at(0);
+    if (firstChar != 'R' && firstChar != 'T') return LINE_SKIP;
+
+    thisFrame.ID = tokens[2].toHex();
+    if (tokens[1].equals("R29") || tokens[1].equals("T29")) thisFrame.extended = true;
+        else thisFrame.extended = false;
+    if (firstChar == 'T') thisFrame.isReceived = false;
+        else thisFrame.isReceived = true;
+    thisFrame.bus = 0;
+    thisFrame.len = qMin(numTokens, MAX_LINE_TOKENS) - 3;
+    if (thisFrame.len > 8) thisFrame.len = 8;
+    for (unsigned int d = 0; d < thisFrame.len; d++) thisFrame.data[d] = tokens[d + 3].toHex();
+    return LINE_FRAME;
+}
 
-    while (!inFile->atEnd()) {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-        line = inFile->readLine().simplified();
-        if (line.length() > 2)
-        {
-            QList<QByteArray> tokens = line.split(' ');
-            int multiplier;
-            if (tokens.length() > 3)
-            {
-                int idxOfDecimal = tokens[0].indexOf('.');
-                if (idxOfDecimal > -1) {
-                    //int decimalPlaces = tokens[0].length() - tokens[0].indexOf('.') - 1;
-                    //the result of the above is the # of digits after the decimal.
-                    //This program deals in microsecond so turn the value into microseconds
-                    multiplier = 1000000; //turn the decimal into full microseconds
-                }
-                else
-                {
-                    multiplier = 1; //special case. Assume no decimal means microseconds
-                }
-                //qDebug() << "decimal places " << decimalPlaces;
-                thisFrame.timestamp = (int64_t)(tokens[0].toDouble() * multiplier);
-                char firstChar = tokens[1].left(1)[0];
-                if (firstChar == 'R' || firstChar == 'T')
-                {
-                    thisFrame.ID = tokens[2].toInt(NULL, 16);
-                    if (tokens[1] == "R29" || tokens[1] == "T29") thisFrame.extended = true;
-                        else thisFrame.extended = false;
-                    if (firstChar == 'T') thisFrame.isReceived = false;
-                        else thisFrame.isReceived = true;
-                    thisFrame.bus = 0;
-                    thisFrame.len = tokens.length() - 3;
-                    for (unsigned int d = 0; d < thisFrame.len; d++)
-                    {
-                        if (tokens[d + 3] != "")
-                        {
-                            thisFrame.data[d] = tokens[d + 3].toInt(NULL, 16);
-                        }
-                        else thisFrame.data[d] = 0;
-                    }
-                    frames->append(thisFrame);
-                }
-            }
-            else foundErrors = true;
-        }
-    }
-    inFile->close();
-    delete inFile;
-    return !foundErrors;
+bool FrameFileIO::loadCRTDFile(QString filename, QVector<CANFrame> *frames, FileIOContext *context)
+{
+    return loadLineFile(filename, lineFormat(LINEFILE_CRTD), frames, context);
 }
 
-bool FrameFileIO::saveCRTDFile(QString filename, const QVector<CANFrame>* frames)
+bool FrameFileIO::saveCRTDFile(QString filename, const CANFrameView *frames, FileIOContext *context)
 {
-    QFile *outFile = new QFile(filename);
-    int lineCounter = 0;
+    QFile outFile(filename);
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
 
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
+    TextWriter out(&outFile);
+    int num = frames->count();
 
     //write in float format with 6 digits after the decimal point
-    outFile->write(QString::number(frames->at(0).timestamp / 1000000.0, 'f', 6).toUtf8() + tr(" CXX GVRET-PC Reverse Engineering Tool Output V").toUtf8() + QString::number(VERSION).toUtf8());
-    outFile->write("\n");
+    out.putFixed(num ? frames->at(0).timestamp : 0, 6);
+    out.put(" CXX GVRET-PC Reverse Engineering Tool Output V");
+    out.putDecimal(VERSION);
+    out.put('\n');
 
-    for (int c = 0; c < frames->count(); c++)
+    for (int c = 0; c < num; c++)
     {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        outFile->write(QString::number(frames->at(c).timestamp / 1000000.0, 'f', 6).toUtf8());
-        outFile->putChar(' ');
+        if (!saveStep(c, num, context)) return false;
+        const CANFrame &frame = frames->at(c);
 
-        if (frames->at(c).isReceived) outFile->putChar('R');
-        else outFile->putChar('T');
+        out.putFixed(frame.timestamp, 6);
+        out.put(frame.isReceived ? " R" : " T");
+        out.put(frame.extended ? "29 " : "11 ");
+        out.putHex(frame.ID, 8);
+        out.put(' ');
 
-        if (frames->at(c).extended)
+        for (unsigned int temp = 0; temp < frame.len; temp++)
         {
-            outFile->write("29 ");
+            out.putHexByte(frame.data[temp]);
+            out.put(' ');
         }
-        else outFile->write("11 ");
-        outFile->write(QString::number(frames->at(c).ID, 16).toUpper().rightJustified(8, '0').toUtf8());
-        outFile->putChar(' ');
-
-        for (unsigned int temp = 0; temp < frames->at(c).len; temp++)
-        {
-            outFile->write(QString::number(frames->at(c).data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->putChar(' ');
-        }
-
-        outFile->write("\n");
+        out.put('\n');
     }
-    outFile->close();
-    delete outFile;
-
-    return true;
+    return out.flush();
 }
 
 
@@ -426,49 +951,49 @@ bool FrameFileIO::saveCRTDFile(QString filename, const QVector<CANFrame>* frames
 //;---+--   ----+----  --+--  ----+---  +  -+ -- -- -- -- -- -- --
 // 0-6         10-18    21-25  28-35    38  41-?
 //Fixed length lines
-bool FrameFileIO::loadPCANFile(QString filename, QVector<CANFrame>* frames)
+bool FrameFileIO::loadPCANFile(QString filename, QVector<CANFrame> *frames, FileIOContext *context)
 {
     QFile *inFile = new QFile(filename);
     CANFrame thisFrame;
-    QByteArray line;
+    TextSpan line;
+    TextSpan tokens[8];
     int lineCounter = 0;
     bool foundErrors = false;
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
+    if (!inFile->open(QIODevice::ReadOnly))
     {
         delete inFile;
         return false;
     }
 
-    while (!inFile->atEnd()) {
+    LineReader reader(inFile);
+    while (reader.nextLine(line)) {
         lineCounter++;
-        if (lineCounter > 100)
+        if (lineCounter > LOADER_EVENT_LINES)
         {
             qApp->processEvents();
             lineCounter = 0;
         }
-        line = inFile->readLine();
-        if (line.startsWith(';')) continue;
-        if (line.length() > 2)
+        if (line.startsWith(";")) continue;
+        if (line.len > 1)
         {
-            thisFrame.timestamp = line.mid(10, 8).simplified().toFloat() * 1000ull;
-            thisFrame.ID = line.mid(28, 8).simplified().toUInt(NULL, 16);
+            //milliseconds with a fraction
+            thisFrame.timestamp = line.mid(10, 8).toFixed(3);
+            thisFrame.ID = line.mid(28, 8).toHex();
             if (thisFrame.ID < 0x1FFFFFFF)
             {
-                thisFrame.len = line.mid(38,1).toInt();
+                thisFrame.len = line.mid(38, 1).toInt();
+                if (thisFrame.len > 8) thisFrame.len = 8;
                 thisFrame.isReceived = true;
                 thisFrame.bus = 0;
                 thisFrame.extended = false;
-                QList<QByteArray> tokens = line.mid(41, thisFrame.len * 3).split(' ');
+                int numTokens = TextTokenizer(line.mid(41, thisFrame.len * 3), ' ').split(tokens, 8);
                 for (unsigned int d = 0; d < thisFrame.len; d++)
                 {
-                    if (tokens[d] != "")
-                    {
-                        thisFrame.data[d] = tokens[d].toInt(NULL, 16);
-                    }
+                    if ((int)d < numTokens && !tokens[d].isEmpty()) thisFrame.data[d] = tokens[d].toHex();
                     else thisFrame.data[d] = 0;
                 }
-                frames->append(thisFrame);
+                if (keepFrame(thisFrame, context)) frames->append(thisFrame);
             }
         }
         //else foundErrors = true;
@@ -480,150 +1005,222 @@ bool FrameFileIO::loadPCANFile(QString filename, QVector<CANFrame>* frames)
 
 
 //The "native" file format for this program
-bool FrameFileIO::loadNativeCSVFile(QString filename, QVector<CANFrame>* frames)
+static int readNativeCSVHeader(const TextSpan &header)
 {
-    QFile *inFile = new QFile(filename);
-    CANFrame thisFrame;
-    QByteArray line;
-    int fileVersion = 1;
-    long long timeStamp = Utility::GetTimeMS();
-    int lineCounter = 0;
-    bool foundErrors = false;
+    if (header.upperAt(23) == 'D') return 2; //Dir is found starting at position 23 if this is a V2 file
+    return 1;
+}
+
+static LineResult parseNativeCSVLine(const TextSpan &line, CANFrame &thisFrame, int fileVersion)
+{
+    TextSpan tokens[MAX_LINE_TOKENS];
+    if (line.len <= 1) return LINE_SKIP;
+
+    int numTokens = qMin(TextTokenizer(line, ',').split(tokens, MAX_LINE_TOKENS), MAX_LINE_TOKENS);
+    if (numTokens < 6) return LINE_ERROR;
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
+    thisFrame.ID = tokens[1].toHex();
+    if (tokens[2].containsNoCase("TRUE")) thisFrame.extended = 1;
+        else thisFrame.extended = 0;
+
+    for (int c = 0; c < 8; c++) thisFrame.data[c] = 0;
+    if (fileVersion == 1)
     {
-        delete inFile;
-        return false;
+        thisFrame.isReceived = true;
+        thisFrame.bus = tokens[3].toInt();
+        thisFrame.len = tokens[4].toInt();
+        if (thisFrame.len > 8) thisFrame.len = 8;
+        if (thisFrame.len + 5 > (unsigned int) numTokens) thisFrame.len = numTokens - 5;
+        for (unsigned int d = 0; d < thisFrame.len; d++) thisFrame.data[d] = tokens[5 + d].toHex();
+    }
+    else if (fileVersion == 2)
+    {
+        if (tokens[3].at(0) == 'R') thisFrame.isReceived = true;
+        else thisFrame.isReceived = false;
+        thisFrame.bus = tokens[4].toInt();
+        thisFrame.len = tokens[5].toInt();
+        if (thisFrame.len > 8) thisFrame.len = 8;
+        if (thisFrame.len + 6 > (unsigned int) numTokens) thisFrame.len = numTokens - 6;
+        for (unsigned int d = 0; d < thisFrame.len; d++) thisFrame.data[d] = tokens[6 + d].toHex();
     }
 
-    line = inFile->readLine().toUpper(); //read out the header first and discard it.
-    if (line.at(23) == 'D') fileVersion = 2; //Dir is found starting at position 23 if this is a V2 file
+    //very short timestamps are junk. Those frames get made up times 5us apart instead
+    if (tokens[0].len <= 3) return LINE_UNTIMED;
+    thisFrame.timestamp = tokens[0].toInt();
+    return LINE_FRAME;
+}
 
-    while (!inFile->atEnd()) {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
+bool FrameFileIO::loadNativeCSVFile(QString filename, QVector<CANFrame> *frames, FileIOContext *context)
+{
+    return loadLineFile(filename, lineFormat(LINEFILE_NATIVE_CSV), frames, context);
+}
 
-        line = inFile->readLine();
-        if (line.length() > 2)
-        {
-            QList<QByteArray> tokens = line.split(',');
-            if (tokens.length() >= 6)
-            {
-                if (tokens[0].length() > 3)
-                {
-                    long long temp = tokens[0].toLongLong();
-                    thisFrame.timestamp = temp;
-                }
-                else
-                {
-                    timeStamp += 5;
-                    thisFrame.timestamp = timeStamp;
-                }
+bool FrameFileIO::saveNativeCSVFile(QString filename, const CANFrameView *frames, FileIOContext *context)
+{
+    QFile outFile(filename);
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
 
-                thisFrame.ID = tokens[1].toInt(NULL, 16);
-                if (tokens[2].toUpper().contains("TRUE")) thisFrame.extended = 1;
-                    else thisFrame.extended = 0;
+    TextWriter out(&outFile);
+    int num = frames->count();
 
-                if (fileVersion == 1)
-                {
-                    thisFrame.isReceived = true;
-                    thisFrame.bus = tokens[3].toInt();
-                    thisFrame.len = tokens[4].toUInt();
-                    for (int c = 0; c < 8; c++) thisFrame.data[c] = 0;
-                    for (unsigned int d = 0; d < thisFrame.len; d++)
-                        thisFrame.data[d] = tokens[5 + d].toInt(NULL, 16);
-                }
-                else if (fileVersion == 2)
-                {
-                    if (tokens[3].at(0) == 'R') thisFrame.isReceived = true;
-                    else thisFrame.isReceived = false;
-                    thisFrame.bus = tokens[4].toInt();
-                    thisFrame.len = tokens[5].toUInt();
-                    if (thisFrame.len + 6 > (unsigned int) tokens.length()) thisFrame.len = tokens.length() - 6;
-                    for (int c = 0; c < 8; c++) thisFrame.data[c] = 0;
-                    for (unsigned int d = 0; d < thisFrame.len; d++)
-                        thisFrame.data[d] = tokens[6 + d].toInt(NULL, 16);
-                }
+    out.put("Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8\n");
 
-                frames->append(thisFrame);
-            }
-            else foundErrors = true;
-        }
+    //same line format as continuous logging so both go through the one formatter
+    char line[LOGGER_MAX_LINE];
+    for (int c = 0; c < num; c++)
+    {
+        if (!saveStep(c, num, context)) return false;
+        out.put(line, ContinuousLogger::formatCSVLine(frames->at(c), line));
     }
-    inFile->close();
-    delete inFile;
-    return !foundErrors;
+    return out.flush();
 }
 
-bool FrameFileIO::saveNativeCSVFile(QString filename, const QVector<CANFrame>* frames)
+/*
+ * Native binary files are read straight out of the mapped file, a batch of fixed width records at a time.
+ * No text to parse and no temporary copies so this is limited mostly by how fast the disk is. A filtered
+ * load of a file with its timestamps in order goes straight to the records in the time window.
+ */
+bool FrameFileIO::loadNativeBinaryFile(QString filename, QVector<CANFrame> *frames, FileIOContext *context)
 {
-    QFile *outFile = new QFile(filename);
-    int lineCounter = 0;
+    LoadFilter *filter = context ? context->filter : NULL;
+    CANBinaryFile inFile;
 
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
+    if (!inFile.open(filename)) return false;
 
-    outFile->write("Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8");
-    outFile->write("\n");
-
-    for (int c = 0; c < frames->count(); c++)
+    const int batch = 65536;
+    if (filter)
     {
-        lineCounter++;
-        if (lineCounter > 100)
+        int first = 0;
+        int last = inFile.count();
+        if (last > 0) filter->anchor(inFile.frameAt(0).timestamp);
+        if (inFile.isMonotonic())
+        {
+            first = inFile.findRecordAtTime(filter->startTime);
+            if (filter->endTime < UINT64_MAX) last = inFile.findRecordAtTime(filter->endTime + 1);
+        }
+
+        QVector<CANFrame> buffer(batch);
+        for (int i = first; i < last; i += batch)
         {
+            int got = inFile.readFrames(i, qMin(batch, last - i), buffer.data());
+            for (int j = 0; j < got; j++)
+            {
+                if (filter->matches(buffer[j])) frames->append(buffer[j]);
+            }
             qApp->processEvents();
-            lineCounter = 0;
         }
+        inFile.close();
+        return true;
+    }
 
-        outFile->write(QString::number(frames->at(c).timestamp).toUtf8());
-        outFile->putChar(44);
+    int start = frames->count();
+    int num = inFile.count();
+    frames->resize(start + num);
+    CANFrame *out = frames->data() + start;
 
-        outFile->write(QString::number(frames->at(c).ID, 16).toUpper().rightJustified(8, '0').toUtf8());
-        outFile->putChar(44);
+    for (int i = 0; i < num; i += batch)
+    {
+        inFile.readFrames(i, batch, out + i);
+        qApp->processEvents();
+    }
+    inFile.close();
+    return true;
+}
 
-        if (frames->at(c).extended) outFile->write("true,");
-        else outFile->write("false,");
+bool FrameFileIO::saveNativeBinaryFile(QString filename, const CANFrameView *frames, FileIOContext *context)
+{
+    Q_UNUSED(context); //writes far faster than a progress bar could follow
+    return CANBinaryFile::write(filename, frames);
+}
 
-        if (frames->at(c).isReceived) outFile->write("Rx,");
-        else outFile->write("Tx,");
+static void decodeJob(DecodeJob &job)
+{
+    job.ok = job.file->decodeBlock(job.block, job.out);
+}
 
-        outFile->write(QString::number(frames->at(c).bus).toUtf8());
-        outFile->putChar(44);
+/*
+ * Every block of a compressed file decodes on its own straight into its place in frames, so they are all
+ * handed to the thread pool at once. A filtered load of a file with its timestamps in order decodes only the
+ * blocks overlapping the time window, into a scratch buffer the kept frames are then copied out of.
+ */
+bool FrameFileIO::loadCompressedFile(QString filename, QVector<CANFrame> *frames, FileIOContext *context)
+{
+    LoadFilter *filter = context ? context->filter : NULL;
+    CANCompressedFile inFile;
 
-        outFile->write(QString::number(frames->at(c).len).toUtf8());
-        outFile->putChar(44);
+    if (!inFile.open(filename)) return false;
 
-        for (unsigned int temp = 0; temp < 8; temp++)
+    const QVector<CANCompressedBlock> &blocks = inFile.getBlocks();
+    int firstBlock = 0;
+    int lastBlock = blocks.count();
+    if (filter)
+    {
+        if (!blocks.isEmpty()) filter->anchor(blocks[0].firstTimestamp);
+        if (inFile.isMonotonic())
         {
-            if (temp < frames->at(c).len)
-                outFile->write(QString::number(frames->at(c).data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            else
-                outFile->write("00");
-            outFile->putChar(44);
+            firstBlock = inFile.findBlockAtTime(filter->startTime);
+            //the block holding the first frame past the window can still start inside it
+            if (filter->endTime < UINT64_MAX) lastBlock = qMin(inFile.findBlockAtTime(filter->endTime + 1) + 1, lastBlock);
+            lastBlock = qMax(firstBlock, lastBlock);
         }
+    }
 
-        outFile->write("\n");
+    QVector<CANFrame> scratch;
+    int start = frames->count();
+    CANFrame *out;
+    if (filter)
+    {
+        int num = (lastBlock > firstBlock) ? blocks[lastBlock - 1].firstFrame + blocks[lastBlock - 1].numFrames - blocks[firstBlock].firstFrame : 0;
+        scratch.resize(num);
+        out = scratch.data();
+    }
+    else
+    {
+        frames->resize(start + inFile.count());
+        out = frames->data() + start;
+    }
 
+    QVector<DecodeJob> jobs;
+    for (int i = firstBlock; i < lastBlock; i++)
+    {
+        DecodeJob job = {&inFile, i, out + blocks[i].firstFrame - blocks[firstBlock].firstFrame, false};
+        jobs.append(job);
     }
-    outFile->close();
-    delete outFile;
-    return true;
+
+    bool result = runLoadJobs(jobs, decodeJob, context ? context->progressDialog : NULL);
+    for (int i = 0; i < jobs.count() && result; i++)
+    {
+        if (!jobs[i].ok) result = false;
+    }
+    inFile.close();
+
+    if (!result) frames->resize(start);
+    else if (filter)
+    {
+        for (int i = 0; i < scratch.count(); i++)
+        {
+            if (filter->matches(scratch[i])) frames->append(scratch[i]);
+        }
+    }
+    return result;
+}
+
+bool FrameFileIO::saveCompressedFile(QString filename, const CANFrameView *frames, FileIOContext *context)
+{
+    Q_UNUSED(context); //writes far faster than a progress bar could follow
+    return CANCompressedFile::write(filename, frames);
 }
 
-bool FrameFileIO::openContinuousNative()
+bool FrameFileIO::startContinuousLogging(ContinuousLogger *logger)
 {
     QString filename;
     QFileDialog dialog(qApp->activeWindow());
+    QSettings settings;
 
     QStringList filters;
     filters.append(QString(tr("GVRET Logs (*.csv *.CSV)")));
+    filters.append(QString(tr("SavvyCAN Binary (*.scb *.SCB)")));
+    filters.append(QString(tr("SavvyCAN Compressed (*.scz *.SCZ)")));
 
     dialog.setFileMode(QFileDialog::AnyFile);
     dialog.setNameFilters(filters);
@@ -633,165 +1230,80 @@ bool FrameFileIO::openContinuousNative()
     if (dialog.exec() == QDialog::Accepted)
     {
         filename = dialog.selectedFiles()[0];
-        continuousFile.setFileName(filename);
-
-        if (!continuousFile.open(QIODevice::WriteOnly | QIODevice::Text))
+        ContinuousLogger::LogFormat format = ContinuousLogger::FORMAT_CSV;
+        if (dialog.selectedNameFilter() == filters[0] && !filename.contains('.')) filename += ".csv";
+        if (dialog.selectedNameFilter() == filters[1])
         {
-            return false;
+            if (!filename.contains('.')) filename += ".scb";
+            format = ContinuousLogger::FORMAT_BINARY;
         }
-        continuousFile.write("Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8");
-        continuousFile.write("\n");
-        return true;
-    }
-    return false;
-}
-
-bool FrameFileIO::closeContinuousNative()
-{
-    if (continuousFile.isOpen())
-    {
-        continuousFile.close();
-        return true;
-    }
-    return false;
-}
-
-bool FrameFileIO::writeContinuousNative(const QVector<CANFrame>* frames, int beginningFrame)
-{
-    if (!continuousFile.isOpen()) return false;
-    qDebug() << "Bgn: " << beginningFrame << "  Count: " << frames->count();
-    for (int c = beginningFrame; c < frames->count(); c++)
-    {
-        continuousFile.write(QString::number(frames->at(c).timestamp).toUtf8());
-        continuousFile.putChar(44);
-
-        continuousFile.write(QString::number(frames->at(c).ID, 16).toUpper().rightJustified(8, '0').toUtf8());
-        continuousFile.putChar(44);
-
-        if (frames->at(c).extended) continuousFile.write("true,");
-        else continuousFile.write("false,");
-
-        if (frames->at(c).isReceived) continuousFile.write("Rx,");
-        else continuousFile.write("Tx,");
-
-        continuousFile.write(QString::number(frames->at(c).bus).toUtf8());
-        continuousFile.putChar(44);
-
-        continuousFile.write(QString::number(frames->at(c).len).toUtf8());
-        continuousFile.putChar(44);
-
-        for (unsigned int temp = 0; temp < 8; temp++)
+        if (dialog.selectedNameFilter() == filters[2])
         {
-            if (temp < frames->at(c).len)
-                continuousFile.write(QString::number(frames->at(c).data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            else
-                continuousFile.write("00");
-            continuousFile.putChar(44);
+            if (!filename.contains('.')) filename += ".scz";
+            format = ContinuousLogger::FORMAT_COMPRESSED;
         }
 
-        continuousFile.write("\n");
+        qint64 rotateBytes = settings.value("ContinuousLog/RotateMB", 0).toLongLong() * 1024 * 1024;
+        int rotateSeconds = settings.value("ContinuousLog/RotateMinutes", 0).toInt() * 60;
+        return logger->startLogging(filename, format, rotateBytes, rotateSeconds);
     }
-    return true;
+    return false;
 }
 
-bool FrameFileIO::flushContinuousNative()
+static LineResult parseGenericCSVLine(const TextSpan &line, CANFrame &thisFrame, int)
 {
-    if (continuousFile.isOpen())
-    {
-        return continuousFile.flush();
-    }
-    return false;
+    TextSpan tokens[2];
+    TextSpan dataTok[8];
+    if (line.len <= 1) return LINE_ERROR;
+
+    int numTokens = TextTokenizer(line, ',').split(tokens, 2);
+
+    thisFrame.ID = tokens[0].toHex();
+    if (thisFrame.ID > 0x7FF) thisFrame.extended = true;
+    else thisFrame.extended  = false;
+    thisFrame.bus = 0;
+    thisFrame.isReceived = true;
+    thisFrame.len = 0;
+    if (numTokens > 1) thisFrame.len = TextTokenizer(tokens[1], ' ').split(dataTok, 8);
+    if (thisFrame.len > 8) thisFrame.len = 8;
+    for (unsigned int d = 0; d < thisFrame.len; d++) thisFrame.data[d] = dataTok[d].toHex();
+
+    //no timestamps in this format at all, frames are spread 5ms apart
+    return LINE_UNTIMED;
 }
 
-bool FrameFileIO::loadGenericCSVFile(QString filename, QVector<CANFrame>* frames)
+bool FrameFileIO::loadGenericCSVFile(QString filename, QVector<CANFrame> *frames, FileIOContext *context)
 {
-    QFile *inFile = new QFile(filename);
-    CANFrame thisFrame;
-    QByteArray line;
-    long long timeStamp = Utility::GetTimeMS();
-    int lineCounter = 0;
-    bool foundErrors = false;
-
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
-
-    line = inFile->readLine(); //read out the header first and discard it.
-
-    while (!inFile->atEnd()) {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        line = inFile->readLine();
-        if (line.length() > 2)
-        {
-            QList<QByteArray> tokens = line.split(',');
-
-            timeStamp += 5000;
-            thisFrame.timestamp = timeStamp;
-            thisFrame.ID = tokens[0].toInt(NULL, 16);
-            if (thisFrame.ID > 0x7FF) thisFrame.extended = true;
-            else thisFrame.extended  = false;
-            thisFrame.bus = 0;
-            QList<QByteArray> dataTok = tokens[1].split(' ');
-            thisFrame.len = dataTok.length();
-            if (thisFrame.len > 8) thisFrame.len = 8;
-            for (unsigned int d = 0; d < thisFrame.len; d++) thisFrame.data[d] = dataTok[d].toInt(NULL, 16);
-
-            frames->append(thisFrame);
-        }
-        else foundErrors = true;
-    }
-    inFile->close();
-    delete inFile;
-    return !foundErrors;
+    return loadLineFile(filename, lineFormat(LINEFILE_GENERIC_CSV), frames, context);
 }
 
 //4f5,ff 34 23 45 24 e4
-bool FrameFileIO::saveGenericCSVFile(QString filename, const QVector<CANFrame>* frames)
+bool FrameFileIO::saveGenericCSVFile(QString filename, const CANFrameView *frames, FileIOContext *context)
 {
-    QFile *outFile = new QFile(filename);
-    int lineCounter = 0;
+    QFile outFile(filename);
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
 
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
+    TextWriter out(&outFile);
+    int num = frames->count();
 
-    outFile->write("ID,Data Bytes");
-    outFile->write("\n");
+    out.put("ID,Data Bytes\n");
 
-    for (int c = 0; c < frames->count(); c++)
+    for (int c = 0; c < num; c++)
     {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
+        if (!saveStep(c, num, context)) return false;
+        const CANFrame &frame = frames->at(c);
 
-        outFile->write(QString::number(frames->at(c).ID, 16).toUpper().rightJustified(8, '0').toUtf8());
-        outFile->putChar(44);
+        out.putHex(frame.ID, 8);
+        out.put(',');
 
-        for (unsigned int temp = 0; temp < frames->at(c).len; temp++)
+        for (unsigned int temp = 0; temp < frame.len; temp++)
         {
-            outFile->write(QString::number(frames->at(c).data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->putChar(' ');
+            out.putHexByte(frame.data[temp]);
+            out.put(' ');
         }
-
-        outFile->write("\n");
-
+        out.put('\n');
     }
-    outFile->close();
-    delete outFile;
-    return true;
+    return out.flush();
 }
 
 //busmaster log file
@@ -823,165 +1335,133 @@ Sample chunk of a busmaster log:
 11:49:12:9440 Rx 1 0x460 s 8 03 E0 00 00 C0 00 00 00
 11:49:12:9530 Rx 1 0x023 s 1 40
 11:49:12:9680 Rx 1 0x408 s 8 0F 02 00 30 00 00 7F 00
-11:49:12:9680 Rx 1 0x40B s 8 00 00 00 00 00 10 60 00
-11:49:12:9690 Rx 1 0x045 s 8 40 00 00 00 00 00 00 00
-*/
-bool FrameFileIO::loadLogFile(QString filename, QVector<CANFrame>* frames)
-{
-    QFile *inFile = new QFile(filename);
-    CANFrame thisFrame;
-    QByteArray line;
-    uint64_t timeStamp = Utility::GetTimeMS();
-    int lineCounter = 0;
-    bool foundErrors = false;
-
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
-
-    line = inFile->readLine(); //read out the header first and discard it.
-
-    while (!inFile->atEnd()) {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        line = inFile->readLine().toUpper();
-        if (line.startsWith("***")) continue;
-        if (line.length() > 1)
-        {
-            QList<QByteArray> tokens = line.split(' ');
-            if (tokens.length() >= 6)
-            {
-                QList<QByteArray> timeToks = tokens[0].split(':');
-                timeStamp = (timeToks[0].toInt() * (1000ul * 1000ul * 60ul * 60ul)) + (timeToks[1].toInt() * (1000ul * 1000ul * 60ul))
-                      + (timeToks[2].toInt() * (1000ul * 1000ul)) + (timeToks[3].toInt() * 100ul);
-                thisFrame.timestamp = timeStamp;
-                if (tokens[1].at(0) == 'R') thisFrame.isReceived = true;
-                    else thisFrame.isReceived = false;
-                thisFrame.ID = tokens[3].right(tokens[3].length() - 2).toInt(NULL, 16);
-                if (tokens[4] == "s") thisFrame.extended = false;
-                    else thisFrame.extended = true;
-                thisFrame.bus = tokens[2].toInt() - 1;
-                thisFrame.len = tokens[5].toUInt();
-                if (thisFrame.len > 8) thisFrame.len = 8;
-                for (unsigned int d = 0; d < thisFrame.len; d++) thisFrame.data[d] = tokens[d + 6].toInt(NULL, 16);
-                frames->append(thisFrame);
-            }
-            else foundErrors = true;
-        }
-    }
-    inFile->close();
-    delete inFile;
-    return !foundErrors;
+11:49:12:9680 Rx 1 0x40B s 8 00 00 00 00 00 10 60 00
+11:49:12:9690 Rx 1 0x045 s 8 40 00 00 00 00 00 00 00
+*/
+static LineResult parseLogLine(const TextSpan &line, CANFrame &thisFrame, int)
+{
+    TextSpan tokens[MAX_LINE_TOKENS];
+    TextSpan timeToks[4];
+    if (line.startsWith("***")) return LINE_SKIP;
+    if (line.len <= 0) return LINE_SKIP;
+
+    int numTokens = qMin(TextTokenizer(line, ' ').split(tokens, MAX_LINE_TOKENS), MAX_LINE_TOKENS);
+    if (numTokens < 6) return LINE_ERROR;
+
+    //hours:minutes:seconds:tenths of a millisecond
+    TextTokenizer(tokens[0], ':').split(timeToks, 4);
+    thisFrame.timestamp = (timeToks[0].toInt() * (1000ul * 1000ul * 60ul * 60ul)) + (timeToks[1].toInt() * (1000ul * 1000ul * 60ul))
+          + (timeToks[2].toInt() * (1000ul * 1000ul)) + (timeToks[3].toInt() * 100ul);
+    if (tokens[1].upperAt(0) == 'R') thisFrame.isReceived = true;
+        else thisFrame.isReceived = false;
+    thisFrame.ID = tokens[3].mid(2).toHex();
+    if (tokens[4].upperAt(0) == 'S' && tokens[4].len == 1) thisFrame.extended = false;
+        else thisFrame.extended = true;
+    thisFrame.bus = tokens[2].toInt() - 1;
+    thisFrame.len = tokens[5].toInt();
+    if (thisFrame.len > 8) thisFrame.len = 8;
+    if (thisFrame.len + 6 > (unsigned int) numTokens) thisFrame.len = numTokens - 6;
+    for (unsigned int d = 0; d < thisFrame.len; d++) thisFrame.data[d] = tokens[d + 6].toHex();
+    return LINE_FRAME;
 }
 
-bool FrameFileIO::saveLogFile(QString filename, const QVector<CANFrame>* frames)
+bool FrameFileIO::loadLogFile(QString filename, QVector<CANFrame> *frames, FileIOContext *context)
 {
-    QFile *outFile = new QFile(filename);
-    QDateTime timestamp, tempStamp;
-    int lineCounter = 0;
+    return loadLineFile(filename, lineFormat(LINEFILE_LOG), frames, context);
+}
 
-    //timestamp = QDateTime::currentDateTime();
+bool FrameFileIO::saveLogFile(QString filename, const CANFrameView *frames, FileIOContext *context)
+{
+    QFile outFile(filename);
+    QDateTime timestamp;
 
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
+    //timestamp = QDateTime::currentDateTime();
 
-    outFile->write("***BUSMASTER Ver 2.4.0***\n");
-    outFile->write("***PROTOCOL CAN***\n");
-    outFile->write("***NOTE: PLEASE DO NOT EDIT THIS DOCUMENT***\n");
-    outFile->write("***[START LOGGING SESSION]***\n");
-    outFile->write("***START DATE AND TIME ");
-    outFile->write(timestamp.toString("d:M:yyyy h:m:s:z").toUtf8());
-    outFile->write("***\n");
-    outFile->write("***HEX***\n");
-    outFile->write("***SYSTEM MODE***\n");
-    outFile->write("***START CHANNEL BAUD RATE***\n");
-    outFile->write("***CHANNEL 1 - Kvaser - Kvaser Leaf Light HS #0 (Channel 0), Serial Number- 0, Firmware- 0x00000037 0x00020000 - 500000 bps***\n");
-    outFile->write("***END CHANNEL BAUD RATE***\n");
-    outFile->write("***START DATABASE FILES (DBF/DBC)***\n");
-    outFile->write("***END OF DATABASE FILES (DBF/DBC)***\n");
-    outFile->write("***<Time><Tx/Rx><Channel><CAN ID><Type><DLC><DataBytes>***\n");
-
-    for (int c = 0; c < frames->count(); c++)
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+
+    TextWriter out(&outFile);
+    int num = frames->count();
+
+    out.put("***BUSMASTER Ver 2.4.0***\n");
+    out.put("***PROTOCOL CAN***\n");
+    out.put("***NOTE: PLEASE DO NOT EDIT THIS DOCUMENT***\n");
+    out.put("***[START LOGGING SESSION]***\n");
+    out.put("***START DATE AND TIME ");
+    out.put(timestamp.toString("d:M:yyyy h:m:s:z").toUtf8());
+    out.put("***\n");
+    out.put("***HEX***\n");
+    out.put("***SYSTEM MODE***\n");
+    out.put("***START CHANNEL BAUD RATE***\n");
+    out.put("***CHANNEL 1 - Kvaser - Kvaser Leaf Light HS #0 (Channel 0), Serial Number- 0, Firmware- 0x00000037 0x00020000 - 500000 bps***\n");
+    out.put("***END CHANNEL BAUD RATE***\n");
+    out.put("***START DATABASE FILES (DBF/DBC)***\n");
+    out.put("***END OF DATABASE FILES (DBF/DBC)***\n");
+    out.put("***<Time><Tx/Rx><Channel><CAN ID><Type><DLC><DataBytes>***\n");
+
+    qint64 utcOffset = num ? localOffsetMS(frames->at(0).timestamp) : 0;
+    for (int c = 0; c < num; c++)
     {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-
-        tempStamp = QDateTime::fromMSecsSinceEpoch(frames->at(c).timestamp / 1000);
-        outFile->write(tempStamp.toString("h:m:s:z").toUtf8());
-        if (frames->at(c).isReceived) outFile->write(" Rx ");
-        else outFile->write(" Tx ");
-        outFile->write(QString::number(frames->at(c).bus).toUtf8() + " ");
-        outFile->write(QString::number(frames->at(c).ID, 16).toUpper().rightJustified(8, '0').toUtf8());
-        if (frames->at(c).extended) outFile->write(" x ");
-            else outFile->write(" s ");
-        outFile->write(QString::number(frames->at(c).len).toUtf8() + " ");
-
-        for (unsigned int temp = 0; temp < frames->at(c).len; temp++)
+        if (!saveStep(c, num, context)) return false;
+        const CANFrame &frame = frames->at(c);
+
+        putTimeOfDay(out, frame.timestamp, utcOffset, ':', 0);
+        out.put(frame.isReceived ? " Rx " : " Tx ");
+        out.putDecimal(frame.bus);
+        out.put(' ');
+        out.putHex(frame.ID, 8);
+        out.put(frame.extended ? " x " : " s ");
+        out.putDecimal(frame.len);
+        out.put(' ');
+
+        for (unsigned int temp = 0; temp < frame.len; temp++)
         {
-            outFile->write(QString::number(frames->at(c).data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->putChar(' ');
+            out.putHexByte(frame.data[temp]);
+            out.put(' ');
         }
-
-        outFile->write("\n");
-
+        out.put('\n');
     }
-    outFile->close();
-    delete outFile;
-    return true;
+    return out.flush();
 }
 
 //"00:01:03.03","223","Std","","00 00 00 00 49 00 00 01 "
-bool FrameFileIO::loadIXXATFile(QString filename, QVector<CANFrame>* frames)
+bool FrameFileIO::loadIXXATFile(QString filename, QVector<CANFrame> *frames, FileIOContext *context)
 {
     QFile *inFile = new QFile(filename);
     CANFrame thisFrame;
-    QByteArray line;
+    TextSpan line;
+    TextSpan tokens[8];
+    TextSpan timeToks[3];
+    TextSpan dataToks[8];
     uint64_t timeStamp = Utility::GetTimeMS();
     int lineCounter = 0;
     bool foundErrors = false;
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
+    if (!inFile->open(QIODevice::ReadOnly))
     {
         delete inFile;
         return false;
     }
 
-    for (int i = 0; i < 7; i++) line = inFile->readLine(); //read out the header first and discard it.
+    LineReader reader(inFile);
+    for (int i = 0; i < 7; i++) reader.nextLine(line); //read out the header first and discard it.
 
-    while (!inFile->atEnd()) {
+    while (reader.nextLine(line)) {
         lineCounter++;
-        if (lineCounter > 100)
+        if (lineCounter > LOADER_EVENT_LINES)
         {
             qApp->processEvents();
             lineCounter = 0;
         }
 
-        line = inFile->readLine().toUpper();
-        if (line.length() > 1)
+        if (line.len > 0)
         {
-            QList<QByteArray> tokens = line.split(',');
-            if (line.length() >= 5)
+            int numTokens = TextTokenizer(line, ',').split(tokens, 8);
+            if (numTokens >= 5)
             {
-                QString timePortion = Utility::unQuote(tokens[0]);
-                QStringList timeToks = timePortion.split(':');
-                if (timeToks.length() >= 3)
+                if (TextTokenizer(tokens[0].unquoted(), ':').split(timeToks, 3) >= 3)
                 {
                     timeStamp = (timeToks[0].toInt() * (1000ul * 1000ul * 60ul * 60ul)) + (timeToks[1].toInt() * (1000ul * 1000ul * 60ul))
-                      + (timeToks[2].toDouble() * (1000.0 * 1000.0));
+                      + timeToks[2].toFixed(6);
                 }
                 else
                 {
@@ -989,11 +1469,11 @@ bool FrameFileIO::loadIXXATFile(QString filename, QVector<CANFrame>* frames)
                     foundErrors = true;
                 }
                 thisFrame.timestamp = timeStamp;
-                thisFrame.ID = Utility::unQuote(tokens[1]).toInt(NULL, 16);
-                QString tempStr = Utility::unQuote(tokens[2]).toUpper();
-                if (tempStr.length() > 0)
+                thisFrame.ID = tokens[1].unquoted().toHex();
+                TextSpan tempStr = tokens[2].unquoted();
+                if (tempStr.len > 0)
                 {
-                    if (tempStr.at(0) == 'S') thisFrame.extended = false;
+                    if (tempStr.upperAt(0) == 'S') thisFrame.extended = false;
                         else thisFrame.extended = true;
                 }
                 else
@@ -1005,10 +1485,10 @@ bool FrameFileIO::loadIXXATFile(QString filename, QVector<CANFrame>* frames)
                 thisFrame.isReceived = true;
                 thisFrame.bus = 0;
 
-                QStringList dataToks = Utility::unQuote(tokens[4]).simplified().split(' ');
-                thisFrame.len = dataToks.length();
-                for (unsigned int d = 0; d < thisFrame.len; d++) thisFrame.data[d] = dataToks[d].toInt(NULL, 16);
-                frames->append(thisFrame);
+                thisFrame.len = TextTokenizer(tokens[4].unquoted(), ' ', true).split(dataToks, 8);
+                if (thisFrame.len > 8) thisFrame.len = 8;
+                for (unsigned int d = 0; d < thisFrame.len; d++) thisFrame.data[d] = dataToks[d].toHex();
+                if (keepFrame(thisFrame, context)) frames->append(thisFrame);
             }
             else foundErrors = true;
         }
@@ -1018,60 +1498,51 @@ bool FrameFileIO::loadIXXATFile(QString filename, QVector<CANFrame>* frames)
     return !foundErrors;
 }
 
-bool FrameFileIO::saveIXXATFile(QString filename, const QVector<CANFrame>* frames)
+bool FrameFileIO::saveIXXATFile(QString filename, const CANFrameView *frames, FileIOContext *context)
 {
-    QFile *outFile = new QFile(filename);
-    QDateTime timestamp, tempStamp;
-    int lineCounter = 0;
+    QFile outFile(filename);
+    QDateTime timestamp;
 
     timestamp = QDateTime::currentDateTime();
 
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+
+    TextWriter out(&outFile);
+    int num = frames->count();
 
-    outFile->write("ASCII Trace IXXAT SavvyCAN V" + QString::number(VERSION).toUtf8() + "\n");
-    outFile->write("Date: " + timestamp.toString("d:M:yyyy").toUtf8() + "\n");
-    outFile->write("Start time: " + timestamp.toString("h:m:s").toUtf8() + "\n");
-    timestamp.addMSecs((frames->last().timestamp - frames->first().timestamp) / 1000);
-    outFile->write("Stop time: " + timestamp.toString("h:m:s").toUtf8() + "\n");
-    outFile->write("Overruns: 0\n");
-    outFile->write("Baudrate: 500 kbit/s\n"); //could be a lie... this code has no way to know the baud rate (at the moment)
-    outFile->write("\"Time\",\"Identifier (hex)\",\"Format\",\"Flags\",\"Data (hex)\"\n");
+    out.put("ASCII Trace IXXAT SavvyCAN V" + QString::number(VERSION).toUtf8() + "\n");
+    out.put("Date: " + timestamp.toString("d:M:yyyy").toUtf8() + "\n");
+    out.put("Start time: " + timestamp.toString("h:m:s").toUtf8() + "\n");
+    if (num) timestamp.addMSecs((frames->last().timestamp - frames->first().timestamp) / 1000);
+    out.put("Stop time: " + timestamp.toString("h:m:s").toUtf8() + "\n");
+    out.put("Overruns: 0\n");
+    out.put("Baudrate: 500 kbit/s\n"); //could be a lie... this code has no way to know the baud rate (at the moment)
+    out.put("\"Time\",\"Identifier (hex)\",\"Format\",\"Flags\",\"Data (hex)\"\n");
 
-    for (int c = 0; c < frames->count(); c++)
+    qint64 utcOffset = num ? localOffsetMS(frames->at(0).timestamp) : 0;
+    for (int c = 0; c < num; c++)
     {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
-        tempStamp = QDateTime::fromMSecsSinceEpoch(frames->at(c).timestamp / 1000);
-        outFile->write("\"" + tempStamp.toString("h:m:s.").toUtf8() + tempStamp.toString("z").rightJustified(3, '0').toUtf8() + "\"");
+        if (!saveStep(c, num, context)) return false;
+        const CANFrame &frame = frames->at(c);
 
-        outFile->write(",\"" + QString::number(frames->at(c).ID, 16).toUpper().rightJustified(8, '0').toUtf8() + "\"");
-        if (frames->at(c).extended) outFile->write(",\"Ext\"");
-            else outFile->write(",\"Std\"");
-        outFile->write(",\"\",\"");
+        out.put('"');
+        putTimeOfDay(out, frame.timestamp, utcOffset, '.', 3);
+        out.put("\",\"");
+        out.putHex(frame.ID, 8);
+        out.put(frame.extended ? "\",\"Ext\"" : "\",\"Std\"");
+        out.put(",\"\",\"");
 
-        for (unsigned int temp = 0; temp < frames->at(c).len; temp++)
+        for (unsigned int temp = 0; temp < frame.len; temp++)
         {
-            outFile->write(QString::number(frames->at(c).data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->putChar(' ');
+            out.putHexByte(frame.data[temp]);
+            out.put(' ');
         }
-
-        outFile->write("\"\n");
-
+        out.put("\"\n");
     }
-    outFile->close();
-    delete outFile;
-    return true;
+    return out.flush();
 }
 
-bool FrameFileIO::loadCANDOFile(QString filename, QVector<CANFrame>* frames)
+bool FrameFileIO::loadCANDOFile(QString filename, QVector<CANFrame> *frames, FileIOContext *context)
 {
     QFile *inFile = new QFile(filename);
     CANFrame thisFrame;
@@ -1121,7 +1592,7 @@ bool FrameFileIO::loadCANDOFile(QString filename, QVector<CANFrame>* frames)
         if (thisFrame.len <= 8 && thisFrame.ID <= 0x7FF)
         {
             for (unsigned int d = 0; d < thisFrame.len; d++) thisFrame.data[d] = (unsigned char)data[4 + d];
-            frames->append(thisFrame);
+            if (keepFrame(thisFrame, context)) frames->append(thisFrame);
         }
         else foundErrors = true;
     }
@@ -1131,43 +1602,33 @@ bool FrameFileIO::loadCANDOFile(QString filename, QVector<CANFrame>* frames)
     return !foundErrors;
 }
 
-bool FrameFileIO::saveCANDOFile(QString filename, const QVector<CANFrame>* frames)
+bool FrameFileIO::saveCANDOFile(QString filename, const CANFrameView *frames, FileIOContext *context)
 {
-    QFile *outFile = new QFile(filename);
-    int lineCounter = 0;
-    QByteArray data;
-    CANFrame thisFrame;
+    QFile outFile(filename);
+    char data[12];
     int ms, id;
 
-    if (!outFile->open(QIODevice::WriteOnly))
-    {
-        delete outFile;
-        return false;
-    }
+    if (!outFile.open(QIODevice::WriteOnly)) return false;
 
-    data.reserve(13);
+    //binary records, but the same big buffered writes help just as much
+    TextWriter out(&outFile);
+    int num = frames->count();
 
     //The initial frame in official files sets the global time but I don't care so it is set all zeros here.
-    thisFrame = frames->at(0);
-    ms = (thisFrame.timestamp / 1000);
+    ms = num ? (frames->at(0).timestamp / 1000) : 0;
     data[0] = (((ms / 1000) % 60) << 2) + ((ms % 1000) >> 8);
     data[1] = (char)(ms & 0xFF);
     data[2] = (char)0xFF;
     data[3] = (char)0xFF;
     for (int l = 0; l < 8; l++) data[4 + l] = 0;
-    outFile->write(data);
+    out.put(data, 12);
 
-    for (int c = 0; c < frames->count(); c++)
+    for (int c = 0; c < num; c++)
     {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
+        if (!saveStep(c, num, context)) return false;
+        const CANFrame &thisFrame = frames->at(c);
         for (int j = 0; j < 8; j++) data[4 + j] = (char)0xFF;
 
-        thisFrame = frames->at(c);
         if (!thisFrame.extended)
         {
             ms = (thisFrame.timestamp / 1000);
@@ -1176,13 +1637,11 @@ bool FrameFileIO::saveCANDOFile(QString filename, const QVector<CANFrame>* frame
             data[1] = (char)(ms & 0xFF);
             data[2] = (char)(id & 0xFF);
             data[3] = (char)((id >> 8) + (thisFrame.len << 4));
-            for (unsigned int d = 0; d < thisFrame.len; d++) data[4 + d] = (char)thisFrame.data[d];
-            outFile->write(data);
+            for (unsigned int d = 0; d < thisFrame.len && d < 8; d++) data[4 + d] = (char)thisFrame.data[d];
+            out.put(data, 12);
         }
     }
-    outFile->close();
-    delete outFile;
-    return true;
+    return out.flush();
 }
 
 //log file from microchip tool
@@ -1194,34 +1653,33 @@ tokens:
 3 = Data byte length
 4-x = The data bytes
 */
-bool FrameFileIO::loadMicrochipFile(QString filename, QVector<CANFrame>* frames)
+bool FrameFileIO::loadMicrochipFile(QString filename, QVector<CANFrame> *frames, FileIOContext *context)
 {
     QFile *inFile = new QFile(filename);
     CANFrame thisFrame;
-    QByteArray line;
+    TextSpan line;
+    TextSpan tokens[MAX_LINE_TOKENS];
     bool inComment = false;
     long long timeStamp;
     int lineCounter = 0;
     bool foundErrors = false;
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
+    if (!inFile->open(QIODevice::ReadOnly))
     {
         delete inFile;
         return false;
     }
 
-    //line = inFile->readLine(); //read out the header first and discard it.
-
-    while (!inFile->atEnd()) {
+    LineReader reader(inFile);
+    while (reader.nextLine(line)) {
         lineCounter++;
-        if (lineCounter > 100)
+        if (lineCounter > LOADER_EVENT_LINES)
         {
             qApp->processEvents();
             lineCounter = 0;
         }
 
-        line = inFile->readLine();
-        if (line.length() > 2)
+        if (line.len > 1)
         {
             if (line.startsWith("//"))
             {
@@ -1231,22 +1689,22 @@ bool FrameFileIO::loadMicrochipFile(QString filename, QVector<CANFrame>* frames)
             {
                 if (!inComment)
                 {
-                    QList<QByteArray> tokens = line.split(';');
-                    if (tokens.length() >= 4)
+                    int numTokens = qMin(TextTokenizer(line, ';').split(tokens, MAX_LINE_TOKENS), MAX_LINE_TOKENS);
+                    if (numTokens >= 4)
                     {
                         timeStamp = tokens[0].toInt() * 1000;
                         thisFrame.timestamp = timeStamp;
                         if (tokens[1].at(0) == 'R') thisFrame.isReceived = true;
                             else thisFrame.isReceived = false;
-                        thisFrame.ID = Utility::ParseStringToNum(tokens[2]);
+                        thisFrame.ID = tokens[2].toNumber();
                         if (thisFrame.ID <= 0x7FF) thisFrame.extended = false;
                             else thisFrame.extended = true;
                         thisFrame.bus = 0;
-                        thisFrame.len = tokens[3].toUInt();
+                        thisFrame.len = tokens[3].toInt();
                         if (thisFrame.len > 8) thisFrame.len = 8;
-                        if (thisFrame.len + 4 > (unsigned int) tokens.length()) thisFrame.len = tokens.length() - 4;
-                        for (unsigned int d = 0; d < thisFrame.len; d++) thisFrame.data[d] = (unsigned char)Utility::ParseStringToNum(tokens[4 + d]);
-                        frames->append(thisFrame);
+                        if (thisFrame.len + 4 > (unsigned int) numTokens) thisFrame.len = numTokens - 4;
+                        for (unsigned int d = 0; d < thisFrame.len; d++) thisFrame.data[d] = (unsigned char)tokens[4 + d].toNumber();
+                        if (keepFrame(thisFrame, context)) frames->append(thisFrame);
                     }
                     else foundErrors = true;
                 }
@@ -1269,56 +1727,48 @@ tokens:
 3 = data length
 4-x = data bytes in hex with 0x prefix
 */
-bool FrameFileIO::saveMicrochipFile(QString filename, const QVector<CANFrame>* frames)
+bool FrameFileIO::saveMicrochipFile(QString filename, const CANFrameView *frames, FileIOContext *context)
 {
-    QFile *outFile = new QFile(filename);
-    QDateTime timestamp, tempStamp;
-    int lineCounter = 0;
+    QFile outFile(filename);
+    QDateTime timestamp;
 
     timestamp = QDateTime::currentDateTime();
 
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
 
-    outFile->write("//---------------------------------\n");
-    outFile->write("Microchip Technology Inc.\n");
-    outFile->write("CAN BUS Analyzer\n");
-    outFile->write("SavvyCAN Exporter\n");
-    outFile->write("Logging Started: ");
-    outFile->write(timestamp.toString("d/M/yyyy h:m:s").toUtf8());
-    outFile->write("\n");
-    outFile->write("//---------------------------------\n");
+    TextWriter out(&outFile);
+    int num = frames->count();
 
-    for (int c = 0; c < frames->count(); c++)
+    out.put("//---------------------------------\n");
+    out.put("Microchip Technology Inc.\n");
+    out.put("CAN BUS Analyzer\n");
+    out.put("SavvyCAN Exporter\n");
+    out.put("Logging Started: ");
+    out.put(timestamp.toString("d/M/yyyy h:m:s").toUtf8());
+    out.put("\n");
+    out.put("//---------------------------------\n");
+
+    for (int c = 0; c < num; c++)
     {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
+        if (!saveStep(c, num, context)) return false;
+        const CANFrame &frame = frames->at(c);
 
-        outFile->write(QString::number((int)(frames->at(c).timestamp / 1000)).toUtf8());
-        if (frames->at(c).isReceived) outFile->write(";RX;");
-        else outFile->write(";TX;");
-        outFile->write("0x" + QString::number(frames->at(c).ID, 16).toUpper().rightJustified(8, '0').toUtf8() + ";");
-        outFile->write(QString::number(frames->at(c).len).toUtf8() + ";");
+        out.putSigned((int)(frame.timestamp / 1000));
+        out.put(frame.isReceived ? ";RX;0x" : ";TX;0x");
+        out.putHex(frame.ID, 8);
+        out.put(';');
+        out.putDecimal(frame.len);
+        out.put(';');
 
-        for (unsigned int temp = 0; temp < frames->at(c).len; temp++)
+        for (unsigned int temp = 0; temp < frame.len; temp++)
         {
-            outFile->write("0x" + QString::number(frames->at(c).data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->putChar(';');
+            out.put("0x");
+            out.putHexByte(frame.data[temp]);
+            out.put(';');
         }
-
-        outFile->write("\n");
-
+        out.put('\n');
     }
-    outFile->close();
-    delete outFile;
-    return true;
+    return out.flush();
 }
 
 
@@ -1351,32 +1801,35 @@ and irrelevant. The second field is a funky timestamp, then message id, etc as
 shown in the file comments. The bytes seem to be space delimited and in hex
 */
 
-bool FrameFileIO::loadTraceFile(QString filename, QVector<CANFrame>* frames)
+bool FrameFileIO::loadTraceFile(QString filename, QVector<CANFrame> *frames, FileIOContext *context)
 {
     QFile *inFile = new QFile(filename);
     CANFrame thisFrame;
-    QByteArray line;
+    TextSpan line;
+    TextSpan tokens[8];
+    TextSpan timestampToks[4];
+    TextSpan dataToks[8];
     long long timeStamp = 0;
     int lineCounter = 0;
     bool foundErrors = false;
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
+    if (!inFile->open(QIODevice::ReadOnly))
     {
         delete inFile;
         return false;
     }
 
-    while (!inFile->atEnd()) {
+    LineReader reader(inFile);
+    while (reader.nextLine(line)) {
         lineCounter++;
-        if (lineCounter > 100)
+        if (lineCounter > LOADER_EVENT_LINES)
         {
             qApp->processEvents();
             lineCounter = 0;
         }
 
-        line = inFile->readLine();
         line = line.trimmed();
-        if (line.length() > 2)
+        if (line.len > 2)
         {
             if (line.startsWith(";"))
             {
@@ -1384,10 +1837,11 @@ bool FrameFileIO::loadTraceFile(QString filename, QVector<CANFrame>* frames)
             }
             else
             {
-                QList<QByteArray> tokens = line.split('\t');
-                if (tokens.length() > 3)
+                int numTokens = TextTokenizer(line, '\t').split(tokens, 8);
+                if (numTokens > 3)
                 {
-                    QList<QByteArray> timestampToks = tokens[1].split(':');
+                    int numTimeToks = TextTokenizer(tokens[1], ':').split(timestampToks, 4);
+                    for (int t = numTimeToks; t < 4; t++) timestampToks[t] = TextSpan();
 
                     timeStamp = timestampToks[0].toInt() * 1000000ul * 60 * 60;
                     timeStamp += timestampToks[1].toInt() * 1000000ul * 60;
@@ -1396,16 +1850,16 @@ bool FrameFileIO::loadTraceFile(QString filename, QVector<CANFrame>* frames)
 
                     thisFrame.timestamp = timeStamp;
 
-                    thisFrame.ID = tokens[2].toLong(NULL, 16);
+                    thisFrame.ID = tokens[2].toHex();
                     if (thisFrame.ID <= 0x7FF) thisFrame.extended = false;
                         else thisFrame.extended = true;
                     thisFrame.bus = 0;
-                    thisFrame.len = tokens[3].toUInt();
+                    thisFrame.len = tokens[3].toInt();
                     if (thisFrame.len > 8) thisFrame.len = 8;
-                    QList<QByteArray> dataToks = tokens[4].split(' ');
-                    if (thisFrame.len > (unsigned int) dataToks.length()) thisFrame.len = (unsigned int) dataToks.length();
-                    for (unsigned int d = 0; d < thisFrame.len; d++) thisFrame.data[d] = (unsigned char)dataToks[d].toInt(NULL, 16);
-                    frames->append(thisFrame);
+                    int numDataToks = (numTokens > 4) ? TextTokenizer(tokens[4], ' ').split(dataToks, 8) : 0;
+                    if (thisFrame.len > (unsigned int) numDataToks) thisFrame.len = (unsigned int) numDataToks;
+                    for (unsigned int d = 0; d < thisFrame.len; d++) thisFrame.data[d] = (unsigned char)dataToks[d].toHex();
+                    if (keepFrame(thisFrame, context)) frames->append(thisFrame);
                 }
                 else foundErrors = true;
             }
@@ -1416,272 +1870,231 @@ bool FrameFileIO::loadTraceFile(QString filename, QVector<CANFrame>* frames)
     return !foundErrors;
 }
 
-bool FrameFileIO::saveTraceFile(QString filename, const QVector<CANFrame> * frames)
+bool FrameFileIO::saveTraceFile(QString filename, const CANFrameView *frames, FileIOContext *context)
 {
-    QFile *outFile = new QFile(filename);
+    QFile outFile(filename);
     QDateTime timestamp;
-    int lineCounter = 0;
     uint64_t tempTime;
-    int tempTimePiece;
 
     timestamp = QDateTime::currentDateTime();
 
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
-
-    outFile->write(";  SavvyCAN CAN Logger trace file\n");
-    outFile->write(";  Device Serial Number : 0000 \n");
-    outFile->write(";  Start Time : ");
-    outFile->write(timestamp.toString("ddd, MMM dd, yyyy :: h:m:s\n").toUtf8());
-    outFile->write(";\n");
-    outFile->write(";  Column description :\n");
-    outFile->write(";  ~~~~~~~~~~~~~~~~~~~~~\n");
-    outFile->write(";\n");
-    outFile->write(";   + Message Number\n");
-    outFile->write(";   |\n");
-    outFile->write(";   |     	     + Time Stamp (ms)\n");
-    outFile->write(";   |     	     |\n");
-    outFile->write(";   |     	     |      	    + Message ID (hex)\n");
-    outFile->write(";   |     	     |      	    |\n");
-    outFile->write(";   |     	     |      	    |   	+ Data Length Code\n");
-    outFile->write(";   |     	     |      	    |   	|\n");
-    outFile->write(";   |     	     |      	    |   	|	 + Data Bytes (hex)\n");
-    outFile->write(";   |     	     |      	    |   	|	 |\n");
-    outFile->write(";---+-----	-----+------	----+---	+	-+ -- -- -- -- -- -- --\n");
-
-
-    for (int c = 0; c < frames->count(); c++)
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+
+    TextWriter out(&outFile);
+    int num = frames->count();
+
+    out.put(";  SavvyCAN CAN Logger trace file\n");
+    out.put(";  Device Serial Number : 0000 \n");
+    out.put(";  Start Time : ");
+    out.put(timestamp.toString("ddd, MMM dd, yyyy :: h:m:s\n").toUtf8());
+    out.put(";\n");
+    out.put(";  Column description :\n");
+    out.put(";  ~~~~~~~~~~~~~~~~~~~~~\n");
+    out.put(";\n");
+    out.put(";   + Message Number\n");
+    out.put(";   |\n");
+    out.put(";   |     	     + Time Stamp (ms)\n");
+    out.put(";   |     	     |\n");
+    out.put(";   |     	     |      	    + Message ID (hex)\n");
+    out.put(";   |     	     |      	    |\n");
+    out.put(";   |     	     |      	    |   	+ Data Length Code\n");
+    out.put(";   |     	     |      	    |   	|\n");
+    out.put(";   |     	     |      	    |   	|	 + Data Bytes (hex)\n");
+    out.put(";   |     	     |      	    |   	|	 |\n");
+    out.put(";---+-----	-----+------	----+---	+	-+ -- -- -- -- -- -- --\n");
+
+    for (int c = 0; c < num; c++)
     {
-        lineCounter++;
-        if ((lineCounter % 100) == 0)
-        {
-            qApp->processEvents();
-            //lineCounter = 0;
-        }
-
+        if (!saveStep(c, num, context)) return false;
+        const CANFrame &frame = frames->at(c);
 
          //1F D3 3F FF 08 FF E0 CB
-        outFile->write(QString::number(lineCounter).rightJustified(10, ' ').toUtf8());
-        outFile->write("\t");
-
-        tempTime = frames->at(c).timestamp;
-        tempTimePiece = tempTime / 1000000ul / 60 / 60;
-        tempTime -= tempTimePiece * 1000000ul * 60 * 60;
-        outFile->write(QString::number(tempTimePiece).rightJustified(2, '0').toUtf8());
-        outFile->write(":");
-
-        tempTimePiece = tempTime / 1000000ul / 60;
-        tempTime -= tempTimePiece * 1000000ul * 60;
-        outFile->write(QString::number(tempTimePiece).rightJustified(2, '0').toUtf8());
-        outFile->write(":");
-
-        tempTimePiece = tempTime / 1000000ul;
-        tempTime -= tempTimePiece * 1000000ul;
-        outFile->write(QString::number(tempTimePiece).rightJustified(2, '0').toUtf8());
-        outFile->write(":");
-
-        tempTimePiece = tempTime / 100;
-        outFile->write(QString::number(tempTimePiece).rightJustified(4, '0').toUtf8());
-        outFile->write("\t");
-
-        outFile->write(QString::number(frames->at(c).ID, 16).toUpper().rightJustified(8, '0').toUtf8() + "\t");
-
-        outFile->write(QString::number(frames->at(c).len).toUtf8() + "\t");
-
-        for (unsigned int temp = 0; temp < frames->at(c).len; temp++)
+        out.putDecimal(c + 1, 10, ' ');
+        out.put('\t');
+
+        //hh:mm:ss:ffff where the last part is in tenths of a millisecond
+        tempTime = frame.timestamp;
+        out.putDecimal(tempTime / 3600000000ull, 2);
+        out.put(':');
+        out.putDecimal((tempTime / 60000000ull) % 60, 2);
+        out.put(':');
+        out.putDecimal((tempTime / 1000000ull) % 60, 2);
+        out.put(':');
+        out.putDecimal((tempTime % 1000000ull) / 100, 4);
+        out.put('\t');
+
+        out.putHex(frame.ID, 8);
+        out.put('\t');
+        out.putDecimal(frame.len);
+        out.put('\t');
+
+        for (unsigned int temp = 0; temp < frame.len; temp++)
         {
-            outFile->write(QString::number(frames->at(c).data[temp], 16).toUpper().rightJustified(2, '0').toUtf8());
-            outFile->putChar(' ');
+            out.putHexByte(frame.data[temp]);
+            out.put(' ');
         }
-
-        outFile->write("\n");
-
+        out.put('\n');
     }
-    outFile->close();
-    delete outFile;
-    return true;
+    return out.flush();
 }
 
-bool FrameFileIO::saveCanDumpFile(QString filename, const QVector<CANFrame> * frames)
+bool FrameFileIO::saveCanDumpFile(QString filename, const CANFrameView *frames, FileIOContext *context)
 {
-    QFile *outFile = new QFile(filename);
-    QDateTime timestamp;
-    int lineCounter = 0;
-    double tempTime;
+    QFile outFile(filename);
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
 
-    timestamp = QDateTime::currentDateTime();
-
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
+    TextWriter out(&outFile);
+    int num = frames->count();
 
-    for (int c = 0; c < frames->count(); c++)
+    for (int c = 0; c < num; c++)
     {
-        lineCounter++;
-        if ((lineCounter % 100) == 0)
-        {
-            qApp->processEvents();
-        }
-
-        outFile->write("(");
-
-	tempTime = frames->at(c).timestamp / 1000000.0;
-        outFile->write(QString::number(tempTime,'f').toUtf8());
-        outFile->write(") vcan0 ");
-
-        outFile->write(QString::number(frames->at(c).ID, 16).rightJustified(3,'0').toUpper().toUtf8());
-
-        outFile->write("#");
-
-        for (unsigned int temp = 0; temp < frames->at(c).len; temp++)
-        {
-            outFile->write(QString::number(frames->at(c).data[temp], 16).rightJustified(2,'0').toUpper().toUtf8());
-        }
+        if (!saveStep(c, num, context)) return false;
+        const CANFrame &frame = frames->at(c);
 
-        outFile->write("\n");
+        out.put('(');
+        out.putFixed(frame.timestamp, 6);
+        out.put(") vcan0 ");
+        out.putHex(frame.ID, 3);
+        out.put('#');
 
+        for (unsigned int temp = 0; temp < frame.len; temp++) out.putHexByte(frame.data[temp]);
+        out.put('\n');
     }
-    outFile->close();
-    delete outFile;
-    return true;
+    return out.flush();
 }
 /* (0.003800) vcan0 164#0000c01aa8000013 */
-bool FrameFileIO::loadCanDumpFile(QString filename, QVector<CANFrame>* frames)
+//(1436509052.249713) vcan0 044#2A366C2BBA
+static LineResult parseCanDumpLine(const TextSpan &line, CANFrame &thisFrame, int)
 {
-    QFile *inFile = new QFile(filename);
-    CANFrame thisFrame;
-    QByteArray line;
-    int lineCounter = 0;
-    int pos = 0;
+    TextSpan tokens[4];
     bool ret;
 
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        delete inFile;
-        return false;
-    }
+    if (line.len < 1) return LINE_SKIP;
 
-    while (!inFile->atEnd()) {
-        lineCounter++;
-        if (lineCounter > 100)
-        {
-            qApp->processEvents();
-            lineCounter = 0;
-        }
+    /* tokenize */
+    if (TextTokenizer(line, ' ').split(tokens, 4) < 3) return LINE_SKIP;
 
-        line = inFile->readLine().toUpper();
-        if (line.length() > 1)
-        {
-            /* tokenize */
-            QList<QByteArray> tokens = line.split(' ');
-            if(tokens.count()<3) continue;
-
-            /* timestamp */
-            QRegExp timeExp("^\\((\\S+)\\)$");
-            ret = timeExp.exactMatch(tokens[0]);
-            if(!ret) continue;
-
-            thisFrame.timestamp = timeExp.cap(1).toDouble(&ret) * 1000000;
-            if(!ret) continue;
-
-            /* ID & value */
-            QRegExp IdValExp("^(\\S+)#(\\S+)\n$");
-            qDebug() << tokens[2];
-            ret = IdValExp.exactMatch(tokens[2]);
-            if(!ret) continue;
-
-            /* ID */
-            qDebug() << IdValExp.cap(1);
-            thisFrame.ID = IdValExp.cap(1).toInt(&ret, 16);
-            if (IdValExp.cap(1).length() > 3) {
-                thisFrame.extended = true;
-            } else {
-                thisFrame.extended = false;
-            }
-            if(!ret) continue;
+    /* timestamp */
+    TextSpan time = tokens[0];
+    if (time.len < 3 || time.at(0) != '(' || time.at(time.len - 1) != ')') return LINE_SKIP;
+    thisFrame.timestamp = time.mid(1, time.len - 2).toFixed(6, &ret);
+    if (!ret) return LINE_SKIP;
 
-            QString val= IdValExp.cap(2);
-            QRegExp valExp("(\\S{2})");
+    /* ID & value */
+    int hashPos = tokens[2].indexOf('#');
+    if (hashPos < 1) return LINE_SKIP;
+    TextSpan idStr = tokens[2].mid(0, hashPos);
+    TextSpan val = tokens[2].mid(hashPos + 1).trimmed();
+    if (val.isEmpty()) return LINE_SKIP;
 
-            /* val byte per byte */
-            pos = 0;
-            thisFrame.len = 0;
-            while ((pos = valExp.indexIn(val, pos)) != -1)
-            {
-                thisFrame.data[thisFrame.len] = valExp.cap(1).toInt(&ret, 16);
-                if(!ret) continue;
+    /* ID */
+    thisFrame.ID = idStr.toHex(&ret);
+    if (!ret) return LINE_SKIP;
+    thisFrame.extended = (idStr.len > 3);
 
-                thisFrame.len++;
-                pos += valExp.matchedLength();
-            }
+    /* val byte per byte */
+    thisFrame.len = 0;
+    for (int pos = 0; pos + 1 < val.len && thisFrame.len < 8; pos += 2)
+    {
+        int hi = TextSpan::hexValue(val.ptr[pos]);
+        int lo = TextSpan::hexValue(val.ptr[pos + 1]);
+        if (hi < 0 || lo < 0) break;
+        thisFrame.data[thisFrame.len++] = (hi << 4) | lo;
+    }
 
-            /*NB: should we make sure len <= 8? */
-            thisFrame.isReceived = true;
-            thisFrame.bus = 0;
-       }
-       frames->append(thisFrame);
+    thisFrame.isReceived = true;
+    thisFrame.bus = 0;
+    return LINE_FRAME;
+}
+
+bool FrameFileIO::loadCanDumpFile(QString filename, QVector<CANFrame> *frames, FileIOContext *context)
+{
+    return loadLineFile(filename, lineFormat(LINEFILE_CANDUMP), frames, context);
+}
+
+LineFormat FrameFileIO::lineFormat(LineFileType type)
+{
+    LineFormat format;
+    switch (type)
+    {
+    case LINEFILE_NATIVE_CSV:
+        format.parse = parseNativeCSVLine;
+        format.headerLines = 1;
+        format.variant = 1;
+        format.readHeader = readNativeCSVHeader;
+        format.untimedStart = Utility::GetTimeMS();
+        format.untimedStep = 5;
+        break;
+    case LINEFILE_CRTD:
+        format.parse = parseCRTDLine;
+        format.headerLines = 1;
+        break;
+    case LINEFILE_GENERIC_CSV:
+        format.parse = parseGenericCSVLine;
+        format.headerLines = 1;
+        format.untimedStart = Utility::GetTimeMS();
+        format.untimedStep = 5000;
+        break;
+    case LINEFILE_LOG:
+        format.parse = parseLogLine;
+        format.headerLines = 1;
+        break;
+    case LINEFILE_CANDUMP:
+        format.parse = parseCanDumpLine;
+        break;
     }
-    inFile->close();
-    delete inFile;
-    return true;
+    return format;
 }
 
 //Chn Identifier Flg   DLC  D0...1...2...3...4...5...6..D7       Time     Dir
 // 0    000000AD         8  FF  FF  00  00  00  00  00  00     154.266550 R
-bool FrameFileIO::loadKvaserFile(QString filename, QVector<CANFrame> *frames, bool useHex)
+bool FrameFileIO::loadKvaserFile(QString filename, QVector<CANFrame> *frames, bool useHex, FileIOContext *context)
 {
     QFile *inFile = new QFile(filename);
     CANFrame thisFrame;
-    QByteArray line;
+    TextSpan line;
     int lineCounter = 0;
-    int base = 10;
     bool foundErrors = false;
 
-    if (useHex) base = 16;
-
-    if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
+    if (!inFile->open(QIODevice::ReadOnly))
     {
         delete inFile;
         return false;
     }
 
+    LineReader reader(inFile);
     //ignore header
-    line = inFile->readLine().simplified().toUpper();
+    reader.nextLine(line);
 
-    if (inFile->atEnd()) foundErrors = true;
+    if (reader.atEnd()) foundErrors = true;
 
-    while (!inFile->atEnd()) {
+    while (reader.nextLine(line)) {
         lineCounter++;
-        if (lineCounter > 100)
+        if (lineCounter > LOADER_EVENT_LINES)
         {
             qApp->processEvents();
             lineCounter = 0;
         }
-        line = inFile->readLine().toUpper();
 
-        qDebug() << line.length();
-
-        if (line.length() > 70) {
+        if (line.len >= 70) {
             //Chn Identifier Flg   DLC  D0...1...2...3...4...5...6..D7       Time     Dir
             // 0    000000AD         8  FF  FF  00  00  00  00  00  00     154.266550 R
-            thisFrame.bus = line.mid(0,3).simplified().toInt();
-            thisFrame.ID = line.mid(4,10).simplified().toInt(NULL, base);
+            thisFrame.bus = line.mid(0,3).toInt();
+            if (useHex) thisFrame.ID = line.mid(4,10).toHex();
+                else thisFrame.ID = line.mid(4,10).toInt();
             if (thisFrame.ID > 0x7FF) thisFrame.extended = true;
                 else thisFrame.extended = false;
-            thisFrame.len = line.mid(21, 3).simplified().toInt();
+            thisFrame.len = line.mid(21, 3).toInt();
+            if (thisFrame.len > 8) thisFrame.len = 8;
             for (int i = 0; i < 8; i++) {
-                thisFrame.data[i] = line.mid(25 + i * 4, 3).simplified().toInt(NULL, base);
+                if (useHex) thisFrame.data[i] = line.mid(25 + i * 4, 3).toHex();
+                    else thisFrame.data[i] = line.mid(25 + i * 4, 3).toInt();
             }
-            thisFrame.timestamp = line.mid(57, 14).simplified().toDouble() * 1000000;
-            if (line.mid(72, 1).toUpper() == "R") thisFrame.isReceived = true;
+            thisFrame.timestamp = line.mid(57, 14).toFixed(6);
+            if (line.upperAt(72) == 'R') thisFrame.isReceived = true;
                 else thisFrame.isReceived = false;
 
-            frames->append(thisFrame);
+            if (keepFrame(thisFrame, context)) frames->append(thisFrame);
         }
         //else foundErrors = true;
     }
@@ -1689,3 +2102,343 @@ bool FrameFileIO::loadKvaserFile(QString filename, QVector<CANFrame> *frames, bo
     delete inFile;
     return !foundErrors;
 }
+
+/*
+ * Format detection. Only the start of the file is read. Every text format scores the lines there: a header only
+ * that format writes is as good as certain, and on top of that each line that looks like one of its frames
+ * counts. Lines that say nothing either way (blank, comments) are left out of the count.
+ */
+struct SniffSample
+{
+    QVector<TextSpan> lines;
+    bool binary;    //has bytes no text log would
+    QByteArray data;
+};
+
+//1 if the line looks like a frame of the format, 0 if it doesn't, -1 if it tells nothing either way
+typedef int (*SniffLineFunc)(const TextSpan &line);
+
+struct FormatSniffer
+{
+    FrameFileIO::FileFormat format;
+    const char *header;     //upper case text in the first lines only this format writes, NULL if there is none
+    SniffLineFunc testLine;
+};
+
+static int sniffNativeCSV(const TextSpan &line)
+{
+    TextSpan tokens[3];
+    if (line.len <= 1) return -1;
+    if (TextTokenizer(line, ',').split(tokens, 3) < 6) return 0;
+    bool timeOk, idOk;
+    tokens[0].toInt(&timeOk);
+    tokens[1].toHex(&idOk);
+    TextSpan ext = tokens[2].trimmed();
+    return timeOk && idOk && (ext.startsWithNoCase("TRUE") || ext.startsWithNoCase("FALSE"));
+}
+
+static int sniffCRTD(const TextSpan &line)
+{
+    TextSpan tokens[3];
+    if (line.trimmed().len <= 2) return -1;
+    if (TextTokenizer(line.trimmed(), ' ', true).split(tokens, 3) < 3) return 0;
+    bool timeOk, idOk;
+    tokens[0].toFixed(6, &timeOk);
+    if (!timeOk) return 0;
+    if (tokens[1].len == 3 && tokens[1].at(0) == 'C') return -1; //comment and event records
+    tokens[2].toHex(&idOk);
+    return idOk && (tokens[1].equals("R11") || tokens[1].equals("R29") || tokens[1].equals("T11") || tokens[1].equals("T29"));
+}
+
+static int sniffGenericCSV(const TextSpan &line)
+{
+    TextSpan tokens[2];
+    TextSpan bytes[9];
+    if (line.len <= 1) return -1;
+    if (TextTokenizer(line, ',').split(tokens, 2) != 2) return 0;
+    bool ok;
+    tokens[0].toHex(&ok);
+    if (!ok || tokens[0].trimmed().len > 8) return 0;
+    int numBytes = TextTokenizer(tokens[1], ' ', true).split(bytes, 9);
+    if (numBytes > 8) return 0;
+    for (int i = 0; i < numBytes; i++)
+    {
+        bytes[i].toHex(&ok);
+        if (!ok || bytes[i].len > 2) return 0;
+    }
+    return 1;
+}
+
+static int sniffBusMaster(const TextSpan &line)
+{
+    TextSpan tokens[6];
+    if (line.len <= 0 || line.startsWith("***")) return -1;
+    if (TextTokenizer(line, ' ').split(tokens, 6) < 6) return 0;
+    TextSpan dir = tokens[1];
+    return tokens[0].indexOf(':') > 0 && (dir.startsWithNoCase("RX") || dir.startsWithNoCase("TX"))
+            && tokens[3].startsWithNoCase("0X");
+}
+
+static int sniffMicrochip(const TextSpan &line)
+{
+    TextSpan tokens[4];
+    if (line.len <= 1 || line.startsWith("//")) return -1;
+    if (TextTokenizer(line, ';').split(tokens, 4) < 4) return 0;
+    bool timeOk, lenOk;
+    tokens[0].toInt(&timeOk);
+    tokens[3].toInt(&lenOk);
+    return timeOk && lenOk && (tokens[1].startsWithNoCase("RX") || tokens[1].startsWithNoCase("TX"));
+}
+
+static int sniffTrace(const TextSpan &rawLine)
+{
+    TextSpan tokens[4];
+    TextSpan line = rawLine.trimmed();
+    if (line.len <= 2 || line.startsWith(";")) return -1;
+    if (TextTokenizer(line, '\t').split(tokens, 4) < 4) return 0;
+    bool idOk, lenOk;
+    tokens[2].toHex(&idOk);
+    tokens[3].toInt(&lenOk);
+    return idOk && lenOk && tokens[1].indexOf(':') > 0;
+}
+
+static int sniffIXXAT(const TextSpan &line)
+{
+    TextSpan tokens[5];
+    if (line.len <= 0) return -1;
+    if (TextTokenizer(line, ',').split(tokens, 5) < 5) return 0;
+    TextSpan type = tokens[2].unquoted();
+    bool idOk;
+    tokens[1].unquoted().toHex(&idOk);
+    return idOk && tokens[0].unquoted().indexOf(':') > 0 && (type.startsWithNoCase("STD") || type.startsWithNoCase("EXT"));
+}
+
+static int sniffVehicleSpy(const TextSpan &line)
+{
+    TextSpan tokens[12];
+    if (line.len <= 0) return -1;
+    if (TextTokenizer(line, ',').split(tokens, 12) <= 20) return 0;
+    bool timeOk, idOk;
+    tokens[1].toFixed(6, &timeOk);
+    tokens[9].toHex(&idOk);
+    return timeOk && idOk;
+}
+
+static int sniffCanDump(const TextSpan &line)
+{
+    CANFrame frame;
+    if (line.trimmed().len == 0) return -1;
+    return parseCanDumpLine(line, frame, 0) == LINE_FRAME;
+}
+
+static int sniffPCAN(const TextSpan &line)
+{
+    if (line.len <= 1 || line.startsWith(";")) return -1;
+    if (line.len < 40) return 0;
+    bool timeOk, idOk;
+    line.mid(10, 8).toFixed(3, &timeOk);
+    line.mid(28, 8).toHex(&idOk);
+    return timeOk && idOk && TextSpan::isDigit(line.at(38));
+}
+
+static int sniffKvaser(const TextSpan &line)
+{
+    if (line.len <= 1 || line.startsWith("Chn")) return -1;
+    if (line.len < 70) return 0;
+    bool busOk, timeOk;
+    line.mid(0, 3).toInt(&busOk);
+    line.mid(57, 14).toFixed(6, &timeOk);
+    return busOk && timeOk;
+}
+
+//in the order ties are settled, the more particular formats first
+static const FormatSniffer formatSniffers[] =
+{
+    {FrameFileIO::FORMAT_NATIVE_CSV,    "TIME STAMP,ID,EXTENDED",   sniffNativeCSV},
+    {FrameFileIO::FORMAT_BUSMASTER,     "***BUSMASTER",             sniffBusMaster},
+    {FrameFileIO::FORMAT_VEHICLESPY,    "ARB ID",                   sniffVehicleSpy},
+    {FrameFileIO::FORMAT_IXXAT,         "IXXAT",                    sniffIXXAT},
+    {FrameFileIO::FORMAT_MICROCHIP,     "MICROCHIP TECHNOLOGY",     sniffMicrochip},
+    {FrameFileIO::FORMAT_TRACE,         "CAN LOGGER TRACE FILE",    sniffTrace},
+    {FrameFileIO::FORMAT_PCAN,          "TIME OFFSET (MS)",         sniffPCAN},
+    {FrameFileIO::FORMAT_KVASER_DEC,    "CHN IDENTIFIER",           sniffKvaser},
+    {FrameFileIO::FORMAT_CANDUMP,       NULL,                       sniffCanDump},
+    {FrameFileIO::FORMAT_CRTD,          NULL,                       sniffCRTD},
+    {FrameFileIO::FORMAT_GENERIC_CSV,   "ID,DATA",                  sniffGenericCSV}
+};
+
+static int sniffScore(const SniffSample &sample, const FormatSniffer &sniffer)
+{
+    int score = 0;
+    if (sniffer.header)
+    {
+        for (int i = 0; i < sample.lines.count() && i < SNIFF_HEADER_LINES; i++)
+        {
+            if (sample.lines[i].containsNoCase(sniffer.header))
+            {
+                score = SNIFF_HEADER_SCORE;
+                break;
+            }
+        }
+    }
+
+    int counted = 0, matched = 0;
+    for (int i = 0; i < sample.lines.count(); i++)
+    {
+        int result = sniffer.testLine(sample.lines[i]);
+        if (result < 0) continue;
+        counted++;
+        matched += result;
+    }
+    if (counted > 0) score += matched * 100 / counted;
+    return score;
+}
+
+//CAN-DO is 12 byte binary records. The first one sets the clock so it doesn't have to make sense as a frame
+static int sniffCANDO(const SniffSample &sample, qint64 fileSize)
+{
+    if (!sample.binary || (fileSize % 12) != 0) return 0;
+    const uchar *data = (const uchar *)sample.data.constData();
+    int records = sample.data.size() / 12;
+    if (records < 2) return 0;
+    int matched = 0;
+    for (int r = 1; r < records; r++)
+    {
+        if ((data[r * 12 + 3] >> 4) <= 8) matched++;
+    }
+    return matched * 100 / (records - 1);
+}
+
+//a Kvaser log holds the same columns either way. Three digit bytes mean decimal, any of A-F means hex
+static bool kvaserUsesHex(const SniffSample &sample)
+{
+    for (int i = 0; i < sample.lines.count(); i++)
+    {
+        const TextSpan &line = sample.lines[i];
+        if (sniffKvaser(line) != 1) continue;
+        for (int col = 4; col < 57; col++)
+        {
+            char c = line.upperAt(col);
+            if (c >= 'A' && c <= 'F') return true;
+        }
+        for (int b = 0; b < 8; b++)
+        {
+            if (line.mid(25 + b * 4, 3).trimmed().len == 3) return false;
+        }
+    }
+    return false;
+}
+
+FrameFileIO::FileFormat FrameFileIO::detectFileFormat(QString filename)
+{
+    if (CANCompressedFile::isCompressedFile(filename)) return FORMAT_COMPRESSED;
+    if (CANBinaryFile::isBinaryFile(filename)) return FORMAT_NATIVE_BINARY;
+
+    QFile inFile(filename);
+    if (!inFile.open(QIODevice::ReadOnly)) return FORMAT_UNKNOWN;
+
+    SniffSample sample;
+    sample.data = inFile.read(SNIFF_BYTES);
+    qint64 fileSize = inFile.size();
+    inFile.close();
+
+    sample.binary = false;
+    for (int i = 0; i < sample.data.size(); i++)
+    {
+        uchar c = (uchar)sample.data[i];
+        if (c < 0x20 && c != '\t' && c != '\r' && c != '\n')
+        {
+            sample.binary = true;
+            break;
+        }
+    }
+    if (sample.binary) return (sniffCANDO(sample, fileSize) >= SNIFF_MIN_SCORE) ? FORMAT_CANDO : FORMAT_UNKNOWN;
+
+    const char *pos = sample.data.constData();
+    const char *end = pos + sample.data.size();
+    if (fileSize > sample.data.size())
+    {
+        //the last line was most likely cut off by the sample
+        while (end > pos && end[-1] != '\n') end--;
+    }
+    while (pos < end) sample.lines.append(takeLine(pos, end));
+
+    FileFormat best = FORMAT_UNKNOWN;
+    int bestScore = SNIFF_MIN_SCORE - 1;
+    for (unsigned int i = 0; i < sizeof(formatSniffers) / sizeof(formatSniffers[0]); i++)
+    {
+        int score = sniffScore(sample, formatSniffers[i]);
+        if (score > bestScore)
+        {
+            bestScore = score;
+            best = formatSniffers[i].format;
+        }
+    }
+
+    if (best == FORMAT_KVASER_DEC && kvaserUsesHex(sample)) best = FORMAT_KVASER_HEX;
+    return best;
+}
+
+QString FrameFileIO::formatName(FileFormat format)
+{
+    switch (format)
+    {
+    case FORMAT_NATIVE_CSV:     return "GVRET CSV";
+    case FORMAT_CRTD:           return "CRTD";
+    case FORMAT_GENERIC_CSV:    return "Generic ID/Data CSV";
+    case FORMAT_BUSMASTER:      return "BusMaster";
+    case FORMAT_MICROCHIP:      return "Microchip";
+    case FORMAT_TRACE:          return "Vector trace";
+    case FORMAT_IXXAT:          return "IXXAT MiniLog";
+    case FORMAT_CANDO:          return "CAN-DO";
+    case FORMAT_VEHICLESPY:     return "Vehicle Spy";
+    case FORMAT_CANDUMP:        return "Candump/Kayak";
+    case FORMAT_PCAN:           return "PCAN Viewer";
+    case FORMAT_KVASER_DEC:     return "Kvaser Decimal";
+    case FORMAT_KVASER_HEX:     return "Kvaser Hex";
+    case FORMAT_NATIVE_BINARY:  return "SavvyCAN Binary";
+    case FORMAT_COMPRESSED:     return "SavvyCAN Compressed";
+    case FORMAT_UNKNOWN:        break;
+    }
+    return "Unknown";
+}
+
+bool FrameFileIO::loadFileOfFormat(QString filename, FileFormat format, QVector<CANFrame> *frames, FileIOContext *context)
+{
+    switch (format)
+    {
+    case FORMAT_NATIVE_CSV:     return loadNativeCSVFile(filename, frames, context);
+    case FORMAT_CRTD:           return loadCRTDFile(filename, frames, context);
+    case FORMAT_GENERIC_CSV:    return loadGenericCSVFile(filename, frames, context);
+    case FORMAT_BUSMASTER:      return loadLogFile(filename, frames, context);
+    case FORMAT_MICROCHIP:      return loadMicrochipFile(filename, frames, context);
+    case FORMAT_TRACE:          return loadTraceFile(filename, frames, context);
+    case FORMAT_IXXAT:          return loadIXXATFile(filename, frames, context);
+    case FORMAT_CANDO:          return loadCANDOFile(filename, frames, context);
+    case FORMAT_VEHICLESPY:     return loadVehicleSpyFile(filename, frames, context);
+    case FORMAT_CANDUMP:        return loadCanDumpFile(filename, frames, context);
+    case FORMAT_PCAN:           return loadPCANFile(filename, frames, context);
+    case FORMAT_KVASER_DEC:     return loadKvaserFile(filename, frames, false, context);
+    case FORMAT_KVASER_HEX:     return loadKvaserFile(filename, frames, true, context);
+    case FORMAT_NATIVE_BINARY:  return loadNativeBinaryFile(filename, frames, context);
+    case FORMAT_COMPRESSED:     return loadCompressedFile(filename, frames, context);
+    case FORMAT_UNKNOWN:        break;
+    }
+    return false;
+}
+
+//the copy lets a window counted from the first frame be pinned down as the file is read
+bool FrameFileIO::loadFileOfFormat(QString filename, FileFormat format, QVector<CANFrame> *frames, const LoadFilter &filter)
+{
+    LoadFilter active = filter;
+    FileIOContext context;
+    context.filter = &active;
+    return loadFileOfFormat(filename, format, frames, &context);
+}
+
+bool FrameFileIO::loadAutoDetect(QString filename, QVector<CANFrame> *frames, FileFormat *detected)
+{
+    FileFormat format = detectFileFormat(filename);
+    if (detected) *detected = format;
+    return loadFileOfFormat(filename, format, frames);
+}
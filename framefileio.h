@@ -11,54 +11,155 @@
 #include <QFile>
 #include <QString>
 #include <QStringList>
+#include <QSet>
 #include <QFileDialog>
+#include <QProgressDialog>
+#include <QAtomicInt>
 #include "can_structs.h"
+#include "canframestore.h"
+#include "framelineformat.h"
+#include "lazyframefile.h"
+#include "continuouslogger.h"
 #include "utility.h"
 
+/*
+ * Which part of a log to load. Frames outside it are dropped as they are parsed so they never take up any
+ * memory. The default keeps everything.
+ */
+struct LoadFilter
+{
+    LoadFilter() : startTime(0), endTime(UINT64_MAX), fromFirstFrame(false) {}
+
+    uint64_t startTime;     //microseconds, both ends are kept
+    uint64_t endTime;
+    bool fromFirstFrame;    //the window counts from the first frame of the file rather than from the timestamps' zero
+    QSet<uint32_t> ids;     //empty keeps every ID
+
+    bool hasTimeWindow() const { return startTime > 0 || endTime < UINT64_MAX; }
+    bool matchesID(uint32_t ID) const { return ids.isEmpty() || ids.contains(ID); }
+    bool matchesTime(uint64_t timestamp) const { return timestamp >= startTime && timestamp <= endTime; }
+    bool matches(const CANFrame &frame) const { return matchesID(frame.ID) && matchesTime(frame.timestamp); }
+
+    //turns a window counted from the first frame into one in the file's own timestamps
+    void anchor(uint64_t firstTimestamp)
+    {
+        if (!fromFirstFrame) return;
+        startTime = (startTime > UINT64_MAX - firstTimestamp) ? UINT64_MAX : startTime + firstTimestamp;
+        endTime = (endTime > UINT64_MAX - firstTimestamp) ? UINT64_MAX : endTime + firstTimestamp;
+        fromFirstFrame = false;
+    }
+};
+
+/*
+ * What one load or save carries along with it, so any number of them can run at once on any threads. Every
+ * loader and saver takes one as an optional last argument. Without it a load keeps the whole file and a save
+ * can't be followed or canceled.
+ */
+struct FileIOContext
+{
+    FileIOContext() : filter(NULL), progressDialog(NULL) {}
+
+    LoadFilter *filter;                 //part of the file a load keeps, NULL for all of it. Anchored as the load goes
+    QProgressDialog *progressDialog;    //dialog a GUI load already has up, parallel parsing reports through it
+    QAtomicInt progress;                //tenths of a percent of a save that are done
+    QAtomicInt canceled;                //set from any thread to make a save give up
+};
+
 class FrameFileIO: public QObject
 {
     Q_OBJECT
 
 public:
+    typedef bool (*SaveFunc)(QString, const CANFrameView *, FileIOContext *);
+    typedef bool (*LoadFunc)(QString, QVector<CANFrame>*, FileIOContext *);
+
+    //the formats that can be viewed in place as well as loaded, see lineFormat()
+    enum LineFileType
+    {
+        LINEFILE_NATIVE_CSV,
+        LINEFILE_CRTD,
+        LINEFILE_GENERIC_CSV,
+        LINEFILE_LOG,
+        LINEFILE_CANDUMP
+    };
+
+    //every format a log can be loaded from, see detectFileFormat()
+    enum FileFormat
+    {
+        FORMAT_UNKNOWN,
+        FORMAT_NATIVE_CSV,
+        FORMAT_CRTD,
+        FORMAT_GENERIC_CSV,
+        FORMAT_BUSMASTER,
+        FORMAT_MICROCHIP,
+        FORMAT_TRACE,
+        FORMAT_IXXAT,
+        FORMAT_CANDO,
+        FORMAT_VEHICLESPY,
+        FORMAT_CANDUMP,
+        FORMAT_PCAN,
+        FORMAT_KVASER_DEC,
+        FORMAT_KVASER_HEX,
+        FORMAT_NATIVE_BINARY,
+        FORMAT_COMPRESSED
+    };
+
     FrameFileIO();
 
     //these present a GUI to the user and allow them to pick the file to load/save
     //The QString returns the filename that was selected and so is really a sort of return value
     //The QVector is used as either the target for loading or the source for saving.
     //These routines call the below loading/saving functions so no need to use them directly if you don't want.
-    static bool loadFrameFile(QString &, QVector<CANFrame>*);
-    static bool saveFrameFile(QString &, const QVector<CANFrame>*);
+    //askWhichPart follows the file dialog with one asking for a time window and the IDs to keep
+    static bool loadFrameFile(QString &, QVector<CANFrame>*, bool askWhichPart = false);
+    static bool saveFrameFile(QString &, const CANFrameView *);
+    //asks for a log in any of the loadable formats and where to write it as a native binary file
+    static bool convertToNativeBinary(QString &);
+    //asks for a line based log and opens it to be browsed without loading it. NULL if canceled or it can't be read
+    static LazyFrameFile *viewFrameFile(QString &);
 
     //These do the actual loading and saving and can be used directly if you'd prefer
-    static bool loadCRTDFile(QString, QVector<CANFrame>*);
-    static bool loadNativeCSVFile(QString, QVector<CANFrame>*);
-    static bool loadGenericCSVFile(QString, QVector<CANFrame>*);
-    static bool loadLogFile(QString, QVector<CANFrame>*);
-    static bool loadMicrochipFile(QString, QVector<CANFrame>*);
-    static bool loadTraceFile(QString, QVector<CANFrame>*);
-    static bool loadIXXATFile(QString, QVector<CANFrame>*);
-    static bool loadCANDOFile(QString, QVector<CANFrame>*);
-    static bool loadVehicleSpyFile(QString, QVector<CANFrame>*);
-    static bool loadCanDumpFile(QString, QVector<CANFrame>*);
-    static bool loadPCANFile(QString, QVector<CANFrame>*);
-    static bool loadKvaserFile(QString, QVector<CANFrame>*, bool);
-    static bool saveCRTDFile(QString, const QVector<CANFrame>*);
-    static bool saveNativeCSVFile(QString, const QVector<CANFrame>*);
-    static bool saveGenericCSVFile(QString, const QVector<CANFrame>*);
-    static bool saveLogFile(QString, const QVector<CANFrame>*);
-    static bool saveMicrochipFile(QString, const QVector<CANFrame>*);
-    static bool saveTraceFile(QString, const QVector<CANFrame>*);
-    static bool saveIXXATFile(QString, const QVector<CANFrame>*);
-    static bool saveCANDOFile(QString, const QVector<CANFrame>*);
-    static bool saveVehicleSpyFile(QString, const QVector<CANFrame>*);
-    static bool saveCanDumpFile(QString filename, const QVector<CANFrame> * frames);
-    static bool openContinuousNative();
-    static bool closeContinuousNative();
-    static bool writeContinuousNative(const QVector<CANFrame>*, int);
-    static bool flushContinuousNative();
-
-private:
-    static QFile continuousFile;
+    static bool loadCRTDFile(QString, QVector<CANFrame>*, FileIOContext *context = NULL);
+    static bool loadNativeCSVFile(QString, QVector<CANFrame>*, FileIOContext *context = NULL);
+    static bool loadGenericCSVFile(QString, QVector<CANFrame>*, FileIOContext *context = NULL);
+    static bool loadLogFile(QString, QVector<CANFrame>*, FileIOContext *context = NULL);
+    static bool loadMicrochipFile(QString, QVector<CANFrame>*, FileIOContext *context = NULL);
+    static bool loadTraceFile(QString, QVector<CANFrame>*, FileIOContext *context = NULL);
+    static bool loadIXXATFile(QString, QVector<CANFrame>*, FileIOContext *context = NULL);
+    static bool loadCANDOFile(QString, QVector<CANFrame>*, FileIOContext *context = NULL);
+    static bool loadVehicleSpyFile(QString, QVector<CANFrame>*, FileIOContext *context = NULL);
+    static bool loadCanDumpFile(QString, QVector<CANFrame>*, FileIOContext *context = NULL);
+    static bool loadPCANFile(QString, QVector<CANFrame>*, FileIOContext *context = NULL);
+    static bool loadKvaserFile(QString, QVector<CANFrame>*, bool, FileIOContext *context = NULL);
+    static bool loadNativeBinaryFile(QString, QVector<CANFrame>*, FileIOContext *context = NULL);
+    static bool loadCompressedFile(QString, QVector<CANFrame>*, FileIOContext *context = NULL);
+    //how the loader for one of the line based formats reads it, for handing to a LazyFrameFile
+    static LineFormat lineFormat(LineFileType type);
+    static bool saveCRTDFile(QString, const CANFrameView *, FileIOContext *context = NULL);
+    static bool saveNativeCSVFile(QString, const CANFrameView *, FileIOContext *context = NULL);
+    static bool saveGenericCSVFile(QString, const CANFrameView *, FileIOContext *context = NULL);
+    static bool saveLogFile(QString, const CANFrameView *, FileIOContext *context = NULL);
+    static bool saveMicrochipFile(QString, const CANFrameView *, FileIOContext *context = NULL);
+    static bool saveTraceFile(QString, const CANFrameView *, FileIOContext *context = NULL);
+    static bool saveIXXATFile(QString, const CANFrameView *, FileIOContext *context = NULL);
+    static bool saveCANDOFile(QString, const CANFrameView *, FileIOContext *context = NULL);
+    static bool saveVehicleSpyFile(QString, const CANFrameView *, FileIOContext *context = NULL);
+    static bool saveCanDumpFile(QString filename, const CANFrameView *frames, FileIOContext *context = NULL);
+    static bool saveNativeBinaryFile(QString, const CANFrameView *, FileIOContext *context = NULL);
+    static bool saveCompressedFile(QString, const CANFrameView *, FileIOContext *context = NULL);
+    static bool convertToNativeBinary(QString inFilename, QString outFilename, LoadFunc loader);
+    //works out the format of a log from the first few KB of it. No GUI involved so command line tools can use it too
+    static FileFormat detectFileFormat(QString filename);
+    static QString formatName(FileFormat format);
+    static bool loadFileOfFormat(QString filename, FileFormat format, QVector<CANFrame>*, FileIOContext *context = NULL);
+    //loads just the frames filter keeps. Where the timestamps are in order the start of the window is searched for
+    static bool loadFileOfFormat(QString filename, FileFormat format, QVector<CANFrame>*, const LoadFilter &filter);
+    //detects the format then loads with the matching loader. detected, if given, is set to the format picked
+    static bool loadAutoDetect(QString filename, QVector<CANFrame>*, FileFormat *detected = NULL);
+    //runs one of the save functions above on another thread with progress and a cancel button, see saveFrameFile
+    static bool saveInBackground(SaveFunc saver, QString filename, const CANFrameView *frames, QProgressDialog *progress);
+    //asks for a file and starts the logger writing to it, with file rotation taken from the settings
+    static bool startContinuousLogging(ContinuousLogger *logger);
 };
 
 #endif // FRAMEFILEIO_H
@@ -0,0 +1,49 @@
+#ifndef FRAMELINEFORMAT_H
+#define FRAMELINEFORMAT_H
+
+#include <string.h>
+#include "can_structs.h"
+#include "utils/textscanner.h"
+
+/*
+ * Formats where every line stands on its own are loaded through loadLineFile() in framefileio.cpp and can be
+ * browsed in place by LazyFrameFile. A format there is mostly a function turning one line into one frame, which
+ * lets big files be parsed in pieces on every core at once. Anything that depends on the lines before it, like
+ * making up timestamps for formats that don't have them, is worked out from counts kept in file order so the
+ * result is the same as reading the file front to back.
+ */
+enum LineResult
+{
+    LINE_SKIP,      //nothing to load on this line (blank, comment, some other kind of record)
+    LINE_FRAME,     //a frame with a timestamp of its own
+    LINE_UNTIMED,   //a frame that gets the next made up timestamp
+    LINE_ERROR      //couldn't make sense of the line. Loading carries on but reports errors at the end
+};
+
+struct LineFormat
+{
+    typedef LineResult (*ParseFunc)(const TextSpan &line, CANFrame &frame, int variant);
+    typedef int (*HeaderFunc)(const TextSpan &firstLine);
+
+    LineFormat(ParseFunc pParse = NULL) : parse(pParse), readHeader(NULL), headerLines(0), variant(0), untimedStart(0), untimedStep(0) {}
+
+    ParseFunc parse;
+    HeaderFunc readHeader;  //picks variant from the first header line if the format has versions
+    int headerLines;        //lines before the first frame
+    int variant;
+    uint64_t untimedStart;  //made up timestamps count up from here
+    uint64_t untimedStep;
+};
+
+//the line starting at pos without its line ending. pos is moved on to the start of the next line
+static inline TextSpan takeLine(const char *&pos, const char *end)
+{
+    const char *nl = (const char *)memchr(pos, '\n', end - pos);
+    const char *lineEnd = nl ? nl : end;
+    TextSpan line(pos, (int)(lineEnd - pos));
+    if (line.len > 0 && line.ptr[line.len - 1] == '\r') line.len--;
+    pos = nl ? nl + 1 : end;
+    return line;
+}
+
+#endif // FRAMELINEFORMAT_H
@@ -121,10 +121,12 @@ void FramePlaybackObject::piStart()
     whichBusSend = 0;
 
     connect(playbackTimer, &QTimer::timeout, this, &FramePlaybackObject::timerTriggered);
+    connect(CANConManager::getInstance(), &CANConManager::framesSent, this, &FramePlaybackObject::retrySending);
 }
 
 void FramePlaybackObject::piStop()
 {
+    disconnect(CANConManager::getInstance(), &CANConManager::framesSent, this, &FramePlaybackObject::retrySending);
     playbackTimer->stop();
     delete playbackTimer;
 }
@@ -226,11 +228,10 @@ void FramePlaybackObject::stepPlaybackForward()
         return;
     }
 
-    sendingBuffer.clear();
     playbackTimer->stop();
     playbackActive = false;
     updatePosition(true);
-    CANConManager::getInstance()->sendFrames(sendingBuffer);
+    flushSendingBuffer();
 }
 
 void FramePlaybackObject::stepPlaybackBackward()
@@ -242,12 +243,11 @@ void FramePlaybackObject::stepPlaybackBackward()
         return;
     }
 
-    sendingBuffer.clear();
     playbackTimer->stop(); //pushing this button halts automatic playback
     playbackActive = false;
 
     updatePosition(false);
-    CANConManager::getInstance()->sendFrames(sendingBuffer);
+    flushSendingBuffer();
 }
 
 void FramePlaybackObject::stopPlayback()
@@ -262,6 +262,7 @@ void FramePlaybackObject::stopPlayback()
     playbackTimer->stop(); //pushing this button halts automatic playback
     playbackActive = false;
     currentPosition = 0;
+    sendingBuffer.clear();
 }
 
 void FramePlaybackObject::pausePlayback()
@@ -317,9 +318,28 @@ void FramePlaybackObject::setPlaybackInterval(int interval)
     playbackTimer->setInterval(interval);
 }
 
+//hands the connections whatever frames they'll take. False while some are still waiting for room in a transmit queue
+bool FramePlaybackObject::flushSendingBuffer()
+{
+    if (sendingBuffer.isEmpty()) return true;
+    return CANConManager::getInstance()->sendPendingFrames(sendingBuffer);
+}
+
+//a connection made room in its transmit queue so don't wait for the next tick to send what was left over
+void FramePlaybackObject::retrySending(int count)
+{
+    Q_UNUSED(count);
+    flushSendingBuffer();
+}
+
 void FramePlaybackObject::timerTriggered()
 {
-    sendingBuffer.clear();
+    //the last tick's frames didn't all fit. Don't move on until they're out, losing them would garble the playback
+    if (!flushSendingBuffer())
+    {
+        if (useOrigTiming) playbackElapsed.start(); //and don't let the log's clock run on meanwhile
+        return;
+    }
 
     if (useOrigTiming)
     {
@@ -388,7 +408,7 @@ void FramePlaybackObject::timerTriggered()
     }
 
     //qDebug() << "sb: " << sendingBuffer.count();
-    if (sendingBuffer.count() > 0) CANConManager::getInstance()->sendFrames(sendingBuffer);
+    flushSendingBuffer();
 }
 
 
@@ -68,9 +68,10 @@ signals:
 
 private slots:
     void timerTriggered();
+    void retrySending(int count);
 
 private:
-     QList<CANFrame> sendingBuffer;
+     QList<CANFrame> sendingBuffer; //frames the connections haven't taken yet. Playback holds position until it is empty
      SequenceItem *currentSeqItem;
      int currentPosition;
      QTimer *playbackTimer;
@@ -88,6 +89,7 @@ private:
 
      quint64 updatePosition(bool forward);
      quint64 peekPosition(bool forward);
+     bool flushSendingBuffer();
      /**
       * @brief starts the device
       */
@@ -14,7 +14,7 @@
  * Also, rows default to enabled which is odd because the button state does not reflect that.
 */
 
-FrameSenderWindow::FrameSenderWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+FrameSenderWindow::FrameSenderWindow(const CANFrameView *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::FrameSenderWindow)
 {
@@ -48,6 +48,7 @@ FrameSenderWindow::FrameSenderWindow(const QVector<CANFrame> *frames, QWidget *p
     connect(ui->btnLoadGrid, SIGNAL(clicked(bool)), this, SLOT(loadGrid()));
     connect(ui->btnSaveGrid, SIGNAL(clicked(bool)), this, SLOT(saveGrid()));
     connect(MainWindow::getReference(), SIGNAL(framesUpdated(int)), this, SLOT(updatedFrames(int)));
+    connect(CANConManager::getInstance(), SIGNAL(framesSent(int)), this, SLOT(retrySending(int)));
 
     intervalTimer->start();
     elapsedTimer.start();
@@ -153,7 +154,7 @@ void FrameSenderWindow::processIncomingFrame(CANFrame *frame)
                             sendingData[sd].count++;
                             doModifiers(sd);
                             updateGridRow(sd);
-                            CANConManager::getInstance()->sendFrame(sendingData[sd]);
+                            sendFrame(sendingData[sd]);
                         }
                         else //delayed sending frame
                         {
@@ -193,6 +194,7 @@ void FrameSenderWindow::clearGrid()
         sendingData.removeAt(i);
         ui->tableSender->removeRow(i);
     }
+    pendingFrames.clear();
 }
 
 void FrameSenderWindow::saveGrid()
@@ -335,6 +337,7 @@ void FrameSenderWindow::handleTick()
     Trigger *trigger;
     int elapsed = elapsedTimer.restart();
     if (elapsed == 0) elapsed = 1;
+    if (!pendingFrames.isEmpty()) CANConManager::getInstance()->sendPendingFrames(pendingFrames);
     //Modifier modifier;
     for (int i = 0; i < sendingData.count(); i++)
     {
@@ -356,13 +359,26 @@ void FrameSenderWindow::handleTick()
                 doModifiers(i);
                 updateGridRow(i);
                 qDebug() << "About to try to send a frame";
-                CANConManager::getInstance()->sendFrame(sendingData[i]);
+                sendFrame(sendingData[i]);
                 if (trigger->ID > 0) trigger->readyCount = false; //reset flag if this is a timed ID trigger
             }
         }
     }
 }
 
+//A full transmit queue doesn't lose a fired frame. It waits in pendingFrames, behind any others still waiting so the order holds,
+//until framesSent says there is room or the next tick comes along.
+void FrameSenderWindow::sendFrame(const CANFrame &frame)
+{
+    pendingFrames.append(frame);
+    CANConManager::getInstance()->sendPendingFrames(pendingFrames);
+}
+
+void FrameSenderWindow::retrySending(int)
+{
+    if (!pendingFrames.isEmpty()) CANConManager::getInstance()->sendPendingFrames(pendingFrames);
+}
+
 /// <summary>
 /// given an index into the sendingData list we run the modifiers that it has set up
 /// </summary>
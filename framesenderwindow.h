@@ -6,6 +6,7 @@
 #include <QElapsedTimer>
 #include <QTime>
 #include "can_structs.h"
+#include "canframestore.h"
 #include "can_trigger_structs.h"
 
 namespace Ui {
@@ -17,7 +18,7 @@ class FrameSenderWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit FrameSenderWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit FrameSenderWindow(const CANFrameView *frames, QWidget *parent = 0);
     ~FrameSenderWindow();
 
 private slots:
@@ -29,12 +30,14 @@ private slots:
     void saveGrid();
     void loadGrid();
     void updatedFrames(int);
+    void retrySending(int);
 
 private:
     Ui::FrameSenderWindow *ui;
     QList<FrameSendData> sendingData;
+    QList<CANFrame> pendingFrames; //fired frames the connections had no room for yet, sent in order before any others
     QHash<int, CANFrame> frameCache; //hash with frame ID as the key and the most recent frame as the value
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameView *modelFrames;
     QTimer *intervalTimer;
     QElapsedTimer elapsedTimer;
     bool inhibitChanged = false;
@@ -53,6 +56,7 @@ private:
     void processCellChange(int line, int col);
     void buildFrameCache();
     void processIncomingFrame(CANFrame *frame);
+    void sendFrame(const CANFrame &frame);
 };
 
 #endif // FRAMESENDERWINDOW_H
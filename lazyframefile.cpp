@@ -0,0 +1,277 @@
+#include "lazyframefile.h"
+
+#include <QSet>
+#include <QMutexLocker>
+#include <QtConcurrent>
+#include <algorithm>
+#include <climits>
+
+LazyFrameFile::LazyFrameFile()
+{
+    map = NULL;
+    size = 0;
+    numFrames = 0;
+    foundErrors = false;
+    chunksTotal = 0;
+    useCounter = 0;
+    lastSlot = 0;
+}
+
+LazyFrameFile::~LazyFrameFile()
+{
+    close();
+}
+
+/*
+ * Parses one piece of the file, recording the start of every LAZY_PAGE_FRAMES-th frame in it. Pages never span
+ * two pieces so the last page of each piece is usually short, which costs nothing but a few extra table entries.
+ * Frame numbers and untimed counts are relative to the piece until open() adds up the pieces before it.
+ */
+void LazyFrameFile::scanChunk(ScanChunk &chunk)
+{
+    LazyFrameFile *owner = chunk.owner;
+    QSet<uint32_t> seen;
+    uint32_t lastID = 0xFFFFFFFF;
+    const char *pos = chunk.start;
+
+    while (pos < chunk.end)
+    {
+        if (owner->canceled.load()) break;
+
+        const char *lineStart = pos;
+        CANFrame frame;
+        LineResult result = owner->format.parse(takeLine(pos, chunk.end), frame, owner->format.variant);
+        if (result == LINE_ERROR) chunk.foundErrors = true;
+        if (result != LINE_FRAME && result != LINE_UNTIMED) continue;
+
+        if ((chunk.numFrames % LAZY_PAGE_FRAMES) == 0)
+        {
+            Page page = {lineStart - owner->map, chunk.numFrames, 0, chunk.numUntimed};
+            chunk.pages.append(page);
+        }
+        chunk.pages.last().numFrames++;
+        chunk.numFrames++;
+        if (result == LINE_UNTIMED) chunk.numUntimed++;
+
+        if (frame.ID != lastID)
+        {
+            seen.insert(frame.ID);
+            lastID = frame.ID;
+        }
+    }
+
+    chunk.ids.reserve(seen.count());
+    for (QSet<uint32_t>::const_iterator it = seen.constBegin(); it != seen.constEnd(); ++it) chunk.ids.append(*it);
+    owner->chunksDone.fetchAndAddRelaxed(1);
+}
+
+bool LazyFrameFile::open(QString filename, const LineFormat &lineFormat)
+{
+    close();
+    canceled.store(0);
+    chunksDone.store(0);
+    chunksTotal = 0;
+
+    file.setFileName(filename);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    size = file.size();
+    map = (size > 0) ? (const char *)file.map(0, size) : NULL;
+    if (!map)
+    {
+        //nothing to browse, or too big for a 32 bit address space
+        file.close();
+        return false;
+    }
+
+    format = lineFormat;
+    const char *end = map + size;
+    const char *pos = map;
+    for (int i = 0; i < format.headerLines && pos < end; i++)
+    {
+        TextSpan line = takeLine(pos, end);
+        if (i == 0 && format.readHeader) format.variant = format.readHeader(line);
+    }
+
+    QVector<ScanChunk> chunks;
+    while (pos < end)
+    {
+        const char *chunkEnd = end;
+        if (end - pos > LAZY_SCAN_CHUNK)
+        {
+            chunkEnd = (const char *)memchr(pos + LAZY_SCAN_CHUNK, '\n', end - pos - LAZY_SCAN_CHUNK);
+            chunkEnd = chunkEnd ? chunkEnd + 1 : end;
+        }
+        ScanChunk chunk = {this, pos, chunkEnd, QVector<Page>(), QVector<uint32_t>(), 0, 0, false};
+        chunks.append(chunk);
+        pos = chunkEnd;
+    }
+    chunksTotal = chunks.count();
+
+    QtConcurrent::blockingMap(chunks, scanChunk);
+    if (canceled.load())
+    {
+        close();
+        return false;
+    }
+
+    //stitch the pieces together in file order
+    QSet<uint32_t> allIDs;
+    int untimed = 0;
+    for (int i = 0; i < chunks.count(); i++)
+    {
+        const ScanChunk &chunk = chunks[i];
+        if ((qint64)numFrames + chunk.numFrames > INT_MAX)
+        {
+            //rows are ints everywhere else, so this is as far as a file can be browsed
+            foundErrors = true;
+            break;
+        }
+        for (int p = 0; p < chunk.pages.count(); p++)
+        {
+            Page page = chunk.pages[p];
+            page.firstFrame += numFrames;
+            page.untimedBefore += untimed;
+            pages.append(page);
+        }
+        numFrames += chunk.numFrames;
+        untimed += chunk.numUntimed;
+        if (chunk.foundErrors) foundErrors = true;
+        for (int j = 0; j < chunk.ids.count(); j++) allIDs.insert(chunk.ids[j]);
+    }
+
+    ids.reserve(allIDs.count());
+    for (QSet<uint32_t>::const_iterator it = allIDs.constBegin(); it != allIDs.constEnd(); ++it) ids.append(*it);
+    std::sort(ids.begin(), ids.end());
+
+    cache.resize(LAZY_CACHE_PAGES);
+    for (int i = 0; i < cache.count(); i++)
+    {
+        cache[i].page = -1;
+        cache[i].lastUse = 0;
+    }
+    return true;
+}
+
+void LazyFrameFile::close()
+{
+    QMutexLocker locker(&cacheMutex);
+    if (map) file.unmap((uchar *)map);
+    if (file.isOpen()) file.close();
+    map = NULL;
+    size = 0;
+    pages.clear();
+    ids.clear();
+    cache.clear();
+    numFrames = 0;
+    foundErrors = false;
+    useCounter = 0;
+    lastSlot = 0;
+}
+
+int LazyFrameFile::openProgress() const
+{
+    if (chunksTotal == 0) return 0;
+    return (int)((qint64)chunksDone.load() * 1000 / chunksTotal);
+}
+
+int LazyFrameFile::findPage(int idx) const
+{
+    //last page starting at or before idx
+    int low = 0;
+    int high = pages.count() - 1;
+    while (low < high)
+    {
+        int mid = (low + high + 1) / 2;
+        if (pages[mid].firstFrame <= idx) low = mid;
+        else high = mid - 1;
+    }
+    return low;
+}
+
+/*
+ * Parses the frames of one page into out. Made up timestamps carry on from the count of them before the page,
+ * which gives every frame the same timestamp a full load would have.
+ */
+void LazyFrameFile::decodePage(int page, CANFrame *out) const
+{
+    const Page &thisPage = pages[page];
+    const char *pos = map + thisPage.offset;
+    const char *end = map + size;
+    uint64_t untimed = thisPage.untimedBefore;
+    int num = 0;
+
+    while (num < thisPage.numFrames && pos < end)
+    {
+        CANFrame frame;
+        LineResult result = format.parse(takeLine(pos, end), frame, format.variant);
+        if (result == LINE_UNTIMED)
+        {
+            untimed++;
+            frame.timestamp = format.untimedStart + untimed * format.untimedStep;
+        }
+        else if (result != LINE_FRAME) continue;
+        out[num++] = frame;
+    }
+
+    //only if the file changed since it was scanned. Blank frames keep the row count what everyone was told
+    while (num < thisPage.numFrames) out[num++] = CANFrame();
+}
+
+const CANFrame &LazyFrameFile::at(int idx) const
+{
+    QMutexLocker locker(&cacheMutex);
+    useCounter++;
+
+    //nearly always the same page as last time
+    CachedPage *slot = &cache[lastSlot];
+    if (slot->page < 0 || idx < pages[slot->page].firstFrame || idx >= pages[slot->page].firstFrame + pages[slot->page].numFrames)
+    {
+        int page = findPage(idx);
+        int oldest = 0;
+        int found = -1;
+        for (int i = 0; i < cache.count(); i++)
+        {
+            if (cache[i].page == page)
+            {
+                found = i;
+                break;
+            }
+            if (cache[i].lastUse < cache[oldest].lastUse) oldest = i;
+        }
+        if (found < 0)
+        {
+            found = oldest;
+            cache[found].page = page;
+            cache[found].frames.resize(pages[page].numFrames);
+            decodePage(page, cache[found].frames.data());
+        }
+        lastSlot = found;
+        slot = &cache[found];
+    }
+    slot->lastUse = useCounter;
+    return slot->frames.at(idx - pages[slot->page].firstFrame);
+}
+
+void LazyFrameFile::readFrames(int first, int num, CANFrame *out) const
+{
+    if (num <= 0) return;
+    QVector<CANFrame> partial;
+
+    for (int page = findPage(first); num > 0 && page < pages.count(); page++)
+    {
+        const Page &thisPage = pages[page];
+        int skip = first - thisPage.firstFrame;
+        int take = qMin(num, thisPage.numFrames - skip);
+        if (skip == 0 && take == thisPage.numFrames) decodePage(page, out);
+        else
+        {
+            partial.resize(thisPage.numFrames);
+            decodePage(page, partial.data());
+            std::copy(partial.constData() + skip, partial.constData() + skip + take, out);
+        }
+        out += take;
+        first += take;
+        num -= take;
+    }
+}
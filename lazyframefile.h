@@ -0,0 +1,108 @@
+#ifndef LAZYFRAMEFILE_H
+#define LAZYFRAMEFILE_H
+
+#include <QFile>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QString>
+#include <QVector>
+#include "can_structs.h"
+#include "framelineformat.h"
+
+//frames in each page of the index. Pages are parsed and cached whole
+#define LAZY_PAGE_FRAMES    4096
+//parsed pages kept around, a bit over 10MB of frames
+#define LAZY_CACHE_PAGES    64
+//bytes of text each thread of the opening scan works through at a time
+#define LAZY_SCAN_CHUNK     (4 * 1024 * 1024)
+
+/*
+ * A line based log browsed where it sits instead of being loaded, for captures too big to hold in memory.
+ * Opening maps the file and parses it once on every core, keeping only where each page of LAZY_PAGE_FRAMES
+ * frames starts and the IDs seen. After that a frame is found by jumping to its page and parsing just that
+ * page. The last LAZY_CACHE_PAGES pages parsed are kept, so paging around a table or going through the file
+ * front to back parses each page once. Memory use is the page table, around 6 bytes per 1000 frames, plus
+ * the cache, whatever the size of the file.
+ */
+class LazyFrameFile
+{
+public:
+    LazyFrameFile();
+    ~LazyFrameFile();
+
+    //maps the file and builds the page table. Blocks until done, cancelOpen() from another thread cuts it short
+    bool open(QString filename, const LineFormat &lineFormat);
+    void close();
+    bool isOpen() const { return map != NULL; }
+    void cancelOpen() { canceled.store(1); }
+    //tenths of a percent of the opening scan that are done
+    int openProgress() const;
+
+    QString fileName() const { return file.fileName(); }
+    int count() const { return numFrames; }
+    //every ID in the file, sorted
+    const QVector<uint32_t> &getIDs() const { return ids; }
+    //true if the file had lines that couldn't be parsed. They are left out like a load would
+    bool hadErrors() const { return foundErrors; }
+
+    /*
+     * Frame at the given index through the page cache. Safe from several threads, but the reference is only good
+     * until LAZY_CACHE_PAGES other pages have been parsed so copy anything that has to be kept.
+     */
+    const CANFrame &at(int idx) const;
+    //num frames starting at first parsed straight into out, skipping the cache. For long scans from several threads
+    void readFrames(int first, int num, CANFrame *out) const;
+
+private:
+    Q_DISABLE_COPY(LazyFrameFile)
+
+    struct Page
+    {
+        qint64 offset;      //of the line holding the first frame of the page
+        int firstFrame;
+        int numFrames;
+        int untimedBefore;  //frames before this page that got made up timestamps
+    };
+
+    struct CachedPage
+    {
+        int page;
+        quint64 lastUse;
+        QVector<CANFrame> frames;
+    };
+
+    struct ScanChunk
+    {
+        LazyFrameFile *owner;
+        const char *start;
+        const char *end;
+        QVector<Page> pages;
+        QVector<uint32_t> ids;
+        int numFrames;
+        int numUntimed;
+        bool foundErrors;
+    };
+
+    static void scanChunk(ScanChunk &chunk);
+    int findPage(int idx) const;
+    void decodePage(int page, CANFrame *out) const;
+
+    QFile file;
+    const char *map;
+    qint64 size;
+    LineFormat format;
+    QVector<Page> pages;
+    QVector<uint32_t> ids;
+    int numFrames;
+    bool foundErrors;
+    QAtomicInt canceled;
+    QAtomicInt chunksDone;
+    int chunksTotal;
+
+    mutable QMutex cacheMutex;
+    mutable QVector<CachedPage> cache;
+    mutable quint64 useCounter;
+    mutable int lastSlot;
+};
+
+#endif // LAZYFRAMEFILE_H
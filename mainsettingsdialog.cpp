@@ -55,6 +55,8 @@ MainSettingsDialog::MainSettingsDialog(QWidget *parent) :
     ui->comboSendingBus->setCurrentIndex(settings->value("Playback/SendingBus", 4).toInt());
     ui->cbUseFiltered->setChecked(settings->value("Main/UseFiltered", false).toBool());
     ui->cbUseOpenGL->setChecked(settings->value("Main/UseOpenGL", false).toBool());
+    ui->spinLogRotateMB->setValue(settings->value("ContinuousLog/RotateMB", 0).toInt());
+    ui->spinLogRotateMinutes->setValue(settings->value("ContinuousLog/RotateMinutes", 0).toInt());
 
     //just for simplicity they all call the same function and that function updates all settings at once
     connect(ui->cbDisplayHex, SIGNAL(toggled(bool)), this, SLOT(updateSettings()));
@@ -73,6 +75,8 @@ MainSettingsDialog::MainSettingsDialog(QWidget *parent) :
     connect(ui->cbUseFiltered, SIGNAL(toggled(bool)), this, SLOT(updateSettings()));
     connect(ui->lineClockFormat, SIGNAL(editingFinished()), this, SLOT(updateSettings()));
     connect(ui->cbUseOpenGL, SIGNAL(toggled(bool)), this, SLOT(updateSettings()));
+    connect(ui->spinLogRotateMB, SIGNAL(valueChanged(int)), this, SLOT(updateSettings()));
+    connect(ui->spinLogRotateMinutes, SIGNAL(valueChanged(int)), this, SLOT(updateSettings()));
 }
 
 MainSettingsDialog::~MainSettingsDialog()
@@ -104,6 +108,8 @@ void MainSettingsDialog::updateSettings()
     settings->setValue("Main/UseFiltered", ui->cbUseFiltered->isChecked());
     settings->setValue("Main/UseOpenGL", ui->cbUseOpenGL->isChecked());
     settings->setValue("Main/TimeFormat", ui->lineClockFormat->text());
+    settings->setValue("ContinuousLog/RotateMB", ui->spinLogRotateMB->value());
+    settings->setValue("ContinuousLog/RotateMinutes", ui->spinLogRotateMinutes->value());
 
     settings->sync();
     emit updatedSettings();
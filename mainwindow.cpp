@@ -3,10 +3,12 @@
 #include "can_structs.h"
 #include <QDateTime>
 #include <QFileDialog>
+#include <QMessageBox>
 #include <QtSerialPort/QSerialPortInfo>
 #include "connections/canconmanager.h"
 #include "connections/connectionwindow.h"
 #include "utility.h"
+#include "signalexport.h"
 
 /*
 Some notes on things I'd like to put into the program but haven't put on github (yet)
@@ -86,11 +88,13 @@ MainWindow::MainWindow(QWidget *parent) :
     inhibitFilterUpdate = false;
     rxFrames = 0;
     framesPerSec = 0;
-    continuousLogging = false;
-    continuousLogFlushCounter = 0;
+    continuousLogActive = false;
+    continuousLogBlinkCounter = 0;
 
     connect(ui->actionSetup, SIGNAL(triggered(bool)), SLOT(showConnectionSettingsWindow()));
     connect(ui->actionOpen_Log_File, &QAction::triggered, this, &MainWindow::handleLoadFile);
+    connect(ui->actionLoad_Part_Of_Log_File, &QAction::triggered, this, &MainWindow::handleLoadPartOfFile);
+    connect(ui->actionView_Log_File, &QAction::triggered, this, &MainWindow::handleViewFile);
     connect(ui->actionGraph_Dta, &QAction::triggered, this, &MainWindow::showGraphingWindow);
     connect(ui->actionFrame_Data_Analysis, &QAction::triggered, this, &MainWindow::showFrameDataAnalysis);
     connect(ui->btnClearFrames, &QAbstractButton::clicked, this, &MainWindow::clearFrames);
@@ -129,8 +133,12 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->actionCapture_Bisector, &QAction::triggered, this, &MainWindow::showBisectWindow);
     connect(ui->actionSignal_Viewer, &QAction::triggered, this, &MainWindow::showSignalViewer);
     connect(ui->actionSave_Continuous_Logfile, &QAction::triggered, this, &MainWindow::handleContinousLogging);
+    connect(ui->actionConvert_Log_File, &QAction::triggered, this, &MainWindow::handleConvertFile);
 
     connect(CANConManager::getInstance(), &CANConManager::framesReceived, model, &CANFrameModel::addFrames);
+    //direct so the GUI thread is the one and only producer for the logger's queue
+    connect(CANConManager::getInstance(), &CANConManager::framesReceived, &continuousLogger, &ContinuousLogger::framesReceived, Qt::DirectConnection);
+    connect(&continuousLogger, &ContinuousLogger::loggingFailed, this, &MainWindow::handleContinuousLogFailed, Qt::QueuedConnection);
 
     lbStatusConnected.setText(tr("Connected to 0 buses"));
     updateFileStatus();
@@ -323,7 +331,7 @@ void MainWindow::gridClicked(QModelIndex idx)
 void MainWindow::gridDoubleClicked(QModelIndex idx)
 {
     //grab ID and timestamp and send them away
-    CANFrame frame = model->getListReference()->at(idx.row());
+    CANFrame frame = model->getFilteredListReference()->at(idx.row());
     emit sendCenterTimeID(frame.ID, frame.timestamp / 1000000.0);
 }
 
@@ -419,13 +427,11 @@ void MainWindow::tickGUIUpdate()
 
         if (model->needsFilterRefresh()) updateFilterList();
 
-        if (continuousLogging)
+        if (continuousLogger.isLogging())
         {
-            const QVector<CANFrame> *modelFrames = model->getListReference();
-            FrameFileIO::writeContinuousNative(modelFrames, modelFrames->count() - rxFrames);
-
-            continuousLogFlushCounter++;
-            if ((continuousLogFlushCounter % 3) == 0)
+            //the logger thread does all the writing, all that is left here is to blink the label
+            continuousLogBlinkCounter++;
+            if ((continuousLogBlinkCounter % 3) == 0)
             {
                 if (ui->lblContMsg->text().length() > 2)
                 {
@@ -436,11 +442,6 @@ void MainWindow::tickGUIUpdate()
                     ui->lblContMsg->setText("CONTINUOUS LOGGING");
                 }
             }
-            if (continuousLogFlushCounter > 8)
-            {
-                continuousLogFlushCounter = 0;
-                FrameFileIO::flushContinuousNative();
-            }
         }
 
         rxFrames = 0;
@@ -493,11 +494,22 @@ void MainWindow::normalizeTiming()
 }
 
 void MainWindow::handleLoadFile()
+{
+    loadFile(false);
+}
+
+//only a time window and the chosen IDs are loaded, for pulling the interesting bit out of a huge capture
+void MainWindow::handleLoadPartOfFile()
+{
+    loadFile(true);
+}
+
+void MainWindow::loadFile(bool askWhichPart)
 {
     QString filename;
     QVector<CANFrame> tempFrames;
 
-    if (FrameFileIO::loadFrameFile(filename, &tempFrames))
+    if (FrameFileIO::loadFrameFile(filename, &tempFrames, askWhichPart))
     {
         ui->canFramesView->scrollToTop();
         model->clearFrames();
@@ -512,11 +524,34 @@ void MainWindow::handleLoadFile()
     }
 }
 
+//the model reads the file a page at a time as it is shown, so nothing is loaded and capturing is ignored until it's cleared
+void MainWindow::handleViewFile()
+{
+    QString filename;
+    LazyFrameFile *file = FrameFileIO::viewFrameFile(filename);
+
+    if (file)
+    {
+        ui->canFramesView->scrollToTop();
+        model->viewFile(file);
+        loadedFileName = filename;
+        ui->lbNumFrames->setText(QString::number(model->rowCount()));
+
+        updateFileStatus();
+        emit framesUpdated(-1);
+    }
+}
+
 void MainWindow::handleSaveFile()
 {
     QString filename;
 
-    if (FrameFileIO::saveFrameFile(filename, model->getListReference()))
+    //the save runs on another thread, frames arriving meanwhile wait in the model until it is done
+    model->holdNewFrames(true);
+    bool saved = FrameFileIO::saveFrameFile(filename, model->getListReference());
+    model->holdNewFrames(false);
+
+    if (saved)
     {
         loadedFileName = filename;
         updateFileStatus();
@@ -525,18 +560,55 @@ void MainWindow::handleSaveFile()
 
 void MainWindow::handleContinousLogging()
 {
-    continuousLogging = !continuousLogging;
+    if (!continuousLogActive)
+    {
+        if (FrameFileIO::startContinuousLogging(&continuousLogger))
+        {
+            continuousLogActive = true;
+            ui->actionSave_Continuous_Logfile->setText(tr("Cease Continuous Logging"));
+        }
+    }
+    else stopContinuousLogging();
+}
+
+//the logger thread gave up on a file. A failure left over from a log that was already stopped is ignored
+void MainWindow::handleContinuousLogFailed()
+{
+    if (!continuousLogActive || !continuousLogger.hasFailed()) return;
+    stopContinuousLogging();
+}
 
-    if (continuousLogging)
+void MainWindow::stopContinuousLogging()
+{
+    continuousLogger.stopLogging();
+    continuousLogActive = false;
+    ui->actionSave_Continuous_Logfile->setText(tr("Start Continuous Logging"));
+    ui->lblContMsg->setText("");
+
+    //frames that came in after a failure were never queued, so anything dropped was dropped before it
+    QString message;
+    if (continuousLogger.hasFailed())
     {
-        ui->actionSave_Continuous_Logfile->setText(tr("Cease Continuous Logging"));
-        FrameFileIO::openContinuousNative();
+        message = tr("Continuous logging stopped. %1").arg(continuousLogger.getFailure());
     }
-    else
+    if (continuousLogger.getFramesDropped() > 0)
     {
-        ui->actionSave_Continuous_Logfile->setText(tr("Start Continuous Logging"));
-        ui->lblContMsg->setText("");
-        FrameFileIO::closeContinuousNative();
+        if (!message.isEmpty()) message += "\n";
+        message += tr("%1 frames could not be written fast enough and were dropped from the log.").arg(continuousLogger.getFramesDropped());
+    }
+    if (!message.isEmpty()) QMessageBox::warning(this, tr("Continuous Logging"), message);
+}
+
+void MainWindow::handleConvertFile()
+{
+    QString filename;
+
+    //doesn't touch the frames in the main view, the converted file is only written out
+    if (FrameFileIO::convertToNativeBinary(filename))
+    {
+        QMessageBox msg;
+        msg.setText(tr("Converted log saved as ") + filename);
+        msg.exec();
     }
 }
 
@@ -544,7 +616,12 @@ void MainWindow::handleSaveFilteredFile()
 {
     QString filename;
 
-    if (FrameFileIO::saveFrameFile(filename, model->getFilteredListReference()))
+    //the save runs on another thread, frames arriving meanwhile wait in the model until it is done
+    model->holdNewFrames(true);
+    bool saved = FrameFileIO::saveFrameFile(filename, model->getFilteredListReference());
+    model->holdNewFrames(false);
+
+    if (saved)
     {
         loadedFileName = filename;
         updateFileStatus();
@@ -601,6 +678,8 @@ void MainWindow::handleSaveDecoded()
 
     QStringList filters;
     filters.append(QString(tr("Text File (*.txt)")));
+    filters.append(QString(tr("Signal Columns CSV (*.csv)")));
+    filters.append(QString(tr("Signal Columns Binary (*.scol)")));
 
     dialog.setFileMode(QFileDialog::AnyFile);
     dialog.setNameFilters(filters);
@@ -610,15 +689,28 @@ void MainWindow::handleSaveDecoded()
     if (dialog.exec() == QDialog::Accepted)
     {
         filename = dialog.selectedFiles()[0];
-        if (!filename.contains('.')) filename += ".txt";
-        saveDecodedTextFile(filename);
+        if (dialog.selectedNameFilter() == filters[0])
+        {
+            if (!filename.contains('.')) filename += ".txt";
+            saveDecodedTextFile(filename);
+            return;
+        }
+
+        SignalExport::Format format = SignalExport::WIDE_CSV;
+        if (dialog.selectedNameFilter() == filters[2]) format = SignalExport::BINARY_COLUMNS;
+        if (!filename.contains('.')) filename += (format == SignalExport::WIDE_CSV) ? ".csv" : ".scol";
+
+        //the export runs on other threads, frames arriving meanwhile wait in the model until it is done
+        model->holdNewFrames(true);
+        SignalExport::exportWithDialog(filename, format, model->getFilteredListReference(), dbcHandler);
+        model->holdNewFrames(false);
     }
 }
 
 void MainWindow::saveDecodedTextFile(QString filename)
 {
     QFile *outFile = new QFile(filename);
-    const QVector<CANFrame> *frames = model->getFilteredListReference();
+    const CANFrameView *frames = model->getFilteredListReference();
 
     if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
         return;
@@ -627,6 +719,10 @@ Time: 205.173000   ID: 0x20E Std Bus: 0 Len: 8
 Data Bytes: 88 10 00 13 BB 00 06 00
     SignalName	Value
 */
+    //reused from frame to frame so the decoded signals don't need new arrays every time
+    QVector<QString> sigStrings;
+    QVector<bool> sigValid;
+
     for (int c = 0; c < frames->count(); c++)
     {
         CANFrame thisFrame = frames->at(c);
@@ -653,13 +749,15 @@ Data Bytes: 88 10 00 13 BB 00 06 00
             DBC_MESSAGE *msg = dbcHandler->findMessage(thisFrame);
             if (msg != NULL)
             {
-                for (int j = 0; j < msg->sigHandler->getCount(); j++)
+                const DBCMessageDecoder &decoder = msg->getDecoder();
+                sigStrings.resize(decoder.getCount());
+                sigValid.resize(decoder.getCount());
+                decoder.decodeText(thisFrame, sigStrings.data(), sigValid.data());
+                for (int j = 0; j < decoder.getCount(); j++)
                 {
-
-                    QString temp;
-                    if (msg->sigHandler->findSignalByIdx(j)->processAsText(thisFrame, temp))
+                    if (sigValid[j])
                     {
-                        builderString.append("\t" + temp);
+                        builderString.append("\t" + sigStrings[j]);
                         builderString.append("\n");
                     }
                 }
@@ -698,7 +796,8 @@ void MainWindow::updateFileStatus()
     {
         if (loadedFileName.length() > 2)
         {
-            output = loadedFileName + " loaded";
+            if (model->isViewingFile()) output = loadedFileName + " viewed";
+            else output = loadedFileName + " loaded";
         }
         else
         {
@@ -915,6 +1014,8 @@ void MainWindow::showDBCFileWindow()
     if (!dbcFileWindow)
     {
         dbcFileWindow = new DBCLoadSaveWindow(model->getListReference());
+        //interpreted text in the grid is cached so have it redone once the DBC files may have changed
+        connect(dbcFileWindow, &QDialog::finished, model, &CANFrameModel::clearCellCache);
     }
     dbcFileWindow->show();
 }
@@ -54,11 +54,15 @@ public:
 
 private slots:
     void handleLoadFile();
+    void handleLoadPartOfFile();
+    void handleViewFile();
     void handleSaveFile();
     void handleSaveFilteredFile();
+    void handleConvertFile();
     void handleSaveFilters();
     void handleLoadFilters();
     void handleContinousLogging();
+    void handleContinuousLogFailed();
     void showGraphingWindow();
     void showFrameDataAnalysis();
     void clearFrames();
@@ -134,8 +138,9 @@ private:
     bool bDirty; //have frames been added or subtracted since the last save/load?
     bool useFiltered; //should sub-windows use the unfiltered or filtered frames list?
 
-    bool continuousLogging;
-    int continuousLogFlushCounter;
+    ContinuousLogger continuousLogger;
+    bool continuousLogActive; //the logger stops itself on a failure, this is whether the menu says Cease
+    int continuousLogBlinkCounter;
 
     //References to other windows we can display
     GraphingWindow *graphingWindow;
@@ -169,6 +174,8 @@ private:
 
     //private methods
     void saveDecodedTextFile(QString);
+    void loadFile(bool askWhichPart);
+    void stopContinuousLogging();
     void addFrameToDisplay(CANFrame &, bool);
     void updateFileStatus();
     void closeEvent(QCloseEvent *event);
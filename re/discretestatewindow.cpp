@@ -2,7 +2,7 @@
 #include "ui_discretestatewindow.h"
 #include "mainwindow.h"
 
-DiscreteStateWindow::DiscreteStateWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+DiscreteStateWindow::DiscreteStateWindow(const CANFrameView *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::DiscreteStateWindow)
 {
@@ -59,7 +59,7 @@ void FileComparatorWindow::loadInterestedFile()
 {
     interestedFrames.clear();
     QString resultingFileName;
-    if (FrameFileIO::loadFrameFile(resultingFileName, &interestedFrames))
+    if (FrameFileIO::loadFrameFile(resultingFileName, &interestedFrames, ui->ckLoadPart->isChecked()))
     {
         ui->lblFirstFile->setText(resultingFileName);
         interestedFilename = resultingFileName;
@@ -71,7 +71,7 @@ void FileComparatorWindow::loadReferenceFile()
 {
     //secondFileFrames.clear();
     QString resultingFileName;
-    if (FrameFileIO::loadFrameFile(resultingFileName, &referenceFrames))
+    if (FrameFileIO::loadFrameFile(resultingFileName, &referenceFrames, ui->ckLoadPart->isChecked()))
     {
         ui->lblRefFrames->setText(QString::number(referenceFrames.length()));
         if (interestedFrames.count() > 0 && referenceFrames.count() > 0) calculateDetails();
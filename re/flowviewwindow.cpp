@@ -6,7 +6,7 @@ const QColor FlowViewWindow::graphColors[8] = {Qt::blue, Qt::green, Qt::black, Q
                                                Qt::gray, Qt::yellow, Qt::cyan, Qt::darkMagenta}; //4 5 6 7
 
 
-FlowViewWindow::FlowViewWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+FlowViewWindow::FlowViewWindow(const CANFrameView *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::FlowViewWindow)
 {
@@ -243,15 +243,16 @@ void FlowViewWindow::gotCenterTimeID(int32_t ID, double timestamp)
         }
     }
 
+    //frameCache holds one ID in capture order so the first frame past t_stamp can be binary searched
     int bestIdx = -1;
-    for (int i = 0; i < frameCache.count(); i++)
+    int low = 0, high = frameCache.count();
+    while (low < high)
     {
-        if (frameCache[i].timestamp > t_stamp)
-        {
-            bestIdx = i - 1;
-            break;
-        }
+        int mid = (low + high) / 2;
+        if (frameCache[mid].timestamp > t_stamp) high = mid;
+        else low = mid + 1;
     }
+    if (low < frameCache.count()) bestIdx = low - 1;
     qDebug() << "Best index " << bestIdx;
     if (bestIdx > -1)
     {
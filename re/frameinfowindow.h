@@ -6,6 +6,7 @@
 #include <QListWidget>
 #include <QTreeWidget>
 #include "can_structs.h"
+#include "canframestore.h"
 #include "bus_protocols/j1939_handler.h"
 
 namespace Ui {
@@ -17,7 +18,7 @@ class FrameInfoWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit FrameInfoWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit FrameInfoWindow(const CANFrameView *frames, QWidget *parent = 0);
     ~FrameInfoWindow();
     void showEvent(QShowEvent*);
 
@@ -31,7 +32,7 @@ private:
 
     QList<int> foundID;
     QList<CANFrame> frameCache;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameView *modelFrames;
     bool useOpenGL;
 
     void refreshIDList();
@@ -5,7 +5,7 @@
 #include "mainwindow.h"
 #include "connections/canconmanager.h"
 
-FuzzingWindow::FuzzingWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+FuzzingWindow::FuzzingWindow(const CANFrameView *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::FuzzingWindow)
 {
@@ -25,6 +25,7 @@ FuzzingWindow::FuzzingWindow(const QVector<CANFrame> *frames, QWidget *parent) :
     connect(ui->bitfield, SIGNAL(gridClicked(int,int)), this, SLOT(bitfieldClicked(int,int)));
 
     connect(MainWindow::getReference(), SIGNAL(framesUpdated(int)), this, SLOT(updatedFrames(int)));
+    connect(CANConManager::getInstance(), &CANConManager::framesSent, this, &FuzzingWindow::retrySending);
 
     refreshIDList();
 
@@ -111,7 +112,10 @@ void FuzzingWindow::changedNumDataBytes(int newVal)
 void FuzzingWindow::timerTriggered()
 {
     CANFrame thisFrame;
-    sendingBuffer.clear();
+
+    //skip this tick if the last one's frames haven't all gone out. Otherwise part of the sequence would never be tried
+    if (!CANConManager::getInstance()->sendPendingFrames(sendingBuffer)) return;
+
     int buses = ui->cbBuses->currentIndex();
     for (int count = 0; count < ui->spinBurst->value(); count++)
     {
@@ -140,10 +144,17 @@ void FuzzingWindow::timerTriggered()
         calcNextBitPattern();
         numSentFrames++;
     }
-    CANConManager::getInstance()->sendFrames(sendingBuffer);
+    CANConManager::getInstance()->sendPendingFrames(sendingBuffer);
     ui->lblNumFrames->setText("# of sent frames: " + QString::number(numSentFrames));
 }
 
+//a transmit queue has room again, send what was left over without waiting for the next tick
+void FuzzingWindow::retrySending(int count)
+{
+    Q_UNUSED(count);
+    if (currentlyFuzzing && !sendingBuffer.isEmpty()) CANConManager::getInstance()->sendPendingFrames(sendingBuffer);
+}
+
 void FuzzingWindow::clearAllFilters()
 {
     for (int i = 0; i < ui->listID->count(); i++)
@@ -274,6 +285,7 @@ void FuzzingWindow::toggleFuzzing()
         ui->btnStartStop->setText("Start Fuzzing");
         currentlyFuzzing = false;
         fuzzTimer->stop();
+        sendingBuffer.clear();
     }
     else //start it then
     {
@@ -5,6 +5,7 @@
 #include <QListWidget>
 #include <QTimer>
 #include "can_structs.h"
+#include "canframestore.h"
 
 namespace Ui {
 class FuzzingWindow;
@@ -25,7 +26,7 @@ class FuzzingWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit FuzzingWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit FuzzingWindow(const CANFrameView *frames, QWidget *parent = 0);
     ~FuzzingWindow();
 
 signals:
@@ -35,6 +36,7 @@ signals:
 private slots:
     void changePlaybackSpeed(int newSpeed);
     void timerTriggered();
+    void retrySending(int count);
     void clearAllFilters();
     void setAllFilters();
     void toggleFuzzing();
@@ -45,11 +47,11 @@ private slots:
 
 private:
     Ui::FuzzingWindow *ui;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameView *modelFrames;
     QTimer *fuzzTimer;
     QList<int> foundIDs;
     QList<int> selectedIDs;
-    QList<CANFrame> sendingBuffer;
+    QList<CANFrame> sendingBuffer; //what the connections had no room for yet. No new frames are made until it's out
     int startID, endID, currentID, currentIdx;
     bool seqIDScan, rangeIDSelect;
     int bitSequenceType;
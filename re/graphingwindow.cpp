@@ -4,7 +4,7 @@
 #include "mainwindow.h"
 #include <QDebug>
 
-GraphingWindow::GraphingWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+GraphingWindow::GraphingWindow(const CANFrameView *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::GraphingWindow)
 {
@@ -1014,7 +1014,7 @@ void GraphingWindow::appendToGraph(GraphParams &params, CANFrame &frame, QVector
     {
         params.strideSoFar = 0;
         int64_t tempVal; //64 bit temp value.
-        tempVal = Utility::processIntegerSignal(frame.data, params.startBit, params.numBits, params.intelFormat, params.isSigned); //& params.mask;
+        tempVal = params.extractor.extract(frame.data); //& params.mask;
         double xVal, yVal;
         if (secondsMode)
         {
@@ -1038,8 +1038,6 @@ void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
     float yminval=10000000.0, ymaxval = -1000000.0;
     float xminval=10000000000.0, xmaxval = -10000000000.0;
     GraphParams *refParam = &params;
-    int sBit, bits;
-    bool intelFormat, isSigned;
 
     qDebug() << "New Graph ID: " << params.ID;
     qDebug() << "Start bit: " << params.startBit;
@@ -1062,15 +1060,12 @@ void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
     params.x.fill(0, numEntries);
     params.y.fill(0, numEntries);
 
-    sBit = params.startBit;
-    bits = params.numBits;
-    intelFormat = params.intelFormat;
-    isSigned = params.isSigned;
+    params.extractor = SignalExtractor(params.startBit, params.numBits, params.intelFormat, params.isSigned);
 
     for (int j = 0; j < numEntries; j++)
     {
         int k = j * params.stride;
-        tempVal = Utility::processIntegerSignal(frameCache[k].data, sBit, bits, intelFormat, isSigned); //& params.mask;
+        tempVal = params.extractor.extract(frameCache[k].data); //& params.mask;
         //qDebug() << tempVal;
         if (secondsMode)
         {
@@ -3,7 +3,9 @@
 
 #include "qcustomplot.h"
 #include "can_structs.h"
+#include "canframestore.h"
 #include "dbc/dbchandler.h"
+#include "utility.h"
 
 #include <QDialog>
 
@@ -26,6 +28,7 @@ public:
     QColor color;
     QCPGraph *ref;
     QString graphName;
+    SignalExtractor extractor; //built from startBit/numBits/intelFormat/isSigned by createGraph
     //the below stuff is used for internal purposes only - code should be refactored so these can be private
     QVector<double> x, y;
     double xbias;
@@ -36,7 +39,7 @@ class GraphingWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit GraphingWindow(const QVector<CANFrame> *, QWidget *parent = 0);
+    explicit GraphingWindow(const CANFrameView *, QWidget *parent = 0);
     ~GraphingWindow();
     void showEvent(QShowEvent*);
 
@@ -75,7 +78,7 @@ private:
     Ui::GraphingWindow *ui;
     DBCHandler *dbcHandler;
     QList<CANFrame> frameCache;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameView *modelFrames;
     QList<GraphParams> graphParams;
     QPen selectedPen;
     QCPSelectionDecorator *selDecorator;
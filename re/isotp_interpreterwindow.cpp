@@ -2,7 +2,7 @@
 #include "ui_isotp_interpreterwindow.h"
 #include "mainwindow.h"
 
-ISOTP_InterpreterWindow::ISOTP_InterpreterWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+ISOTP_InterpreterWindow::ISOTP_InterpreterWindow(const CANFrameView *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::ISOTP_InterpreterWindow)
 {
@@ -93,7 +93,7 @@ void ISOTP_InterpreterWindow::writeSettings()
 void ISOTP_InterpreterWindow::interpretCapturedFrames()
 {
     clearList();
-    decoder->rapidFrames(NULL, *modelFrames);
+    decoder->rapidFrames(NULL, modelFrames->toVector());
 }
 
 void ISOTP_InterpreterWindow::listFilterItemChanged(QListWidgetItem *item)
@@ -3,7 +3,7 @@
 #include "mainwindow.h"
 #include "utility.h"
 
-RangeStateWindow::RangeStateWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+RangeStateWindow::RangeStateWindow(const CANFrameView *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::RangeStateWindow)
 {
@@ -259,9 +259,13 @@ bool RangeStateWindow::processSignal(int startBit, int bitLength, int sensitivit
 
     int i;
 
+    SignalExtractor extractor(startBit, bitLength, !bigEndian, isSigned);
+    QVector<int64_t> rawVals(numFrames);
+    extractor.extractBatch(frameCache.constData(), numFrames, rawVals.data());
+
     for (i = 0; i < numFrames; i++)
     {
-        valu = Utility::processIntegerSignal(frameCache.at(i).data, startBit, bitLength, !bigEndian, isSigned);
+        valu = rawVals[i];
         if (valu < lowestValue) lowestValue = valu;
         if (valu > highestValue) highestValue = valu;
     }
@@ -280,7 +284,7 @@ bool RangeStateWindow::processSignal(int startBit, int bitLength, int sensitivit
     int range = highestValue - lowestValue;
     multiplier = (double)sensitivity / (double)range;
 
-    for (i = 0; i < numFrames; i++) scaledVals.append((int)((Utility::processIntegerSignal(frameCache.at(i).data, startBit, bitLength, !bigEndian, isSigned) - lowestValue) * multiplier));
+    for (i = 0; i < numFrames; i++) scaledVals.append((int)((rawVals[i] - lowestValue) * multiplier));
 
     for (i = 1; i < numFrames; i++)
     {
@@ -426,7 +430,10 @@ void RangeStateWindow::clickedSignalList(int idx)
 
     int numFrames = frameCache.count();
     QVector<int> values;
+    QVector<int64_t> rawVals(numFrames);
+    SignalExtractor extractor(startBit, bitLength, !isBigEndian, isSigned);
+    extractor.extractBatch(frameCache.constData(), numFrames, rawVals.data());
     values.reserve(numFrames);
-    for (int i = 0; i < numFrames; i++) values.append((int)((Utility::processIntegerSignal(frameCache.at(i).data, startBit, bitLength, !isBigEndian, isSigned))));
+    for (int i = 0; i < numFrames; i++) values.append((int)rawVals[i]);
     createGraph(values);
 }
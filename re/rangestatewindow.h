@@ -3,6 +3,7 @@
 
 #include <QDialog>
 #include "can_structs.h"
+#include "canframestore.h"
 
 namespace Ui {
 class RangeStateWindow;
@@ -13,7 +14,7 @@ class RangeStateWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit RangeStateWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit RangeStateWindow(const CANFrameView *frames, QWidget *parent = 0);
     ~RangeStateWindow();
     void showEvent(QShowEvent*);
 
@@ -24,7 +25,7 @@ private slots:
 
 private:
     Ui::RangeStateWindow *ui;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameView *modelFrames;
     QVector<CANFrame> frameCache;
     QList<int64_t> foundSignals;
     QHash<int, bool> idFilters;
@@ -2,6 +2,7 @@
 #define UDSSCANWINDOW_H
 
 #include "can_structs.h"
+#include "canframestore.h"
 #include "connections/canconnection.h"
 #include "bus_protocols/uds_handler.h"
 
@@ -18,7 +19,7 @@ class UDSScanWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit UDSScanWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit UDSScanWindow(const CANFrameView *frames, QWidget *parent = 0);
     ~UDSScanWindow();
 
 private slots:
@@ -37,7 +38,7 @@ private slots:
 
 private:
     Ui::UDSScanWindow *ui;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameView *modelFrames;
     UDS_HANDLER *udsHandler;
     QTimer *waitTimer;
     QList<UDS_MESSAGE> sendingFrames;
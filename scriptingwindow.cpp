@@ -7,7 +7,7 @@
 
 #include "connections/canconmanager.h"
 
-ScriptingWindow::ScriptingWindow(const QVector<CANFrame> *frames, QWidget *parent) :
+ScriptingWindow::ScriptingWindow(const CANFrameView *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::ScriptingWindow)
 {
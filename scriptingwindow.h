@@ -3,6 +3,7 @@
 
 #include "scriptcontainer.h"
 #include "can_structs.h"
+#include "canframestore.h"
 #include "connections/canconnection.h"
 #include "jsedit.h"
 
@@ -20,7 +21,7 @@ class ScriptingWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit ScriptingWindow(const QVector<CANFrame> *frames, QWidget *parent = 0);
+    explicit ScriptingWindow(const CANFrameView *frames, QWidget *parent = 0);
     void showEvent(QShowEvent*);
     ~ScriptingWindow();
 
@@ -54,7 +55,7 @@ private:
     JSEdit *editor;
     QList<ScriptContainer *> scripts;
     ScriptContainer *currentScript;
-    const QVector<CANFrame> *modelFrames;
+    const CANFrameView *modelFrames;
     QElapsedTimer elapsedTime;
     QTimer valuesTimer;
 };
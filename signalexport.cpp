@@ -0,0 +1,747 @@
+#include "signalexport.h"
+
+#include <QSaveFile>
+#include <QHash>
+#include <QBuffer>
+#include <QScopedPointer>
+#include <QThread>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <QFutureWatcher>
+#include <QEventLoop>
+#include <QTimer>
+#include <QApplication>
+#include <QProgressDialog>
+#include <QMessageBox>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QListWidget>
+#include <QPushButton>
+#include <QCheckBox>
+#include <QLineEdit>
+#include <QDoubleValidator>
+#include <QSettings>
+#include <math.h>
+#include <limits.h>
+#include "dbc/dbchandler.h"
+#include "lazyframefile.h"
+#include "utils/textwriter.h"
+
+//most frames in each piece of the capture handed to a thread
+#define EXPORT_CHUNK_FRAMES         65536
+//pieces per thread in each round. The output of a round is held in memory until it has been written
+#define EXPORT_CHUNKS_PER_THREAD    4
+//default for the bytes of rows a round may hold, see SignalExport::setMemoryLimit()
+#define EXPORT_MEMORY_BYTES         (256 * 1024 * 1024ll)
+//a gap between frames longer than this many resampled rows is written out as a run of held rows instead of
+//being formatted by the piece, so a long silence in a capture doesn't have to fit in memory. With many
+//columns the limit comes down, to as few as EXPORT_MIN_RUN_ROWS, before the pieces are made smaller
+#define EXPORT_RUN_ROWS             4096
+#define EXPORT_MIN_RUN_ROWS         16
+//pieces are only made smaller than this many frames once runs are down to EXPORT_MIN_RUN_ROWS
+#define EXPORT_MIN_CHUNK_FRAMES     4096
+//most rows in each part of a piece and so in each binary row group, and most bytes in one
+#define EXPORT_GROUP_ROWS           65536
+#define EXPORT_GROUP_BYTES          (16 * 1024 * 1024ll)
+//what a single part may never grow past, the most a QByteArray can hold with room to spare
+#define EXPORT_MAX_PART_BYTES       ((qint64)INT_MAX - 4096)
+
+//what every piece of an export shares. None of it changes while the pieces are worked on
+struct ExportJob
+{
+    const CANFrameView *frames;
+    DBCHandler *dbc;            //only findMessage(), which just reads the message indexes
+    const QHash<DBC_MESSAGE *, int> *planIndex;
+    const QVector<SignalExportPlan> *plans;
+    int numColumns;
+    int maxSignals;
+    SignalExport::Format format;
+    uint64_t period;
+    uint64_t endTime;           //resampled rows stop short of this
+    int groupRows;              //most rows in a part
+    quint64 runRows;            //gaps of at least this many resampled rows become runs
+};
+
+//rows of a piece. Either formatted data or, for a long gap while resampling, a run of rows all holding the same values
+struct ExportPart
+{
+    ExportPart() : rows(0), runStart(0), runRows(0) {}
+
+    QByteArray data;
+    quint64 rows;
+    uint64_t runStart;
+    quint64 runRows;
+    QVector<double> runValues;
+    QVector<bool> runHave;
+};
+
+struct ExportChunk
+{
+    const ExportJob *job;
+    int first;
+    int count;
+    QVector<double> startValues;    //resampling: values held from before the piece
+    QVector<bool> startHave;
+    QVector<double> lastValues;     //latest value of each column in the piece
+    QVector<bool> seen;             //whether the piece had the column at all
+    QVector<ExportPart> parts;
+    bool failed;                    //a part came out too big to hold
+};
+
+/*
+ * Rows going into one part, as text straight away or gathered up into columns for a binary row group.
+ */
+class RowWriter
+{
+public:
+    RowWriter(const ExportJob *pJob) : job(pJob), rows(0)
+    {
+        if (job->format == SignalExport::WIDE_CSV)
+        {
+            buffer.setBuffer(&data);
+            buffer.open(QIODevice::WriteOnly);
+            text.reset(new TextWriter(&buffer, 256 * 1024));
+        }
+        else columnValues.resize(job->numColumns);
+    }
+
+    quint64 count() const { return rows; }
+
+    //most bytes a row can take up in either format: eight per value in binary, and in text up to 24 characters
+    //for a number in %.15g and its comma
+    static qint64 rowBytes(SignalExport::Format format, int numColumns)
+    {
+        return (qint64)(numColumns + 1) * ((format == SignalExport::WIDE_CSV) ? 24 : 8);
+    }
+
+    void addRow(uint64_t time, const double *values, const bool *have)
+    {
+        rows++;
+        if (text)
+        {
+            text->putFixed(time, 6);
+            for (int c = 0; c < job->numColumns; c++)
+            {
+                text->put(',');
+                if (have[c]) text->putDouble(values[c]);
+            }
+            text->put('\n');
+            return;
+        }
+        times.append(time);
+        for (int c = 0; c < job->numColumns; c++) columnValues[c].append(have[c] ? values[c] : NAN);
+    }
+
+    //hands over what has been written. False if it is more than a QByteArray can hold
+    bool finish(QByteArray &out)
+    {
+        if (text)
+        {
+            text->flush();
+            text.reset();
+            bool fits = (buffer.size() == (qint64)data.size()) && (data.size() <= EXPORT_MAX_PART_BYTES);
+            buffer.close();
+            out = data;
+            return fits;
+        }
+        if (rows == 0) return true;
+
+        qint64 size = 4 + (qint64)rows * 8 * (1 + job->numColumns);
+        if (size > EXPORT_MAX_PART_BYTES) return false;
+        out.resize((int)size);
+        uchar *p = (uchar *)out.data();
+        qToLittleEndian<quint32>((quint32)rows, p);
+        p += 4;
+        for (int r = 0; r < times.count(); r++, p += 8) qToLittleEndian<quint64>(times[r], p);
+        for (int c = 0; c < job->numColumns; c++)
+        {
+            const double *values = columnValues[c].constData();
+            for (int r = 0; r < times.count(); r++, p += 8)
+            {
+                quint64 bits;
+                memcpy(&bits, &values[r], 8);
+                qToLittleEndian<quint64>(bits, p);
+            }
+        }
+        return true;
+    }
+
+private:
+    const ExportJob *job;
+    quint64 rows;
+    QByteArray data;
+    QBuffer buffer;
+    QScopedPointer<TextWriter> text;
+    QVector<uint64_t> times;
+    QVector< QVector<double> > columnValues;
+};
+
+//num frames of the view from first on. A file being viewed is read a page at a time so the threads don't fight over its cache
+static void copyFrames(const CANFrameView *frames, int first, int num, CANFrame *out)
+{
+    const LazyFrameFile *file = frames->lazyFile();
+    if (!file)
+    {
+        for (int i = 0; i < num; i++) out[i] = frames->at(first + i);
+        return;
+    }
+
+    //filtered rows are in file order so every page read covers the next run of them
+    QVector<CANFrame> page(LAZY_PAGE_FRAMES);
+    int i = 0;
+    while (i < num)
+    {
+        int pageFirst = frames->storeIndex(first + i);
+        int pageNum = qMin(LAZY_PAGE_FRAMES, file->count() - pageFirst);
+        file->readFrames(pageFirst, pageNum, page.data());
+        while (i < num && frames->storeIndex(first + i) < pageFirst + pageNum)
+        {
+            out[i] = page[frames->storeIndex(first + i) - pageFirst];
+            i++;
+        }
+    }
+}
+
+//plan for the message a frame belongs to, NULL if none of its signals are exported. Answers are kept in known
+static const SignalExportPlan *findPlan(const ExportJob *job, const CANFrame &frame, QHash<quint64, int> &known)
+{
+    quint64 key = ((quint64)frame.bus << 32) | frame.ID;
+    QHash<quint64, int>::const_iterator found = known.constFind(key);
+    int plan;
+    if (found != known.constEnd()) plan = found.value();
+    else
+    {
+        plan = job->planIndex->value(job->dbc->findMessage(frame), -1);
+        known.insert(key, plan);
+    }
+    return (plan >= 0) ? &job->plans->at(plan) : NULL;
+}
+
+/*
+ * Resampling only. Works back from the end of a piece finding the latest value of each column, which is what
+ * the next piece starts out holding. Usually only the last few frames have to be decoded.
+ */
+static void scanChunkEnd(ExportChunk &chunk)
+{
+    const ExportJob *job = chunk.job;
+    QVector<CANFrame> frames(qMin(chunk.count, LAZY_PAGE_FRAMES));
+    QHash<quint64, int> known;
+    QVector<double> sigValues(job->maxSignals);
+    QVector<bool> sigValid(job->maxSignals);
+    chunk.lastValues.fill(0.0, job->numColumns);
+    chunk.seen.fill(false, job->numColumns);
+    int numSeen = 0;
+
+    //read a block at a time from the end as the frames needed are rarely far back
+    for (int end = chunk.first + chunk.count; end > chunk.first && numSeen < job->numColumns; end -= frames.count())
+    {
+        int num = qMin(frames.count(), end - chunk.first);
+        copyFrames(job->frames, end - num, num, frames.data());
+        for (int i = num - 1; i >= 0 && numSeen < job->numColumns; i--)
+        {
+            const SignalExportPlan *plan = findPlan(job, frames[i], known);
+            if (!plan) continue;
+            plan->decoder.decode(frames[i], sigValues.data(), sigValid.data());
+            for (int s = 0; s < plan->signalIdx.count(); s++)
+            {
+                int col = plan->columns[s];
+                if (chunk.seen[col] || !sigValid[plan->signalIdx[s]]) continue;
+                chunk.lastValues[col] = sigValues[plan->signalIdx[s]];
+                chunk.seen[col] = true;
+                numSeen++;
+            }
+        }
+    }
+}
+
+//moves the rows written so far into a part of their own and starts over
+static void endPart(ExportChunk &chunk, QScopedPointer<RowWriter> &rows)
+{
+    if (rows->count() > 0)
+    {
+        ExportPart part;
+        part.rows = rows->count();
+        if (!rows->finish(part.data)) chunk.failed = true;
+        chunk.parts.append(part);
+    }
+    rows.reset(new RowWriter(chunk.job));
+}
+
+/*
+ * Decodes a piece and makes its rows. Resampled rows that fall in a gap between two frames all hold the same
+ * values, so a long gap becomes a run part that write() expands as it goes into the file. Parts are kept to
+ * the job's groupRows rows, which is also the size of the binary row groups.
+ */
+static void writeChunk(ExportChunk &chunk)
+{
+    const ExportJob *job = chunk.job;
+    bool resample = (job->period > 0);
+    //resampling needs the first frame of the next piece to know where the rows of this one stop
+    int numRead = chunk.count;
+    if (resample && chunk.first + chunk.count < job->frames->count()) numRead++;
+    QVector<CANFrame> frames(numRead);
+    copyFrames(job->frames, chunk.first, numRead, frames.data());
+
+    QHash<quint64, int> known;
+    QVector<double> sigValues(job->maxSignals);
+    QVector<bool> sigValid(job->maxSignals);
+    QVector<double> values(job->numColumns, 0.0);
+    QVector<bool> have(job->numColumns, false);
+    if (resample)
+    {
+        values = chunk.startValues;
+        have = chunk.startHave;
+    }
+
+    chunk.parts.clear();
+    chunk.failed = false;
+    QScopedPointer<RowWriter> rows(new RowWriter(job));
+
+    uint64_t nextRow = 0;
+    if (resample) nextRow = ((frames[0].timestamp + job->period - 1) / job->period) * job->period;
+
+    for (int i = 0; i <= chunk.count; i++)
+    {
+        //the rows before the frame hold what came before it
+        if (resample)
+        {
+            uint64_t until = (i < numRead) ? frames[i].timestamp : job->endTime;
+            if (until > nextRow)
+            {
+                quint64 numRows = (until - nextRow + job->period - 1) / job->period;
+                if (numRows < job->runRows)
+                {
+                    for (quint64 r = 0; r < numRows; r++)
+                    {
+                        rows->addRow(nextRow + r * job->period, values.constData(), have.constData());
+                        if (rows->count() >= (quint64)job->groupRows) endPart(chunk, rows);
+                    }
+                }
+                else
+                {
+                    endPart(chunk, rows);
+                    ExportPart run;
+                    run.runStart = nextRow;
+                    run.runRows = numRows;
+                    run.runValues = values;
+                    run.runHave = have;
+                    chunk.parts.append(run);
+                }
+                nextRow += numRows * job->period;
+            }
+        }
+        if (i == chunk.count) break;
+
+        const CANFrame &frame = frames[i];
+        const SignalExportPlan *plan = findPlan(job, frame, known);
+        if (!plan) continue;
+        if (plan->decoder.decode(frame, sigValues.data(), sigValid.data()) == 0) continue;
+
+        bool found = false;
+        for (int s = 0; s < plan->signalIdx.count(); s++)
+        {
+            if (!sigValid[plan->signalIdx[s]]) continue;
+            values[plan->columns[s]] = sigValues[plan->signalIdx[s]];
+            have[plan->columns[s]] = true;
+            found = true;
+        }
+
+        //without resampling the frame is a row of its own with just its signals filled in
+        if (!resample && found)
+        {
+            rows->addRow(frame.timestamp, values.constData(), have.constData());
+            for (int s = 0; s < plan->columns.count(); s++) have[plan->columns[s]] = false;
+            if (rows->count() >= (quint64)job->groupRows) endPart(chunk, rows);
+        }
+    }
+    endPart(chunk, rows);
+}
+
+SignalExport::SignalExport()
+{
+    format = WIDE_CSV;
+    resamplePeriod = 0;
+    memoryLimit = EXPORT_MEMORY_BYTES;
+    maxSignals = 0;
+    prepared = false;
+}
+
+void SignalExport::addSignal(DBC_MESSAGE *msg, DBC_SIGNAL *sig)
+{
+    Column col;
+    col.message = msg;
+    col.signal = sig;
+    columns.append(col);
+    prepared = false;
+}
+
+void SignalExport::prepare()
+{
+    planIndex.clear();
+    plans.clear();
+    maxSignals = 0;
+    for (int c = 0; c < columns.count(); c++)
+    {
+        DBC_MESSAGE *msg = columns[c].message;
+        int plan = planIndex.value(msg, -1);
+        if (plan < 0)
+        {
+            plan = plans.count();
+            SignalExportPlan newPlan;
+            newPlan.decoder = msg->getDecoder();
+            for (int s = 0; s < newPlan.decoder.getCount(); s++)
+            {
+                newPlan.decoder.getSignal(s)->getExtractor();
+                newPlan.decoder.getSignal(s)->getValueTable();
+            }
+            plans.append(newPlan);
+            planIndex.insert(msg, plan);
+            maxSignals = qMax(maxSignals, newPlan.decoder.getCount());
+        }
+        SignalExportPlan &mp = plans[plan];
+        for (int s = 0; s < mp.decoder.getCount(); s++)
+        {
+            if (mp.decoder.getSignal(s) != columns[c].signal) continue;
+            mp.signalIdx.append(s);
+            mp.columns.append(c);
+            break;
+        }
+    }
+    prepared = true;
+}
+
+static void encodeHeader(uchar *out, int numColumns, quint64 rows, uint64_t period, quint32 groups)
+{
+    memset(out, 0, SIGCOL_HEADER_SIZE);
+    memcpy(out, SIGCOL_MAGIC, 8);
+    qToLittleEndian<quint32>(SIGCOL_VERSION, out + 8);
+    qToLittleEndian<quint32>(numColumns, out + 12);
+    qToLittleEndian<quint64>(rows, out + 16);
+    qToLittleEndian<quint64>(period, out + 24);
+    qToLittleEndian<quint32>(groups, out + 32);
+}
+
+static void appendString(QByteArray &out, const QString &str)
+{
+    QByteArray bytes = str.toUtf8().left(0xFFFF);
+    uchar len[2];
+    qToLittleEndian<quint16>(bytes.size(), len);
+    out.append((const char *)len, 2);
+    out.append(bytes);
+}
+
+bool SignalExport::write(QString filename, const CANFrameView *frames, DBCHandler *dbc)
+{
+    canceled.store(0);
+    progressValue.store(0);
+    error.clear();
+
+    if (columns.isEmpty())
+    {
+        error = QObject::tr("No signals were picked to export.");
+        return false;
+    }
+    if (!prepared)
+    {
+        error = QObject::tr("The export wasn't prepared.");
+        return false;
+    }
+
+    ExportJob job;
+    job.frames = frames;
+    job.dbc = dbc;
+    job.planIndex = &planIndex;
+    job.plans = &plans;
+    job.numColumns = columns.count();
+    job.maxSignals = maxSignals;
+    job.format = format;
+    job.period = resamplePeriod;
+    job.endTime = frames->isEmpty() ? 0 : frames->last().timestamp + 1;
+
+    /*
+     * Sizes everything from what a row can cost, so a round holds at most memoryLimit bytes of rows however many
+     * columns there are. A piece without resampling makes at most a row per frame. Resampled, each frame can be
+     * followed by up to runRows - 1 formatted rows, a longer gap costing about one row as a run.
+     */
+    qint64 rowBytes = RowWriter::rowBytes(format, columns.count());
+    int threads = qMax(1, QThread::idealThreadCount());
+    qint64 chunkBytes = qMax((qint64)1, memoryLimit / (threads * EXPORT_CHUNKS_PER_THREAD));
+    job.groupRows = (int)qBound((qint64)1, EXPORT_GROUP_BYTES / rowBytes, (qint64)EXPORT_GROUP_ROWS);
+    job.runRows = 1;
+    if (resamplePeriod > 0)
+    {
+        job.runRows = (quint64)qBound((qint64)EXPORT_MIN_RUN_ROWS, chunkBytes / (rowBytes * EXPORT_MIN_CHUNK_FRAMES),
+                                      (qint64)EXPORT_RUN_ROWS);
+    }
+    qint64 frameBytes = rowBytes * (qint64)job.runRows;
+    int chunkFrames = (int)qBound((qint64)1, chunkBytes / frameBytes, (qint64)EXPORT_CHUNK_FRAMES);
+    int chunksPerRound = (int)qBound((qint64)1, memoryLimit / (frameBytes * chunkFrames),
+                                     (qint64)(threads * EXPORT_CHUNKS_PER_THREAD));
+
+    QSaveFile outFile(filename);
+    if (!outFile.open(QIODevice::WriteOnly))
+    {
+        error = QObject::tr("Couldn't create %1").arg(filename);
+        return false;
+    }
+
+    QByteArray header;
+    if (format == WIDE_CSV)
+    {
+        header = "Time";
+        for (int c = 0; c < columns.count(); c++) header += "," + (columns[c].message->name + "." + columns[c].signal->name).toUtf8();
+        header += "\n";
+    }
+    else
+    {
+        header.resize(SIGCOL_HEADER_SIZE);
+        encodeHeader((uchar *)header.data(), columns.count(), 0, resamplePeriod, 0);
+        for (int c = 0; c < columns.count(); c++)
+        {
+            appendString(header, columns[c].message->name + "." + columns[c].signal->name);
+            appendString(header, columns[c].signal->unitName);
+        }
+    }
+    outFile.write(header);
+
+    int total = frames->count();
+    QVector<double> carryValues(columns.count(), 0.0);
+    QVector<bool> carryHave(columns.count(), false);
+    quint64 totalRows = 0;
+    quint32 totalGroups = 0;
+    bool failed = false;
+
+    for (int first = 0; first < total && !failed && !canceled.load(); )
+    {
+        QVector<ExportChunk> chunks;
+        for (int i = 0; i < chunksPerRound && first < total; i++)
+        {
+            ExportChunk chunk;
+            chunk.job = &job;
+            chunk.first = first;
+            chunk.count = qMin(chunkFrames, total - first);
+            chunk.failed = false;
+            chunks.append(chunk);
+            first += chunk.count;
+        }
+
+        //what each piece starts out holding depends on every piece before it, so that is worked out in order
+        if (resamplePeriod > 0)
+        {
+            QtConcurrent::blockingMap(chunks, scanChunkEnd);
+            for (int i = 0; i < chunks.count(); i++)
+            {
+                chunks[i].startValues = carryValues;
+                chunks[i].startHave = carryHave;
+                for (int c = 0; c < columns.count(); c++)
+                {
+                    if (!chunks[i].seen[c]) continue;
+                    carryValues[c] = chunks[i].lastValues[c];
+                    carryHave[c] = true;
+                }
+            }
+        }
+        QtConcurrent::blockingMap(chunks, writeChunk);
+
+        for (int i = 0; i < chunks.count() && !failed; i++)
+        {
+            if (chunks[i].failed) failed = true;
+            for (int p = 0; p < chunks[i].parts.count() && !failed; p++)
+            {
+                const ExportPart &part = chunks[i].parts[p];
+                if (part.rows > 0)
+                {
+                    if (outFile.write(part.data) != part.data.size()) failed = true;
+                    totalRows += part.rows;
+                    totalGroups++;
+                }
+                //a run is written in pieces that each become a row group of their own
+                for (quint64 done = 0; done < part.runRows && !failed; done += job.groupRows)
+                {
+                    quint64 num = qMin((quint64)job.groupRows, part.runRows - done);
+                    QByteArray data;
+                    RowWriter rows(&job);
+                    for (quint64 r = done; r < done + num; r++)
+                    {
+                        rows.addRow(part.runStart + r * resamplePeriod, part.runValues.constData(), part.runHave.constData());
+                    }
+                    if (!rows.finish(data) || outFile.write(data) != data.size()) failed = true;
+                    totalRows += num;
+                    totalGroups++;
+                }
+            }
+            chunks[i].parts.clear(); //let go of each piece as soon as it is written
+        }
+        progressValue.store((int)((qint64)first * 1000 / total));
+    }
+
+    if (!failed && format == BINARY_COLUMNS)
+    {
+        uchar finalHeader[SIGCOL_HEADER_SIZE];
+        encodeHeader(finalHeader, columns.count(), totalRows, resamplePeriod, totalGroups);
+        if (!outFile.seek(0) || outFile.write((const char *)finalHeader, SIGCOL_HEADER_SIZE) != SIGCOL_HEADER_SIZE) failed = true;
+    }
+
+    if (canceled.load())
+    {
+        outFile.cancelWriting();
+        error = QObject::tr("The export was canceled.");
+        return false;
+    }
+    if (failed || !outFile.commit())
+    {
+        error = QObject::tr("Couldn't write %1").arg(filename);
+        return false;
+    }
+    progressValue.store(1000);
+    return true;
+}
+
+/*
+ * Asks which signals to export, out of every message in the loaded DBC files, and whether to resample them.
+ * The resampling answers are offered again next time.
+ */
+static bool askExportOptions(SignalExport &exporter, DBCHandler *dbc)
+{
+    QSettings settings;
+    QDialog dialog(qApp->activeWindow());
+    dialog.setWindowTitle(QObject::tr("Export Decoded Signals"));
+
+    QListWidget *signalList = new QListWidget(&dialog);
+    QVector<DBC_MESSAGE *> choiceMessages;
+    QVector<DBC_SIGNAL *> choiceSignals;
+    for (int f = 0; f < dbc->getFileCount(); f++)
+    {
+        DBCMessageHandler *messages = dbc->getFileByIdx(f)->messageHandler;
+        for (int m = 0; m < messages->getCount(); m++)
+        {
+            DBC_MESSAGE *msg = messages->findMsgByIdx(m);
+            for (int s = 0; s < msg->sigHandler->getCount(); s++)
+            {
+                DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(s);
+                if (sig->valType == STRING) continue; //nothing to put in a number column
+                QListWidgetItem *item = new QListWidgetItem(msg->name + "." + sig->name, signalList);
+                item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+                item->setCheckState(Qt::Checked);
+                choiceMessages.append(msg);
+                choiceSignals.append(sig);
+            }
+        }
+    }
+
+    QPushButton *allButton = new QPushButton(QObject::tr("All"), &dialog);
+    QPushButton *noneButton = new QPushButton(QObject::tr("None"), &dialog);
+    QObject::connect(allButton, &QPushButton::clicked, signalList, [signalList]()
+    {
+        for (int i = 0; i < signalList->count(); i++) signalList->item(i)->setCheckState(Qt::Checked);
+    });
+    QObject::connect(noneButton, &QPushButton::clicked, signalList, [signalList]()
+    {
+        for (int i = 0; i < signalList->count(); i++) signalList->item(i)->setCheckState(Qt::Unchecked);
+    });
+    QHBoxLayout *pickButtons = new QHBoxLayout();
+    pickButtons->addWidget(allButton);
+    pickButtons->addWidget(noneButton);
+    pickButtons->addStretch();
+
+    QCheckBox *resample = new QCheckBox(QObject::tr("Resample to one row per period"), &dialog);
+    QLineEdit *periodEdit = new QLineEdit(settings.value("DecodedExport/Period", "10").toString(), &dialog);
+    QDoubleValidator *validator = new QDoubleValidator(0.001, 1e9, 3, &dialog);
+    validator->setLocale(QLocale::c());
+    periodEdit->setValidator(validator);
+    resample->setChecked(settings.value("DecodedExport/Resample", false).toBool());
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    QObject::connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    QObject::connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    QFormLayout *layout = new QFormLayout(&dialog);
+    layout->addRow(signalList);
+    layout->addRow(pickButtons);
+    layout->addRow(resample);
+    layout->addRow(QObject::tr("Period (ms)"), periodEdit);
+    layout->addRow(buttons);
+
+    if (dialog.exec() != QDialog::Accepted) return false;
+
+    for (int i = 0; i < signalList->count(); i++)
+    {
+        if (signalList->item(i)->checkState() == Qt::Checked) exporter.addSignal(choiceMessages[i], choiceSignals[i]);
+    }
+    if (exporter.columnCount() == 0)
+    {
+        QMessageBox msgBox;
+        msgBox.setText(QObject::tr("No signals were picked to export."));
+        msgBox.exec();
+        return false;
+    }
+
+    if (resample->isChecked())
+    {
+        uint64_t period = (uint64_t)(QLocale::c().toDouble(periodEdit->text()) * 1000.0 + 0.5);
+        if (period == 0)
+        {
+            QMessageBox msgBox;
+            msgBox.setText(QObject::tr("The resample period has to be at least a microsecond."));
+            msgBox.exec();
+            return false;
+        }
+        exporter.setResamplePeriod(period);
+    }
+
+    settings.setValue("DecodedExport/Resample", resample->isChecked());
+    settings.setValue("DecodedExport/Period", periodEdit->text());
+    return true;
+}
+
+bool SignalExport::exportWithDialog(QString filename, Format format, const CANFrameView *frames, DBCHandler *dbc)
+{
+    if (!dbc || dbc->getFileCount() == 0)
+    {
+        QMessageBox msgBox;
+        msgBox.setText(QObject::tr("Load a DBC file first so there are signals to export."));
+        msgBox.exec();
+        return false;
+    }
+
+    SignalExport exporter;
+    exporter.setFormat(format);
+    if (!askExportOptions(exporter, dbc)) return false;
+    //the GUI keeps drawing frames through the same DBC objects while the export runs, so their caches are built here
+    exporter.prepare();
+
+    QProgressDialog progress(qApp->activeWindow());
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setLabelText(QObject::tr("Exporting signals..."));
+    progress.setCancelButtonText(QObject::tr("Cancel"));
+    progress.setRange(0, 1000);
+    progress.setMinimumDuration(0);
+    progress.show();
+
+    //same arrangement as FrameFileIO::saveInBackground, the export runs on the pool while the dialog keeps updating
+    QFutureWatcher<bool> watcher;
+    QEventLoop loop;
+    QTimer progressTimer;
+    SignalExport *running = &exporter;
+    QObject::connect(&watcher, &QFutureWatcher<bool>::finished, &loop, &QEventLoop::quit);
+    QObject::connect(&progressTimer, &QTimer::timeout, &progress, [&progress, running]() { progress.setValue(running->progress()); });
+    QObject::connect(&progress, &QProgressDialog::canceled, &watcher, [running]() { running->cancel(); });
+
+    watcher.setFuture(QtConcurrent::run(running, &SignalExport::write, filename, frames, dbc));
+    progressTimer.start(100);
+    if (!watcher.isFinished()) loop.exec();
+    watcher.waitForFinished();
+    progressTimer.stop();
+    progress.cancel();
+
+    bool result = watcher.result();
+    if (!result && !exporter.canceled.load())
+    {
+        QMessageBox msgBox;
+        msgBox.setText(exporter.errorString());
+        msgBox.exec();
+    }
+    return result;
+}
@@ -0,0 +1,122 @@
+#ifndef SIGNALEXPORT_H
+#define SIGNALEXPORT_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QAtomicInt>
+#include "can_structs.h"
+#include "canframestore.h"
+#include "dbc/dbc_classes.h"
+
+class DBCHandler;
+
+//the columns one message's frames fill in, worked out by SignalExport::prepare()
+struct SignalExportPlan
+{
+    DBCMessageDecoder decoder;
+    QVector<int> signalIdx;     //decoder index of each exported signal of the message
+    QVector<int> columns;       //and the column it goes in
+};
+
+/*
+ * Writes the decoded signals of a capture out with one column per signal, for loading into analysis tools.
+ * The frames are cut into pieces that are decoded on every core through each message's DBCMessageDecoder and
+ * written back out in order. The pieces are sized from the number of columns so the rows held in memory at
+ * once stay within a limit, however big the capture and however many signals are picked.
+ *
+ * Without resampling each frame holding one of the signals gives a row, with only that frame's signals filled
+ * in. Resampled, there is a row at every multiple of the period from the first frame to the last holding the
+ * latest value of each signal, empty until the signal has first been seen. Resampling expects the frames in
+ * time order, as captures are.
+ *
+ * Wide CSV: a Time column in seconds and then one column per signal named Message.Signal.
+ *
+ * Binary columns, everything little endian:
+ *
+ * Header (40 bytes):
+ *   char     magic[8]       "SVSIGCOL"
+ *   uint32   version
+ *   uint32   columnCount
+ *   uint64   rowCount
+ *   uint64   period         microseconds between rows, 0 if every row is a frame
+ *   uint32   groupCount
+ *   uint32   reserved
+ *
+ * Column table, per column:
+ *   uint16   name length, then the name (Message.Signal) as UTF-8
+ *   uint16   unit length, then the unit as UTF-8
+ *
+ * Row groups, groupCount of them:
+ *   uint32   rows
+ *   uint64   timestamps[rows]   microseconds
+ *   double   values[rows]       for the first column, then the same for each of the others. NaN where there is no value
+ */
+
+#define SIGCOL_MAGIC        "SVSIGCOL"
+#define SIGCOL_VERSION      1
+#define SIGCOL_HEADER_SIZE  40
+
+class SignalExport
+{
+public:
+    enum Format
+    {
+        WIDE_CSV,
+        BINARY_COLUMNS
+    };
+
+    SignalExport();
+
+    //the columns come out in the order the signals are added
+    void addSignal(DBC_MESSAGE *msg, DBC_SIGNAL *sig);
+    int columnCount() const { return columns.count(); }
+    void setFormat(Format fmt) { format = fmt; }
+    //microseconds between rows, 0 for a row per frame
+    void setResamplePeriod(uint64_t period) { resamplePeriod = period; }
+    //about how many bytes of finished rows may be held at once while they wait to be written, 256MB by default
+    void setMemoryLimit(qint64 bytes) { memoryLimit = bytes; }
+
+    /*
+     * Copies the decoders of the picked signals' messages, building any the DBC objects haven't got cached yet.
+     * Has to be called after the last addSignal() on the thread that owns the DBC files, as the GUI thread
+     * builds the same caches while it draws the frames.
+     */
+    void prepare();
+
+    /*
+     * Writes the file, blocking until it is done. Needs prepare() first and then only reads the DBC files, so it
+     * can run on another thread. The DBC files must not change meanwhile, nor the frames.
+     * A canceled or failed export leaves no file behind.
+     */
+    bool write(QString filename, const CANFrameView *frames, DBCHandler *dbc);
+    //safe from any thread while write() runs
+    void cancel() { canceled.store(1); }
+    //tenths of a percent of the frames done
+    int progress() const { return progressValue.load(); }
+    QString errorString() const { return error; }
+
+    //asks for the signals and resampling then writes filename on the thread pool with a progress dialog
+    static bool exportWithDialog(QString filename, Format format, const CANFrameView *frames, DBCHandler *dbc);
+
+private:
+    struct Column
+    {
+        DBC_MESSAGE *message;
+        DBC_SIGNAL *signal;
+    };
+
+    QVector<Column> columns;
+    QHash<DBC_MESSAGE *, int> planIndex;
+    QVector<SignalExportPlan> plans;
+    int maxSignals;             //most signals in any message with a plan, for sizing the decode arrays
+    bool prepared;
+    Format format;
+    uint64_t resamplePeriod;
+    qint64 memoryLimit;
+    QAtomicInt canceled;
+    QAtomicInt progressValue;
+    QString error;
+};
+
+#endif // SIGNALEXPORT_H
@@ -2,6 +2,14 @@
 
 #include "tst_lfqueue.h"
 #include "tst_cancon.h"
+#include "tst_signalextract.h"
+#include "tst_canframestore.h"
+#include "tst_canbinaryfile.h"
+#include "tst_cancompressedfile.h"
+#include "tst_frameloaders.h"
+#include "tst_continuouslogger.h"
+#include "tst_dbcloader.h"
+#include "tst_signalexport.h"
 
 
 int main(int argc, char** argv)
@@ -15,6 +23,14 @@ int main(int argc, char** argv)
    };
 
    ASSERT_TEST(new TestLFQueue());
+   ASSERT_TEST(new TestSignalExtract());
+   ASSERT_TEST(new TestCANFrameStore());
+   ASSERT_TEST(new TestCANBinaryFile());
+   ASSERT_TEST(new TestCANCompressedFile());
+   ASSERT_TEST(new TestFrameLoaders());
+   ASSERT_TEST(new TestContinuousLogger());
+   ASSERT_TEST(new TestDBCLoader());
+   ASSERT_TEST(new TestSignalExport());
    ASSERT_TEST(new TestCanCon(CANCon::SOCKETCAN, "vcan0", 1));
 
    return status;
@@ -1,4 +1,4 @@
-QT += core gui serialbus widgets testlib serialbus
+QT += core gui serialbus widgets testlib serialbus concurrent
 
 
 CONFIG += c++11
@@ -9,6 +9,25 @@ SOURCES += \
     tst_lfqueue.cpp \
     main.cpp \
     tst_cancon.cpp \
+    tst_signalextract.cpp \
+    tst_canframestore.cpp \
+    ../canframestore.cpp \
+    ../lazyframefile.cpp \
+    tst_canbinaryfile.cpp \
+    ../canbinaryfile.cpp \
+    tst_cancompressedfile.cpp \
+    ../cancompressedfile.cpp \
+    tst_frameloaders.cpp \
+    ../framefileio.cpp \
+    tst_continuouslogger.cpp \
+    ../continuouslogger.cpp \
+    tst_dbcloader.cpp \
+    ../dbc/dbc_classes.cpp \
+    ../dbc/dbchandler.cpp \
+    ../dbc/dbccache.cpp \
+    tst_signalexport.cpp \
+    ../signalexport.cpp \
+    ../utility.cpp \
     ../connections/canconfactory.cpp \
     ../connections/canconnection.cpp \
     ../connections/gvretserial.cpp \
@@ -23,8 +42,31 @@ target.path= .
 INSTALLS += target
 
 HEADERS += \
+    testframes.h \
     tst_lfqueue.h \
     tst_cancon.h \
+    tst_signalextract.h \
+    tst_canframestore.h \
+    ../canframestore.h \
+    ../lazyframefile.h \
+    ../framelineformat.h \
+    tst_canbinaryfile.h \
+    ../canbinaryfile.h \
+    tst_cancompressedfile.h \
+    ../cancompressedfile.h \
+    tst_frameloaders.h \
+    ../framefileio.h \
+    tst_continuouslogger.h \
+    ../continuouslogger.h \
+    tst_dbcloader.h \
+    ../dbc/dbc_classes.h \
+    ../dbc/dbchandler.h \
+    ../dbc/dbccache.h \
+    tst_signalexport.h \
+    ../signalexport.h \
+    ../utils/textscanner.h \
+    ../utils/textwriter.h \
+    ../utility.h \
     ../connections/canconconst.h \
     ../connections/canconfactory.h \
     ../connections/canconnection.h \
@@ -0,0 +1,24 @@
+#ifndef TESTFRAMES_H
+#define TESTFRAMES_H
+
+#include "can_structs.h"
+
+/*
+ * Frames shared by the log file tests. Frame i is stamped i+1 ms so every format can represent it exactly,
+ * cycles through sixteen standard IDs and has a payload that tells it apart from its neighbours.
+ */
+static inline CANFrame makeFrame(int i)
+{
+    CANFrame frame;
+    frame.ID            = 0x100 + (i % 16);
+    frame.extended      = false;
+    frame.isReceived    = true;
+    frame.bus           = 0;
+    frame.len           = 8;
+    frame.timestamp     = 1000 * (quint64) (i + 1);
+    for(int b=0 ; b<8 ; b++)
+        frame.data[b] = (uchar) (i + b);
+    return frame;
+}
+
+#endif // TESTFRAMES_H
@@ -0,0 +1,106 @@
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "canbinaryfile.h"
+#include "tst_canbinaryfile.h"
+
+
+
+static QVector<CANFrame> makeFrames(int num)
+{
+    QVector<CANFrame> frames;
+    for(int i=0 ; i<num ; i++) {
+        CANFrame frame;
+        frame.ID            = (i % 3) ? 0x100 + (i % 7) : 0x18FEF100;
+        frame.extended      = frame.ID > 0x7FF;
+        frame.isReceived    = (i & 1);
+        frame.bus           = i % 2;
+        frame.len           = i % 9;
+        frame.timestamp     = 1000 * (quint64) i;
+        for(int b=0 ; b<8 ; b++)
+            frame.data[b] = (uchar) (i * 8 + b);
+        frames.append(frame);
+    }
+    return frames;
+}
+
+
+void TestCANBinaryFile::roundTrip()
+{
+    QTemporaryDir dir;
+    QString name = dir.path() + "/roundtrip.scb";
+    QVector<CANFrame> frames = makeFrames(1000);
+    CANFrameView view(&frames);
+
+    QVERIFY(CANBinaryFile::write(name, &view));
+    QVERIFY(CANBinaryFile::isBinaryFile(name));
+
+    CANBinaryFile file;
+    QVERIFY(file.open(name));
+    QCOMPARE(file.count(), frames.count());
+    QVERIFY(file.isMonotonic());
+
+    for(int i=0 ; i<frames.count() ; i++) {
+        CANFrame frame = file.frameAt(i);
+        QCOMPARE(frame.ID, frames[i].ID);
+        QCOMPARE(frame.extended, frames[i].extended);
+        QCOMPARE(frame.isReceived, frames[i].isReceived);
+        QCOMPARE(frame.bus, frames[i].bus);
+        QCOMPARE(frame.len, frames[i].len);
+        QCOMPARE(frame.timestamp, frames[i].timestamp);
+        QVERIFY(memcmp(frame.data, frames[i].data, 8) == 0);
+    }
+}
+
+
+void TestCANBinaryFile::index()
+{
+    QTemporaryDir dir;
+    QString name = dir.path() + "/index.scb";
+    int num = CANBIN_CHECKPOINT_INTERVAL * 2 + 100;
+    QVector<CANFrame> frames = makeFrames(num);
+    CANFrameView view(&frames);
+
+    QVERIFY(CANBinaryFile::write(name, &view));
+
+    CANBinaryFile file;
+    QVERIFY(file.open(name));
+    QCOMPARE(file.getCheckpoints().count(), 3);
+
+    /* IDs come back sorted with counts adding up to the whole file */
+    int total = 0;
+    uint32_t lastID = 0;
+    foreach(const CANBinaryIDEntry& entry, file.getIDIndex()) {
+        QVERIFY(entry.ID >= lastID);
+        lastID = entry.ID;
+        total += entry.count;
+    }
+    QCOMPARE(total, num);
+
+    QCOMPARE(file.findRecordAtTime(0), 0);
+    QCOMPARE(file.findRecordAtTime(1000 * 70000), 70000);
+    QCOMPARE(file.findRecordAtTime(1000 * 70000 - 1), 70000);
+    QCOMPARE(file.findRecordAtTime(1000 * (quint64) num), num);
+}
+
+
+/* a file whose writer died half way still gives up its complete records */
+void TestCANBinaryFile::truncated()
+{
+    QTemporaryDir dir;
+    QString name = dir.path() + "/truncated.scb";
+    QVector<CANFrame> frames = makeFrames(100);
+    CANFrameView view(&frames);
+
+    QVERIFY(CANBinaryFile::write(name, &view));
+
+    QFile raw(name);
+    QVERIFY(raw.open(QIODevice::ReadWrite));
+    QVERIFY(raw.resize(CANBIN_HEADER_SIZE + 50 * CANBIN_RECORD_SIZE + 10));
+    raw.close();
+
+    CANBinaryFile file;
+    QVERIFY(file.open(name));
+    QCOMPARE(file.count(), 50);
+    QCOMPARE(file.frameAt(49).timestamp, frames[49].timestamp);
+}
@@ -0,0 +1,17 @@
+#ifndef TST_CANBINARYFILE_H
+#define TST_CANBINARYFILE_H
+
+#include <QObject>
+
+class TestCANBinaryFile: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void roundTrip();
+    void index();
+    void truncated();
+};
+
+#endif // TST_CANBINARYFILE_H
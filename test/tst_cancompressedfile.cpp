@@ -0,0 +1,176 @@
+#include <QtTest>
+#include <QFileInfo>
+
+#include "cancompressedfile.h"
+#include "framefileio.h"
+#include "tst_cancompressedfile.h"
+
+
+/*
+ * Looks like a fleet capture: a handful of IDs at fixed periods with a bit of jitter, most payloads
+ * unchanged from one frame to the next and a counter in some of them.
+ */
+static QVector<CANFrame> makeFrames(int num)
+{
+    QVector<CANFrame> frames;
+    for(int i=0 ; i<num ; i++) {
+        CANFrame frame;
+        int stream          = i % 12;
+        frame.ID            = (stream < 9) ? 0x100 + stream * 0x10 : 0x18FEF100 + stream;
+        frame.extended      = frame.ID > 0x7FF;
+        frame.isReceived    = true;
+        frame.bus           = stream & 1;
+        frame.len           = (stream == 5) ? 3 : 8;
+        frame.timestamp     = 10000 * (quint64) (i / 12) + stream * 100 + (i % 7);
+        for(int b=0 ; b<8 ; b++)
+            frame.data[b] = (b < (int) frame.len) ? (uchar) (stream * 8 + b) : 0;
+        if(stream < 4)
+            frame.data[0] = (uchar) (i / 12);
+        frames.append(frame);
+    }
+    return frames;
+}
+
+
+static bool sameFrames(const QVector<CANFrame>& a, const QVector<CANFrame>& b)
+{
+    if(a.count() != b.count())
+        return false;
+    for(int i=0 ; i<a.count() ; i++) {
+        if(a[i].ID != b[i].ID || a[i].extended != b[i].extended || a[i].isReceived != b[i].isReceived
+                || a[i].bus != b[i].bus || a[i].len != b[i].len || a[i].timestamp != b[i].timestamp
+                || memcmp(a[i].data, b[i].data, a[i].len) != 0)
+            return false;
+    }
+    return true;
+}
+
+
+void TestCANCompressedFile::roundTrip()
+{
+    QString name = dir.path() + "/roundtrip.scz";
+    QVector<CANFrame> frames = makeFrames(CANCMP_BLOCK_FRAMES * 3 + 10);
+    frames[100].timestamp = 5; //one going backwards has to survive too
+    CANFrameView view(&frames);
+
+    QVERIFY(CANCompressedFile::write(name, &view));
+    QVERIFY(CANCompressedFile::isCompressedFile(name));
+
+    QVector<CANFrame> loaded;
+    QVERIFY(FrameFileIO::loadCompressedFile(name, &loaded));
+    QVERIFY(sameFrames(loaded, frames));
+
+    CANCompressedFile file;
+    QVERIFY(file.open(name));
+    QVERIFY(!file.isMonotonic());
+    QCOMPARE(file.getBlocks().count(), 4);
+}
+
+
+/* any block can be decoded without touching the ones before it, and found by time */
+void TestCANCompressedFile::blocksStandAlone()
+{
+    QString name = dir.path() + "/blocks.scz";
+    QVector<CANFrame> frames = makeFrames(CANCMP_BLOCK_FRAMES * 4);
+    CANFrameView view(&frames);
+    QVERIFY(CANCompressedFile::write(name, &view));
+
+    CANCompressedFile file;
+    QVERIFY(file.open(name));
+    QVERIFY(file.isMonotonic());
+    QCOMPARE(file.count(), frames.count());
+
+    const CANCompressedBlock& block = file.getBlocks()[2];
+    QCOMPARE(file.findBlockAtTime(frames[block.firstFrame + 5].timestamp), 2);
+
+    QVector<CANFrame> decoded(block.numFrames);
+    QVERIFY(file.decodeBlock(2, decoded.data()));
+    QVERIFY(sameFrames(decoded, frames.mid(block.firstFrame, block.numFrames)));
+}
+
+
+/* a file cut off in the middle of a block still loads every block before it */
+void TestCANCompressedFile::truncated()
+{
+    QString name = dir.path() + "/truncated.scz";
+    QVector<CANFrame> frames = makeFrames(CANCMP_BLOCK_FRAMES * 2 + 100);
+    CANFrameView view(&frames);
+    QVERIFY(CANCompressedFile::write(name, &view));
+
+    CANCompressedFile file;
+    QVERIFY(file.open(name));
+    qint64 cut = file.getBlocks()[2].offset - 10;
+    file.close();
+
+    QFile raw(name);
+    QVERIFY(raw.open(QIODevice::ReadWrite));
+    QVERIFY(raw.resize(cut));
+    raw.close();
+
+    QVector<CANFrame> loaded;
+    QVERIFY(FrameFileIO::loadCompressedFile(name, &loaded));
+    QCOMPARE(loaded.count(), CANCMP_BLOCK_FRAMES);
+    QVERIFY(sameFrames(loaded, frames.mid(0, CANCMP_BLOCK_FRAMES)));
+}
+
+
+void TestCANCompressedFile::streamingWriter()
+{
+    QString name = dir.path() + "/streamed.scz";
+    QVector<CANFrame> frames = makeFrames(CANCMP_BLOCK_FRAMES + 500);
+
+    CANCompressedWriter writer;
+    QVERIFY(writer.open(name));
+    foreach(const CANFrame& frame, frames)
+        QVERIFY(writer.append(frame));
+    QCOMPARE(writer.framesPending(), 500);
+    QVERIFY(writer.close());
+    QCOMPARE(writer.framesWritten(), (quint64) frames.count());
+
+    QVector<CANFrame> loaded;
+    QVERIFY(FrameFileIO::loadCompressedFile(name, &loaded));
+    QVERIFY(sameFrames(loaded, frames));
+}
+
+
+void TestCANCompressedFile::compareWithCSV_data()
+{
+    QTest::addColumn<bool>("compressed");
+
+    QTest::newRow("csv")        << false;
+    QTest::newRow("compressed") << true;
+}
+
+
+/*
+ * The point of the format: much smaller than the GVRET csv of the same capture, and quicker to load back.
+ * Each row times one of the two loaders on the same frames so the benchmark results can be compared.
+ */
+void TestCANCompressedFile::compareWithCSV()
+{
+    QFETCH(bool, compressed);
+    QString csvName = dir.path() + "/compare.csv";
+    QString packedName = dir.path() + "/compare.scz";
+    QVector<CANFrame> frames = makeFrames(CANCMP_BLOCK_FRAMES * 8);
+    CANFrameView view(&frames);
+
+    QVERIFY(FrameFileIO::saveNativeCSVFile(csvName, &view));
+    QVERIFY(CANCompressedFile::write(packedName, &view));
+    QVERIFY(QFileInfo(packedName).size() * 10 < QFileInfo(csvName).size());
+
+    QVector<CANFrame> loaded;
+    if(compressed) {
+        QBENCHMARK {
+            loaded.clear();
+            QVERIFY(FrameFileIO::loadCompressedFile(packedName, &loaded));
+        }
+        QVERIFY(sameFrames(loaded, frames));
+    }
+    else {
+        QBENCHMARK {
+            loaded.clear();
+            QVERIFY(FrameFileIO::loadNativeCSVFile(csvName, &loaded));
+        }
+        QCOMPARE(loaded.count(), frames.count());
+    }
+}
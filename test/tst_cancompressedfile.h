@@ -0,0 +1,22 @@
+#ifndef TST_CANCOMPRESSEDFILE_H
+#define TST_CANCOMPRESSEDFILE_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+class TestCANCompressedFile: public QObject
+{
+    Q_OBJECT
+private:
+    QTemporaryDir dir;
+
+private slots:
+    void roundTrip();
+    void blocksStandAlone();
+    void truncated();
+    void streamingWriter();
+    void compareWithCSV_data();
+    void compareWithCSV();
+};
+
+#endif // TST_CANCOMPRESSEDFILE_H
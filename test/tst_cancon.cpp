@@ -263,9 +263,16 @@ void TestCanCon::write()
     CANConnection* conn_p;
     QVERIFY(pCreate(conn_p));
 
+    QSignalSpy spy(conn_p, SIGNAL(status(CANCon::status)));
+
     /* start connection */
     conn_p->start();
 
+    /* frames are refused until the device is connected */
+    for(int i=0 ; (spy.count() != 1) && (i < 10) ; i++)
+        QTest::qWait(500);
+    QCOMPARE(conn_p->getStatus(), CANCon::CONNECTED);
+
     /* configure */
     QVERIFY(pConfig(conn_p));
 
@@ -0,0 +1,121 @@
+#include <QtTest>
+
+#include "canframestore.h"
+#include "tst_canframestore.h"
+
+
+
+static CANFrame makeFrame(int idx)
+{
+    CANFrame frame;
+    frame.ID        = idx & 0x7FF;
+    frame.timestamp = idx;
+    frame.len       = 8;
+    return frame;
+}
+
+
+/* frames straddling chunk boundaries must come back in order and keep their address */
+void TestCANFrameStore::appendAcrossChunks()
+{
+    CANFrameStore store;
+    int num = CANFrameStore::CHUNK_SIZE * 2 + 10;
+
+    store.append(makeFrame(0));
+    const CANFrame* firstFrame = &store.at(0);
+
+    for(int i=1 ; i<num ; i++)
+        store.append(makeFrame(i));
+
+    QCOMPARE(store.count(), num);
+    QCOMPARE(&store.at(0), firstFrame);
+    for(int i=0 ; i<num ; i++)
+        QCOMPARE((int) store.at(i).timestamp, i);
+
+    store[num-1].ID = 0x123;
+    QCOMPARE(store.at(num-1).ID, (uint32_t) 0x123);
+}
+
+
+void TestCANFrameStore::truncate()
+{
+    CANFrameStore store;
+    int num = CANFrameStore::CHUNK_SIZE + 5;
+
+    for(int i=0 ; i<num ; i++)
+        store.append(makeFrame(i));
+
+    store.truncate(CANFrameStore::CHUNK_SIZE);
+    QCOMPARE(store.count(), CANFrameStore::CHUNK_SIZE);
+
+    /* appending again has to start a fresh chunk */
+    store.append(makeFrame(42));
+    QCOMPARE(store.count(), CANFrameStore::CHUNK_SIZE + 1);
+    QCOMPARE((int) store.at(CANFrameStore::CHUNK_SIZE).timestamp, 42);
+
+    store.truncate(0);
+    QVERIFY(store.isEmpty());
+    store.append(makeFrame(7));
+    QCOMPARE((int) store.at(0).timestamp, 7);
+}
+
+
+void TestCANFrameStore::rowView()
+{
+    CANFrameStore store;
+    QVector<quint32> rows;
+
+    for(int i=0 ; i<100 ; i++) {
+        store.append(makeFrame(i));
+        if(i % 3 == 0)
+            rows.append(i);
+    }
+
+    CANFrameView all(&store);
+    CANFrameView filtered(&store, &rows);
+
+    QCOMPARE(all.count(), 100);
+    QCOMPARE(filtered.count(), rows.count());
+    for(int i=0 ; i<filtered.count() ; i++) {
+        QCOMPARE((int) filtered.at(i).timestamp, i * 3);
+        QCOMPARE(filtered.storeIndex(i), i * 3);
+    }
+    QCOMPARE((int) filtered.last().timestamp, 99);
+
+    QVector<CANFrame> copy = filtered.toVector();
+    QCOMPARE(copy.count(), rows.count());
+    QCOMPARE((int) copy.at(1).timestamp, 3);
+
+    CANFrameView vecView(&copy);
+    QCOMPARE(vecView.count(), copy.count());
+    QCOMPARE((int) vecView.first().timestamp, 0);
+}
+
+
+void TestCANFrameStore::idBitset()
+{
+    CANIDBitset ids;
+
+    QVERIFY(!ids.test(0x100));
+    QVERIFY(!ids.test(0x1FFFFFFF));
+
+    ids.set(0x100, true);
+    ids.set(0x18FEF100, true);
+    ids.set(0x1FFFFFFF, true);
+    QVERIFY(ids.test(0x100));
+    QVERIFY(ids.test(0x18FEF100));
+    QVERIFY(ids.test(0x1FFFFFFF));
+    QVERIFY(!ids.test(0x101));
+    QVERIFY(!ids.test(0x18FEF101));
+
+    ids.set(0x100, false);
+    QVERIFY(!ids.test(0x100));
+    QVERIFY(ids.test(0x18FEF100));
+
+    /* clearing an ID in a page that was never used must not allocate or fail */
+    ids.set(0x0ABCDEF0, false);
+    QVERIFY(!ids.test(0x0ABCDEF0));
+
+    ids.clear();
+    QVERIFY(!ids.test(0x18FEF100));
+}
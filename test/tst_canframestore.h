@@ -0,0 +1,18 @@
+#ifndef TST_CANFRAMESTORE_H
+#define TST_CANFRAMESTORE_H
+
+#include <QObject>
+
+class TestCANFrameStore: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void appendAcrossChunks();
+    void truncate();
+    void rowView();
+    void idBitset();
+};
+
+#endif // TST_CANFRAMESTORE_H
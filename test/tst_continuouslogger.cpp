@@ -0,0 +1,139 @@
+#include <QtTest>
+#include <QDir>
+
+#include "continuouslogger.h"
+#include "canbinaryfile.h"
+#include "framefileio.h"
+#include "tst_continuouslogger.h"
+#include "testframes.h"
+
+
+#define NUM_FRAMES  50000
+#define BATCH_SIZE  100
+
+
+/* hands frames over in batches the way CANConManager does */
+static void feedFrames(ContinuousLogger& logger)
+{
+    QVector<CANFrame> batch;
+    for(int i=0 ; i<NUM_FRAMES ; i++) {
+        batch.append(makeFrame(i));
+        if(batch.count() == BATCH_SIZE) {
+            logger.framesReceived(NULL, batch);
+            batch.clear();
+        }
+    }
+    if(!batch.isEmpty())
+        logger.framesReceived(NULL, batch);
+}
+
+
+static bool checkFrames(const QVector<CANFrame>& frames, int first = 0)
+{
+    for(int i=0 ; i<frames.count() ; i++) {
+        CANFrame expected = makeFrame(first + i);
+        const CANFrame& frame = frames[i];
+        if(frame.ID != expected.ID || frame.len != expected.len || frame.timestamp != expected.timestamp
+                || memcmp(frame.data, expected.data, 8) != 0)
+            return false;
+    }
+    return true;
+}
+
+
+void TestContinuousLogger::csvLine()
+{
+    CANFrame frame = makeFrame(0);
+    frame.ID = 0x18DAF110;
+    frame.extended = true;
+    frame.bus = 1;
+    frame.len = 3;
+
+    char line[LOGGER_MAX_LINE];
+    int len = ContinuousLogger::formatCSVLine(frame, line);
+    QCOMPARE(QByteArray(line, len), QByteArray("1000,18DAF110,true,Rx,1,3,00,01,02,00,00,00,00,00,\n"));
+}
+
+
+void TestContinuousLogger::csvLog()
+{
+    QString name = dir.path() + "/continuous.csv";
+    ContinuousLogger logger;
+    QVERIFY(logger.startLogging(name, ContinuousLogger::FORMAT_CSV));
+    feedFrames(logger);
+    logger.stopLogging();
+
+    QCOMPARE(logger.getFramesWritten() + logger.getFramesDropped(), (quint64) NUM_FRAMES);
+    QVector<CANFrame> frames;
+    QVERIFY(FrameFileIO::loadNativeCSVFile(name, &frames));
+    QCOMPARE((quint64) frames.count(), logger.getFramesWritten());
+    if(logger.getFramesDropped() == 0)
+        QVERIFY(checkFrames(frames));
+}
+
+
+void TestContinuousLogger::binaryLog()
+{
+    QString name = dir.path() + "/continuous.sbin";
+    ContinuousLogger logger;
+    QVERIFY(logger.startLogging(name, ContinuousLogger::FORMAT_BINARY));
+    feedFrames(logger);
+    logger.stopLogging();
+
+    CANBinaryFile file;
+    QVERIFY(file.open(name));
+    QCOMPARE((quint64) file.count(), logger.getFramesWritten());
+    if(logger.getFramesDropped() == 0) {
+        QVector<CANFrame> frames(file.count());
+        QCOMPARE(file.readFrames(0, file.count(), frames.data()), file.count());
+        QVERIFY(checkFrames(frames));
+    }
+}
+
+
+/* every frame has to end up in exactly one of the rolled over files, in order */
+void TestContinuousLogger::rotateBySize()
+{
+    QDir rotateDir(dir.path() + "/rotate");
+    QVERIFY(rotateDir.mkpath("."));
+    ContinuousLogger logger;
+    QVERIFY(logger.startLogging(rotateDir.filePath("log.csv"), ContinuousLogger::FORMAT_CSV, 256 * 1024));
+    feedFrames(logger);
+    logger.stopLogging();
+    QVERIFY(logger.getFramesDropped() == 0);
+
+    QString name = rotateDir.filePath("log.csv");
+    QVector<CANFrame> all;
+    for(int n=1 ; QFile::exists(name) ; n++) {
+        QVector<CANFrame> frames;
+        QVERIFY(FrameFileIO::loadNativeCSVFile(name, &frames));
+        all += frames;
+        name = rotateDir.filePath(QString("log_%1.csv").arg(n));
+    }
+    QVERIFY(rotateDir.count() > 3);
+    QCOMPARE(all.count(), NUM_FRAMES);
+    QVERIFY(checkFrames(all));
+}
+
+
+/* a rolled over file that can't be created stops the log with the reason instead of dropping everything after it */
+void TestContinuousLogger::rotateOpenFails()
+{
+    QDir failDir(dir.path() + "/rotatefail");
+    QVERIFY(failDir.mkpath("log_1.csv")); /* a directory where the second file should go */
+    ContinuousLogger logger;
+    QSignalSpy failed(&logger, SIGNAL(loggingFailed()));
+    QVERIFY(logger.startLogging(failDir.filePath("log.csv"), ContinuousLogger::FORMAT_CSV, 256 * 1024));
+    feedFrames(logger);
+    logger.stopLogging();
+
+    QCOMPARE(failed.count(), 1);
+    QVERIFY(logger.hasFailed());
+    QVERIFY(!logger.isLogging());
+    QVERIFY(logger.getFailure().contains("log_1.csv"));
+
+    QVector<CANFrame> frames;
+    QVERIFY(FrameFileIO::loadNativeCSVFile(failDir.filePath("log.csv"), &frames));
+    QVERIFY(frames.count() > 0 && frames.count() < NUM_FRAMES);
+    QCOMPARE((quint64) frames.count(), logger.getFramesWritten());
+}
@@ -0,0 +1,21 @@
+#ifndef TST_CONTINUOUSLOGGER_H
+#define TST_CONTINUOUSLOGGER_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+class TestContinuousLogger: public QObject
+{
+    Q_OBJECT
+private:
+    QTemporaryDir dir;
+
+private slots:
+    void csvLine();
+    void csvLog();
+    void binaryLog();
+    void rotateBySize();
+    void rotateOpenFails();
+};
+
+#endif // TST_CONTINUOUSLOGGER_H
@@ -0,0 +1,414 @@
+#include <QtTest>
+#include <QFile>
+
+#include "dbc/dbchandler.h"
+#include "dbc/dbccache.h"
+#include "tst_dbcloader.h"
+
+
+static QString writeDBC(const QString& name, const char* text)
+{
+    QFile file(name);
+    if(!file.open(QIODevice::WriteOnly))
+        return QString();
+    file.write(text);
+    return name;
+}
+
+
+static const char* MUX_DBC =
+    "BU_: ECU Tester\n"
+    "BO_ 2364540160 Muxed: 8 ECU\n"
+    " SG_ Selector M : 0|8@1+ (1,0) [0|255] \"\" Tester\n"
+    " SG_ Temp m1 : 8|16@1- (0.1,-40) [-40|125] \"degC\" Tester,ECU\n"
+    " SG_ Volts m2 : 8|16@0+ (1E-3,0) [0|65.535] \"V\" Tester\n"
+    " SG_ Always : 56|8@1+ (1,0) [0|255] \"\" Vector__XXX\n";
+
+
+static int signalCount(DBCFile& dbc)
+{
+    int count = 0;
+    for(int i=0 ; i<dbc.messageHandler->getCount() ; i++)
+        count += dbc.messageHandler->findMsgByIdx(i)->sigHandler->getCount();
+    return count;
+}
+
+
+/* the same messages, signals and attributes, down to the value tables */
+static void compareFiles(DBCFile& a, DBCFile& b)
+{
+    QCOMPARE(b.dbc_nodes.count(), a.dbc_nodes.count());
+    QCOMPARE(b.dbc_attributes.count(), a.dbc_attributes.count());
+    for(int i=0 ; i<a.dbc_attributes.count() ; i++) {
+        QCOMPARE(b.dbc_attributes[i].name, a.dbc_attributes[i].name);
+        QCOMPARE(b.dbc_attributes[i].enumVals, a.dbc_attributes[i].enumVals);
+        QCOMPARE(b.dbc_attributes[i].defaultValue, a.dbc_attributes[i].defaultValue);
+    }
+
+    QCOMPARE(b.messageHandler->getCount(), a.messageHandler->getCount());
+    for(int m=0 ; m<a.messageHandler->getCount() ; m++) {
+        DBC_MESSAGE* msgA = a.messageHandler->findMsgByIdx(m);
+        DBC_MESSAGE* msgB = b.messageHandler->findMsgByIdx(m);
+        QCOMPARE(msgB->ID, msgA->ID);
+        QCOMPARE(msgB->name, msgA->name);
+        QCOMPARE(msgB->comment, msgA->comment);
+        QCOMPARE(msgB->len, msgA->len);
+        QCOMPARE(msgB->sender->name, msgA->sender->name);
+        QCOMPARE(msgB->bgColor, msgA->bgColor);
+        QCOMPARE(msgB->attributes.count(), msgA->attributes.count());
+        QCOMPARE(msgB->multiplexorSignal != NULL, msgA->multiplexorSignal != NULL);
+        QCOMPARE(b.messageHandler->findMsgByID(msgA->ID), b.messageHandler->findMsgByIdx(m));
+
+        QCOMPARE(msgB->sigHandler->getCount(), msgA->sigHandler->getCount());
+        for(int s=0 ; s<msgA->sigHandler->getCount() ; s++) {
+            DBC_SIGNAL* sigA = msgA->sigHandler->findSignalByIdx(s);
+            DBC_SIGNAL* sigB = msgB->sigHandler->findSignalByIdx(s);
+            QCOMPARE(sigB->name, sigA->name);
+            QCOMPARE(sigB->startBit, sigA->startBit);
+            QCOMPARE(sigB->signalSize, sigA->signalSize);
+            QCOMPARE(sigB->intelByteOrder, sigA->intelByteOrder);
+            QCOMPARE(sigB->valType, sigA->valType);
+            QCOMPARE(sigB->isMultiplexor, sigA->isMultiplexor);
+            QCOMPARE(sigB->isMultiplexed, sigA->isMultiplexed);
+            QCOMPARE(sigB->multiplexValue, sigA->multiplexValue);
+            QCOMPARE(sigB->factor, sigA->factor);
+            QCOMPARE(sigB->bias, sigA->bias);
+            QCOMPARE(sigB->min, sigA->min);
+            QCOMPARE(sigB->max, sigA->max);
+            QCOMPARE(sigB->unitName, sigA->unitName);
+            QCOMPARE(sigB->comment, sigA->comment);
+            QCOMPARE(sigB->receiver->name, sigA->receiver->name);
+            QCOMPARE(sigB->parentMessage, msgB);
+            QCOMPARE(sigB->attributes.count(), sigA->attributes.count());
+            QCOMPARE(sigB->valList.count(), sigA->valList.count());
+            for(int v=0 ; v<sigA->valList.count() ; v++) {
+                QCOMPARE(sigB->valList[v].value, sigA->valList[v].value);
+                QCOMPARE(sigB->valList[v].descript, sigA->valList[v].descript);
+            }
+        }
+    }
+}
+
+
+void TestDBCLoader::initTestCase()
+{
+    /* keeps the cache entries out of the real cache directory */
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+
+void TestDBCLoader::examples_data()
+{
+    QTest::addColumn<QString>("name");
+    QTest::addColumn<int>("messages");
+    QTest::addColumn<int>("sigs");
+
+    QTest::newRow("LeafPowertrainBus") << "LeafPowertrainBus.dbc"  << 10  << 21;
+    QTest::newRow("ThinkCity")         << "ThinkCity.dbc"          << 501 << 548;
+    QTest::newRow("bms")               << "bms.dbc"                << 6   << 30;
+}
+
+
+/* the example files load whole and clean */
+void TestDBCLoader::examples()
+{
+    QFETCH(QString, name);
+    QFETCH(int, messages);
+    QFETCH(int, sigs);
+
+    QString path = QFINDTESTDATA("../examples/" + name);
+    QVERIFY(!path.isEmpty());
+
+    DBCFile dbc;
+    dbc.loadFile(path);
+    QCOMPARE(dbc.getLoadErrors(), QStringList());
+    QCOMPARE(dbc.messageHandler->getCount(), messages);
+    QCOMPARE(signalCount(dbc), sigs);
+    QCOMPARE(dbc.getFilename(), name);
+}
+
+
+/* comments (one of them over several lines), value tables and attributes all end up where they belong */
+void TestDBCLoader::thinkCity()
+{
+    DBCFile dbc;
+    dbc.loadFile(QFINDTESTDATA("../examples/ThinkCity.dbc"));
+
+    DBC_MESSAGE* msg = dbc.messageHandler->findMsgByID(1091);
+    QVERIFY(msg);
+    QCOMPARE(msg->comment, QString("Period of transmission if node active: 200ms"));
+    QCOMPARE(msg->sender->name, QString("VCU"));
+    QVERIFY(msg->findAttrValByName("GenMsgCycleTime"));
+
+    DBC_SIGNAL* sig = msg->sigHandler->findSignalByName("VCUStoredBeltWarningLightSC");
+    QVERIFY(sig);
+    QCOMPARE(sig->startBit, 13);
+    QCOMPARE(sig->signalSize, 1);
+    QVERIFY(!sig->intelByteOrder);
+    QCOMPARE(sig->valType, UNSIGNED_INT);
+    QCOMPARE(sig->valList.count(), 2);
+    QCOMPARE(sig->valList[0].value, 1);
+    QCOMPARE(sig->valList[0].descript, QString("Error present"));
+    QVERIFY(sig->findAttrValByName("GenSigCycleTime"));
+    QCOMPARE(sig->findAttrValByName("GenSigCycleTime")->value.toInt(), 200);
+
+    DBC_ATTRIBUTE* sendType = dbc.findAttributeByName("GenMsgSendType");
+    QVERIFY(sendType);
+    QCOMPARE(sendType->valType, ENUM);
+    QCOMPARE(sendType->enumVals.count(), 10);
+    QCOMPARE(sendType->defaultValue.toInt(), 0);
+
+    DBC_NODE* node = dbc.findNodeByName("ZD");
+    QVERIFY(node);
+    QCOMPARE(node->comment, QString("Zebra Battery Display."));
+}
+
+
+void TestDBCLoader::multiplexing()
+{
+    QString path = writeDBC(dir.path() + "/mux.dbc", MUX_DBC);
+
+    DBCFile dbc;
+    dbc.loadFile(path);
+    QCOMPARE(dbc.getLoadErrors(), QStringList());
+
+    DBC_MESSAGE* msg = dbc.messageHandler->findMsgByID(0x0CF00400);
+    QVERIFY(msg);
+    QCOMPARE(msg->sigHandler->getCount(), 4);
+    QVERIFY(msg->multiplexorSignal);
+    QCOMPARE(msg->multiplexorSignal->name, QString("Selector"));
+
+    DBC_SIGNAL* temp = msg->sigHandler->findSignalByName("Temp");
+    QVERIFY(temp->isMultiplexed);
+    QCOMPARE(temp->multiplexValue, 1);
+    QCOMPARE(temp->valType, SIGNED_INT);
+    QVERIFY(temp->intelByteOrder);
+    QCOMPARE(temp->factor, 0.1);
+    QCOMPARE(temp->bias, -40.0);
+    QCOMPARE(temp->unitName, QString("degC"));
+    QCOMPARE(temp->receiver->name, QString("Tester"));
+
+    DBC_SIGNAL* volts = msg->sigHandler->findSignalByName("Volts");
+    QCOMPARE(volts->multiplexValue, 2);
+    QVERIFY(!volts->intelByteOrder);
+    QCOMPARE(volts->factor, 0.001);
+    QVERIFY(!msg->sigHandler->findSignalByName("Always")->isMultiplexed);
+}
+
+
+/* the message decoder gives what the signals give one at a time, whichever group the multiplexor picks */
+void TestDBCLoader::decoder()
+{
+    QString path = writeDBC(dir.path() + "/mux.dbc", MUX_DBC);
+
+    DBCFile dbc;
+    dbc.loadFile(path);
+    DBC_MESSAGE* msg = dbc.messageHandler->findMsgByID(0x0CF00400);
+    QVERIFY(msg);
+    QCOMPARE(msg->getDecoder().getCount(), 4);
+
+    CANFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.len = 8;
+    frame.data[1] = 0x58;
+    frame.data[2] = 0x02;
+    frame.data[7] = 9;
+
+    QVector<double> values(4);
+    QVector<bool> valid(4);
+    QVector<QString> texts(4);
+    QVector<bool> textValid(4);
+    for(int selector=0 ; selector<4 ; selector++) {
+        frame.data[0] = selector;
+        const DBCMessageDecoder& decoder = msg->getDecoder();
+        int decoded = decoder.decode(frame, values.data(), valid.data());
+        QCOMPARE(decoder.decodeText(frame, texts.data(), textValid.data()), decoded);
+        QCOMPARE(decoded, (selector == 1 || selector == 2) ? 3 : 2);
+
+        for(int i=0 ; i<decoder.getCount() ; i++) {
+            DBC_SIGNAL* sig = decoder.getSignal(i);
+            double value;
+            QString text;
+            QCOMPARE(valid[i], sig->processAsDouble(frame, value));
+            QCOMPARE(textValid[i], sig->processAsText(frame, text));
+            if(valid[i]) {
+                QCOMPARE(values[i], value);
+                QCOMPARE(texts[i], text);
+            }
+        }
+    }
+
+    frame.data[0] = 1;
+    msg->getDecoder().decode(frame, values.data(), valid.data());
+    QVERIFY(valid[1]);
+    QCOMPARE(values[1], 20.0);
+    QCOMPARE(values[3], 9.0);
+
+    /* moving a signal to another group is picked up */
+    msg->sigHandler->findSignalByName("Volts")->multiplexValue = 1;
+    QVERIFY(!msg->decoder.isFor(msg));
+    QCOMPARE(msg->getDecoder().decode(frame, values.data(), valid.data()), 4);
+}
+
+
+/* value lists give the first description listed for a value, whether the values are close together or spread out */
+void TestDBCLoader::valueTable()
+{
+    DBC_SIGNAL gear;
+    gear.name = "Gear";
+    for(int i=0 ; i<10 ; i++) {
+        DBC_VAL_ENUM_ENTRY val;
+        val.value = 9 - i;
+        val.descript = QString("G%1").arg(9 - i);
+        gear.valList.append(val);
+    }
+    DBC_VAL_ENUM_ENTRY again;
+    again.value = 3;
+    again.descript = "Again";
+    gear.valList.append(again);
+
+    QString text;
+    for(int i=0 ; i<10 ; i++) {
+        gear.formatValue(i, text);
+        QCOMPARE(text, QString("Gear: G%1").arg(i));
+    }
+    gear.formatValue(-1, text);
+    QCOMPARE(text, QString("Gear: -1"));
+    gear.formatValue(12.5, text);
+    QCOMPARE(text, QString("Gear: 12.5"));
+
+    /* edits to the signal are picked up */
+    gear.valList[0].descript = "Top";
+    gear.unitName = "th";
+    gear.formatValue(9, text);
+    QCOMPARE(text, QString("Gear: Top"));
+    gear.formatValue(10, text);
+    QCOMPARE(text, QString("Gear: 10th"));
+
+    DBC_SIGNAL dtc;
+    dtc.name = "DTC";
+    for(int i=0 ; i<200 ; i++) {
+        DBC_VAL_ENUM_ENTRY val;
+        val.value = (i - 100) * 0x10001;
+        val.descript = QString("Code%1").arg(i);
+        dtc.valList.append(val);
+    }
+    for(int i=0 ; i<200 ; i++) {
+        QVERIFY(dtc.getValueTable().findText((i - 100) * 0x10001));
+        dtc.formatValue((i - 100) * 0x10001, text);
+        QCOMPARE(text, QString("DTC: Code%1").arg(i));
+        QVERIFY(!dtc.getValueTable().findText((i - 100) * 0x10001 + 1));
+    }
+    QVERIFY(!dtc.getValueTable().findText(INT64_MAX));
+}
+
+
+/* bad statements are left out with their line number and don't take the good ones around them along */
+void TestDBCLoader::errors()
+{
+    QString path = writeDBC(dir.path() + "/errors.dbc",
+        "BU_: ECU\n"                                            /* 1 */
+        "BO_ 100 First: 8 ECU\n"                                /* 2 */
+        " SG_ Good : 0|8@1+ (1,0) [0|255] \"\" ECU\n"           /* 3 */
+        " SG_ BadOrder : 8|8@7+ (1,0) [0|255] \"\" ECU\n"       /* 4 */
+        " SG_ BadRange : 16|8@1+ (1,0) [0|x] \"\" ECU\n"        /* 5 */
+        "BO_ 200 Second: 8 ECU\n"                               /* 6 */
+        " SG_ Other : 0|8@1+ (1,0) [0|255] \"\" ECU\n"          /* 7 */
+        "CM_ BO_ 300 \"no such message\";\n"                    /* 8 */
+        "CM_ SG_ 100 Missing \"no such signal\";\n"             /* 9 */
+        "BA_ \"Undefined\" BO_ 100 1;\n"                        /* 10 */
+        "VAL_ 100 Good 0 \"Off\" 1 \"On\"\n"                    /* 11, no ; */
+        "CM_ BO_ 200 \"still read\";\n");                       /* 12 */
+
+    DBCFile dbc;
+    dbc.loadFile(path);
+
+    QStringList errors = dbc.getLoadErrors();
+    QCOMPARE(errors.count(), 6);
+    QStringList lines;
+    foreach(QString error, errors)
+        lines << error.section(':', 0, 0);
+    lines.sort();
+    QCOMPARE(lines, QStringList() << "line 10" << "line 11" << "line 4" << "line 5" << "line 8" << "line 9");
+
+    DBC_MESSAGE* first = dbc.messageHandler->findMsgByID(100);
+    QCOMPARE(first->sigHandler->getCount(), 1);
+    QVERIFY(first->sigHandler->findSignalByName("Good")->valList.isEmpty());
+    QCOMPARE(dbc.messageHandler->findMsgByID(200)->sigHandler->getCount(), 1);
+    QCOMPARE(dbc.messageHandler->findMsgByID(200)->comment, QString("still read"));
+}
+
+
+/* a cached copy comes back the same as the parsed file, and stops being used once the source changes */
+void TestDBCLoader::cache()
+{
+    QString path = dir.path() + "/cached.dbc";
+    QVERIFY(QFile::copy(QFINDTESTDATA("../examples/ThinkCity.dbc"), path));
+
+    DBCFile parsed;
+    parsed.loadFile(path);
+    QVERIFY(DBCCache::save(path, parsed));
+
+    DBCFile cached;
+    QVERIFY(DBCCache::load(path, cached));
+    compareFiles(parsed, cached);
+    QCOMPARE(cached.getFilename(), QString("cached.dbc"));
+
+    /* multiplexors have to point into the restored signals */
+    QString muxPath = writeDBC(dir.path() + "/cachedmux.dbc", MUX_DBC);
+    DBCFile muxParsed;
+    muxParsed.loadFile(muxPath);
+    QVERIFY(DBCCache::save(muxPath, muxParsed));
+    DBCFile muxCached;
+    QVERIFY(DBCCache::load(muxPath, muxCached));
+    compareFiles(muxParsed, muxCached);
+    QCOMPARE(muxCached.messageHandler->findMsgByIdx(0)->multiplexorSignal,
+             muxCached.messageHandler->findMsgByIdx(0)->sigHandler->findSignalByName("Selector"));
+
+    QFile source(path);
+    QVERIFY(source.open(QIODevice::Append));
+    source.write("\nCM_ BO_ 1091 \"changed\";\n");
+    source.close();
+
+    DBCFile stale;
+    QVERIFY(!DBCCache::load(path, stale));
+    QCOMPARE(stale.messageHandler->getCount(), 0);
+}
+
+
+void TestDBCLoader::loadSpeed_data()
+{
+    QTest::addColumn<QString>("name");
+    QTest::addColumn<bool>("cached");
+
+    QTest::newRow("LeafPowertrainBus")          << "LeafPowertrainBus.dbc"  << false;
+    QTest::newRow("ThinkCity")                  << "ThinkCity.dbc"          << false;
+    QTest::newRow("bms")                        << "bms.dbc"                << false;
+    QTest::newRow("LeafPowertrainBus cached")   << "LeafPowertrainBus.dbc"  << true;
+    QTest::newRow("ThinkCity cached")           << "ThinkCity.dbc"          << true;
+    QTest::newRow("bms cached")                 << "bms.dbc"                << true;
+}
+
+
+void TestDBCLoader::loadSpeed()
+{
+    QFETCH(QString, name);
+    QFETCH(bool, cached);
+    QString path = QFINDTESTDATA("../examples/" + name);
+
+    if(cached) {
+        DBCFile parsed;
+        parsed.loadFile(path);
+        QVERIFY(DBCCache::save(path, parsed));
+        QBENCHMARK {
+            DBCFile dbc;
+            DBCCache::load(path, dbc);
+        }
+        return;
+    }
+
+    QBENCHMARK {
+        DBCFile dbc;
+        dbc.loadFile(path);
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef TST_DBCLOADER_H
+#define TST_DBCLOADER_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+class TestDBCLoader: public QObject
+{
+    Q_OBJECT
+private:
+    QTemporaryDir dir;
+
+private slots:
+    void initTestCase();
+    void examples_data();
+    void examples();
+    void thinkCity();
+    void multiplexing();
+    void decoder();
+    void valueTable();
+    void errors();
+    void cache();
+    void loadSpeed_data();
+    void loadSpeed();
+};
+
+#endif // TST_DBCLOADER_H
@@ -0,0 +1,357 @@
+#include <QtTest>
+#include <QFile>
+#include <QtConcurrent>
+
+#include "framefileio.h"
+#include "tst_frameloaders.h"
+#include "testframes.h"
+
+
+#define NUM_FRAMES 100000
+
+enum LogFormat
+{
+    NATIVE_CSV,
+    CRTD,
+    CANDUMP,
+    BUSMASTER
+};
+
+
+static QString writeLog(const QString& name, LogFormat format)
+{
+    QFile file(name);
+    if(!file.open(QIODevice::WriteOnly))
+        return QString();
+
+    char line[128];
+    if(format == NATIVE_CSV)
+        file.write("Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8\n");
+    else if(format == CRTD)
+        file.write("0.000000 CXX generated\n");
+    else if(format == BUSMASTER)
+        file.write("***<Time><Tx/Rx><Channel><CAN ID><Type><DLC><DataBytes>***\n");
+
+    for(int i=0 ; i<NUM_FRAMES ; i++) {
+        CANFrame frame = makeFrame(i);
+        quint64 secs = frame.timestamp / 1000000;
+        quint64 usecs = frame.timestamp % 1000000;
+        const uchar* d = frame.data;
+        switch(format) {
+        case NATIVE_CSV:
+            qsnprintf(line, sizeof(line), "%llu,%08X,false,Rx,0,8,%02X,%02X,%02X,%02X,%02X,%02X,%02X,%02X\n",
+                      frame.timestamp, frame.ID, d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+            break;
+        case CRTD:
+            qsnprintf(line, sizeof(line), "%llu.%06llu R11 %03X %02X %02X %02X %02X %02X %02X %02X %02X\n",
+                      secs, usecs, frame.ID, d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+            break;
+        case CANDUMP:
+            qsnprintf(line, sizeof(line), "(%llu.%06llu) can0 %03X#%02X%02X%02X%02X%02X%02X%02X%02X\n",
+                      secs, usecs, frame.ID, d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+            break;
+        case BUSMASTER:
+            qsnprintf(line, sizeof(line), "%llu:%llu:%llu:%llu Rx 1 0x%03X s 8 %02X %02X %02X %02X %02X %02X %02X %02X\n",
+                      secs / 3600, (secs / 60) % 60, secs % 60, usecs / 100,
+                      frame.ID, d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+            break;
+        }
+        file.write(line);
+    }
+    file.close();
+    return name;
+}
+
+
+static bool checkFrames(const QVector<CANFrame>& frames)
+{
+    if(frames.count() != NUM_FRAMES)
+        return false;
+    for(int i=0 ; i<NUM_FRAMES ; i++) {
+        CANFrame expected = makeFrame(i);
+        const CANFrame& frame = frames[i];
+        if(frame.ID != expected.ID || frame.len != expected.len || frame.timestamp != expected.timestamp
+                || frame.extended != expected.extended || frame.bus != expected.bus
+                || memcmp(frame.data, expected.data, 8) != 0)
+            return false;
+    }
+    return true;
+}
+
+
+void TestFrameLoaders::nativeCSV()
+{
+    QString name = writeLog(dir.path() + "/native.csv", NATIVE_CSV);
+    QVERIFY(!name.isEmpty());
+    QVector<CANFrame> frames;
+
+    QBENCHMARK {
+        frames.clear();
+        QVERIFY(FrameFileIO::loadNativeCSVFile(name, &frames));
+    }
+    QVERIFY(checkFrames(frames));
+}
+
+
+void TestFrameLoaders::crtd()
+{
+    QString name = writeLog(dir.path() + "/crtd.txt", CRTD);
+    QVERIFY(!name.isEmpty());
+    QVector<CANFrame> frames;
+
+    QBENCHMARK {
+        frames.clear();
+        QVERIFY(FrameFileIO::loadCRTDFile(name, &frames));
+    }
+    QVERIFY(checkFrames(frames));
+}
+
+
+void TestFrameLoaders::canDump()
+{
+    QString name = writeLog(dir.path() + "/candump.log", CANDUMP);
+    QVERIFY(!name.isEmpty());
+    QVector<CANFrame> frames;
+
+    QBENCHMARK {
+        frames.clear();
+        QVERIFY(FrameFileIO::loadCanDumpFile(name, &frames));
+    }
+    QVERIFY(checkFrames(frames));
+}
+
+
+void TestFrameLoaders::busMaster()
+{
+    QString name = writeLog(dir.path() + "/busmaster.log", BUSMASTER);
+    QVERIFY(!name.isEmpty());
+    QVector<CANFrame> frames;
+
+    QBENCHMARK {
+        frames.clear();
+        QVERIFY(FrameFileIO::loadLogFile(name, &frames));
+    }
+    QVERIFY(checkFrames(frames));
+}
+
+
+/* made up timestamps have to keep counting across the pieces of a parallel load */
+void TestFrameLoaders::untimedAcrossChunks()
+{
+    QString name = dir.path() + "/generic.csv";
+    QFile file(name);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("ID,Data\n");
+    int num = 1000000; //13MB, well past the size where loading goes parallel
+    for(int i=0 ; i<num ; i++)
+        file.write("7DF,02 01 0C\n");
+    file.close();
+
+    QVector<CANFrame> frames;
+    QVERIFY(FrameFileIO::loadGenericCSVFile(name, &frames));
+    QCOMPARE(frames.count(), num);
+    for(int i=1 ; i<num ; i++)
+        QCOMPARE(frames[i].timestamp - frames[i-1].timestamp, (quint64) 5000);
+    QCOMPARE(frames.last().len, 3u);
+}
+
+
+/* what the savers write has to come back the same through the matching loader */
+static void saveAndReload(const QString& name, FrameFileIO::SaveFunc saver, FrameFileIO::LoadFunc loader)
+{
+    QVector<CANFrame> frames;
+    for(int i=0 ; i<NUM_FRAMES ; i++)
+        frames.append(makeFrame(i));
+    CANFrameView view(&frames);
+
+    QBENCHMARK {
+        QVERIFY(saver(name, &view, NULL));
+    }
+
+    QVector<CANFrame> loaded;
+    QVERIFY(loader(name, &loaded, NULL));
+    QVERIFY(checkFrames(loaded));
+}
+
+
+void TestFrameLoaders::saveNativeCSV()
+{
+    saveAndReload(dir.path() + "/saved.csv", FrameFileIO::saveNativeCSVFile, FrameFileIO::loadNativeCSVFile);
+}
+
+
+void TestFrameLoaders::saveCRTD()
+{
+    saveAndReload(dir.path() + "/saved.txt", FrameFileIO::saveCRTDFile, FrameFileIO::loadCRTDFile);
+}
+
+
+void TestFrameLoaders::saveCanDump()
+{
+    saveAndReload(dir.path() + "/saved.log", FrameFileIO::saveCanDumpFile, FrameFileIO::loadCanDumpFile);
+}
+
+
+/* a file viewed in place has to give the same frames a load would, wherever they are read from */
+void TestFrameLoaders::viewFile()
+{
+    QString name = writeLog(dir.path() + "/viewed.csv", NATIVE_CSV);
+    QVERIFY(!name.isEmpty());
+
+    LazyFrameFile file;
+    QBENCHMARK {
+        QVERIFY(file.open(name, FrameFileIO::lineFormat(FrameFileIO::LINEFILE_NATIVE_CSV)));
+    }
+    QCOMPARE(file.count(), NUM_FRAMES);
+    QCOMPARE(file.getIDs().count(), 16);
+    QVERIFY(!file.hadErrors());
+
+    /* back to front so nearly every page has to be parsed again */
+    QVector<CANFrame> frames(NUM_FRAMES);
+    for(int i=NUM_FRAMES-1 ; i>=0 ; i--)
+        frames[i] = file.at(i);
+    QVERIFY(checkFrames(frames));
+
+    /* a run starting and ending part way through a page */
+    QVector<CANFrame> run(3 * LAZY_PAGE_FRAMES);
+    file.readFrames(LAZY_PAGE_FRAMES / 2, run.count(), run.data());
+    for(int i=0 ; i<run.count() ; i++)
+        QCOMPARE(run[i].timestamp, makeFrame(LAZY_PAGE_FRAMES / 2 + i).timestamp);
+
+    CANFrameView view(&file);
+    QCOMPARE(view.count(), NUM_FRAMES);
+    QCOMPARE(view.last().timestamp, makeFrame(NUM_FRAMES - 1).timestamp);
+}
+
+
+/* made up timestamps keep counting across pages and scan pieces when viewing too */
+void TestFrameLoaders::viewUntimed()
+{
+    QString name = dir.path() + "/viewed_generic.csv";
+    QFile out(name);
+    QVERIFY(out.open(QIODevice::WriteOnly));
+    out.write("ID,Data\n");
+    int num = 1000000;
+    for(int i=0 ; i<num ; i++)
+        out.write("7DF,02 01 0C\n");
+    out.close();
+
+    LazyFrameFile file;
+    QVERIFY(file.open(name, FrameFileIO::lineFormat(FrameFileIO::LINEFILE_GENERIC_CSV)));
+    QCOMPARE(file.count(), num);
+    quint64 first = file.at(0).timestamp;
+    for(int i=1 ; i<num ; i++)
+        QCOMPARE(file.at(i).timestamp - first, (quint64) i * 5000);
+}
+
+
+/* every format has to be recognised from what a matching tool writes, then load through the loader picked */
+void TestFrameLoaders::detectFormats()
+{
+    QCOMPARE(FrameFileIO::detectFileFormat(writeLog(dir.path() + "/detect.csv", NATIVE_CSV)), FrameFileIO::FORMAT_NATIVE_CSV);
+    QCOMPARE(FrameFileIO::detectFileFormat(writeLog(dir.path() + "/detect.txt", CRTD)), FrameFileIO::FORMAT_CRTD);
+    QCOMPARE(FrameFileIO::detectFileFormat(writeLog(dir.path() + "/detect_candump.log", CANDUMP)), FrameFileIO::FORMAT_CANDUMP);
+    QCOMPARE(FrameFileIO::detectFileFormat(writeLog(dir.path() + "/detect_busmaster.log", BUSMASTER)), FrameFileIO::FORMAT_BUSMASTER);
+
+    QVector<CANFrame> frames;
+    for(int i=0 ; i<1000 ; i++)
+        frames.append(makeFrame(i));
+    CANFrameView view(&frames);
+
+    struct { FrameFileIO::SaveFunc saver; const char* name; FrameFileIO::FileFormat format; } saved[] = {
+        { FrameFileIO::saveGenericCSVFile,  "/detect_generic.csv",  FrameFileIO::FORMAT_GENERIC_CSV },
+        { FrameFileIO::saveMicrochipFile,   "/detect.can",          FrameFileIO::FORMAT_MICROCHIP },
+        { FrameFileIO::saveTraceFile,       "/detect.trace",        FrameFileIO::FORMAT_TRACE },
+        { FrameFileIO::saveIXXATFile,       "/detect_ixxat.csv",    FrameFileIO::FORMAT_IXXAT },
+        { FrameFileIO::saveCANDOFile,       "/detect.avc",          FrameFileIO::FORMAT_CANDO },
+        { FrameFileIO::saveNativeBinaryFile,"/detect.scb",          FrameFileIO::FORMAT_NATIVE_BINARY },
+        { FrameFileIO::saveCompressedFile,  "/detect.scz",          FrameFileIO::FORMAT_COMPRESSED }
+    };
+    for(unsigned int i=0 ; i<sizeof(saved)/sizeof(saved[0]) ; i++) {
+        QString name = dir.path() + saved[i].name;
+        QVERIFY(saved[i].saver(name, &view, NULL));
+        QCOMPARE(FrameFileIO::detectFileFormat(name), saved[i].format);
+    }
+
+    QFile noise(dir.path() + "/detect_noise.txt");
+    QVERIFY(noise.open(QIODevice::WriteOnly));
+    noise.write("nothing in here looks like a frame\nnot this either\n");
+    noise.close();
+    QCOMPARE(FrameFileIO::detectFileFormat(noise.fileName()), FrameFileIO::FORMAT_UNKNOWN);
+
+    QVector<CANFrame> loaded;
+    FrameFileIO::FileFormat detected;
+    QVERIFY(FrameFileIO::loadAutoDetect(dir.path() + "/detect_candump.log", &loaded, &detected));
+    QCOMPARE(detected, FrameFileIO::FORMAT_CANDUMP);
+    QVERIFY(checkFrames(loaded));
+}
+
+
+/* only the frames inside the window with the wanted IDs come back, whichever way the format gets to them */
+void TestFrameLoaders::partialLoad()
+{
+    LoadFilter filter;
+    filter.fromFirstFrame = true;
+    filter.startTime = 50000000;
+    filter.endTime = 60000000;
+    filter.ids << 0x101 << 0x10A;
+
+    QVector<CANFrame> all;
+    QVector<CANFrame> expected;
+    for(int i=0 ; i<NUM_FRAMES ; i++) {
+        all.append(makeFrame(i));
+        if(i >= 50000 && i <= 60000 && filter.ids.contains(all.last().ID))
+            expected.append(all.last());
+    }
+    CANFrameView view(&all);
+
+    QVERIFY(FrameFileIO::saveNativeBinaryFile(dir.path() + "/partial.scb", &view));
+    QVERIFY(FrameFileIO::saveCompressedFile(dir.path() + "/partial.scz", &view));
+    QVERIFY(FrameFileIO::saveMicrochipFile(dir.path() + "/partial.can", &view));
+
+    struct { QString name; FrameFileIO::FileFormat format; } files[] = {
+        { writeLog(dir.path() + "/partial.log", CANDUMP),   FrameFileIO::FORMAT_CANDUMP },
+        { writeLog(dir.path() + "/partial.csv", NATIVE_CSV),FrameFileIO::FORMAT_NATIVE_CSV },
+        { dir.path() + "/partial.scb",                      FrameFileIO::FORMAT_NATIVE_BINARY },
+        { dir.path() + "/partial.scz",                      FrameFileIO::FORMAT_COMPRESSED },
+        { dir.path() + "/partial.can",                      FrameFileIO::FORMAT_MICROCHIP }
+    };
+    for(unsigned int f=0 ; f<sizeof(files)/sizeof(files[0]) ; f++) {
+        QVector<CANFrame> frames;
+        QVERIFY(FrameFileIO::loadFileOfFormat(files[f].name, files[f].format, &frames, filter));
+        QCOMPARE(frames.count(), expected.count());
+        for(int i=0 ; i<frames.count() ; i++) {
+            QCOMPARE(frames[i].ID, expected[i].ID);
+            QCOMPARE(frames[i].timestamp, expected[i].timestamp);
+        }
+    }
+}
+
+
+/* loads running side by side each keep to their own filter */
+void TestFrameLoaders::concurrentLoads()
+{
+    QVector<CANFrame> all;
+    for(int i=0 ; i<NUM_FRAMES ; i++)
+        all.append(makeFrame(i));
+    CANFrameView view(&all);
+    QString name = dir.path() + "/concurrent.can";
+    QVERIFY(FrameFileIO::saveMicrochipFile(name, &view));
+
+    QVector<CANFrame> frames[4];
+    QFuture<bool> loads[4];
+    for(int t=0 ; t<4 ; t++) {
+        LoadFilter filter;
+        filter.ids << (uint32_t) (0x100 + t);
+        QVector<CANFrame> *out = &frames[t];
+        loads[t] = QtConcurrent::run([name, filter, out]() {
+            return FrameFileIO::loadFileOfFormat(name, FrameFileIO::FORMAT_MICROCHIP, out, filter);
+        });
+    }
+    for(int t=0 ; t<4 ; t++) {
+        QVERIFY(loads[t].result());
+        QCOMPARE(frames[t].count(), NUM_FRAMES / 16);
+        for(int i=0 ; i<frames[t].count() ; i++)
+            QCOMPARE(frames[t][i].ID, (uint32_t) (0x100 + t));
+    }
+}
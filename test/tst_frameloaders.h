@@ -0,0 +1,29 @@
+#ifndef TST_FRAMELOADERS_H
+#define TST_FRAMELOADERS_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+class TestFrameLoaders: public QObject
+{
+    Q_OBJECT
+private:
+    QTemporaryDir dir;
+
+private slots:
+    void nativeCSV();
+    void crtd();
+    void canDump();
+    void busMaster();
+    void untimedAcrossChunks();
+    void saveNativeCSV();
+    void saveCRTD();
+    void saveCanDump();
+    void viewFile();
+    void viewUntimed();
+    void detectFormats();
+    void partialLoad();
+    void concurrentLoads();
+};
+
+#endif // TST_FRAMELOADERS_H
@@ -1,5 +1,6 @@
 #include <QtTest>
 
+#include <QThreadPool>
 #include <QtConcurrent/qtconcurrentrun.h>
 
 #include "utils/lfqueue.h"
@@ -83,3 +84,231 @@ void TestLFQueue::exchange()
 
     thread.waitForFinished();
 }
+
+
+void batchReaderThread(LFQueue<int>* pQueue_p, int pSize) {
+    int* val_p;
+    int count;
+    int expected = 0;
+
+    while(expected < pSize) {
+        if(! (val_p = pQueue_p->peekBatch(count)) )
+            continue;
+        QVERIFY(count > 0);
+
+        for(int i=0 ; i<count ; i++)
+            QCOMPARE(val_p[i], expected++);
+        pQueue_p->dequeueBatch(count);
+    }
+}
+
+
+void TestLFQueue::batchExchange_data()
+{
+    QTest::addColumn<int>("queueSize");
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("small")  << 7    << 100000;
+    QTest::newRow("large")  << 4000 << 1000000;
+}
+
+
+void TestLFQueue::batchExchange()
+{
+    LFQueue<int> queue;
+    QFETCH(int, queueSize);
+    QFETCH(int, size);
+
+    int* val_p;
+    int count;
+    int next = 0;
+
+    QCOMPARE(queue.setSize(queueSize), true);
+    /* sizes are rounded to a power of two */
+    QCOMPARE(queue.size() & (queue.size() - 1), 0);
+    QVERIFY(queue.size() >= queueSize);
+
+    QFuture<void> thread = QtConcurrent::run(batchReaderThread, &queue, size);
+
+    while(next < size) {
+        if(! (val_p = queue.getBatch(count)) )
+            continue;
+        QVERIFY(count > 0);
+
+        count = qMin(count, size - next);
+        for(int i=0 ; i<count ; i++)
+            val_p[i] = next++;
+        queue.queueBatch(count);
+    }
+
+    thread.waitForFinished();
+    QCOMPARE(queue.count(), 0);
+}
+
+
+void mpscWriterThread(LFMPSCQueue<qint64>* pQueue_p, int pWriter, int pSize) {
+    for(int i=0 ; i<pSize ; i++) {
+        while(! pQueue_p->enqueue( ((qint64) pWriter << 32) | i ) );
+    }
+}
+
+
+void TestLFQueue::mpscContention_data()
+{
+    QTest::addColumn<int>("writers");
+    QTest::addColumn<int>("queueSize");
+
+    QTest::newRow("1 writer")   << 1 << 16;
+    QTest::newRow("2 writers")  << 2 << 16;
+    QTest::newRow("4 writers")  << 4 << 256;
+}
+
+
+/* each writer's values must come out complete and in the order it wrote them */
+void TestLFQueue::mpscContention()
+{
+    LFMPSCQueue<qint64> queue;
+    QFETCH(int, writers);
+    QFETCH(int, queueSize);
+
+    const int size = 100000;
+    QVector<int> expected(writers, 0);
+    QThreadPool pool;
+    qint64* val_p;
+    bool inOrder = true;
+
+    QCOMPARE(queue.setSize(queueSize), true);
+
+    /* a pool of its own so every writer runs at once without touching the global pool's limits */
+    pool.setMaxThreadCount(writers);
+    for(int w=0 ; w<writers ; w++)
+        QtConcurrent::run(&pool, mpscWriterThread, &queue, w, size);
+
+    /* the writers block on a full queue, so everything is read out before anything is checked */
+    for(int n=0 ; n<writers*size ; n++) {
+        while(! (val_p = queue.peek()) );
+
+        int writer = (int) (*val_p >> 32);
+        int value  = (int) (*val_p & 0xFFFFFFFF);
+        if(writer < 0 || writer >= writers || value != expected[writer])
+            inOrder = false;
+        else
+            expected[writer]++;
+
+        queue.dequeue();
+    }
+
+    pool.waitForDone();
+
+    QVERIFY(inOrder);
+    QVERIFY(queue.peek() == NULL);
+}
+
+
+/* single element producer/consumer in the same thread, measures the cost of the index handling */
+void TestLFQueue::throughput()
+{
+    LFQueue<int> queue;
+    const int size = 1000000;
+    int* val_p;
+
+    QCOMPARE(queue.setSize(4096), true);
+
+    QBENCHMARK {
+        for(int i=0 ; i<size ; i++) {
+            val_p = queue.get();
+            *val_p = i;
+            queue.queue();
+
+            val_p = queue.peek();
+            queue.dequeue();
+        }
+    }
+}
+
+
+void TestLFQueue::throughputBatch()
+{
+    LFQueue<int> queue;
+    const int size = 1000000;
+    int* val_p;
+    int count;
+    qint64 sum = 0;
+
+    QCOMPARE(queue.setSize(4096), true);
+
+    QBENCHMARK {
+        for(int done=0 ; done<size ; ) {
+            val_p = queue.getBatch(count);
+            for(int i=0 ; i<count ; i++)
+                val_p[i] = i;
+            queue.queueBatch(count);
+
+            val_p = queue.peekBatch(count);
+            for(int i=0 ; i<count ; i++)
+                sum += val_p[i];
+            queue.dequeueBatch(count);
+            done += count;
+        }
+    }
+
+    QVERIFY(sum > 0); /* keeps the reads from being optimized out */
+}
+
+
+/* enqueue and dequeue on one thread, the cost of the MPSC queue without any contention */
+void TestLFQueue::throughputMPSC()
+{
+    LFMPSCQueue<int> queue;
+    const int size = 1000000;
+
+    QCOMPARE(queue.setSize(4096), true);
+
+    QBENCHMARK {
+        for(int i=0 ; i<size ; i++) {
+            queue.enqueue(i);
+            queue.peek();
+            queue.dequeue();
+        }
+    }
+}
+
+
+void TestLFQueue::throughputMPSCContention_data()
+{
+    QTest::addColumn<int>("writers");
+
+    QTest::newRow("2 writers")  << 2;
+    QTest::newRow("4 writers")  << 4;
+}
+
+
+/* several writer threads feeding one reader, measures the cost of the contended enqueue */
+void TestLFQueue::throughputMPSCContention()
+{
+    LFMPSCQueue<qint64> queue;
+    QFETCH(int, writers);
+
+    const int size = 250000;
+    QThreadPool pool;
+    qint64* val_p;
+    qint64 sum = 0;
+
+    QCOMPARE(queue.setSize(4096), true);
+    pool.setMaxThreadCount(writers);
+
+    QBENCHMARK {
+        for(int w=0 ; w<writers ; w++)
+            QtConcurrent::run(&pool, mpscWriterThread, &queue, w, size);
+
+        for(int n=0 ; n<writers*size ; n++) {
+            while(! (val_p = queue.peek()) );
+            sum += *val_p & 0xFFFFFFFF;
+            queue.dequeue();
+        }
+
+        pool.waitForDone();
+    }
+
+    QVERIFY(sum > 0); /* keeps the reads from being optimized out */
+}
@@ -13,6 +13,15 @@ private slots:
     void setSize();
     void exchange_data();
     void exchange();
+    void batchExchange_data();
+    void batchExchange();
+    void mpscContention_data();
+    void mpscContention();
+    void throughput();
+    void throughputBatch();
+    void throughputMPSC();
+    void throughputMPSCContention_data();
+    void throughputMPSCContention();
 };
 
 #endif // TST_LFQUEUE_H
@@ -0,0 +1,249 @@
+#include <QtTest>
+#include <QFile>
+#include <QtEndian>
+#include <math.h>
+
+#include "signalexport.h"
+#include "dbc/dbchandler.h"
+#include "tst_signalexport.h"
+
+
+#define NUM_FRAMES  200000
+#define GAP_FRAME   100000
+#define GAP_US      20000000ull
+#define PERIOD_US   1000
+
+
+static const char* EXPORT_DBC =
+    "BU_: ECU\n"
+    "BO_ 256 Counter: 8 ECU\n"
+    " SG_ Count : 0|16@1+ (1,0) [0|65535] \"\" Vector__XXX\n"
+    " SG_ Half : 16|8@1+ (0.5,0) [0|127.5] \"V\" Vector__XXX\n"
+    "BO_ 2364540160 Muxed: 8 ECU\n"
+    " SG_ Selector M : 0|8@1+ (1,0) [0|255] \"\" Vector__XXX\n"
+    " SG_ Temp m1 : 8|16@1- (0.1,-40) [-40|125] \"degC\" Vector__XXX\n"
+    " SG_ Always : 56|8@1+ (1,0) [0|255] \"\" Vector__XXX\n";
+
+
+static CANFrame makeFrame(uint32_t ID, quint64 timestamp)
+{
+    CANFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.ID        = ID;
+    frame.extended  = ID > 0x7FF;
+    frame.len       = 8;
+    frame.timestamp = timestamp;
+    return frame;
+}
+
+
+static DBC_MESSAGE* findMessage(const char* name)
+{
+    DBCHandler* dbc = DBCHandler::getReference();
+    return dbc->getFileByIdx(0)->messageHandler->findMsgByName(name);
+}
+
+
+static void addColumn(SignalExport& exporter, const char* msgName, const char* sigName)
+{
+    DBC_MESSAGE* msg = findMessage(msgName);
+    exporter.addSignal(msg, msg->sigHandler->findSignalByName(sigName));
+}
+
+
+static QStringList readLines(const QString& name)
+{
+    QFile file(name);
+    if(!file.open(QIODevice::ReadOnly))
+        return QStringList();
+    return QString::fromUtf8(file.readAll()).split('\n', QString::SkipEmptyParts);
+}
+
+
+/* expected Counter.Count of the resampled row at time t, the last frame at or before it */
+static double heldCount(quint64 t)
+{
+    quint64 i = t / 1000;
+    if(i >= GAP_FRAME)
+        i = (t < GAP_FRAME * 1000 + GAP_US) ? GAP_FRAME - 1 : (t - GAP_US) / 1000;
+    return (double) (i & 0xFFFF);
+}
+
+
+void TestSignalExport::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    QString path = dir.path() + "/export.dbc";
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(EXPORT_DBC);
+    file.close();
+
+    DBCHandler::getReference()->removeAllFiles();
+    QVERIFY(DBCHandler::getReference()->loadDBCFile(path));
+}
+
+
+void TestSignalExport::cleanupTestCase()
+{
+    DBCHandler::getReference()->removeAllFiles();
+}
+
+
+/* without resampling each frame is a row with only its own signals filled in */
+void TestSignalExport::frameRows()
+{
+    QVector<CANFrame> frames;
+    for(int i=0 ; i<10 ; i++) {
+        CANFrame counter = makeFrame(0x100, 1000 * (quint64) (i + 1));
+        counter.data[0] = i;
+        counter.data[2] = 2 * i;
+        frames.append(counter);
+
+        CANFrame muxed = makeFrame(0x0CF00400, 1000 * (quint64) (i + 1) + 500);
+        muxed.data[0] = 1 + (i % 2);
+        muxed.data[1] = 0x58;
+        muxed.data[2] = 0x02;
+        muxed.data[7] = i;
+        frames.append(muxed);
+    }
+    frames.append(makeFrame(0x555, 20000));
+    CANFrameView view(&frames);
+
+    SignalExport exporter;
+    addColumn(exporter, "Counter", "Count");
+    addColumn(exporter, "Muxed", "Temp");
+    addColumn(exporter, "Counter", "Half");
+    addColumn(exporter, "Muxed", "Always");
+    QString path = dir.path() + "/rows.csv";
+    exporter.prepare();
+    QVERIFY(exporter.write(path, &view, DBCHandler::getReference()));
+    QCOMPARE(exporter.progress(), 1000);
+
+    QStringList lines = readLines(path);
+    QCOMPARE(lines.count(), 21);
+    QCOMPARE(lines[0], QString("Time,Counter.Count,Muxed.Temp,Counter.Half,Muxed.Always"));
+    QCOMPARE(lines[1], QString("0.001000,0,,0,"));
+    QCOMPARE(lines[2], QString("0.001500,,20,,0"));
+    QCOMPARE(lines[4], QString("0.002500,,,,1"));
+    QCOMPARE(lines[19], QString("0.010000,9,,9,"));
+    QCOMPARE(lines[20], QString("0.010500,,,,9"));
+}
+
+
+/*
+ * Resampled across several pieces and a gap long enough to be written as a run of held rows. The binary
+ * and CSV files have to agree with each other and with what the frames held at every row.
+ */
+void TestSignalExport::resampled()
+{
+    QVector<CANFrame> frames(NUM_FRAMES);
+    for(int i=0 ; i<NUM_FRAMES ; i++) {
+        quint64 t = 1000 * (quint64) i + (i >= GAP_FRAME ? GAP_US : 0);
+        frames[i] = makeFrame(0x100, t);
+        frames[i].data[0] = i & 0xFF;
+        frames[i].data[1] = (i >> 8) & 0xFF;
+    }
+    CANFrameView view(&frames);
+    quint64 numRows = frames.last().timestamp / PERIOD_US + 1;
+
+    SignalExport exporter;
+    exporter.setFormat(SignalExport::BINARY_COLUMNS);
+    exporter.setResamplePeriod(PERIOD_US);
+    addColumn(exporter, "Counter", "Count");
+    addColumn(exporter, "Muxed", "Temp");
+    QString binPath = dir.path() + "/resampled.scol";
+    exporter.prepare();
+    QVERIFY(exporter.write(binPath, &view, DBCHandler::getReference()));
+
+    QFile file(binPath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray data = file.readAll();
+    const uchar* p = (const uchar*) data.constData();
+    const uchar* end = p + data.size();
+    QCOMPARE(QByteArray(data.constData(), 8), QByteArray(SIGCOL_MAGIC));
+    QCOMPARE(qFromLittleEndian<quint32>(p + 12), 2u);
+    QCOMPARE(qFromLittleEndian<quint64>(p + 16), numRows);
+    QCOMPARE(qFromLittleEndian<quint64>(p + 24), (quint64) PERIOD_US);
+    quint32 groups = qFromLittleEndian<quint32>(p + 32);
+    p += SIGCOL_HEADER_SIZE;
+
+    QStringList names;
+    for(int c=0 ; c<4 ; c++) {
+        quint16 len = qFromLittleEndian<quint16>(p);
+        names.append(QString::fromUtf8((const char*) p + 2, len));
+        p += 2 + len;
+    }
+    QCOMPARE(names, QStringList() << "Counter.Count" << "" << "Muxed.Temp" << "degC");
+
+    quint64 row = 0;
+    bool valuesOK = true;
+    for(quint32 g=0 ; g<groups ; g++) {
+        QVERIFY(end - p >= 4);
+        quint32 rows = qFromLittleEndian<quint32>(p);
+        p += 4;
+        QVERIFY((quint64) (end - p) >= (quint64) rows * 24);
+        for(quint32 r=0 ; r<rows ; r++) {
+            quint64 t = qFromLittleEndian<quint64>(p + 8 * r);
+            quint64 countBits = qFromLittleEndian<quint64>(p + 8 * (rows + r));
+            quint64 tempBits = qFromLittleEndian<quint64>(p + 8 * (2 * rows + r));
+            double count, temp;
+            memcpy(&count, &countBits, 8);
+            memcpy(&temp, &tempBits, 8);
+            if(t != (row + r) * PERIOD_US || count != heldCount(t) || !isnan(temp))
+                valuesOK = false;
+        }
+        row += rows;
+        p += (quint64) rows * 24;
+    }
+    QVERIFY(valuesOK);
+    QCOMPARE(row, numRows);
+    QVERIFY(p == end);
+
+    exporter.setFormat(SignalExport::WIDE_CSV);
+    QString csvPath = dir.path() + "/resampled.csv";
+    QVERIFY(exporter.write(csvPath, &view, DBCHandler::getReference()));
+    QStringList lines = readLines(csvPath);
+    QCOMPARE((quint64) lines.count(), numRows + 1);
+    QCOMPARE(lines[1], QString("0.000000,0,"));
+    QCOMPARE(lines[110001], QString("110.000000,%1,").arg(heldCount(110000000)));
+    quint64 last = (numRows - 1) * PERIOD_US;
+    QCOMPARE(lines.last(), QString("%1,%2,").arg(last / 1000000.0, 0, 'f', 6).arg(heldCount(last)));
+}
+
+
+/*
+ * A memory limit far too small for the usual piece sizes has to make smaller pieces, parts and runs
+ * without changing a single row of what is written.
+ */
+void TestSignalExport::memoryLimit()
+{
+    QVector<CANFrame> frames(NUM_FRAMES / 10);
+    for(int i=0 ; i<frames.count() ; i++) {
+        quint64 t = 1000 * (quint64) i + (i >= GAP_FRAME / 10 ? GAP_US / 10 : 0);
+        frames[i] = makeFrame(0x100, t);
+        frames[i].data[0] = i & 0xFF;
+        frames[i].data[1] = (i >> 8) & 0xFF;
+    }
+    CANFrameView view(&frames);
+
+    SignalExport exporter;
+    exporter.setResamplePeriod(PERIOD_US);
+    addColumn(exporter, "Counter", "Count");
+    addColumn(exporter, "Muxed", "Temp");
+    QString fullPath = dir.path() + "/unlimited.csv";
+    exporter.prepare();
+    QVERIFY(exporter.write(fullPath, &view, DBCHandler::getReference()));
+
+    exporter.setMemoryLimit(64 * 1024);
+    QString limitedPath = dir.path() + "/limited.csv";
+    QVERIFY(exporter.write(limitedPath, &view, DBCHandler::getReference()));
+
+    QFile full(fullPath), limited(limitedPath);
+    QVERIFY(full.open(QIODevice::ReadOnly));
+    QVERIFY(limited.open(QIODevice::ReadOnly));
+    QByteArray expected = full.readAll();
+    QVERIFY(!expected.isEmpty());
+    QVERIFY(limited.readAll() == expected);
+}
@@ -0,0 +1,21 @@
+#ifndef TST_SIGNALEXPORT_H
+#define TST_SIGNALEXPORT_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+class TestSignalExport: public QObject
+{
+    Q_OBJECT
+private:
+    QTemporaryDir dir;
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void frameRows();
+    void resampled();
+    void memoryLimit();
+};
+
+#endif // TST_SIGNALEXPORT_H
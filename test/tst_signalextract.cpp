@@ -0,0 +1,78 @@
+#include <QtTest>
+
+#include "utility.h"
+#include "tst_signalextract.h"
+
+
+
+void TestSignalExtract::equivalence_data()
+{
+    QTest::addColumn<bool>("littleEndian");
+    QTest::addColumn<bool>("isSigned");
+
+    QTest::newRow("intel unsigned")     << true  << false;
+    QTest::newRow("intel signed")       << true  << true;
+    QTest::newRow("motorola unsigned")  << false << false;
+    QTest::newRow("motorola signed")    << false << true;
+}
+
+
+/* every layout that fits in the frame against processIntegerSignal with random payloads */
+void TestSignalExtract::equivalence()
+{
+    QFETCH(bool, littleEndian);
+    QFETCH(bool, isSigned);
+
+    qsrand(0x5A17);
+
+    for(int startBit=0 ; startBit<64 ; startBit++) {
+        /* 64 bit signed signals are excluded: processIntegerSignal shifts by 64 there */
+        int maxSize = isSigned ? 63 : 64;
+        for(int sigSize=1 ; sigSize<=maxSize ; sigSize++) {
+            SignalExtractor extractor(startBit, sigSize, littleEndian, isSigned);
+            if(!extractor.fastPath)
+                continue;
+
+            for(int i=0 ; i<64 ; i++) {
+                uint8_t data[8];
+                for(int b=0 ; b<8 ; b++)
+                    data[b] = qrand() & 0xFF;
+
+                QCOMPARE(extractor.extract(data),
+                         Utility::processIntegerSignal(data, startBit, sigSize, littleEndian, isSigned));
+            }
+        }
+    }
+}
+
+
+void TestSignalExtract::batch()
+{
+    const int count = 1000;
+    QVector<CANFrame> frames(count);
+    QVector<int64_t> values(count);
+
+    qsrand(0xB47C);
+
+    for(int i=0 ; i<count ; i++) {
+        frames[i].len = 8;
+        for(int b=0 ; b<8 ; b++)
+            frames[i].data[b] = qrand() & 0xFF;
+    }
+
+    for(int i=0 ; i<256 ; i++) {
+        int startBit    = qrand() % 64;
+        int sigSize     = 1 + qrand() % 63;
+        bool littleEndian = qrand() & 1;
+        bool isSigned   = qrand() & 1;
+
+        SignalExtractor extractor(startBit, sigSize, littleEndian, isSigned);
+        if(!extractor.fastPath)
+            continue;
+
+        extractor.extractBatch(frames.constData(), count, values.data());
+
+        for(int f=0 ; f<count ; f++)
+            QCOMPARE(values[f], Utility::processIntegerSignal(frames[f].data, startBit, sigSize, littleEndian, isSigned));
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef TST_SIGNALEXTRACT_H
+#define TST_SIGNALEXTRACT_H
+
+#include <QObject>
+
+class TestSignalExtract: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void equivalence_data();
+    void equivalence();
+    void batch();
+};
+
+#endif // TST_SIGNALEXTRACT_H
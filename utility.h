@@ -6,6 +6,8 @@
 #include <QByteArray>
 #include <QDateTime>
 #include <QDebug>
+#include <QtEndian>
+#include "can_structs.h"
 
 class Utility
 {
@@ -240,4 +242,113 @@ public:
     }
 };
 
+/*
+ * processIntegerSignal walks the signal one bit at a time which is slow when it is run over
+ * millions of frames. This is the same thing worked out ahead of time. The 8 data bytes are loaded as one
+ * 64 bit word (byte swapped for motorola signals). In that word both intel and motorola signals are
+ * a contiguous run of bits so the signal is just a left shift to drop the bits above it and a right shift
+ * to drop the bits below it. Using an arithmetic right shift for signed signals sign extends for free.
+ * Build one of these when the signal definition is loaded and reuse it for every frame.
+*/
+class SignalExtractor
+{
+public:
+    int startBit;
+    int sigSize;
+    bool littleEndian;
+    bool isSigned;
+    bool fastPath; //false if the signal does not fit in the 8 data bytes. Those go through processIntegerSignal instead.
+    int leftShift;
+    int rightShift;
+
+    SignalExtractor()
+    {
+        startBit = 0;
+        sigSize = 0; //matches no real signal so a default constructed extractor is always stale
+        littleEndian = true;
+        isSigned = false;
+        fastPath = false;
+        leftShift = 0;
+        rightShift = 0;
+    }
+
+    SignalExtractor(int startBit, int sigSize, bool littleEndian, bool isSigned)
+    {
+        this->startBit = startBit;
+        this->sigSize = sigSize;
+        this->littleEndian = littleEndian;
+        this->isSigned = isSigned;
+        fastPath = false;
+        leftShift = 0;
+        rightShift = 0;
+
+        if (sigSize < 1 || sigSize > 64 || startBit < 0 || startBit > 63) return;
+
+        int lowBit; //position of the least significant bit of the signal within the 64 bit word
+        if (littleEndian)
+        {
+            if (startBit + sigSize > 64) return;
+            lowBit = startBit;
+        }
+        else
+        {
+            //startBit is the most significant bit. Once the bytes are swapped it sits here:
+            int highBit = ((7 - (startBit / 8)) * 8) + (startBit % 8);
+            lowBit = highBit - sigSize + 1;
+            if (lowBit < 0) return;
+        }
+
+        leftShift = 64 - (lowBit + sigSize);
+        rightShift = 64 - sigSize;
+        fastPath = true;
+    }
+
+    //true if this extractor was built for the given signal layout
+    bool isFor(int startBit, int sigSize, bool littleEndian, bool isSigned) const
+    {
+        return (this->startBit == startBit && this->sigSize == sigSize
+                && this->littleEndian == littleEndian && this->isSigned == isSigned);
+    }
+
+    int64_t extract(const uint8_t *data) const
+    {
+        if (!fastPath) return Utility::processIntegerSignal(data, startBit, sigSize, littleEndian, isSigned);
+
+        uint64_t word;
+        if (littleEndian) word = qFromLittleEndian<quint64>(data);
+        else word = qFromBigEndian<quint64>(data);
+
+        word <<= leftShift;
+        if (isSigned) return ((int64_t)word) >> rightShift;
+        return (int64_t)(word >> rightShift);
+    }
+
+    //decode this signal out of count frames in a row. out must have room for count values.
+    void extractBatch(const CANFrame *frames, int count, int64_t *out) const
+    {
+        if (!fastPath)
+        {
+            for (int i = 0; i < count; i++) out[i] = Utility::processIntegerSignal(frames[i].data, startBit, sigSize, littleEndian, isSigned);
+            return;
+        }
+
+        if (littleEndian)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                uint64_t word = qFromLittleEndian<quint64>(frames[i].data) << leftShift;
+                out[i] = isSigned ? (((int64_t)word) >> rightShift) : (int64_t)(word >> rightShift);
+            }
+        }
+        else
+        {
+            for (int i = 0; i < count; i++)
+            {
+                uint64_t word = qFromBigEndian<quint64>(frames[i].data) << leftShift;
+                out[i] = isSigned ? (((int64_t)word) >> rightShift) : (int64_t)(word >> rightShift);
+            }
+        }
+    }
+};
+
 #endif // UTILITY_H
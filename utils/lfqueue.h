@@ -2,19 +2,40 @@
 #define LFQUEUE_H
 
 #include <QObject>
+#include <QAtomicInteger>
 #include <QDebug>
 
 
-/* macros */
-#define IS_EMPTY()  (  mWIdx.load()             == mRIdx.load() )
-#define IS_FULL()   ( (mWIdx.load()+1)%mSize    == mRIdx.load() )
+/* producer and consumer indices are kept this far apart so the two threads don't fight over the same cache line */
+#define LFQUEUE_CACHE_LINE  64
 
 
+/* round size up to the next power of two, 0 if it can't be done */
+static inline int lfqueueRoundSize(int size)
+{
+    int pow2 = 1;
+    while(pow2 < size) {
+        if(pow2 > (0x7FFFFFFF >> 1))
+            return 0;
+        pow2 <<= 1;
+    }
+    return pow2;
+}
+
+
+/*
+ * Single producer / single consumer lock free ring.
+ * The size is rounded up to a power of two and the indices are free running counters, so wrapping is a mask
+ * and all slots can be used. The producer fills slots obtained with get() (or getBatch()) and publishes them with
+ * queue() (or queueBatch()). The consumer reads with peek() (or peekBatch()) and releases with dequeue()
+ * (or dequeueBatch()). Batch calls hand out a contiguous span of slots which may be shorter than what is
+ * available when the span would wrap around the end of the array; call again to get the rest.
+ */
 template<class T>
 class LFQueue
 {
 public:
-    LFQueue() : mSize(0), mArray(NULL){}
+    LFQueue() : mSize(0), mMask(0), mArray(NULL) {}
 
     ~LFQueue() {setSize(0);}
 
@@ -26,66 +47,283 @@ public:
             delete[] mArray;
             mArray = NULL;
         }
+        mSize = 0;
+        mMask = 0;
+        flush();
 
         if(size>0) {
-            mArray = new T[size];
-            if(mArray)
-                mSize = size;
+            int pow2 = lfqueueRoundSize(size);
+            if(!pow2)
+                return false;
+
+            mArray = new T[pow2];
+            if(mArray) {
+                mSize = pow2;
+                mMask = pow2 - 1;
+            }
             return ( mArray!=NULL );
         }
 
         return true;
     }
 
+    int size() const {
+        return mSize;
+    }
+
+    /* number of queued elements, only exact when called from the producer or the consumer */
+    int count() const {
+        return (int) (mWIdx.loadAcquire() - mRIdx.loadAcquire());
+    }
+
     void flush() {
         mRIdx.store(0);
         mWIdx.store(0);
     }
 
     T* get() {
-        if(IS_FULL())
+        quint32 wIdx = mWIdx.load();
+        if( (wIdx - mRIdx.loadAcquire()) >= (quint32) mSize )
             return NULL;
 
-        return &(mArray[mWIdx.loadAcquire()]); /* prevent memory reordering (belt and braces) */
+        return &(mArray[wIdx & mMask]);
     }
 
 
     void queue() {
         #ifdef QT_DEBUG
-        if(IS_FULL())
+        if( (mWIdx.load() - mRIdx.load()) >= (quint32) mSize )
             qCritical() << "BUG: queueing in full queue";
         #endif
 
-        int wIdx = mWIdx.load();
-        mWIdx.storeRelease((wIdx+1)%mSize);
+        mWIdx.storeRelease(mWIdx.load() + 1);
+    }
+
+
+    /**
+     * @brief getBatch
+     * @param pCount: set to the number of contiguous free slots returned
+     * @return pointer to the first free slot, NULL if the queue is full
+     */
+    T* getBatch(int& pCount) {
+        quint32 wIdx    = mWIdx.load();
+        quint32 free    = (quint32) mSize - (wIdx - mRIdx.loadAcquire());
+        quint32 toEnd   = (quint32) mSize - (wIdx & mMask);
+
+        pCount = (int) qMin(free, toEnd);
+        if(!pCount)
+            return NULL;
+
+        return &(mArray[wIdx & mMask]);
+    }
+
+
+    /* publish pCount slots previously obtained with getBatch */
+    void queueBatch(int pCount) {
+        #ifdef QT_DEBUG
+        if( (mWIdx.load() - mRIdx.load()) + pCount > (quint32) mSize )
+            qCritical() << "BUG: queueing past the end of the queue";
+        #endif
+
+        mWIdx.storeRelease(mWIdx.load() + pCount);
     }
 
 
     T* peek() {
-        if(IS_EMPTY())
+        quint32 rIdx = mRIdx.load();
+        if( mWIdx.loadAcquire() == rIdx )
             return NULL;
 
-        return &(mArray[mRIdx.loadAcquire()]); /* prevent memory reordering (belt and braces) */
+        return &(mArray[rIdx & mMask]);
     }
 
 
     void dequeue() {
         #ifdef QT_DEBUG
-        if(IS_EMPTY())
+        if( mWIdx.load() == mRIdx.load() )
             qCritical() << "BUG: dequeueing an empty queue";
         #endif
 
-        int rIdx = mRIdx.load();
-        mRIdx.storeRelease((rIdx+1)%mSize);
+        mRIdx.storeRelease(mRIdx.load() + 1);
+    }
+
+
+    /**
+     * @brief peekBatch
+     * @param pCount: set to the number of contiguous queued elements returned
+     * @return pointer to the oldest element, NULL if the queue is empty
+     */
+    T* peekBatch(int& pCount) {
+        quint32 rIdx    = mRIdx.load();
+        quint32 used    = mWIdx.loadAcquire() - rIdx;
+        quint32 toEnd   = (quint32) mSize - (rIdx & mMask);
+
+        pCount = (int) qMin(used, toEnd);
+        if(!pCount)
+            return NULL;
+
+        return &(mArray[rIdx & mMask]);
+    }
+
+
+    /* release pCount elements previously obtained with peekBatch */
+    void dequeueBatch(int pCount) {
+        #ifdef QT_DEBUG
+        if( (mWIdx.load() - mRIdx.load()) < (quint32) pCount )
+            qCritical() << "BUG: dequeueing more than is queued";
+        #endif
+
+        mRIdx.storeRelease(mRIdx.load() + pCount);
     }
 
 
 private:
     int mSize;
+    quint32 mMask;
     T*  mArray;
 
-    QAtomicInt mRIdx;
-    QAtomicInt mWIdx;
+    char                    mPad0[LFQUEUE_CACHE_LINE];
+    QAtomicInteger<quint32> mWIdx;  /* written by the producer only */
+    char                    mPad1[LFQUEUE_CACHE_LINE - sizeof(QAtomicInteger<quint32>)];
+    QAtomicInteger<quint32> mRIdx;  /* written by the consumer only */
+    char                    mPad2[LFQUEUE_CACHE_LINE - sizeof(QAtomicInteger<quint32>)];
+};
+
+
+/*
+ * Multiple producer / single consumer lock free ring, for queues that several threads write into
+ * (frames being transmitted for instance). Each slot carries a sequence number telling whether it is free
+ * for the producer that claimed that position or holds data for the consumer. Producers claim a position
+ * with a compare and swap so they never wait on each other for longer than that.
+ * The consumer side is used exactly like LFQueue: peek() then dequeue().
+ */
+template<class T>
+class LFMPSCQueue
+{
+public:
+    LFMPSCQueue() : mSize(0), mMask(0), mArray(NULL) {}
+
+    ~LFMPSCQueue() {setSize(0);}
+
+    /* not thread safe, call before producers and consumer start */
+    bool setSize(int size) {
+        if(size<0)
+            return false;
+
+        if(mArray) {
+            delete[] mArray;
+            mArray = NULL;
+        }
+        mSize = 0;
+        mMask = 0;
+        mRIdx.store(0);
+        mWIdx.store(0);
+
+        if(size>0) {
+            int pow2 = lfqueueRoundSize(size);
+            if(!pow2)
+                return false;
+
+            mArray = new Slot[pow2];
+            if(!mArray)
+                return false;
+
+            for(int i=0 ; i<pow2 ; i++)
+                mArray[i].mSeq.store(i);
+            mSize = pow2;
+            mMask = pow2 - 1;
+        }
+
+        return true;
+    }
+
+    int size() const {
+        return mSize;
+    }
+
+    /**
+     * @brief copies pItem in the queue. Can be called from any number of threads
+     * @return false if the queue is full
+     */
+    bool enqueue(const T& pItem) {
+        if(!mArray)
+            return false;
+
+        quint32 pos = mWIdx.load();
+        for(;;) {
+            Slot& slot  = mArray[pos & mMask];
+            qint32 diff = (qint32) (slot.mSeq.loadAcquire() - pos);
+
+            if(diff == 0) {
+                /* slot is free for this position, try to claim it */
+                if(mWIdx.testAndSetRelaxed(pos, pos + 1, pos)) {
+                    slot.mData = pItem;
+                    slot.mSeq.storeRelease(pos + 1);
+                    return true;
+                }
+                /* pos now holds the position another producer left us with */
+            }
+            else if(diff < 0) {
+                /* consumer has not released this slot yet, queue is full */
+                return false;
+            }
+            else {
+                /* another producer got there first */
+                pos = mWIdx.load();
+            }
+        }
+    }
+
+
+    T* peek() {
+        if(!mArray)
+            return NULL;
+
+        quint32 rIdx = mRIdx.load();
+        Slot& slot = mArray[rIdx & mMask];
+        if( slot.mSeq.loadAcquire() != rIdx + 1 )
+            return NULL;
+
+        return &slot.mData;
+    }
+
+
+    void dequeue() {
+        quint32 rIdx = mRIdx.load();
+
+        #ifdef QT_DEBUG
+        if( mArray[rIdx & mMask].mSeq.load() != rIdx + 1 )
+            qCritical() << "BUG: dequeueing an empty queue";
+        #endif
+
+        /* hand the slot back to producers for its next lap */
+        mArray[rIdx & mMask].mSeq.storeRelease(rIdx + mSize);
+        mRIdx.store(rIdx + 1);
+    }
+
+
+    /* consumer side flush, producers may keep going */
+    void flush() {
+        while(peek())
+            dequeue();
+    }
+
+
+private:
+    struct Slot {
+        QAtomicInteger<quint32> mSeq;
+        T                       mData;
+    };
+
+    int mSize;
+    quint32 mMask;
+    Slot* mArray;
+
+    char                    mPad0[LFQUEUE_CACHE_LINE];
+    QAtomicInteger<quint32> mWIdx;  /* shared by producers */
+    char                    mPad1[LFQUEUE_CACHE_LINE - sizeof(QAtomicInteger<quint32>)];
+    QAtomicInteger<quint32> mRIdx;  /* consumer only */
+    char                    mPad2[LFQUEUE_CACHE_LINE - sizeof(QAtomicInteger<quint32>)];
 };
 
 #endif // LFQUEUE_H
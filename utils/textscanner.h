@@ -0,0 +1,324 @@
+#ifndef TEXTSCANNER_H
+#define TEXTSCANNER_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <stdint.h>
+#include <string.h>
+
+
+/*
+ * Streaming helpers for the text log loaders. A file is read in big blocks and handed out one line at a time
+ * as TextSpans pointing straight into the read buffer, tokens are spans into the line and numbers are parsed
+ * from the spans directly. Nothing allocates per line, which is where the old readLine()/split() loaders
+ * spent most of their time.
+ */
+
+
+/* a piece of text that lives somewhere else. Only valid until the buffer it points into changes */
+struct TextSpan
+{
+    const char* ptr;
+    int         len;
+
+    TextSpan() : ptr(""), len(0) {}
+    TextSpan(const char* pPtr, int pLen) : ptr(pPtr), len(pLen) {}
+
+    bool isEmpty() const { return len <= 0; }
+    char at(int i) const { return (i >= 0 && i < len) ? ptr[i] : 0; }
+    char upperAt(int i) const { char c = at(i); return (c >= 'a' && c <= 'z') ? c - 32 : c; }
+
+    TextSpan mid(int pos, int n = -1) const {
+        if(pos >= len || pos < 0) return TextSpan(ptr + len, 0);
+        if(n < 0 || pos + n > len) n = len - pos;
+        return TextSpan(ptr + pos, n);
+    }
+
+    /* strip spaces, tabs and line endings from both sides */
+    TextSpan trimmed() const {
+        int b = 0, e = len;
+        while(b < e && isSpace(ptr[b])) b++;
+        while(e > b && isSpace(ptr[e-1])) e--;
+        return TextSpan(ptr + b, e - b);
+    }
+
+    /* text between the first pair of double quotes, or the whole span if there isn't a pair (like Utility::unQuote) */
+    TextSpan unquoted() const {
+        int first = indexOf('"');
+        if(first < 0) return *this;
+        int second = indexOf('"', first + 1);
+        if(second < 0) return *this;
+        return TextSpan(ptr + first + 1, second - first - 1);
+    }
+
+    int indexOf(char c, int from = 0) const {
+        for(int i = from ; i < len ; i++)
+            if(ptr[i] == c) return i;
+        return -1;
+    }
+
+    bool startsWith(const char* str) const {
+        int n = (int) strlen(str);
+        return n <= len && memcmp(ptr, str, n) == 0;
+    }
+
+    /* str must be upper case */
+    bool startsWithNoCase(const char* str) const {
+        int i = 0;
+        for( ; str[i] ; i++)
+            if(i >= len || upperAt(i) != str[i]) return false;
+        return true;
+    }
+
+    bool equals(const char* str) const {
+        int n = (int) strlen(str);
+        return n == len && memcmp(ptr, str, n) == 0;
+    }
+
+    /* str must be upper case */
+    bool containsNoCase(const char* str) const {
+        int n = (int) strlen(str);
+        for(int i = 0 ; i + n <= len ; i++)
+            if(mid(i, n).startsWithNoCase(str)) return true;
+        return false;
+    }
+
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+    static bool isDigit(char c) { return (unsigned) ((unsigned char) c - '0') < 10u; }
+
+    static int hexValue(char c) {
+        unsigned d = (unsigned char) c - '0';
+        if(d < 10) return (int) d;
+        d = ((unsigned char) c | 0x20) - 'a';
+        if(d < 6) return (int) d + 10;
+        return -1;
+    }
+
+    /* hex number with or without 0x in front, surrounding spaces ignored. ok is false if no digit was found */
+    uint64_t toHex(bool* ok = NULL) const {
+        TextSpan t = trimmed();
+        int i = 0;
+        if(t.len > 2 && t.ptr[0] == '0' && (t.ptr[1] | 0x20) == 'x') i = 2;
+        uint64_t val = 0;
+        int start = i;
+        for( ; i < t.len ; i++) {
+            int d = hexValue(t.ptr[i]);
+            if(d < 0) break;
+            val = (val << 4) | (unsigned) d;
+        }
+        if(ok) *ok = (i > start) && (i == t.len);
+        return val;
+    }
+
+    /* decimal number, optionally signed. Stops at the first character that isn't a digit */
+    int64_t toInt(bool* ok = NULL) const {
+        TextSpan t = trimmed();
+        int i = 0;
+        bool neg = false;
+        if(i < t.len && (t.ptr[i] == '-' || t.ptr[i] == '+')) neg = (t.ptr[i++] == '-');
+        int64_t val = 0;
+        int start = i;
+        for( ; i < t.len ; i++) {
+            unsigned d = (unsigned char) t.ptr[i] - '0';
+            if(d >= 10) break;
+            val = val * 10 + d;
+        }
+        if(ok) *ok = (i > start) && (i == t.len);
+        return neg ? -val : val;
+    }
+
+    /* number in whatever base it says it is in: 0x.. or x.. hex, 0b.. or b.. binary, otherwise decimal (like Utility::ParseStringToNum) */
+    uint64_t toNumber() const {
+        TextSpan t = trimmed();
+        int skip = (t.len > 1 && t.ptr[0] == '0') ? 1 : 0;
+        char prefix = t.upperAt(skip);
+        if(prefix == 'X') return t.mid(skip + 1).toHex();
+        if(prefix == 'B') {
+            uint64_t val = 0;
+            for(int i = skip + 1 ; i < t.len && (t.ptr[i] == '0' || t.ptr[i] == '1') ; i++)
+                val = (val << 1) | (uint64_t) (t.ptr[i] - '0');
+            return val;
+        }
+        return (uint64_t) t.toInt();
+    }
+
+    /*
+     * Decimal number with an optional fraction, scaled by 10^scaleDigits and truncated, all in integer math.
+     * "12.3456789" with 6 digits is 12345678. Used for timestamps so there is no double rounding either.
+     */
+    int64_t toFixed(int scaleDigits, bool* ok = NULL) const {
+        TextSpan t = trimmed();
+        int i = 0;
+        bool neg = false;
+        if(i < t.len && (t.ptr[i] == '-' || t.ptr[i] == '+')) neg = (t.ptr[i++] == '-');
+        int64_t val = 0;
+        int digits = 0;
+        for( ; i < t.len ; i++) {
+            unsigned d = (unsigned char) t.ptr[i] - '0';
+            if(d >= 10) break;
+            val = val * 10 + d;
+            digits++;
+        }
+        int frac = 0;
+        if(i < t.len && t.ptr[i] == '.') {
+            for(i++ ; i < t.len ; i++) {
+                unsigned d = (unsigned char) t.ptr[i] - '0';
+                if(d >= 10) break;
+                if(frac < scaleDigits) {
+                    val = val * 10 + d;
+                    frac++;
+                }
+                digits++;
+            }
+        }
+        for( ; frac < scaleDigits ; frac++) val *= 10;
+        if(ok) *ok = digits > 0 && i == t.len;
+        return neg ? -val : val;
+    }
+
+    /* general decimal number with fraction and exponent. Doesn't depend on the locale the way strtod does */
+    double toDouble(bool* ok = NULL) const {
+        TextSpan t = trimmed();
+        int i = 0;
+        bool neg = false;
+        if(i < t.len && (t.ptr[i] == '-' || t.ptr[i] == '+')) neg = (t.ptr[i++] == '-');
+        double val = 0;
+        int digits = 0;
+        for( ; i < t.len && isDigit(t.ptr[i]) ; i++, digits++)
+            val = val * 10.0 + (t.ptr[i] - '0');
+        if(i < t.len && t.ptr[i] == '.') {
+            double scale = 0.1;
+            for(i++ ; i < t.len && isDigit(t.ptr[i]) ; i++, digits++) {
+                val += (t.ptr[i] - '0') * scale;
+                scale *= 0.1;
+            }
+        }
+        if(digits && i < t.len && (t.ptr[i] | 0x20) == 'e') {
+            int exp = (int) t.mid(i + 1).toInt();
+            i = t.len;
+            double p = 1.0;
+            for(int e = (exp < 0 ? -exp : exp) ; e > 0 ; e--) p *= 10.0;
+            val = (exp < 0) ? val / p : val * p;
+        }
+        if(ok) *ok = digits > 0 && i == t.len;
+        return neg ? -val : val;
+    }
+};
+
+
+/*
+ * Splits a span on a separator without allocating. With collapse set runs of the separator (and any
+ * whitespace when the separator is a space) count as one and leading ones are skipped, like
+ * simplified().split(' ') used to do.
+ */
+class TextTokenizer
+{
+public:
+    TextTokenizer(const TextSpan& pText, char pSep, bool pCollapse = false) :
+        mText(pText), mPos(0), mSep(pSep), mCollapse(pCollapse) {}
+
+    bool next(TextSpan& pToken) {
+        if(mCollapse)
+            while(mPos < mText.len && isSep(mText.ptr[mPos])) mPos++;
+        if(mPos > mText.len || (mCollapse && mPos == mText.len))
+            return false;
+
+        int start = mPos;
+        while(mPos < mText.len && !isSep(mText.ptr[mPos])) mPos++;
+        pToken = TextSpan(mText.ptr + start, mPos - start);
+        mPos++; /* step over the separator, or past the end if there wasn't one */
+        return true;
+    }
+
+    /* fills up to pMax tokens and returns how many there were in total (can be more than pMax) */
+    int split(TextSpan* pTokens, int pMax) {
+        int count = 0;
+        TextSpan tok;
+        while(next(tok)) {
+            if(count < pMax) pTokens[count] = tok;
+            count++;
+        }
+        return count;
+    }
+
+private:
+    bool isSep(char c) const {
+        if(mCollapse && mSep == ' ') return TextSpan::isSpace(c);
+        return c == mSep;
+    }
+
+    TextSpan    mText;
+    int         mPos;
+    char        mSep;
+    bool        mCollapse;
+};
+
+
+/*
+ * Reads a device a large block at a time and returns it line by line. A line is only valid until the next
+ * call to nextLine(). Line endings (\n or \r\n) are not part of the line.
+ */
+class LineReader
+{
+public:
+    LineReader(QIODevice* pDevice, int pBlockSize = 1 << 20) :
+        mDevice(pDevice), mStart(0), mEnd(0), mEof(false), mConsumed(0)
+    {
+        mBuffer.resize(pBlockSize);
+    }
+
+    bool nextLine(TextSpan& pLine) {
+        for(;;) {
+            const char* data = mBuffer.constData();
+            const char* nl = (const char*) memchr(data + mStart, '\n', mEnd - mStart);
+            if(nl) {
+                int lineEnd = (int) (nl - data);
+                pLine = makeLine(mStart, lineEnd);
+                mConsumed += lineEnd + 1 - mStart;
+                mStart = lineEnd + 1;
+                return true;
+            }
+            if(mEof) {
+                if(mStart >= mEnd) return false;
+                pLine = makeLine(mStart, mEnd); /* last line without a newline */
+                mConsumed += mEnd - mStart;
+                mStart = mEnd;
+                return true;
+            }
+            fill();
+        }
+    }
+
+    bool atEnd() const { return mEof && mStart >= mEnd; }
+
+    /* bytes handed out as lines so far, for progress reporting */
+    qint64 consumed() const { return mConsumed; }
+
+private:
+    TextSpan makeLine(int pStart, int pEnd) const {
+        if(pEnd > pStart && mBuffer.constData()[pEnd-1] == '\r') pEnd--;
+        return TextSpan(mBuffer.constData() + pStart, pEnd - pStart);
+    }
+
+    void fill() {
+        /* move the partial line to the front, grow only if a single line is bigger than the buffer */
+        int remain = mEnd - mStart;
+        if(remain > 0 && mStart > 0) memmove(mBuffer.data(), mBuffer.constData() + mStart, remain);
+        mStart = 0;
+        mEnd = remain;
+        if(mEnd == mBuffer.size()) mBuffer.resize(mBuffer.size() * 2);
+
+        qint64 got = mDevice->read(mBuffer.data() + mEnd, mBuffer.size() - mEnd);
+        if(got <= 0) mEof = true;
+        else mEnd += (int) got;
+    }
+
+    QIODevice*  mDevice;
+    QByteArray  mBuffer;
+    int         mStart;
+    int         mEnd;
+    bool        mEof;
+    qint64      mConsumed;
+};
+
+#endif // TEXTSCANNER_H
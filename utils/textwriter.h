@@ -0,0 +1,192 @@
+#ifndef TEXTWRITER_H
+#define TEXTWRITER_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/*
+ * The saving side of textscanner.h. Text is formatted straight into one big buffer that goes to the device in
+ * large writes, numbers are turned into digits by hand and hex comes out of a table two digits at a time.
+ * Nothing allocates per line, unlike building each line out of QString::number() temporaries.
+ */
+
+
+/* "00".."FF", two upper case digits for every byte value */
+static const char textWriterHexPairs[] =
+    "000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+
+class TextWriter
+{
+public:
+    /* longest single number any of the put functions can produce, the buffer always has room for one */
+    static const int MAX_NUMBER = 32;
+
+    TextWriter(QIODevice* pDevice, int pBufferSize = 1 << 20) :
+        mDevice(pDevice), mFailed(false)
+    {
+        if(pBufferSize < MAX_NUMBER * 2) pBufferSize = MAX_NUMBER * 2;
+        mBuffer.resize(pBufferSize);
+        mPos = mBuffer.data();
+        mEnd = mPos + pBufferSize;
+    }
+
+    ~TextWriter() { flush(); }
+
+    void put(char c) {
+        if(mPos == mEnd) flushBuffer();
+        *mPos++ = c;
+    }
+
+    void put(const char* pStr) { put(pStr, (int) strlen(pStr)); }
+    void put(const QByteArray& pStr) { put(pStr.constData(), pStr.size()); }
+
+    void put(const char* pStr, int pLen) {
+        if(mEnd - mPos < pLen) {
+            flushBuffer();
+            if(pLen > mEnd - mPos) { /* bigger than the whole buffer, goes straight out */
+                if(mDevice->write(pStr, pLen) != pLen) mFailed = true;
+                return;
+            }
+        }
+        memcpy(mPos, pStr, pLen);
+        mPos += pLen;
+    }
+
+    /* unsigned decimal, padded on the left with pPad to at least pMinWidth characters */
+    void putDecimal(uint64_t pVal, int pMinWidth = 0, char pPad = '0') {
+        reserve(MAX_NUMBER + pMinWidth);
+        mPos = writeDecimal(mPos, pVal, pMinWidth, pPad);
+    }
+
+    void putSigned(int64_t pVal) {
+        reserve(MAX_NUMBER);
+        if(pVal < 0) {
+            *mPos++ = '-';
+            mPos = writeDecimal(mPos, 0 - (uint64_t) pVal);
+        }
+        else mPos = writeDecimal(mPos, (uint64_t) pVal);
+    }
+
+    /* upper case hex with at least pMinDigits digits, no 0x in front */
+    void putHex(uint32_t pVal, int pMinDigits = 1) {
+        reserve(MAX_NUMBER);
+        mPos = writeHex(mPos, pVal, pMinDigits);
+    }
+
+    void putHexByte(uint8_t pVal) {
+        reserve(2);
+        mPos = writeHexByte(mPos, pVal);
+    }
+
+    /*
+     * pVal / 10^pFracDigits with exactly pFracDigits digits after the point, all in integer math.
+     * putFixed(1234567, 6) is "1.234567", which is how microsecond timestamps turn into seconds.
+     */
+    void putFixed(uint64_t pVal, int pFracDigits) {
+        reserve(MAX_NUMBER + pFracDigits);
+        mPos = writeFixed(mPos, pVal, pFracDigits);
+    }
+
+    /* up to 15 significant digits, the way %.15g has it. Whole numbers skip printf altogether */
+    void putDouble(double pVal) {
+        reserve(MAX_NUMBER);
+        mPos = writeDouble(mPos, pVal);
+    }
+
+    /* writes out everything buffered so far. False if anything written since the start failed */
+    bool flush() {
+        flushBuffer();
+        return !mFailed;
+    }
+
+    bool hasFailed() const { return mFailed; }
+
+    /*
+     * The same formatting straight into memory for callers that manage their own buffer. Each returns
+     * the position just past what it wrote.
+     */
+    static char* writeDecimal(char* p, uint64_t pVal, int pMinWidth = 0, char pPad = '0') {
+        char digits[20];
+        int n = 0;
+        do { digits[n++] = (char) ('0' + (pVal % 10)); pVal /= 10; } while(pVal);
+        for(int i = n ; i < pMinWidth ; i++) *p++ = pPad;
+        while(n) *p++ = digits[--n];
+        return p;
+    }
+
+    static char* writeHex(char* p, uint32_t pVal, int pMinDigits = 1) {
+        int digits = 1;
+        while(digits < 8 && (pVal >> (digits * 4))) digits++;
+        for(int i = digits ; i < pMinDigits ; i++) *p++ = '0';
+        /* the second character of each pair is a single hex digit for values below 16 */
+        for(int shift = (digits - 1) * 4 ; shift >= 0 ; shift -= 4)
+            *p++ = textWriterHexPairs[((pVal >> shift) & 0xF) * 2 + 1];
+        return p;
+    }
+
+    static char* writeHexByte(char* p, uint8_t pVal) {
+        p[0] = textWriterHexPairs[pVal * 2];
+        p[1] = textWriterHexPairs[pVal * 2 + 1];
+        return p + 2;
+    }
+
+    static char* writeFixed(char* p, uint64_t pVal, int pFracDigits) {
+        uint64_t scale = 1;
+        for(int i = 0 ; i < pFracDigits ; i++) scale *= 10;
+        p = writeDecimal(p, pVal / scale);
+        if(pFracDigits > 0) {
+            *p++ = '.';
+            p = writeDecimal(p, pVal % scale, pFracDigits);
+        }
+        return p;
+    }
+
+    static char* writeDouble(char* p, double pVal) {
+        /* the range test comes first as converting NaN or anything too big for an int64_t isn't defined */
+        if(pVal > -1e15 && pVal < 1e15 && pVal == (double) (int64_t) pVal) {
+            int64_t whole = (int64_t) pVal;
+            if(whole < 0) {
+                *p++ = '-';
+                return writeDecimal(p, 0 - (uint64_t) whole);
+            }
+            return writeDecimal(p, (uint64_t) whole);
+        }
+        int len = snprintf(p, MAX_NUMBER, "%.15g", pVal);
+        if(len < 0 || len >= MAX_NUMBER) len = 0;
+        /* printf follows the C locale, which Qt sets from the environment, so the point can come out as a comma */
+        for(int i = 0 ; i < len ; i++)
+            if(p[i] == ',') p[i] = '.';
+        return p + len;
+    }
+
+private:
+    void reserve(int pBytes) {
+        if(mEnd - mPos < pBytes) flushBuffer();
+    }
+
+    void flushBuffer() {
+        qint64 len = mPos - mBuffer.data();
+        if(len > 0 && mDevice->write(mBuffer.constData(), len) != len) mFailed = true;
+        mPos = mBuffer.data();
+    }
+
+    QIODevice*  mDevice;
+    QByteArray  mBuffer;
+    char*       mPos;
+    char*       mEnd;
+    bool        mFailed;
+};
+
+#endif // TEXTWRITER_H